@@ -0,0 +1,134 @@
+#include <QtTest/QtTest>
+#include <QTextStream>
+#include "chezmoioutputparser.h"
+#include "filestatusbatch.h"
+#include "syntheticdata.h"
+
+namespace {
+
+// QProcess hands out standard output in chunks of about this size
+constexpr qsizetype ChunkSize = 64 * 1024;
+
+}
+
+class BenchChezmoiOutputParser : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkTextStream_data();
+    void benchmarkTextStream();
+    void benchmarkParser_data();
+    void benchmarkParser();
+    void benchmarkParserChunked_data();
+    void benchmarkParserChunked();
+    void benchmarkManaged_data();
+    void benchmarkManaged();
+};
+
+void BenchChezmoiOutputParser::benchmarkTextStream_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchChezmoiOutputParser::benchmarkTextStream()
+{
+    QFETCH(int, count);
+    const QByteArray input = SyntheticData::statusOutput(count);
+
+    // What ChezmoiService did before: decode everything, then copy every line twice more
+    QHash<QString, ChezmoiStatus> statuses;
+    QBENCHMARK {
+        statuses.clear();
+        QString output = QString::fromUtf8(input);
+        QTextStream stream(&output, QIODevice::ReadOnly);
+        QString line;
+        while (stream.readLineInto(&line)) {
+            if (line.length() < 3) {
+                continue;
+            }
+            const QString codes = line.left(2);
+            const QString path = line.mid(3).trimmed();
+            statuses.insert(path, ChezmoiStatus::fromCodes(codes.at(0).toLatin1(), codes.at(1).toLatin1()));
+        }
+    }
+    QCOMPARE(statuses.size(), qsizetype(count));
+}
+
+void BenchChezmoiOutputParser::benchmarkParser_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchChezmoiOutputParser::benchmarkParser()
+{
+    QFETCH(int, count);
+    const QByteArray input = SyntheticData::statusOutput(count);
+
+    QHash<QString, ChezmoiStatus> statuses;
+    QBENCHMARK {
+        statuses = ChezmoiOutputParser::parseStatus(input);
+    }
+    QCOMPARE(statuses.size(), qsizetype(count));
+}
+
+void BenchChezmoiOutputParser::benchmarkParserChunked_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchChezmoiOutputParser::benchmarkParserChunked()
+{
+    QFETCH(int, count);
+    const QByteArray input = SyntheticData::statusOutput(count);
+
+    // No hash inserts, fed in the chunks readyReadStandardOutput delivers
+    qsizetype parsed = 0;
+    QBENCHMARK {
+        parsed = 0;
+        ChezmoiOutputParser parser;
+        auto countLine = [&parsed](QByteArrayView line) {
+            QByteArrayView path;
+            ChezmoiStatus status;
+            if (ChezmoiOutputParser::parseStatusLine(line, &path, &status)) {
+                ++parsed;
+            }
+        };
+        const QByteArrayView output(input);
+        for (qsizetype offset = 0; offset < output.size(); offset += ChunkSize) {
+            parser.feed(output.sliced(offset, qMin(ChunkSize, output.size() - offset)), countLine);
+        }
+        parser.finish(countLine);
+    }
+    QCOMPARE(parsed, qsizetype(count));
+}
+
+void BenchChezmoiOutputParser::benchmarkManaged_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchChezmoiOutputParser::benchmarkManaged()
+{
+    QFETCH(int, count);
+    const QByteArray input = SyntheticData::managedOutput(count);
+
+    // As getManagedFiles() consumes it: lines straight into a batch's string pool, attributes come from the sources later
+    FileStatusBatch files;
+    QBENCHMARK {
+        files = FileStatusBatch(QStringLiteral("/src"), QStringLiteral("/home/user"));
+        ChezmoiOutputParser parser;
+        auto addLine = [&files](QByteArrayView line) {
+            const QByteArrayView path = ChezmoiOutputParser::parseManagedLine(line);
+            if (!path.isEmpty()) {
+                files.appendUtf8(path, ChezmoiStatus(), 0);
+            }
+        };
+        parser.feed(input, addLine);
+        parser.finish(addLine);
+    }
+    QCOMPARE(files.size(), qsizetype(count));
+}
+
+QTEST_GUILESS_MAIN(BenchChezmoiOutputParser)
+#include "bench_chezmoioutputparser.moc"
@@ -0,0 +1,52 @@
+#include <QtTest/QtTest>
+#include <QLoggingCategory>
+#include "chezmoiconfig.h"
+#include "chezmoiservice.h"
+#include "syntheticdata.h"
+
+class BenchChezmoiService : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkConvertToTargetPath_data();
+    void benchmarkConvertToTargetPath();
+};
+
+void BenchChezmoiService::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QLoggingCategory::setFilterRules(QStringLiteral("default.debug=false\ndefault.info=false"));
+}
+
+void BenchChezmoiService::benchmarkConvertToTargetPath_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchChezmoiService::benchmarkConvertToTargetPath()
+{
+    QFETCH(int, count);
+
+    // Directories come from the parsed config, so no chezmoi process is involved
+    ChezmoiService service;
+    QVERIFY(service.config()->loadFromData(QStringLiteral("sourceDir = \"/src\"\ndestDir = \"/home/user\"\n")));
+
+    QStringList sourcePaths;
+    sourcePaths.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        sourcePaths << QStringLiteral("/src/") + QString::fromUtf8(SyntheticData::sourcePath(i));
+    }
+
+    QString last;
+    QBENCHMARK {
+        for (const QString &sourcePath : std::as_const(sourcePaths)) {
+            last = service.convertToTargetPath(sourcePath);
+        }
+    }
+    QCOMPARE(last, QStringLiteral("/home/user/") + QString::fromUtf8(SyntheticData::path(count - 1)));
+}
+
+QTEST_GUILESS_MAIN(BenchChezmoiService)
+#include "bench_chezmoiservice.moc"
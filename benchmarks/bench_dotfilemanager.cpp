@@ -0,0 +1,163 @@
+#include <QtTest/QtTest>
+#include <QImage>
+#include <QLoggingCategory>
+#include <QTreeView>
+#include "dotfilemanager.h"
+#include "memoryregistry.h"
+#include "syntheticdata.h"
+
+namespace {
+
+// Roughly a maximized main window
+constexpr int ViewWidth = 1600;
+constexpr int ViewHeight = 1000;
+
+// Budget for what the tree and the inventory batch may each hold per managed file
+constexpr qint64 MaxTreeBytesPerFile = 1024;
+constexpr qint64 MaxBatchBytesPerFile = 256;
+
+FileStatusBatch makeInventory(int count)
+{
+    FileStatusBatch files(QStringLiteral("/src"), QStringLiteral("/home/user"));
+    files.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const QByteArray path = SyntheticData::path(i);
+        // Most files are clean, as in a real tree
+        const ChezmoiStatus status = i % 20 == 0 ? ChezmoiStatus(ChezmoiStatus::NoChange, ChezmoiStatus::Modified)
+                                                 : ChezmoiStatus();
+        files.appendUtf8(path, status, SyntheticData::isTemplate(i) ? FileStatusBatch::Template : 0);
+    }
+    return files;
+}
+
+// Touches every row the way a view does: index, parent and the display text of each column
+qsizetype traverse(const QAbstractItemModel &model, const QModelIndex &parent)
+{
+    qsizetype visited = 0;
+    const int rows = model.rowCount(parent);
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < model.columnCount(parent); ++column) {
+            const QModelIndex index = model.index(row, column, parent);
+            if (model.parent(index) != parent) {
+                return -1;
+            }
+            model.data(index, Qt::DisplayRole);
+            model.data(index, Qt::ForegroundRole);
+        }
+        visited += 1 + traverse(model, model.index(row, 0, parent));
+    }
+    return visited;
+}
+
+}
+
+class BenchDotfileManager : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkBuildTree_data();
+    void benchmarkBuildTree();
+    void benchmarkTraversal_data();
+    void benchmarkTraversal();
+    void benchmarkPaint_data();
+    void benchmarkPaint();
+    void benchmarkMemoryPerFile_data();
+    void benchmarkMemoryPerFile();
+};
+
+void BenchDotfileManager::initTestCase()
+{
+    // The model logs every file it adds; keep the console out of the measurements
+    QLoggingCategory::setFilterRules(QStringLiteral("default.debug=false\ndefault.info=false"));
+}
+
+void BenchDotfileManager::benchmarkBuildTree_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchDotfileManager::benchmarkBuildTree()
+{
+    QFETCH(int, count);
+    const FileStatusBatch files = makeInventory(count);
+
+    DotfileManager manager;
+    QBENCHMARK {
+        manager.setInventory(files);
+    }
+    QCOMPARE(manager.fileCount(), count);
+}
+
+void BenchDotfileManager::benchmarkTraversal_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchDotfileManager::benchmarkTraversal()
+{
+    QFETCH(int, count);
+    DotfileManager manager;
+    manager.setInventory(makeInventory(count));
+
+    qsizetype visited = 0;
+    QBENCHMARK {
+        visited = traverse(manager, QModelIndex());
+    }
+    QVERIFY(visited > count);
+}
+
+void BenchDotfileManager::benchmarkPaint_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchDotfileManager::benchmarkPaint()
+{
+    QFETCH(int, count);
+    DotfileManager manager;
+    manager.setInventory(makeInventory(count));
+
+    // Set up like MainWindow's file tree
+    QTreeView view;
+    view.setIndentation(15);
+    view.setModel(&manager);
+    view.resize(ViewWidth, ViewHeight);
+    view.expandAll();
+    view.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&view));
+
+    // One full repaint of everything on screen, details columns included
+    QImage image(view.size(), QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        view.render(&image);
+    }
+}
+
+void BenchDotfileManager::benchmarkMemoryPerFile_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchDotfileManager::benchmarkMemoryPerFile()
+{
+    QFETCH(int, count);
+    const FileStatusBatch files = makeInventory(count);
+    DotfileManager manager;
+    manager.setInventory(files);
+
+    // Read through the registry, as the log viewer does
+    const MemoryRegistry::Usage tree = MemoryRegistry::instance()->usage(QStringLiteral("File tree"));
+    const qint64 treeBytesPerFile = tree.bytes / count;
+    const qint64 batchBytesPerFile = files.byteSize() / count;
+    QTest::setBenchmarkResult(treeBytesPerFile, QTest::BytesAllocated);
+    qInfo("%lld tree bytes and %lld batch bytes per file, %lld tree nodes", treeBytesPerFile, batchBytesPerFile, tree.objects);
+
+    QVERIFY(tree.objects > count);
+    QVERIFY2(treeBytesPerFile <= MaxTreeBytesPerFile, qPrintable(QString::number(treeBytesPerFile)));
+    QVERIFY2(batchBytesPerFile <= MaxBatchBytesPerFile, qPrintable(QString::number(batchBytesPerFile)));
+}
+
+QTEST_MAIN(BenchDotfileManager)
+#include "bench_dotfilemanager.moc"
@@ -0,0 +1,242 @@
+#include <QtTest/QtTest>
+#include <QAction>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QTabWidget>
+#include <QTemporaryDir>
+#include <QTreeView>
+#include <KActionCollection>
+#include <memory>
+#include "dotfilemanager.h"
+#include "filetab.h"
+#include "mainwindow.h"
+#include "syntheticdata.h"
+
+namespace {
+
+// Managed files in the generated tree, unless DOTWEAVER_HARNESS_FILES says otherwise
+constexpr int DefaultFileCount = 2000;
+
+// How long any one step may take before the run counts as hung
+constexpr int StepTimeoutMs = 60000;
+
+// Limit for one measurement: the environment variable if set, otherwise the default
+qint64 threshold(const char *variable, qint64 defaultValue)
+{
+    bool ok = false;
+    const qint64 value = qEnvironmentVariableIntValue(variable, &ok);
+    return ok ? value : defaultValue;
+}
+
+}
+
+/**
+ * @brief Times the main window's user-visible operations against a fake chezmoi
+ *
+ * Runs MainWindow headless over a generated tree of managed files and
+ * measures time to a populated tree, a manual refresh, the refresh after an
+ * apply and opening a file in a tab, along with how many chezmoi processes
+ * each one started. Each is reported as a benchmark result, so
+ * benchmark_json.py can track it, and fails when over its threshold.
+ */
+class BenchEndToEnd : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkTimeToPopulatedTree();
+    void benchmarkRefresh();
+    void benchmarkApply();
+    void benchmarkOpenTab();
+
+private:
+    void generateTree(int count);
+    int spawnCount() const;
+    void check(const char *name, qint64 elapsedMs, int spawns, const char *maxMsVariable, qint64 maxMs,
+               const char *maxSpawnsVariable, int maxSpawns);
+
+    QTemporaryDir m_root;
+    std::unique_ptr<MainWindow> m_window;
+    QList<QByteArray> m_paths;
+};
+
+void BenchEndToEnd::initTestCase()
+{
+    QVERIFY(m_root.isValid());
+
+    // Config, log and inventory cache all live in the scratch directory, so every run starts cold
+    const QDir root(m_root.path());
+    qputenv("XDG_CONFIG_HOME", root.filePath(QStringLiteral("config")).toLocal8Bit());
+    qputenv("XDG_DATA_HOME", root.filePath(QStringLiteral("data")).toLocal8Bit());
+    qputenv("XDG_CACHE_HOME", root.filePath(QStringLiteral("cache")).toLocal8Bit());
+    qputenv("DOTWEAVER_CHEZMOI", FAKE_CHEZMOI_PATH);
+    qputenv("FAKE_CHEZMOI_DIR", root.filePath(QStringLiteral("fake")).toLocal8Bit());
+    QLoggingCategory::setFilterRules(QStringLiteral("default.debug=false\ndefault.info=false"));
+
+    generateTree(threshold("DOTWEAVER_HARNESS_FILES", DefaultFileCount));
+}
+
+void BenchEndToEnd::cleanupTestCase()
+{
+    m_window.reset();
+}
+
+void BenchEndToEnd::generateTree(int count)
+{
+    const QDir root(m_root.path());
+    for (const QString &directory : {QStringLiteral("config/chezmoi"), QStringLiteral("fake"),
+                                     QStringLiteral("source"), QStringLiteral("home")}) {
+        QVERIFY(root.mkpath(directory));
+    }
+
+    auto writeFile = [](const QString &path, const QByteArray &contents) {
+        QVERIFY(QDir().mkpath(QFileInfo(path).path()));
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(contents);
+    };
+
+    writeFile(root.filePath(QStringLiteral("config/chezmoi/chezmoi.toml")),
+              QStringLiteral("sourceDir = \"%1\"\ndestDir = \"%2\"\n")
+                  .arg(root.filePath(QStringLiteral("source")), root.filePath(QStringLiteral("home"))).toUtf8());
+
+    // Real sources and targets, so the tree's metadata columns have something to stat
+    QByteArray managed;
+    QByteArray status;
+    for (int i = 0; i < count; ++i) {
+        const QByteArray path = SyntheticData::path(i);
+        m_paths << path;
+        writeFile(root.filePath(QStringLiteral("home/") + QString::fromUtf8(path)), "setting = " + QByteArray::number(i) + '\n');
+        writeFile(root.filePath(QStringLiteral("source/") + QString::fromUtf8(SyntheticData::sourcePath(i))), "setting = " + QByteArray::number(i) + '\n');
+        managed += path + '\n';
+        if (i % 20 == 0) {
+            status += " M " + path + '\n';
+        }
+    }
+    writeFile(root.filePath(QStringLiteral("fake/managed.out")), managed);
+    writeFile(root.filePath(QStringLiteral("fake/managed.source-relative.out")), SyntheticData::managedSourceOutput(count));
+    writeFile(root.filePath(QStringLiteral("fake/status.out")), status);
+
+    // Roughly what chezmoi costs on a real home directory
+    writeFile(root.filePath(QStringLiteral("fake/fakechezmoi.ini")),
+              "[managed]\nlatencyMs=50\n"
+              "[status]\nlatencyMs=300\njitterMs=50\n"
+              "[apply]\nlatencyMs=200\n");
+}
+
+int BenchEndToEnd::spawnCount() const
+{
+    QFile log(QDir(m_root.path()).filePath(QStringLiteral("fake/spawns.log")));
+    if (!log.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    return int(log.readAll().count('\n'));
+}
+
+void BenchEndToEnd::check(const char *name, qint64 elapsedMs, int spawns, const char *maxMsVariable, qint64 maxMs,
+                          const char *maxSpawnsVariable, int maxSpawns)
+{
+    QTest::setBenchmarkResult(elapsedMs, QTest::WalltimeMilliseconds);
+    qInfo("%s: %lld ms, %d chezmoi processes", name, elapsedMs, spawns);
+
+    const qint64 allowedMs = threshold(maxMsVariable, maxMs);
+    const qint64 allowedSpawns = threshold(maxSpawnsVariable, maxSpawns);
+    QVERIFY2(elapsedMs <= allowedMs,
+             qPrintable(QStringLiteral("%1 took %2 ms, limit %3 ms (%4)").arg(QLatin1String(name)).arg(elapsedMs).arg(allowedMs).arg(QLatin1String(maxMsVariable))));
+    QVERIFY2(spawns <= allowedSpawns,
+             qPrintable(QStringLiteral("%1 started %2 chezmoi processes, limit %3 (%4)").arg(QLatin1String(name)).arg(spawns).arg(allowedSpawns).arg(QLatin1String(maxSpawnsVariable))));
+}
+
+void BenchEndToEnd::benchmarkTimeToPopulatedTree()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    m_window = std::make_unique<MainWindow>();
+    QSignalSpy populated(m_window->dotfileManager(), &DotfileManager::filesRefreshed);
+    QSignalSpy resolved(m_window->dotfileManager(), &DotfileManager::statusesRefreshed);
+    m_window->resize(1280, 800);
+    m_window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(m_window.get()));
+
+    QVERIFY(populated.count() > 0 || populated.wait(StepTimeoutMs));
+    const qint64 populatedMs = timer.elapsed();
+    QCOMPARE(m_window->dotfileManager()->fileCount(), int(m_paths.size()));
+
+    // Statuses come in a second pass; wait for them so later steps start from a settled window
+    QVERIFY(resolved.count() > 0 || resolved.wait(StepTimeoutMs));
+
+    check("Time to populated tree", populatedMs, spawnCount(),
+          "DOTWEAVER_MAX_POPULATE_MS", 5000, "DOTWEAVER_MAX_POPULATE_SPAWNS", 4);
+}
+
+void BenchEndToEnd::benchmarkRefresh()
+{
+    QVERIFY(m_window);
+    const int spawnsBefore = spawnCount();
+    QSignalSpy resolved(m_window->dotfileManager(), &DotfileManager::statusesRefreshed);
+
+    QElapsedTimer timer;
+    timer.start();
+    m_window->actionCollection()->action(QStringLiteral("refresh"))->trigger();
+    QVERIFY(resolved.wait(StepTimeoutMs));
+
+    check("Refresh", timer.elapsed(), spawnCount() - spawnsBefore,
+          "DOTWEAVER_MAX_REFRESH_MS", 3000, "DOTWEAVER_MAX_REFRESH_SPAWNS", 3);
+}
+
+void BenchEndToEnd::benchmarkApply()
+{
+    QVERIFY(m_window);
+    const int spawnsBefore = spawnCount();
+    QSignalSpy resolved(m_window->dotfileManager(), &DotfileManager::statusesRefreshed);
+
+    // From 'chezmoi apply' starting until the tree shows the statuses that follow it
+    QElapsedTimer timer;
+    timer.start();
+    m_window->actionCollection()->action(QStringLiteral("sync"))->trigger();
+    QVERIFY(resolved.wait(StepTimeoutMs));
+
+    check("Refresh after apply", timer.elapsed(), spawnCount() - spawnsBefore,
+          "DOTWEAVER_MAX_APPLY_MS", 4000, "DOTWEAVER_MAX_APPLY_SPAWNS", 3);
+}
+
+void BenchEndToEnd::benchmarkOpenTab()
+{
+    QVERIFY(m_window);
+    auto *tree = m_window->findChild<QTreeView *>();
+    auto *tabs = m_window->findChild<QTabWidget *>();
+    QVERIFY(tree && tabs);
+
+    // The first file at the top level, as a user would double-click it in the (unfiltered) view
+    QAbstractItemModel *model = tree->model();
+    QModelIndex file;
+    for (int row = 0; row < model->rowCount() && !file.isValid(); ++row) {
+        const QModelIndex index = model->index(row, 0);
+        if (model->rowCount(index) == 0) {
+            file = index;
+        }
+    }
+    QVERIFY(file.isValid());
+
+    const int spawnsBefore = spawnCount();
+    const int tabsBefore = tabs->count();
+    QElapsedTimer timer;
+    timer.start();
+    Q_EMIT tree->doubleClicked(file);
+    QTRY_COMPARE_WITH_TIMEOUT(tabs->count(), tabsBefore + 1, StepTimeoutMs);
+    auto *tab = qobject_cast<FileTab *>(tabs->currentWidget());
+    QVERIFY(tab);
+    QVERIFY(QTest::qWaitForWindowExposed(m_window.get()));
+    QTRY_VERIFY_WITH_TIMEOUT(tab->isVisible(), StepTimeoutMs);
+    QCoreApplication::processEvents();
+
+    check("Open tab", timer.elapsed(), spawnCount() - spawnsBefore,
+          "DOTWEAVER_MAX_OPEN_TAB_MS", 1500, "DOTWEAVER_MAX_OPEN_TAB_SPAWNS", 1);
+}
+
+QTEST_MAIN(BenchEndToEnd)
+#include "bench_endtoend.moc"
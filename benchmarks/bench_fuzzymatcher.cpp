@@ -0,0 +1,116 @@
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+#include "fuzzymatcher.h"
+#include "syntheticdata.h"
+
+namespace {
+// What a user types, one keystroke at a time, to find .config/app12/sub5/settings-1212.conf
+constexpr QStringView TypedQuery = u"app12settings1212";
+
+// Rows the quick open palette asks for
+constexpr qsizetype ResultLimit = 200;
+
+// One frame at 60 Hz, unless DOTWEAVER_MAX_KEYSTROKE_MS says otherwise
+constexpr qint64 DefaultKeystrokeBudgetMs = 16;
+}
+
+class BenchFuzzyMatcher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkBuildIndex_data();
+    void benchmarkBuildIndex();
+    void benchmarkTyping_data();
+    void benchmarkTyping();
+    void benchmarkSlowestKeystroke_data();
+    void benchmarkSlowestKeystroke();
+
+private:
+    static QStringList paths(int count);
+};
+
+QStringList BenchFuzzyMatcher::paths(int count)
+{
+    QStringList result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        result << QString::fromUtf8(SyntheticData::path(i));
+    }
+    return result;
+}
+
+void BenchFuzzyMatcher::benchmarkBuildIndex_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchFuzzyMatcher::benchmarkBuildIndex()
+{
+    QFETCH(int, count);
+    const QStringList input = paths(count);
+
+    FuzzyMatcher matcher;
+    QBENCHMARK {
+        matcher.setPaths(input);
+    }
+    QCOMPARE(matcher.size(), qsizetype(count));
+}
+
+void BenchFuzzyMatcher::benchmarkTyping_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchFuzzyMatcher::benchmarkTyping()
+{
+    QFETCH(int, count);
+    FuzzyMatcher matcher;
+    matcher.setPaths(paths(count));
+
+    // The whole query typed out, each prefix searched as the palette does on textChanged
+    QList<FuzzyMatcher::Match> matches;
+    QBENCHMARK {
+        matcher.match(QStringView(), ResultLimit);
+        for (qsizetype length = 1; length <= TypedQuery.size(); ++length) {
+            matches = matcher.match(TypedQuery.first(length), ResultLimit);
+        }
+    }
+    if (count > 1212) {
+        QVERIFY(!matches.isEmpty());
+        QCOMPARE(matcher.path(matches.first().index), QStringLiteral(".config/app12/sub1/settings-1212.conf"));
+    }
+}
+
+void BenchFuzzyMatcher::benchmarkSlowestKeystroke_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchFuzzyMatcher::benchmarkSlowestKeystroke()
+{
+    QFETCH(int, count);
+    FuzzyMatcher matcher;
+    matcher.setPaths(paths(count));
+
+    // The first character scans every path, so it is usually the one at risk of missing a frame
+    qint64 slowestNs = 0;
+    for (qsizetype length = 1; length <= TypedQuery.size(); ++length) {
+        QElapsedTimer timer;
+        timer.start();
+        matcher.match(TypedQuery.first(length), ResultLimit);
+        slowestNs = qMax(slowestNs, timer.nsecsElapsed());
+    }
+    QTest::setBenchmarkResult(slowestNs / 1e6, QTest::WalltimeMilliseconds);
+
+    bool ok = false;
+    qint64 budgetMs = qEnvironmentVariableIntValue("DOTWEAVER_MAX_KEYSTROKE_MS", &ok);
+    if (!ok) {
+        budgetMs = DefaultKeystrokeBudgetMs;
+    }
+    QVERIFY2(slowestNs <= budgetMs * 1000000,
+             qPrintable(QStringLiteral("slowest keystroke took %1 ms, limit %2 ms").arg(slowestNs / 1e6).arg(budgetMs)));
+}
+
+QTEST_GUILESS_MAIN(BenchFuzzyMatcher)
+#include "bench_fuzzymatcher.moc"
@@ -0,0 +1,85 @@
+#include <QtTest/QtTest>
+#include "ignorematcher.h"
+#include "syntheticdata.h"
+
+namespace {
+// Exact entries in the rendered .chezmoiignore, besides the globs every real one has
+constexpr int ExactPatterns = 100;
+}
+
+class BenchIgnoreMatcher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void benchmarkCompile();
+    void benchmarkClassify_data();
+    void benchmarkClassify();
+
+private:
+    static QString ignoreText();
+    static QStringList paths(int count);
+};
+
+QString BenchIgnoreMatcher::ignoreText()
+{
+    // Mostly literal paths, as per-machine blocks of a templated .chezmoiignore tend to be
+    QString text = QStringLiteral(
+        "README.md\n"
+        "*.txt\n"
+        "**/*.bak\n"
+        ".cache/**\n"
+        ".config/app1?/sub{2,3}\n"
+        ".config/app2*/**/settings-*[05].conf\n"
+        "!.config/app20/sub5\n"
+        ".local/share/[a-m]*/**\n");
+    for (int i = 0; i < ExactPatterns; ++i) {
+        text += QStringLiteral(".config/app%1/sub%2\n").arg(i * 3).arg(i % 7);
+    }
+    return text;
+}
+
+QStringList BenchIgnoreMatcher::paths(int count)
+{
+    QStringList result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        result << QString::fromUtf8(SyntheticData::path(i));
+    }
+    return result;
+}
+
+void BenchIgnoreMatcher::benchmarkCompile()
+{
+    const QString text = ignoreText();
+    IgnoreMatcher matcher;
+    QBENCHMARK {
+        matcher.compile(text);
+    }
+    QCOMPARE(matcher.patternCount(), qsizetype(8 + ExactPatterns));
+}
+
+void BenchIgnoreMatcher::benchmarkClassify_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchIgnoreMatcher::benchmarkClassify()
+{
+    QFETCH(int, count);
+    const QStringList input = paths(count);
+    IgnoreMatcher matcher;
+    matcher.compile(ignoreText());
+
+    // What the file watcher or an "Add to chezmoi" listing would ask for a whole directory tree
+    QList<bool> ignored;
+    QBENCHMARK {
+        ignored = matcher.classify(input);
+    }
+    QCOMPARE(ignored.size(), qsizetype(count));
+    QVERIFY(ignored.contains(true));
+    QVERIFY(ignored.contains(false));
+}
+
+QTEST_GUILESS_MAIN(BenchIgnoreMatcher)
+#include "bench_ignorematcher.moc"
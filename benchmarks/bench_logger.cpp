@@ -0,0 +1,53 @@
+#include <QtTest/QtTest>
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+#include "logger.h"
+#include "syntheticdata.h"
+
+class BenchLogger : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkDebug_data();
+    void benchmarkDebug();
+
+private:
+    QTemporaryDir m_logDir;
+};
+
+void BenchLogger::initTestCase()
+{
+    // The log file goes to a scratch directory; console output is not part of the measurement
+    QVERIFY(m_logDir.isValid());
+    qputenv("XDG_DATA_HOME", m_logDir.path().toLocal8Bit());
+    QLoggingCategory::setFilterRules(QStringLiteral("default.debug=false\ndefault.info=false"));
+}
+
+void BenchLogger::benchmarkDebug_data()
+{
+    SyntheticData::addSizes();
+}
+
+void BenchLogger::benchmarkDebug()
+{
+    QFETCH(int, count);
+
+    QStringList paths;
+    paths.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        paths << QString::fromUtf8(SyntheticData::path(i));
+    }
+
+    // The message DotfileManager logs for every file it adds to the tree
+    QBENCHMARK {
+        for (const QString &path : std::as_const(paths)) {
+            LOG_DEBUG(QStringLiteral("DotfileManager: Adding file to tree: %1").arg(path));
+        }
+    }
+    QVERIFY(QFileInfo(Logger::instance()->getLogFilePath()).size() > 0);
+}
+
+QTEST_GUILESS_MAIN(BenchLogger)
+#include "bench_logger.moc"
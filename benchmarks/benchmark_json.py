@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""Run the QBENCHMARK executables and write or compare their results as JSON.
+
+    benchmark_json.py run build/benchmarks/bench_* > current.json
+    benchmark_json.py compare baseline.json current.json [--threshold 0.10]
+
+Each result is keyed "executable/function:tag" and holds the metric, the
+value per iteration and the iteration count. compare exits with status 1
+when any benchmark got slower than the threshold allows.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import xml.etree.ElementTree as ElementTree
+
+
+def run_benchmarks(executables):
+    results = {}
+    environment = dict(os.environ, QT_QPA_PLATFORM=os.environ.get("QT_QPA_PLATFORM", "offscreen"))
+    for executable in executables:
+        name = os.path.basename(executable)
+        with tempfile.NamedTemporaryFile(suffix=".xml") as output:
+            subprocess.run([executable, "-o", output.name + ",xml"], env=environment, check=True)
+            root = ElementTree.parse(output.name).getroot()
+        for function in root.iter("TestFunction"):
+            for result in function.iter("BenchmarkResult"):
+                key = "%s/%s:%s" % (name, function.get("name"), result.get("tag", ""))
+                results[key] = {
+                    "metric": result.get("metric"),
+                    "value": float(result.get("value")),
+                    "iterations": int(result.get("iterations")),
+                }
+    return {"benchmarks": results}
+
+
+def compare(baseline, current, threshold):
+    regressions = 0
+    for key, result in sorted(current["benchmarks"].items()):
+        before = baseline["benchmarks"].get(key)
+        if before is None or before["metric"] != result["metric"] or before["value"] <= 0:
+            print("%-70s %14.4f  (new)" % (key, result["value"]))
+            continue
+        change = result["value"] / before["value"] - 1.0
+        regressed = change > threshold
+        regressions += regressed
+        print("%-70s %14.4f %+8.1f%%%s" % (key, result["value"], change * 100, "  REGRESSED" if regressed else ""))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+    run = commands.add_parser("run")
+    run.add_argument("executables", nargs="+")
+    diff = commands.add_parser("compare")
+    diff.add_argument("baseline")
+    diff.add_argument("current")
+    diff.add_argument("--threshold", type=float, default=0.10, help="allowed slowdown, 0.10 = 10%%")
+    arguments = parser.parse_args()
+
+    if arguments.command == "run":
+        json.dump(run_benchmarks(arguments.executables), sys.stdout, indent=2, sort_keys=True)
+        print()
+        return 0
+
+    with open(arguments.baseline) as baseline, open(arguments.current) as current:
+        regressions = compare(json.load(baseline), json.load(current), arguments.threshold)
+    if regressions:
+        print("%d benchmark(s) regressed by more than %.0f%%" % (regressions, arguments.threshold * 100))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
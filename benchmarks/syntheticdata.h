@@ -0,0 +1,92 @@
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include <QByteArray>
+#include <QtTest/QtTest>
+
+/**
+ * @brief Generated dotfile inventories for the benchmarks
+ *
+ * Paths spread over a few hundred application directories a couple of
+ * levels deep, roughly like a large real home directory, and are the same
+ * on every run so results can be compared.
+ */
+namespace SyntheticData {
+
+// Sizes every scalable benchmark runs at
+inline void addSizes()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+}
+
+// Target path relative to the destination directory, as chezmoi lists it
+inline QByteArray path(int i)
+{
+    if (i % 50 == 0) {
+        return ".dotfile-" + QByteArray::number(i);
+    }
+    return ".config/app" + QByteArray::number(i % 300) + "/sub" + QByteArray::number(i % 7)
+        + "/settings-" + QByteArray::number(i) + ".conf";
+}
+
+inline bool isTemplate(int i)
+{
+    return i % 10 == 0;
+}
+
+// Source path relative to the source directory, with the attributes chezmoi strips from the target
+inline QByteArray sourcePath(int i)
+{
+    const QByteArray suffix = isTemplate(i) ? ".tmpl" : "";
+    if (i % 50 == 0) {
+        return "dot_dotfile-" + QByteArray::number(i) + suffix;
+    }
+    return (i % 3 == 0 ? "dot_config/private_app" : "dot_config/app") + QByteArray::number(i % 300)
+        + "/sub" + QByteArray::number(i % 7) + "/settings-" + QByteArray::number(i) + ".conf" + suffix;
+}
+
+// 'chezmoi managed --exclude=dirs' output
+inline QByteArray managedOutput(int count)
+{
+    QByteArray output;
+    output.reserve(qsizetype(count) * 40);
+    for (int i = 0; i < count; ++i) {
+        output += path(i);
+        output += '\n';
+    }
+    return output;
+}
+
+// 'chezmoi managed --exclude=dirs --path-style=source-relative' output
+inline QByteArray managedSourceOutput(int count)
+{
+    QByteArray output;
+    output.reserve(qsizetype(count) * 48);
+    for (int i = 0; i < count; ++i) {
+        output += sourcePath(i);
+        output += '\n';
+    }
+    return output;
+}
+
+// 'chezmoi status' output with every file listed
+inline QByteArray statusOutput(int count)
+{
+    static const char *const codes[] = {" M", " A", "MM", "D ", "R "};
+    QByteArray output;
+    output.reserve(qsizetype(count) * 44);
+    for (int i = 0; i < count; ++i) {
+        output += codes[i % 5];
+        output += ' ';
+        output += path(i);
+        output += '\n';
+    }
+    return output;
+}
+
+}
+
+#endif // SYNTHETICDATA_H
@@ -0,0 +1,248 @@
+#include "boltdatabase.h"
+#include "logger.h"
+
+#include <QFile>
+#include <QtEndian>
+
+#include <cstring>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// bbolt writes its structures in host byte order with no padding; these are their byte layouts
+constexpr qint64 PageHeaderSize = 16;   // id u64, flags u16, count u16, overflow u32
+constexpr qint64 ElementSize = 16;      // branch: pos, ksize, pgid; leaf: flags, pos, ksize, vsize
+constexpr qint64 BucketHeaderSize = 16; // root pgid u64, sequence u64
+constexpr qint64 MetaSize = 64;
+constexpr qint64 MetaChecksumOffset = 56;
+
+constexpr quint16 BranchPageFlag = 0x01;
+constexpr quint16 LeafPageFlag = 0x02;
+constexpr quint16 MetaPageFlag = 0x04;
+constexpr quint32 BucketLeafFlag = 0x01;
+
+constexpr quint32 BoltMagic = 0xED0CDAED;
+constexpr quint32 BoltVersion = 2;
+
+// Corrupt files could otherwise send the walk round in circles
+constexpr int MaxTreeDepth = 64;
+
+template<typename T>
+T read(const uchar *data)
+{
+    return qFromUnaligned<T>(data);
+}
+
+quint64 fnv1a(const uchar *data, qint64 size)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for (qint64 i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+}
+
+BoltDatabase::BoltDatabase(const QString &filePath)
+    : m_file(std::make_unique<QFile>(filePath))
+    , m_data(nullptr)
+    , m_size(0)
+    , m_pageSize(0)
+    , m_rootBucket(0)
+    , m_txid(0)
+{
+    if (!m_file->open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    m_size = m_file->size();
+    if (m_size < PageHeaderSize + MetaSize) {
+        LOG_WARNING(QStringLiteral("BoltDatabase: %1 is too small to be a bbolt database").arg(filePath));
+        return;
+    }
+
+    m_data = m_file->map(0, m_size);
+    if (!m_data) {
+        LOG_WARNING(QStringLiteral("BoltDatabase: cannot map %1: %2").arg(filePath, m_file->errorString()));
+        return;
+    }
+
+    // Two meta pages alternate between commits; the second sits one page after the first
+    quint32 pageSize = 0;
+    quint64 root = 0;
+    quint64 txid = 0;
+    const bool firstValid = readMeta(0, &pageSize, &root, &txid);
+    if (firstValid) {
+        m_pageSize = pageSize;
+        m_rootBucket = root;
+        m_txid = txid;
+    }
+
+    const qint64 secondOffset = firstValid ? pageSize : 4096;
+    if (readMeta(secondOffset, &pageSize, &root, &txid) && (!firstValid || txid > m_txid)) {
+        m_pageSize = pageSize;
+        m_rootBucket = root;
+        m_txid = txid;
+    }
+
+    if (m_pageSize == 0) {
+        LOG_WARNING(QStringLiteral("BoltDatabase: %1 has no valid meta page").arg(filePath));
+        m_file->unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+}
+
+BoltDatabase::~BoltDatabase() = default;
+
+bool BoltDatabase::isValid() const
+{
+    return m_data && m_pageSize > 0;
+}
+
+quint64 BoltDatabase::transactionId() const
+{
+    return m_txid;
+}
+
+bool BoltDatabase::readMeta(qint64 offset, quint32 *pageSize, quint64 *root, quint64 *txid) const
+{
+    if (offset + PageHeaderSize + MetaSize > m_size) {
+        return false;
+    }
+
+    const uchar *page = m_data + offset;
+    if (!(read<quint16>(page + 8) & MetaPageFlag)) {
+        return false;
+    }
+
+    const uchar *meta = page + PageHeaderSize;
+    if (read<quint32>(meta) != BoltMagic || read<quint32>(meta + 4) != BoltVersion) {
+        return false;
+    }
+    if (fnv1a(meta, MetaChecksumOffset) != read<quint64>(meta + MetaChecksumOffset)) {
+        return false;
+    }
+
+    *pageSize = read<quint32>(meta + 8);
+    *root = read<quint64>(meta + 16);
+    *txid = read<quint64>(meta + 48);
+    return *pageSize >= 512 && (*pageSize & (*pageSize - 1)) == 0;
+}
+
+bool BoltDatabase::page(quint64 id, const uchar **data, qint64 *size) const
+{
+    const quint64 offset = id * m_pageSize;
+    if (id == 0 || offset / m_pageSize != id || offset + PageHeaderSize > quint64(m_size)) {
+        return false;
+    }
+
+    *data = m_data + offset;
+    const quint64 span = (quint64(read<quint32>(*data + 12)) + 1) * m_pageSize;
+    *size = qint64(qMin<quint64>(span, quint64(m_size) - offset));
+    return true;
+}
+
+bool BoltDatabase::visitPage(const uchar *data, qint64 size, const ElementVisitor &visitor, int depth) const
+{
+    if (depth > MaxTreeDepth || size < PageHeaderSize) {
+        return false;
+    }
+
+    const quint16 flags = read<quint16>(data + 8);
+    const quint16 count = read<quint16>(data + 10);
+    if (PageHeaderSize + qint64(count) * ElementSize > size) {
+        return false;
+    }
+
+    // Element positions are relative to the element itself
+    for (quint16 i = 0; i < count; ++i) {
+        const uchar *element = data + PageHeaderSize + qint64(i) * ElementSize;
+        const qint64 elementOffset = element - data;
+
+        if (flags & BranchPageFlag) {
+            const quint32 position = read<quint32>(element);
+            const quint32 keySize = read<quint32>(element + 4);
+            if (elementOffset + qint64(position) + keySize > size) {
+                return false;
+            }
+            const uchar *child = nullptr;
+            qint64 childSize = 0;
+            if (!page(read<quint64>(element + 8), &child, &childSize)
+                || !visitPage(child, childSize, visitor, depth + 1)) {
+                return false;
+            }
+        } else if (flags & LeafPageFlag) {
+            const quint32 elementFlags = read<quint32>(element);
+            const quint32 position = read<quint32>(element + 4);
+            const quint32 keySize = read<quint32>(element + 8);
+            const quint32 valueSize = read<quint32>(element + 12);
+            if (elementOffset + qint64(position) + keySize + valueSize > size) {
+                return false;
+            }
+            const uchar *key = element + position;
+            visitor(key, keySize, key + keySize, valueSize, elementFlags & BucketLeafFlag);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BoltDatabase::visitBucket(const Bucket &bucket, const ElementVisitor &visitor) const
+{
+    if (bucket.inlinePage) {
+        return visitPage(bucket.inlinePage, bucket.inlineSize, visitor, 0);
+    }
+
+    const uchar *data = nullptr;
+    qint64 size = 0;
+    return page(bucket.root, &data, &size) && visitPage(data, size, visitor, 0);
+}
+
+bool BoltDatabase::findBucket(const Bucket &parent, const QByteArray &name, Bucket *bucket) const
+{
+    bool found = false;
+    const bool ok = visitBucket(parent, [&](const uchar *key, quint32 keySize, const uchar *value, quint32 valueSize, bool isBucket) {
+        if (found || !isBucket || keySize != quint32(name.size()) || valueSize < BucketHeaderSize
+            || std::memcmp(key, name.constData(), keySize) != 0) {
+            return;
+        }
+        found = true;
+        bucket->root = read<quint64>(value);
+        if (bucket->root == 0) {
+            // Small buckets are stored as a page image right after their header
+            bucket->inlinePage = value + BucketHeaderSize;
+            bucket->inlineSize = valueSize - BucketHeaderSize;
+        }
+    });
+    return ok && found;
+}
+
+bool BoltDatabase::forEach(const QList<QByteArray> &bucketPath, const Visitor &visitor) const
+{
+    if (!isValid()) {
+        return false;
+    }
+
+    Bucket bucket;
+    bucket.root = m_rootBucket;
+    for (const QByteArray &name : bucketPath) {
+        Bucket child;
+        if (!findBucket(bucket, name, &child)) {
+            return false;
+        }
+        bucket = child;
+    }
+
+    const bool ok = visitBucket(bucket, [&visitor](const uchar *key, quint32 keySize, const uchar *value, quint32 valueSize, bool isBucket) {
+        if (!isBucket) {
+            visitor(QByteArray(reinterpret_cast<const char *>(key), keySize),
+                    QByteArray(reinterpret_cast<const char *>(value), valueSize));
+        }
+    });
+    if (!ok) {
+        LOG_WARNING(QStringLiteral("BoltDatabase: corrupt page in %1").arg(m_file->fileName()));
+    }
+    return ok;
+}
@@ -0,0 +1,62 @@
+#ifndef BOLTDATABASE_H
+#define BOLTDATABASE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <functional>
+#include <memory>
+
+class QFile;
+
+/**
+ * @brief Read-only, in-process reader for bbolt database files
+ *
+ * Maps the file and walks its B+tree pages directly, without taking bbolt's
+ * file lock. bbolt never overwrites pages reachable from the newest committed
+ * meta page, so the meta page with the highest transaction id and a valid
+ * checksum always describes a consistent snapshot.
+ *
+ * The mapping is read-only, so const methods may be called from several threads.
+ */
+class BoltDatabase
+{
+public:
+    using Visitor = std::function<void(const QByteArray &key, const QByteArray &value)>;
+
+    explicit BoltDatabase(const QString &filePath);
+    ~BoltDatabase();
+
+    BoltDatabase(const BoltDatabase &) = delete;
+    BoltDatabase &operator=(const BoltDatabase &) = delete;
+
+    bool isValid() const;
+    quint64 transactionId() const;
+
+    /** Visits the plain key/value pairs of a (nested) bucket; nested buckets are skipped */
+    bool forEach(const QList<QByteArray> &bucketPath, const Visitor &visitor) const;
+
+private:
+    struct Bucket {
+        quint64 root = 0;
+        const uchar *inlinePage = nullptr; // set instead of root for buckets stored inside their parent's leaf
+        qint64 inlineSize = 0;
+    };
+
+    using ElementVisitor = std::function<void(const uchar *key, quint32 keySize, const uchar *value, quint32 valueSize, bool isBucket)>;
+
+    bool readMeta(qint64 offset, quint32 *pageSize, quint64 *root, quint64 *txid) const;
+    bool page(quint64 id, const uchar **data, qint64 *size) const;
+    bool visitPage(const uchar *data, qint64 size, const ElementVisitor &visitor, int depth) const;
+    bool visitBucket(const Bucket &bucket, const ElementVisitor &visitor) const;
+    bool findBucket(const Bucket &parent, const QByteArray &name, Bucket *bucket) const;
+
+    std::unique_ptr<QFile> m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    quint32 m_pageSize;
+    quint64 m_rootBucket;
+    quint64 m_txid;
+};
+
+#endif // BOLTDATABASE_H
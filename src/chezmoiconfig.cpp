@@ -0,0 +1,873 @@
+#include "chezmoiconfig.h"
+#include "logger.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QLocale>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+
+// A small TOML reader covering what chezmoi configurations use. Arrays and
+// inline tables are validated and kept verbatim but not exposed as values.
+
+bool isBareKeyChar(QChar c)
+{
+    return (c >= u'a' && c <= u'z') || (c >= u'A' && c <= u'Z') || (c >= u'0' && c <= u'9') || c == u'_' || c == u'-';
+}
+
+void skipBlanks(QStringView text, qsizetype &pos)
+{
+    while (pos < text.size() && (text[pos] == u' ' || text[pos] == u'\t')) {
+        ++pos;
+    }
+}
+
+bool parseEscape(QStringView text, qsizetype &pos, QString *out)
+{
+    if (pos + 1 >= text.size()) {
+        return false;
+    }
+
+    const QChar escape = text[pos + 1];
+    pos += 2;
+    switch (escape.unicode()) {
+    case 'b': out->append(u'\b'); return true;
+    case 't': out->append(u'\t'); return true;
+    case 'n': out->append(u'\n'); return true;
+    case 'f': out->append(u'\f'); return true;
+    case 'r': out->append(u'\r'); return true;
+    case '"': out->append(u'"'); return true;
+    case '\\': out->append(u'\\'); return true;
+    case 'u':
+    case 'U': {
+        const qsizetype length = escape == u'u' ? 4 : 8;
+        if (pos + length > text.size()) {
+            return false;
+        }
+        bool ok = false;
+        const char32_t codePoint = text.mid(pos, length).toUInt(&ok, 16);
+        if (!ok) {
+            return false;
+        }
+        pos += length;
+        out->append(QString::fromUcs4(&codePoint, 1));
+        return true;
+    }
+    }
+    return false;
+}
+
+bool parseBasicString(QStringView text, qsizetype &pos, QString *out)
+{
+    ++pos;
+    while (pos < text.size()) {
+        const QChar c = text[pos];
+        if (c == u'"') {
+            ++pos;
+            return true;
+        }
+        if (c == u'\n') {
+            return false;
+        }
+        if (c == u'\\') {
+            if (!parseEscape(text, pos, out)) {
+                return false;
+            }
+            continue;
+        }
+        out->append(c);
+        ++pos;
+    }
+    return false;
+}
+
+bool parseLiteralString(QStringView text, qsizetype &pos, QString *out)
+{
+    const qsizetype start = ++pos;
+    while (pos < text.size() && text[pos] != u'\'') {
+        if (text[pos] == u'\n') {
+            return false;
+        }
+        ++pos;
+    }
+    if (pos >= text.size()) {
+        return false;
+    }
+    *out = text.mid(start, pos - start).toString();
+    ++pos;
+    return true;
+}
+
+bool parseMultilineString(QStringView text, qsizetype &pos, QString *out)
+{
+    const QChar quote = text[pos];
+    const bool literal = quote == u'\'';
+    pos += 3;
+
+    // A newline directly after the opening delimiter is not part of the string
+    if (text.mid(pos, 2) == QStringView(u"\r\n")) {
+        pos += 2;
+    } else if (pos < text.size() && text[pos] == u'\n') {
+        ++pos;
+    }
+
+    while (pos < text.size()) {
+        const QChar c = text[pos];
+        if (c == quote && pos + 2 < text.size() && text[pos + 1] == quote && text[pos + 2] == quote) {
+            // Up to two quotes may sit right before the closing delimiter
+            while (pos + 3 < text.size() && text[pos + 3] == quote) {
+                out->append(quote);
+                ++pos;
+            }
+            pos += 3;
+            return true;
+        }
+        if (!literal && c == u'\\') {
+            // A line-ending backslash swallows the newline and the indentation after it
+            qsizetype next = pos + 1;
+            skipBlanks(text, next);
+            if (next < text.size() && (text[next] == u'\n' || text[next] == u'\r')) {
+                pos = next;
+                while (pos < text.size() && text[pos].isSpace()) {
+                    ++pos;
+                }
+                continue;
+            }
+            if (!parseEscape(text, pos, out)) {
+                return false;
+            }
+            continue;
+        }
+        out->append(c);
+        ++pos;
+    }
+    return false;
+}
+
+bool isMultilineDelimiter(QStringView text, qsizetype pos)
+{
+    return text.mid(pos, 3) == QStringView(u"\"\"\"") || text.mid(pos, 3) == QStringView(u"'''");
+}
+
+bool parseString(QStringView text, qsizetype &pos, QString *out)
+{
+    if (isMultilineDelimiter(text, pos)) {
+        return parseMultilineString(text, pos, out);
+    }
+    return text[pos] == u'"' ? parseBasicString(text, pos, out) : parseLiteralString(text, pos, out);
+}
+
+// Arrays and inline tables may nest and span several lines
+bool skipCompound(QStringView text, qsizetype &pos)
+{
+    int depth = 0;
+    while (pos < text.size()) {
+        const QChar c = text[pos];
+        if (c == u'[' || c == u'{') {
+            ++depth;
+            ++pos;
+        } else if (c == u']' || c == u'}') {
+            ++pos;
+            if (--depth == 0) {
+                return true;
+            }
+        } else if (c == u'"' || c == u'\'') {
+            QString ignored;
+            if (!parseString(text, pos, &ignored)) {
+                return false;
+            }
+        } else if (c == u'#') {
+            while (pos < text.size() && text[pos] != u'\n') {
+                ++pos;
+            }
+        } else {
+            ++pos;
+        }
+    }
+    return false;
+}
+
+QVariant parseScalar(QStringView token)
+{
+    if (token == QStringView(u"true")) {
+        return true;
+    }
+    if (token == QStringView(u"false")) {
+        return false;
+    }
+
+    QString digits = token.toString();
+    digits.remove(u'_');
+    bool ok = false;
+
+    int base = 10;
+    qsizetype offset = 0;
+    if (digits.startsWith("0x"_L1)) {
+        base = 16;
+        offset = 2;
+    } else if (digits.startsWith("0o"_L1)) {
+        base = 8;
+        offset = 2;
+    } else if (digits.startsWith("0b"_L1)) {
+        base = 2;
+        offset = 2;
+    }
+    const qlonglong integer = QStringView(digits).mid(offset).toLongLong(&ok, base);
+    if (ok) {
+        return integer;
+    }
+    const double number = digits.toDouble(&ok);
+    if (ok) {
+        return number;
+    }
+
+    // Dates and times are passed through as text
+    return token.toString();
+}
+
+bool parseValue(QStringView text, qsizetype &pos, QVariant *value)
+{
+    if (pos >= text.size()) {
+        return false;
+    }
+
+    const QChar c = text[pos];
+    if (c == u'"' || c == u'\'') {
+        QString string;
+        if (!parseString(text, pos, &string)) {
+            return false;
+        }
+        *value = string;
+        return true;
+    }
+    if (c == u'[' || c == u'{') {
+        *value = QVariant();
+        return skipCompound(text, pos);
+    }
+
+    const qsizetype start = pos;
+    while (pos < text.size() && text[pos] != u'#' && text[pos] != u'\n' && text[pos] != u'\r') {
+        ++pos;
+    }
+    while (pos > start && (text[pos - 1] == u' ' || text[pos - 1] == u'\t')) {
+        --pos;
+    }
+    if (pos == start) {
+        return false;
+    }
+    *value = parseScalar(text.mid(start, pos - start));
+    return true;
+}
+
+// Parses a possibly dotted key up to the following '=' or ']'
+bool parseKey(QStringView text, qsizetype &pos, QStringList *segments)
+{
+    for (;;) {
+        skipBlanks(text, pos);
+        if (pos >= text.size()) {
+            return false;
+        }
+
+        QString segment;
+        const QChar c = text[pos];
+        if (c == u'"') {
+            if (!parseBasicString(text, pos, &segment)) {
+                return false;
+            }
+        } else if (c == u'\'') {
+            if (!parseLiteralString(text, pos, &segment)) {
+                return false;
+            }
+        } else {
+            const qsizetype start = pos;
+            while (pos < text.size() && isBareKeyChar(text[pos])) {
+                ++pos;
+            }
+            if (pos == start) {
+                return false;
+            }
+            segment = text.mid(start, pos - start).toString();
+        }
+        segments->append(segment);
+
+        skipBlanks(text, pos);
+        if (pos < text.size() && text[pos] == u'.') {
+            ++pos;
+            continue;
+        }
+        return true;
+    }
+}
+
+}
+
+ChezmoiConfig::ChezmoiConfig(QObject *parent)
+    : QObject(parent)
+    , m_mutex()
+    , m_document()
+    , m_filePath()
+    , m_valid(false)
+    , m_generation(0)
+    , m_pendingKeys()
+    , m_watcher(new QFileSystemWatcher(this))
+{
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &ChezmoiConfig::onFileChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &ChezmoiConfig::onFileChanged);
+}
+
+ChezmoiConfig::~ChezmoiConfig() = default;
+
+QString ChezmoiConfig::defaultConfigPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + "/chezmoi/chezmoi.toml"_L1;
+}
+
+bool ChezmoiConfig::load(const QString &filePath)
+{
+    const QString path = filePath.isEmpty() ? defaultConfigPath() : filePath;
+
+    Document document;
+    bool valid = true;
+    QFile file(path);
+    if (file.exists()) {
+        QString error;
+        if (!file.open(QIODevice::ReadOnly)) {
+            LOG_WARNING(QStringLiteral("Cannot read chezmoi config %1: %2").arg(path, file.errorString()));
+            valid = false;
+        } else if (!parse(QString::fromUtf8(file.readAll()), &document, &error)) {
+            LOG_WARNING(QStringLiteral("Cannot parse chezmoi config %1, %2").arg(path, error));
+            valid = false;
+        }
+    } else {
+        // chezmoi also reads YAML and JSON configurations, which are left to chezmoi itself
+        const QDir configDir = QFileInfo(path).absoluteDir();
+        for (const QString &name : {"chezmoi.yaml"_L1, "chezmoi.yml"_L1, "chezmoi.json"_L1, "chezmoi.jsonc"_L1}) {
+            if (configDir.exists(name)) {
+                LOG_INFO(QStringLiteral("chezmoi is configured through %1, reading it through chezmoi").arg(configDir.filePath(name)));
+                valid = false;
+                break;
+            }
+        }
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_document = std::move(document);
+        m_filePath = path;
+        m_valid = valid;
+        m_pendingKeys.clear();
+        ++m_generation;
+    }
+
+    updateWatchedPaths();
+    LOG_DEBUG(QStringLiteral("Loaded chezmoi config %1 (%2)").arg(path, valid ? "native"_L1 : "through chezmoi"_L1));
+    return valid;
+}
+
+bool ChezmoiConfig::loadFromData(const QString &text)
+{
+    Document document;
+    QString error;
+    const bool valid = parse(text, &document, &error);
+    if (!valid) {
+        LOG_WARNING(QStringLiteral("Cannot parse chezmoi config, %1").arg(error));
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_document = std::move(document);
+    m_valid = valid;
+    m_pendingKeys.clear();
+    ++m_generation;
+    return valid;
+}
+
+QString ChezmoiConfig::toData() const
+{
+    QMutexLocker locker(&m_mutex);
+    return joinedText();
+}
+
+QString ChezmoiConfig::joinedText() const
+{
+    if (m_document.lines.isEmpty()) {
+        return QString();
+    }
+
+    QString text;
+    for (const Line &line : m_document.lines) {
+        text += line.text;
+        text += u'\n';
+    }
+    if (!m_document.trailingNewline) {
+        text.chop(1);
+    }
+    return text;
+}
+
+bool ChezmoiConfig::save()
+{
+    QString data;
+    QStringList keys;
+    QString path;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_valid) {
+            LOG_WARNING("Not writing chezmoi config: it is not a TOML file we could parse"_L1);
+            return false;
+        }
+        if (m_pendingKeys.isEmpty() || m_filePath.isEmpty()) {
+            return true;
+        }
+        data = joinedText();
+        keys = QStringList(m_pendingKeys.cbegin(), m_pendingKeys.cend());
+        path = m_filePath;
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data.toUtf8()) < 0 || !file.commit()) {
+        LOG_ERROR(QStringLiteral("Failed to write chezmoi config %1: %2").arg(path, file.errorString()));
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pendingKeys.clear();
+    }
+
+    keys.sort();
+    LOG_INFO(QStringLiteral("Wrote chezmoi config %1: %2").arg(path, keys.join(", "_L1)));
+    updateWatchedPaths();
+    Q_EMIT changed(keys);
+    return true;
+}
+
+bool ChezmoiConfig::isValid() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_valid;
+}
+
+QString ChezmoiConfig::filePath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_filePath;
+}
+
+quint64 ChezmoiConfig::generation() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_generation;
+}
+
+bool ChezmoiConfig::hasPendingChanges() const
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_pendingKeys.isEmpty();
+}
+
+bool ChezmoiConfig::contains(const QString &key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_document.keyLines.contains(normalizeKey(key));
+}
+
+QVariant ChezmoiConfig::value(const QString &key, const QVariant &defaultValue) const
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_document.values.constFind(normalizeKey(key));
+    if (it == m_document.values.constEnd() || !it->isValid()) {
+        return defaultValue;
+    }
+    return *it;
+}
+
+void ChezmoiConfig::setValue(const QString &key, const QVariant &value)
+{
+    QMutexLocker locker(&m_mutex);
+    const QString normalized = normalizeKey(key);
+
+    const auto lineIt = m_document.keyLines.constFind(normalized);
+    if (lineIt != m_document.keyLines.constEnd()) {
+        if (m_document.values.value(normalized) == value) {
+            return;
+        }
+        // Rewrite just the value; the key's spelling, spacing and trailing comment stay as they were
+        Line &line = m_document.lines[*lineIt];
+        const QString formatted = formatValue(value);
+        line.text.replace(line.valueStart, line.valueLength, formatted);
+        line.valueLength = formatted.size();
+        m_document.values.insert(normalized, value);
+    } else {
+        insertKey(key, value);
+    }
+
+    m_pendingKeys.insert(normalized);
+    ++m_generation;
+}
+
+void ChezmoiConfig::insertKey(const QString &key, const QVariant &value)
+{
+    const QStringList segments = key.split(u'.');
+    const QString formatted = formatValue(value);
+    QList<Line> &lines = m_document.lines;
+
+    auto sectionEnd = [&lines](int header) {
+        int end = header + 1;
+        while (end < lines.size() && !lines[end].isHeader) {
+            ++end;
+        }
+        return end;
+    };
+    auto lastKeyIn = [&lines](int begin, int end) {
+        int last = -1;
+        for (int i = begin; i < end; ++i) {
+            if (!lines[i].key.isEmpty()) {
+                last = i;
+            }
+        }
+        return last;
+    };
+
+    QList<Line> inserted;
+    int position = -1;
+
+    // Prefer the closest enclosing [table] that already exists
+    for (qsizetype depth = segments.size() - 1; depth > 0 && position < 0; --depth) {
+        const QString table = normalizeKey(segments.mid(0, depth).join(u'.'));
+        const auto headerIt = m_document.tableLines.constFind(table);
+        if (headerIt == m_document.tableLines.constEnd()) {
+            continue;
+        }
+        const int header = *headerIt;
+        const int last = lastKeyIn(header + 1, sectionEnd(header));
+        position = (last >= 0 ? last : header) + 1;
+        Line line;
+        line.text = segments.mid(depth).join(u'.') + " = "_L1 + formatted;
+        inserted.append(line);
+    }
+
+    if (position < 0) {
+        int firstHeader = 0;
+        while (firstHeader < lines.size() && !lines[firstHeader].isHeader) {
+            ++firstHeader;
+        }
+
+        // A dotted key joins top-level keys that already spell out the same table, e.g. git.autoCommit
+        const QString prefix = segments.size() > 1 ? normalizeKey(segments.mid(0, segments.size() - 1).join(u'.')) + u'.' : QString();
+        int lastRootKey = -1;
+        for (int i = 0; i < firstHeader; ++i) {
+            if (!lines[i].key.isEmpty() && lines[i].key.startsWith(prefix)) {
+                lastRootKey = i;
+            }
+        }
+
+        if (segments.size() == 1 || lastRootKey >= 0) {
+            position = lastRootKey >= 0 ? lastRootKey + 1 : firstHeader;
+            Line line;
+            line.text = key + " = "_L1 + formatted;
+            inserted.append(line);
+            if (lastRootKey < 0 && firstHeader < lines.size()) {
+                inserted.append(Line());
+            }
+        } else {
+            position = lines.size();
+            if (!lines.isEmpty() && !lines.last().text.trimmed().isEmpty()) {
+                inserted.append(Line());
+            }
+            Line header;
+            header.text = u'[' + segments.mid(0, segments.size() - 1).join(u'.') + u']';
+            inserted.append(header);
+            Line line;
+            line.text = segments.last() + " = "_L1 + formatted;
+            inserted.append(line);
+        }
+    }
+
+    for (qsizetype i = 0; i < inserted.size(); ++i) {
+        lines.insert(position + i, inserted[i]);
+    }
+
+    // Re-read the document so keys, tables and value spans point at the right lines again
+    Document document;
+    QString error;
+    if (parse(joinedText(), &document, &error)) {
+        m_document = std::move(document);
+    } else {
+        LOG_ERROR(QStringLiteral("Inserting %1 produced an unreadable chezmoi config, %2").arg(key, error));
+    }
+}
+
+void ChezmoiConfig::onFileChanged()
+{
+    QFile file(m_filePath);
+    QString text;
+    if (file.open(QIODevice::ReadOnly)) {
+        text = QString::fromUtf8(file.readAll());
+    }
+
+    QHash<QString, QVariant> previousValues;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_valid && text == joinedText()) {
+            // Our own save, or a write that changed nothing
+            locker.unlock();
+            updateWatchedPaths();
+            return;
+        }
+        previousValues = m_document.values;
+    }
+
+    load(m_filePath);
+
+    QStringList changedKeys;
+    {
+        QMutexLocker locker(&m_mutex);
+        const QHash<QString, QVariant> &values = m_document.values;
+        for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+            if (previousValues.value(it.key()) != it.value()) {
+                changedKeys.append(it.key());
+            }
+        }
+        for (auto it = previousValues.constBegin(); it != previousValues.constEnd(); ++it) {
+            if (!values.contains(it.key())) {
+                changedKeys.append(it.key());
+            }
+        }
+    }
+
+    if (!changedKeys.isEmpty()) {
+        changedKeys.sort();
+        LOG_INFO(QStringLiteral("chezmoi config changed on disk: %1").arg(changedKeys.join(", "_L1)));
+        Q_EMIT changed(changedKeys);
+    }
+}
+
+void ChezmoiConfig::updateWatchedPaths()
+{
+    const QStringList watched = m_watcher->files() + m_watcher->directories();
+    if (!watched.isEmpty()) {
+        m_watcher->removePaths(watched);
+    }
+
+    const QString path = filePath();
+    if (path.isEmpty()) {
+        return;
+    }
+
+    // Editors save by replacing the file, and the config may not exist yet; the directory catches both
+    if (QFileInfo::exists(path)) {
+        m_watcher->addPath(path);
+    } else {
+        const QString directory = QFileInfo(path).absolutePath();
+        if (QFileInfo::exists(directory)) {
+            m_watcher->addPath(directory);
+        }
+    }
+}
+
+QString ChezmoiConfig::sourceDir() const
+{
+    const QString configured = value(QStringLiteral("sourceDir")).toString();
+    if (!configured.isEmpty()) {
+        return expandPath(configured);
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/chezmoi"_L1;
+}
+
+QString ChezmoiConfig::destDir() const
+{
+    const QString configured = value(QStringLiteral("destDir")).toString();
+    return configured.isEmpty() ? QDir::homePath() : expandPath(configured);
+}
+
+QString ChezmoiConfig::workingTree() const
+{
+    const QString configured = value(QStringLiteral("workingTree")).toString();
+    return configured.isEmpty() ? sourceDir() : expandPath(configured);
+}
+
+QString ChezmoiConfig::leftDelimiter() const
+{
+    return value(QStringLiteral("template.leftDelimiter"), QStringLiteral("{{")).toString();
+}
+
+QString ChezmoiConfig::rightDelimiter() const
+{
+    return value(QStringLiteral("template.rightDelimiter"), QStringLiteral("}}")).toString();
+}
+
+bool ChezmoiConfig::gitAutoCommit() const
+{
+    return value(QStringLiteral("git.autoCommit"), false).toBool();
+}
+
+bool ChezmoiConfig::gitAutoPush() const
+{
+    return value(QStringLiteral("git.autoPush"), false).toBool();
+}
+
+QString ChezmoiConfig::gitCommitMessageTemplate() const
+{
+    return value(QStringLiteral("git.commitMessageTemplate")).toString();
+}
+
+bool ChezmoiConfig::parse(const QString &source, Document *document, QString *error)
+{
+    Document result;
+    result.trailingNewline = source.isEmpty() || source.endsWith(u'\n');
+
+    const QStringView text(source);
+    QString currentTable;
+    bool inArrayTable = false;
+    int lineNumber = 1;
+    qsizetype pos = 0;
+
+    auto fail = [&](const QString &message) {
+        *error = QStringLiteral("line %1: %2").arg(lineNumber).arg(message);
+        return false;
+    };
+
+    while (pos < text.size()) {
+        const qsizetype lineStart = pos;
+        Line line;
+
+        skipBlanks(text, pos);
+        if (pos < text.size() && text[pos] == u'[') {
+            const bool arrayTable = pos + 1 < text.size() && text[pos + 1] == u'[';
+            pos += arrayTable ? 2 : 1;
+            QStringList segments;
+            if (!parseKey(text, pos, &segments)) {
+                return fail(QStringLiteral("invalid table name"));
+            }
+            if (text.mid(pos, arrayTable ? 2 : 1) != QStringView(arrayTable ? u"]]" : u"]")) {
+                return fail(QStringLiteral("unterminated table header"));
+            }
+            pos += arrayTable ? 2 : 1;
+
+            // Keys inside arrays of tables are not addressable by a single dotted path
+            inArrayTable = arrayTable;
+            currentTable = normalizeKey(segments.join(u'.'));
+            line.isHeader = true;
+            if (!arrayTable) {
+                line.table = currentTable;
+            }
+        } else if (pos < text.size() && text[pos] != u'#' && text[pos] != u'\n' && text[pos] != u'\r') {
+            QStringList segments;
+            if (!parseKey(text, pos, &segments) || pos >= text.size() || text[pos] != u'=') {
+                return fail(QStringLiteral("expected key = value"));
+            }
+            ++pos;
+            skipBlanks(text, pos);
+
+            const qsizetype valueStart = pos;
+            QVariant value;
+            if (!parseValue(text, pos, &value)) {
+                return fail(QStringLiteral("invalid value"));
+            }
+            line.valueStart = valueStart - lineStart;
+            line.valueLength = pos - valueStart;
+
+            if (!inArrayTable) {
+                const QString key = normalizeKey(segments.join(u'.'));
+                line.key = currentTable.isEmpty() ? key : currentTable + u'.' + key;
+                if (result.keyLines.contains(line.key)) {
+                    return fail(QStringLiteral("duplicate key %1").arg(line.key));
+                }
+                result.values.insert(line.key, value);
+                result.keyLines.insert(line.key, result.lines.size());
+            }
+        }
+
+        // Only a comment may follow on the same line
+        skipBlanks(text, pos);
+        if (pos < text.size() && text[pos] == u'#') {
+            while (pos < text.size() && text[pos] != u'\n') {
+                ++pos;
+            }
+        }
+        if (pos < text.size() && text[pos] == u'\r') {
+            ++pos;
+        }
+        if (pos < text.size() && text[pos] != u'\n') {
+            return fail(QStringLiteral("unexpected characters after value"));
+        }
+
+        line.text = text.mid(lineStart, pos - lineStart).toString();
+        lineNumber += line.text.count(u'\n') + 1;
+        if (!line.table.isEmpty()) {
+            result.tableLines.insert(line.table, result.lines.size());
+        }
+        result.lines.append(line);
+        ++pos;
+    }
+
+    *document = std::move(result);
+    return true;
+}
+
+QString ChezmoiConfig::normalizeKey(const QString &key)
+{
+    return key.toLower();
+}
+
+QString ChezmoiConfig::formatValue(const QVariant &value)
+{
+    switch (value.typeId()) {
+    case QMetaType::Bool:
+        return value.toBool() ? QStringLiteral("true") : QStringLiteral("false");
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        return QString::number(value.toLongLong());
+    case QMetaType::Double: {
+        QString number = QString::number(value.toDouble(), 'g', QLocale::FloatingPointShortest);
+        if (!number.contains(u'.') && !number.contains(u'e') && !number.contains("inf"_L1) && !number.contains("nan"_L1)) {
+            number += ".0"_L1;
+        }
+        return number;
+    }
+    default:
+        break;
+    }
+
+    const QString string = value.toString();
+    QString quoted;
+    quoted.reserve(string.size() + 2);
+    quoted += u'"';
+    for (const QChar c : string) {
+        switch (c.unicode()) {
+        case '"': quoted += "\\\""_L1; break;
+        case '\\': quoted += "\\\\"_L1; break;
+        case '\n': quoted += "\\n"_L1; break;
+        case '\t': quoted += "\\t"_L1; break;
+        case '\r': quoted += "\\r"_L1; break;
+        default:
+            if (c.unicode() < 0x20 || c.unicode() == 0x7f) {
+                quoted += QStringLiteral("\\u%1").arg(int(c.unicode()), 4, 16, u'0');
+            } else {
+                quoted += c;
+            }
+        }
+    }
+    quoted += u'"';
+    return quoted;
+}
+
+QString ChezmoiConfig::expandPath(const QString &path)
+{
+    if (path == u'~') {
+        return QDir::homePath();
+    }
+    if (path.startsWith("~/"_L1)) {
+        return QDir::cleanPath(QDir::homePath() + path.mid(1));
+    }
+    return QDir::cleanPath(path);
+}
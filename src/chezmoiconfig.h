@@ -0,0 +1,97 @@
+#ifndef CHEZMOICONFIG_H
+#define CHEZMOICONFIG_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+#include <QVariant>
+
+class QFileSystemWatcher;
+
+/**
+ * @brief chezmoi's TOML configuration, read and edited without running chezmoi
+ *
+ * The file is kept as its original lines so comments, ordering and formatting
+ * survive a save; setValue() only rewrites the value of the key being edited.
+ * Keys are dotted paths ("git.autoPush") and, like chezmoi's, case-insensitive;
+ * changed() reports them in lower case.
+ * The getters may be called from worker threads.
+ */
+class ChezmoiConfig : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChezmoiConfig(QObject *parent = nullptr);
+    ~ChezmoiConfig() override;
+
+    static QString defaultConfigPath();
+
+    bool load(const QString &filePath = QString());
+    bool loadFromData(const QString &text);
+    QString toData() const;
+    bool save();
+
+    /** @brief True when the configuration is a TOML file we parsed, or chezmoi runs on defaults */
+    bool isValid() const;
+    QString filePath() const;
+    quint64 generation() const;
+    bool hasPendingChanges() const;
+
+    bool contains(const QString &key) const;
+    QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
+    void setValue(const QString &key, const QVariant &value);
+
+    QString sourceDir() const;
+    QString destDir() const;
+    QString workingTree() const;
+    QString leftDelimiter() const;
+    QString rightDelimiter() const;
+    bool gitAutoCommit() const;
+    bool gitAutoPush() const;
+    QString gitCommitMessageTemplate() const;
+
+Q_SIGNALS:
+    void changed(const QStringList &keys);
+
+private Q_SLOTS:
+    void onFileChanged();
+
+private:
+    struct Line {
+        QString text;              // may span several physical lines for multi-line values
+        QString key;               // normalized dotted key of a key/value pair
+        QString table;             // normalized name of a [table] header
+        bool isHeader = false;     // [table] or [[array of tables]] header
+        qsizetype valueStart = -1;
+        qsizetype valueLength = 0;
+    };
+
+    struct Document {
+        QList<Line> lines;
+        QHash<QString, QVariant> values;
+        QHash<QString, int> keyLines;
+        QHash<QString, int> tableLines;
+        bool trailingNewline = true;
+    };
+
+    static bool parse(const QString &text, Document *document, QString *error);
+    static QString normalizeKey(const QString &key);
+    static QString formatValue(const QVariant &value);
+    static QString expandPath(const QString &path);
+    QString joinedText() const;
+    void insertKey(const QString &key, const QVariant &value);
+    void updateWatchedPaths();
+
+    mutable QMutex m_mutex;
+    Document m_document;
+    QString m_filePath;
+    bool m_valid;
+    quint64 m_generation;
+    QSet<QString> m_pendingKeys;
+    QFileSystemWatcher *m_watcher;
+};
+
+#endif // CHEZMOICONFIG_H
@@ -0,0 +1,77 @@
+#include "chezmoioutputparser.h"
+
+ChezmoiOutputParser::ChezmoiOutputParser()
+    : m_partial()
+{
+}
+
+QByteArrayView ChezmoiOutputParser::chopCarriageReturn(QByteArrayView line)
+{
+    return line.endsWith('\r') ? line.chopped(1) : line;
+}
+
+bool ChezmoiOutputParser::parseStatusLine(QByteArrayView line, QByteArrayView *path, ChezmoiStatus *status)
+{
+    // "XY path": X compares with the last written state, Y with the target state
+    if (line.size() < 3) {
+        return false;
+    }
+    *path = line.sliced(3).trimmed();
+    if (path->isEmpty()) {
+        return false;
+    }
+    *status = ChezmoiStatus::fromCodes(line.at(0), line.at(1));
+    return true;
+}
+
+QByteArrayView ChezmoiOutputParser::parseManagedLine(QByteArrayView line)
+{
+    // One target path per line; blank lines yield an empty view
+    return line.trimmed();
+}
+
+QByteArrayView ChezmoiOutputParser::parseDiffLine(QByteArrayView line)
+{
+    // "diff --git a/<path> b/<path>"; the name after " b/" is the one the file has afterwards
+    constexpr QByteArrayView prefix("diff --git a/");
+    if (!line.startsWith(prefix)) {
+        return QByteArrayView();
+    }
+    const qsizetype separator = line.lastIndexOf(QByteArrayView(" b/"));
+    if (separator < prefix.size()) {
+        return QByteArrayView();
+    }
+    return line.sliced(separator + 3);
+}
+
+QByteArrayView ChezmoiOutputParser::parseErrorLine(QByteArrayView line)
+{
+    // With --keep-going every file that fails gets a line of its own
+    constexpr QByteArrayView prefix("chezmoi: ");
+    if (!line.startsWith(prefix)) {
+        return QByteArrayView();
+    }
+    const QByteArrayView rest = line.sliced(prefix.size());
+    const qsizetype separator = rest.indexOf(QByteArrayView(": "));
+    if (separator <= 0) {
+        return QByteArrayView();
+    }
+    return rest.first(separator);
+}
+
+QHash<QString, ChezmoiStatus> ChezmoiOutputParser::parseStatus(QByteArrayView output)
+{
+    QHash<QString, ChezmoiStatus> statuses;
+    ChezmoiOutputParser parser;
+    auto parseLine = [&statuses](QByteArrayView line) {
+        QByteArrayView path;
+        ChezmoiStatus status;
+        if (parseStatusLine(line, &path, &status)) {
+            // The hash key is the only string built per line
+            statuses.insert(QString::fromUtf8(path), status);
+        }
+    };
+    parser.feed(output, parseLine);
+    parser.finish(parseLine);
+    return statuses;
+}
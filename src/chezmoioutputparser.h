@@ -0,0 +1,86 @@
+#ifndef CHEZMOIOUTPUTPARSER_H
+#define CHEZMOIOUTPUTPARSER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+#include <QString>
+
+#include <cstring>
+
+#include "chezmoistatus.h"
+
+/**
+ * @brief Splits chezmoi's output into lines as it arrives
+ *
+ * Chunks are scanned in place and each complete line is handed out as a
+ * view into the chunk; only a line cut off at the end of a chunk is copied,
+ * to be joined with the start of the next one. The static helpers parse
+ * single lines without building any QString.
+ */
+class ChezmoiOutputParser
+{
+public:
+    ChezmoiOutputParser();
+
+    // Calls handler(QByteArrayView) for every complete line in chunk, without its line ending
+    template<typename Handler>
+    void feed(QByteArrayView chunk, Handler &&handler);
+
+    // Hands out the last line if the output did not end with a newline
+    template<typename Handler>
+    void finish(Handler &&handler);
+
+    static bool parseStatusLine(QByteArrayView line, QByteArrayView *path, ChezmoiStatus *status);
+    static QByteArrayView parseManagedLine(QByteArrayView line);
+    // The path a "diff --git" header of --verbose output is about; empty for any other line
+    static QByteArrayView parseDiffLine(QByteArrayView line);
+    // The path a "chezmoi: <path>: <error>" line of an error output is about; empty for any other line
+    static QByteArrayView parseErrorLine(QByteArrayView line);
+    static QHash<QString, ChezmoiStatus> parseStatus(QByteArrayView output);
+
+private:
+    static QByteArrayView chopCarriageReturn(QByteArrayView line);
+
+    QByteArray m_partial;
+};
+
+template<typename Handler>
+void ChezmoiOutputParser::feed(QByteArrayView chunk, Handler &&handler)
+{
+    const char *begin = chunk.data();
+    const char *end = begin + chunk.size();
+
+    if (!m_partial.isEmpty()) {
+        const char *newline = static_cast<const char *>(std::memchr(begin, '\n', size_t(end - begin)));
+        if (!newline) {
+            m_partial.append(begin, end - begin);
+            return;
+        }
+        m_partial.append(begin, newline - begin);
+        handler(chopCarriageReturn(m_partial));
+        m_partial.clear();
+        begin = newline + 1;
+    }
+
+    while (begin < end) {
+        const char *newline = static_cast<const char *>(std::memchr(begin, '\n', size_t(end - begin)));
+        if (!newline) {
+            m_partial.append(begin, end - begin);
+            return;
+        }
+        handler(chopCarriageReturn(QByteArrayView(begin, newline - begin)));
+        begin = newline + 1;
+    }
+}
+
+template<typename Handler>
+void ChezmoiOutputParser::finish(Handler &&handler)
+{
+    if (!m_partial.isEmpty()) {
+        handler(chopCarriageReturn(m_partial));
+        m_partial.clear();
+    }
+}
+
+#endif // CHEZMOIOUTPUTPARSER_H
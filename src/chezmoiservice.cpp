@@ -1,35 +1,223 @@
 #include "chezmoiservice.h"
+#include "chezmoiconfig.h"
+#include "chezmoioutputparser.h"
+#include "chezmoistate.h"
+#include "filewatcher.h"
+#include "gitrepository.h"
+#include "ignorematcher.h"
 #include "logger.h"
 
 #include <memory>
+#include <QCryptographicHash>
 #include <QStandardPaths>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QDebug>
-#include <QTextStream>
+#include <QProcessEnvironment>
 #include <QRegularExpression>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <initializer_list>
+#include <utility>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
 
 using namespace Qt::Literals::StringLiterals;
 
+namespace {
+// Environment variable naming the chezmoi executable to run instead of the one on PATH
+constexpr const char *ExecutableEnvironmentVariable = "DOTWEAVER_CHEZMOI";
+
+// Editors save in bursts (write, rename, chmod); collect them, but stay well inside a 100 ms row update
+constexpr int StatusBatchMs = 30;
+
+// Qt's default wait: ample for a large status diff, and a chezmoi stuck on a passphrase prompt or a git
+// lock only holds its worker, and everyone sharing the query, this long
+constexpr int QueryTimeoutMs = 30000;
+
+// A streamed listing may take longer than that overall, but not go this long without output
+constexpr int QueryStallMs = 30000;
+
+// Argument bytes one bulk run may use: never more than this, however large ARG_MAX is
+constexpr qsizetype MaxArgumentBytes = 1024 * 1024;
+
+// ... and at least what POSIX guarantees for arguments and environment together
+constexpr qsizetype MinArgumentBytes = 4096;
+
+// CreateProcess takes a command line of at most 32767 characters
+constexpr qsizetype CommandLineBytes = 32000;
+
+qsizetype argumentBytes(const QString &argument)
+{
+    // The string, its terminator and its slot in argv
+    return argument.toLocal8Bit().size() + 1 + qsizetype(sizeof(char *));
+}
+
+// Drops prefix from the front of name. A literal_ prefix is dropped wherever it comes and ends
+// attribute parsing, so later prefixes are kept as part of the name.
+bool takePrefix(QStringView &name, QLatin1StringView prefix, bool &literal)
+{
+    if (literal) {
+        return false;
+    }
+    if (name.startsWith("literal_"_L1)) {
+        name = name.sliced(8);
+        literal = true;
+        return false;
+    }
+    if (!name.startsWith(prefix)) {
+        return false;
+    }
+    name = name.sliced(prefix.size());
+    return true;
+}
+
+void takePrefixes(QStringView &name, std::initializer_list<QLatin1StringView> prefixes, bool &literal)
+{
+    for (const QLatin1StringView prefix : prefixes) {
+        takePrefix(name, prefix, literal);
+    }
+}
+
+// chezmoi's attribute order for directories: remove_, external_, exact_, private_, readonly_, dot_
+QString directoryTargetName(QStringView name)
+{
+    bool literal = false;
+    takePrefixes(name, {"remove_"_L1, "external_"_L1, "exact_"_L1, "private_"_L1, "readonly_"_L1}, literal);
+    return takePrefix(name, "dot_"_L1, literal) ? u'.' + name.toString() : name.toString();
+}
+
+// ... and for files, where the first prefix picks the entry type and with it the attributes that may follow
+QString fileTargetName(QStringView name, bool *isTemplate)
+{
+    bool literal = false;
+    bool encrypted = false;
+    if (takePrefix(name, "create_"_L1, literal)) {
+        encrypted = takePrefix(name, "encrypted_"_L1, literal);
+        takePrefixes(name, {"private_"_L1, "readonly_"_L1, "empty_"_L1, "executable_"_L1}, literal);
+    } else if (takePrefix(name, "modify_"_L1, literal)) {
+        encrypted = takePrefix(name, "encrypted_"_L1, literal);
+        takePrefixes(name, {"private_"_L1, "readonly_"_L1, "executable_"_L1}, literal);
+    } else if (takePrefix(name, "remove_"_L1, literal) || takePrefix(name, "symlink_"_L1, literal)) {
+        // No attributes besides dot_
+    } else if (takePrefix(name, "run_"_L1, literal)) {
+        if (!takePrefix(name, "once_"_L1, literal)) {
+            takePrefix(name, "onchange_"_L1, literal);
+        }
+        if (!takePrefix(name, "before_"_L1, literal)) {
+            takePrefix(name, "after_"_L1, literal);
+        }
+    } else {
+        encrypted = takePrefix(name, "encrypted_"_L1, literal);
+        takePrefixes(name, {"private_"_L1, "readonly_"_L1, "empty_"_L1, "executable_"_L1}, literal);
+    }
+    const bool dot = takePrefix(name, "dot_"_L1, literal);
+    
+    // Suffixes come off from the end: the encryption tool's, then .tmpl, and .literal keeps what precedes it
+    if (encrypted && (name.endsWith(".age"_L1) || name.endsWith(".asc"_L1))) {
+        name.chop(4);
+    }
+    *isTemplate = false;
+    if (name.endsWith(".literal"_L1)) {
+        name.chop(8);
+    } else if (name.endsWith(".tmpl"_L1)) {
+        name.chop(5);
+        *isTemplate = true;
+        if (name.endsWith(".literal"_L1)) {
+            name.chop(8);
+        }
+    }
+    return dot ? u'.' + name.toString() : name.toString();
+}
+}
+
 ChezmoiService::ChezmoiService(QObject *parent)
+    : ChezmoiService(QString(), parent)
+{
+}
+
+ChezmoiService::ChezmoiService(const QString &executablePath, QObject *parent)
     : QObject(parent)
     , m_process(std::make_unique<QProcess>(this))
+    , m_config(std::make_unique<ChezmoiConfig>(this))
     , m_chezmoiPath()
     , m_currentOperation()
+    , m_fileWatcher(new FileWatcher(this))
+    , m_watchedPaths()
+    , m_watchedSourceDir()
+    , m_watchedDestDir()
+    , m_pendingStatusPaths()
+    , m_batchPaths()
+    , m_statusBatchTimer(new QTimer(this))
+    , m_statusProcess(std::make_unique<QProcess>(this))
+    , m_statusBatchParser()
+    , m_bulkProcess(std::make_unique<QProcess>(this))
+    , m_bulkQueue()
+    , m_bulkChunk()
+    , m_bulkParser()
+    , m_bulkTargets()
+    , m_bulkErrors()
+    , m_bulkTotal(0)
+    , m_bulkDone(0)
+    , m_bulkChunkDone(0)
+    , m_bulkProgress(-1)
+    , m_queryMutex()
+    , m_queryFinished()
+    , m_inFlightQueries()
+    , m_savedSpawns(0)
+    , m_ignoreMutex()
+    , m_ignoreMatcher()
+    , m_ignoreKey()
 {
     connect(m_process.get(), QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
             this, &ChezmoiService::onProcessFinished);
     connect(m_process.get(), &QProcess::errorOccurred,
             this, &ChezmoiService::onProcessError);
     
-    m_chezmoiPath = getChezmoiExecutable();
+    connect(m_config.get(), &ChezmoiConfig::changed,
+            this, &ChezmoiService::configurationChanged);
+    
+    m_statusBatchTimer->setSingleShot(true);
+    m_statusBatchTimer->setInterval(StatusBatchMs);
+    connect(m_statusBatchTimer, &QTimer::timeout, this, &ChezmoiService::flushStatusBatch);
+    connect(m_fileWatcher, &FileWatcher::pathsChanged, this, &ChezmoiService::onWatchedPathsChanged);
+    connect(m_fileWatcher, &FileWatcher::overflowed, this, &ChezmoiService::managedFilesChanged);
+    connect(m_statusProcess.get(), &QProcess::readyReadStandardOutput,
+            this, &ChezmoiService::onStatusBatchOutput);
+    connect(m_statusProcess.get(), QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &ChezmoiService::onStatusBatchFinished);
+    connect(m_bulkProcess.get(), &QProcess::readyReadStandardOutput,
+            this, &ChezmoiService::onBulkOutput);
+    connect(m_bulkProcess.get(), QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &ChezmoiService::onBulkFinished);
+    connect(m_bulkProcess.get(), &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        // A run that never started has no finished signal to move the queue on
+        if (error == QProcess::FailedToStart && isBulkRunning()) {
+            onBulkFinished(-1, QProcess::CrashExit);
+        }
+    });
+    
+    m_chezmoiPath = executablePath.isEmpty() ? getChezmoiExecutable() : executablePath;
+    m_config->load();
     
     LOG_INFO(QStringLiteral("ChezmoiService initialized with path: %1").arg(m_chezmoiPath.isEmpty() ? "NOT FOUND"_L1 : m_chezmoiPath));
 }
 
 ChezmoiService::~ChezmoiService() = default;
 
-QString ChezmoiService::getChezmoiExecutable() const
+QString ChezmoiService::getChezmoiExecutable()
 {
+    // Tests and benchmarks point this at a stand-in so they don't depend on what is installed
+    const QString overridePath = qEnvironmentVariable(ExecutableEnvironmentVariable);
+    if (!overridePath.isEmpty()) {
+        LOG_INFO(QStringLiteral("Using chezmoi executable from %1: %2").arg(QLatin1String(ExecutableEnvironmentVariable), overridePath));
+        return overridePath;
+    }
+    
     QString path = QStandardPaths::findExecutable(QStringLiteral("chezmoi"));
     LOG_INFO(QStringLiteral("Looking for chezmoi executable: %1").arg(path.isEmpty() ? "NOT FOUND"_L1 : path));
     return path;
@@ -39,7 +227,7 @@ bool ChezmoiService::isChezmoiInitialized() const
 {
     QString chezmoiDir = getChezmoiDirectory();
     bool dirExists = QDir(chezmoiDir).exists();
-    bool gitExists = QDir(chezmoiDir + QStringLiteral("/.git")).exists();
+    bool gitExists = GitRepository::isRepository(chezmoiDir);
     bool initialized = dirExists && gitExists;
     
     LOG_INFO(QStringLiteral("Checking chezmoi initialization:"));
@@ -68,69 +256,99 @@ bool ChezmoiService::initializeRepository(const QString &repositoryUrl)
     return runChezmoiCommand(args, true);
 }
 
-QList<ChezmoiService::FileStatus> ChezmoiService::getManagedFiles()
+FileStatusBatch ChezmoiService::getManagedFiles(bool includeStatuses, const PartialBatchHandler &onPartial) const
 {
-    QList<FileStatus> files;
-    
     LOG_INFO("Getting managed files from chezmoi"_L1);
     
     if (m_chezmoiPath.isEmpty()) {
         LOG_ERROR("Cannot get managed files: chezmoi executable not found"_L1);
-        return files;
+        return FileStatusBatch();
     }
 
-    // First get the file statuses
-    QHash<QString, QString> fileStatuses = getFileStatuses();
-
-    if (!runChezmoiCommand({QStringLiteral("managed"), QStringLiteral("--exclude=dirs")}, false)) {
-        LOG_ERROR("Failed to run 'chezmoi managed --exclude=dirs' command"_L1);
-        return files;
+    // Statuses take a full target-state diff; callers that show the inventory first fetch them separately
+    QHash<QString, ChezmoiStatus> fileStatuses;
+    if (includeStatuses) {
+        fileStatuses = getFileStatuses();
     }
 
-    QString output = QString::fromUtf8(m_process->readAllStandardOutput());
-    LOG_INFO(QStringLiteral("Chezmoi managed command output (%1 chars):").arg(output.length()));
-    LOG_INFO(output.isEmpty() ? "  (empty output)"_L1 : QStringLiteral("  %1").arg(output.left(200) + (output.length() > 200 ? "..."_L1 : ""_L1)));
-
-    QTextStream stream(&output);
-    QString line;
-    int fileCount = 0;
+    // Source names are listed by a second chezmoi run alongside this one and joined once both are done;
+    // they are also the only place templates show, as chezmoi strips .tmpl from targets
+    QFuture<ManagedSources> managedSources = QtConcurrent::run([this]() {
+        return getManagedSources();
+    });
 
-    // Cache the source directory to avoid multiple calls
-    QString sourceDir = getChezmoiDirectory();
+    // Absolute paths are derived from these on demand rather than stored per file
+    const QString sourceDir = getChezmoiDirectory();
+    const QString destDir = getDestinationDirectory();
+    FileStatusBatch files(sourceDir, destDir);
+    FileStatusBatch partial(sourceDir, destDir);
 
-    while (stream.readLineInto(&line)) {
-        if (line.trimmed().isEmpty()) {
-            continue;
+    auto addLine = [&](QByteArrayView line) {
+        const QByteArrayView path = ChezmoiOutputParser::parseManagedLine(line);
+        if (path.isEmpty()) {
+            return;
         }
+        // Files 'chezmoi status' does not list are up to date
+        const ChezmoiStatus status = includeStatuses ? fileStatuses.value(QString::fromUtf8(path)) : ChezmoiStatus();
+        files.appendUtf8(path, status, 0);
+        if (onPartial) {
+            partial.appendUtf8(path, status, 0);
+        }
+    };
+    auto chunkDone = [&]() {
+        // Hand out what has arrived so far, so callers can fill views before chezmoi exits
+        if (onPartial && !partial.isEmpty()) {
+            onPartial(std::exchange(partial, FileStatusBatch(sourceDir, destDir)));
+        }
+    };
 
-        fileCount++;
-        LOG_DEBUG(QStringLiteral("Processing managed file: %1").arg(line.trimmed()));
-
-        FileStatus status;
-        status.path = line.trimmed();
-        
-        // Use actual status from chezmoi status, or default to "managed"
-        status.status = fileStatuses.value(status.path, u"managed"_s);
-        status.isTemplate = line.contains(u".tmpl"_s);
-
-        // Get source file info
-        QString sourcePath = sourceDir + QStringLiteral("/") + status.path;
-        status.sourceFile = QFileInfo(sourcePath);
-
-        // Get target file info
-        QString targetPath = QDir::homePath() + QStringLiteral("/") + status.path;
-        status.targetFile = QFileInfo(targetPath);
-
-        files.append(status);
+    if (!runStreamingQuery({QStringLiteral("managed"), QStringLiteral("--exclude=dirs")}, addLine, chunkDone)) {
+        LOG_ERROR("Failed to run 'chezmoi managed --exclude=dirs' command"_L1);
+        managedSources.waitForFinished();
+        return FileStatusBatch();
     }
     
-    LOG_INFO(QStringLiteral("Found %1 managed files").arg(fileCount));
+    const ManagedSources sources = managedSources.result();
+    for (qsizetype i = 0; i < files.size(); ++i) {
+        const QString path = files.path(i).toString();
+        files.appendSourcePath(sources.pathsByTarget.value(path));
+        if (sources.templates.contains(path)) {
+            files.setAttributes(i, FileStatusBatch::Template);
+        }
+    }
+    files.collectMetadata();
+    
+    LOG_INFO(QStringLiteral("Found %1 managed files").arg(files.size()));
     return files;
 }
 
-QHash<QString, QString> ChezmoiService::getFileStatuses()
+ChezmoiService::ManagedSources ChezmoiService::getManagedSources() const
 {
-    QHash<QString, QString> statuses;
+    // Keyed by the target chezmoi derives from each name, which is what the target listing prints
+    ManagedSources sources;
+    auto addLine = [&sources](QByteArrayView line) {
+        const QByteArrayView path = ChezmoiOutputParser::parseManagedLine(line);
+        if (path.isEmpty()) {
+            return;
+        }
+        const QString sourcePath = QString::fromUtf8(path);
+        bool isTemplate = false;
+        const QString targetPath = targetRelativePath(sourcePath, &isTemplate);
+        sources.pathsByTarget.insert(targetPath, sourcePath);
+        if (isTemplate) {
+            sources.templates.insert(targetPath);
+        }
+    };
+    if (!runStreamingQuery({QStringLiteral("managed"), QStringLiteral("--exclude=dirs"), QStringLiteral("--path-style=source-relative")}, addLine)) {
+        LOG_WARNING("Failed to list managed source paths; files will have none and no template flag"_L1);
+        return ManagedSources();
+    }
+    return sources;
+}
+
+QHash<QString, ChezmoiStatus> ChezmoiService::getFileStatuses() const
+{
+    QHash<QString, ChezmoiStatus> statuses;
     
     LOG_INFO("Getting file statuses from 'chezmoi status'"_L1);
     
@@ -139,68 +357,533 @@ QHash<QString, QString> ChezmoiService::getFileStatuses()
         return statuses;
     }
     
-    if (!runChezmoiCommand({QStringLiteral("status")}, false)) {
+    auto addLine = [&statuses](QByteArrayView line) {
+        QByteArrayView path;
+        ChezmoiStatus status;
+        if (ChezmoiOutputParser::parseStatusLine(line, &path, &status)) {
+            statuses.insert(QString::fromUtf8(path), status);
+        }
+    };
+    if (!runStreamingQuery({QStringLiteral("status")}, addLine)) {
         LOG_ERROR("Failed to run 'chezmoi status' command"_L1);
+        return QHash<QString, ChezmoiStatus>();
+    }
+    
+    LOG_INFO(QStringLiteral("Found %1 files with status changes").arg(statuses.size()));
+    return statuses;
+}
+
+QString ChezmoiService::getStateFile() const
+{
+    return ChezmoiState::defaultPath(getConfigFile());
+}
+
+QHash<QString, ChezmoiStatus> ChezmoiService::getTargetChanges(const QStringList &targetPaths) const
+{
+    // Targets edited since chezmoi last wrote them are "modified" whatever the source says, so
+    // they can be answered from the persistent state without spawning chezmoi
+    QHash<QString, ChezmoiStatus> statuses;
+    ChezmoiState state;
+    if (targetPaths.isEmpty() || !state.load(getStateFile())) {
         return statuses;
     }
     
-    QString output = QString::fromUtf8(m_process->readAllStandardOutput());
-    LOG_INFO(QStringLiteral("Chezmoi status command output (%1 chars):").arg(output.length()));
+    const QString destDir = getDestinationDirectory();
+    QStringList absolutePaths;
+    absolutePaths.reserve(targetPaths.size());
+    for (const QString &path : targetPaths) {
+        absolutePaths << destDir + u'/' + path;
+    }
+    
+    const QList<ChezmoiState::TargetChange> changes = state.compareTargets(absolutePaths);
+    for (int i = 0; i < changes.size(); ++i) {
+        if (changes.at(i) == ChezmoiState::TargetChange::Modified) {
+            // The edit is what apply would undo, so both columns read M as chezmoi would print them
+            statuses.insert(targetPaths.at(i), ChezmoiStatus(ChezmoiStatus::Modified, ChezmoiStatus::Modified));
+        }
+    }
+    
+    LOG_DEBUG(QStringLiteral("Persistent state marks %1 of %2 targets as modified").arg(statuses.size()).arg(targetPaths.size()));
+    return statuses;
+}
+
+void ChezmoiService::watchManagedFiles(const QHash<QString, QString> &sourcePathsByTarget)
+{
+    if (!m_fileWatcher->isAvailable()) {
+        return;
+    }
+    
+    m_fileWatcher->clear();
+    m_watchedPaths.clear();
+    m_pendingStatusPaths.clear();
+    m_statusBatchTimer->stop();
+    
+    m_watchedSourceDir = QDir::cleanPath(getChezmoiDirectory());
+    m_watchedDestDir = QDir::cleanPath(getDestinationDirectory());
+    if (m_watchedSourceDir.isEmpty() || m_watchedDestDir.isEmpty()) {
+        return;
+    }
+    
+    // Targets are watched through their directories, which also sees editors that save by renaming
+    QSet<QString> targetDirectories;
+    for (auto it = sourcePathsByTarget.cbegin(); it != sourcePathsByTarget.cend(); ++it) {
+        const QString targetPath = m_watchedDestDir + u'/' + it.key();
+        m_watchedPaths.insert(targetPath, it.key());
+        // Files without a listed source are only seen through the source directory's rescan
+        if (!it.value().isEmpty()) {
+            m_watchedPaths.insert(QDir::cleanPath(it.value()), it.key());
+        }
+        
+        // A missing target is watched from its nearest existing ancestor
+        QString directory = QFileInfo(targetPath).path();
+        while (!QFileInfo(directory).isDir() && directory.length() > m_watchedDestDir.length()) {
+            directory = QFileInfo(directory).path();
+        }
+        targetDirectories.insert(directory);
+    }
+    
+    m_fileWatcher->addDirectory(m_watchedSourceDir, true);
+    for (const QString &directory : std::as_const(targetDirectories)) {
+        m_fileWatcher->addDirectory(directory);
+    }
+    
+    LOG_INFO(QStringLiteral("Watching %1 managed files in %2 directories")
+             .arg(sourcePathsByTarget.size()).arg(m_fileWatcher->directories().size()));
+}
+
+void ChezmoiService::onWatchedPathsChanged(const QStringList &paths)
+{
+    bool rescan = false;
+    bool specialFilesChanged = false;
+    for (const QString &path : paths) {
+        const auto it = m_watchedPaths.constFind(path);
+        if (it != m_watchedPaths.constEnd()) {
+            m_pendingStatusPaths.insert(it.value());
+        } else if (path.startsWith(m_watchedSourceDir + u'/')) {
+            // New source files, .chezmoiignore, .chezmoidata and shared templates can change any number of targets;
+            // a new source file whose target is ignored changes none
+            rescan = rescan || !isIgnoredSource(path);
+            specialFilesChanged = specialFilesChanged || path.contains("/.chezmoi"_L1);
+        }
+        // Anything else is an unmanaged neighbour of a target
+    }
+    
+    // Data and templates feed the rendered .chezmoiignore without changing its bytes
+    if (specialFilesChanged) {
+        QMutexLocker locker(&m_ignoreMutex);
+        m_ignoreMatcher.reset();
+        m_ignoreKey.clear();
+    }
+    
+    if (rescan) {
+        LOG_DEBUG("Source directory layout changed, requesting a full rescan"_L1);
+        m_statusBatchTimer->stop();
+        m_pendingStatusPaths.clear();
+        Q_EMIT managedFilesChanged();
+        return;
+    }
+    
+    // The window starts at the first change so a busy writer cannot postpone the update indefinitely
+    if (!m_pendingStatusPaths.isEmpty() && !m_statusBatchTimer->isActive()) {
+        m_statusBatchTimer->start();
+    }
+}
+
+void ChezmoiService::flushStatusBatch()
+{
+    if (m_pendingStatusPaths.isEmpty() || m_chezmoiPath.isEmpty()) {
+        return;
+    }
+    if (m_statusProcess->state() != QProcess::NotRunning) {
+        // Picked up again when the running batch finishes
+        return;
+    }
+    
+    QStringList paths(m_pendingStatusPaths.cbegin(), m_pendingStatusPaths.cend());
+    m_pendingStatusPaths.clear();
+    
+    // Edited targets are settled by the state database alone; only the rest need chezmoi
+    const QHash<QString, ChezmoiStatus> targetChanges = getTargetChanges(paths);
+    for (auto it = targetChanges.cbegin(); it != targetChanges.cend(); ++it) {
+        Q_EMIT fileStatusChanged(it.key(), it.value());
+        paths.removeOne(it.key());
+    }
+    if (paths.isEmpty()) {
+        return;
+    }
+    
+    // A selective apply refreshes its rows without anything being watched
+    const QString destDir = m_watchedDestDir.isEmpty() ? QDir::cleanPath(getDestinationDirectory()) : m_watchedDestDir;
+    QStringList targetPaths;
+    targetPaths.reserve(paths.size());
+    for (const QString &path : std::as_const(paths)) {
+        targetPaths << destDir + u'/' + path;
+    }
+    
+    // What does not fit on one command line waits for the next batch
+    const QList<QStringList> chunks = chunkArguments(targetPaths, argumentBudget());
+    const qsizetype batchSize = chunks.first().size();
+    for (qsizetype i = batchSize; i < paths.size(); ++i) {
+        m_pendingStatusPaths.insert(paths.at(i));
+    }
+    paths.resize(batchSize);
+    m_batchPaths = QSet<QString>(paths.cbegin(), paths.cend());
+    m_statusBatchParser = ChezmoiOutputParser();
+    
+    QStringList args;
+    args << QStringLiteral("status");
+    args << chunks.first();
+    
+    LOG_DEBUG(QStringLiteral("Refreshing status of %1 changed files").arg(paths.size()));
+    m_statusProcess->start(m_chezmoiPath, args);
+}
+
+void ChezmoiService::onStatusBatchOutput()
+{
+    // Rows are updated as chezmoi reports them rather than when the whole batch is done
+    m_statusBatchParser.feed(m_statusProcess->readAllStandardOutput(), [this](QByteArrayView line) {
+        applyStatusBatchLine(line);
+    });
+}
+
+void ChezmoiService::applyStatusBatchLine(QByteArrayView line)
+{
+    QByteArrayView path;
+    ChezmoiStatus status;
+    if (!ChezmoiOutputParser::parseStatusLine(line, &path, &status)) {
+        return;
+    }
+    const QString relativePath = QString::fromUtf8(path);
+    if (m_batchPaths.remove(relativePath)) {
+        Q_EMIT fileStatusChanged(relativePath, status);
+    }
+}
+
+void ChezmoiService::onStatusBatchFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    onStatusBatchOutput();
     
-    QTextStream stream(&output);
-    QString line;
+    if (exitStatus != QProcess::NormalExit || exitCode != 0) {
+        // Usually a file that stopped being managed; only a full reload can tell
+        LOG_WARNING(QStringLiteral("chezmoi status for changed files failed: %1")
+                    .arg(QString::fromUtf8(m_statusProcess->readAllStandardError()).trimmed()));
+        m_batchPaths.clear();
+        Q_EMIT managedFilesChanged();
+        return;
+    }
     
-    while (stream.readLineInto(&line)) {
-        if (line.trimmed().isEmpty()) {
+    m_statusBatchParser.finish([this](QByteArrayView line) {
+        applyStatusBatchLine(line);
+    });
+    
+    // Paths chezmoi did not list have no differences
+    for (const QString &path : std::exchange(m_batchPaths, QSet<QString>())) {
+        Q_EMIT fileStatusChanged(path, ChezmoiStatus());
+    }
+    
+    if (!m_pendingStatusPaths.isEmpty()) {
+        m_statusBatchTimer->start();
+    }
+}
+
+bool ChezmoiService::addFiles(const QStringList &filePaths)
+{
+    return queueBulk(QStringLiteral("add"), filePaths);
+}
+
+bool ChezmoiService::forgetFiles(const QStringList &filePaths)
+{
+    return queueBulk(QStringLiteral("forget"), filePaths);
+}
+
+bool ChezmoiService::applyFiles(const QStringList &filePaths)
+{
+    return queueBulk(QStringLiteral("apply"), filePaths);
+}
+
+bool ChezmoiService::isBulkRunning() const
+{
+    return !m_bulkChunk.command.isEmpty();
+}
+
+QList<QStringList> ChezmoiService::chunkArguments(const QStringList &paths, qsizetype budget)
+{
+    QList<QStringList> chunks;
+    qsizetype used = 0;
+    for (const QString &path : paths) {
+        const qsizetype bytes = argumentBytes(path);
+        // A path too long for any run still gets a run of its own
+        if (chunks.isEmpty() || used + bytes > budget) {
+            chunks.append(QStringList());
+            used = 0;
+        }
+        chunks.last().append(path);
+        used += bytes;
+    }
+    return chunks;
+}
+
+QStringList ChezmoiService::bulkArguments(const QString &command)
+{
+    // --verbose prints a diff per file written, which progress is counted from. forget would otherwise
+    // ask for confirmation on a terminal it does not have, and apply goes on past files it cannot write
+    QStringList arguments{command, QStringLiteral("--verbose")};
+    if (command == "forget"_L1) {
+        arguments << QStringLiteral("--force");
+    } else if (command == "apply"_L1) {
+        arguments << QStringLiteral("--keep-going");
+    }
+    return arguments;
+}
+
+qsizetype ChezmoiService::argumentBudget()
+{
+#ifdef Q_OS_UNIX
+    // Arguments and environment share ARG_MAX; using half of what the environment leaves keeps a margin
+    qsizetype budget = qsizetype(sysconf(_SC_ARG_MAX));
+    const QStringList environment = QProcessEnvironment::systemEnvironment().toStringList();
+    for (const QString &variable : environment) {
+        budget -= argumentBytes(variable);
+    }
+    return qBound(MinArgumentBytes, budget / 2, MaxArgumentBytes);
+#else
+    return CommandLineBytes;
+#endif
+}
+
+bool ChezmoiService::queueBulk(const QString &command, const QStringList &filePaths)
+{
+    if (m_chezmoiPath.isEmpty() || filePaths.isEmpty()) {
+        return false;
+    }
+    
+    qsizetype fixedBytes = argumentBytes(m_chezmoiPath);
+    for (const QString &argument : bulkArguments(command)) {
+        fixedBytes += argumentBytes(argument);
+    }
+    const QList<QStringList> chunks = chunkArguments(filePaths, argumentBudget() - fixedBytes);
+    for (const QStringList &paths : chunks) {
+        m_bulkQueue.append({command, paths, {}, {}});
+    }
+    m_bulkTotal += int(filePaths.size());
+    LOG_INFO(QStringLiteral("Queued chezmoi %1 of %2 files in %3 runs").arg(command).arg(filePaths.size()).arg(chunks.size()));
+    
+    // Requests made while a bulk operation runs join its queue and its progress
+    reportBulkProgress();
+    if (!isBulkRunning()) {
+        startNextBulkChunk();
+    }
+    return true;
+}
+
+void ChezmoiService::startNextBulkChunk()
+{
+    if (m_bulkQueue.isEmpty()) {
+        const QString operation = std::exchange(m_bulkChunk, BulkChunk()).command;
+        const QStringList errors = std::exchange(m_bulkErrors, QStringList());
+        m_bulkTotal = 0;
+        m_bulkDone = 0;
+        m_bulkChunkDone = 0;
+        m_bulkProgress = -1;
+        
+        if (errors.isEmpty()) {
+            Q_EMIT bulkCompleted(true, QStringLiteral("Operation '%1' completed successfully").arg(operation));
+        } else {
+            Q_EMIT bulkCompleted(false, QStringLiteral("Operation '%1' failed: %2").arg(operation, errors.join(u'\n')));
+        }
+        return;
+    }
+    
+    m_bulkChunk = m_bulkQueue.takeFirst();
+    m_bulkChunkDone = 0;
+    m_bulkTargets.clear();
+    m_bulkParser = ChezmoiOutputParser();
+    resolveBulkTargets(&m_bulkChunk);
+    
+    if (m_bulkChunk.command == "apply"_L1 && !m_bulkChunk.targets.isEmpty()) {
+        Q_EMIT applyStarted(m_bulkChunk.targets);
+    }
+    
+    LOG_DEBUG(QStringLiteral("Running chezmoi %1 for %2 files").arg(m_bulkChunk.command).arg(m_bulkChunk.paths.size()));
+    m_bulkProcess->start(m_chezmoiPath, bulkArguments(m_bulkChunk.command) + m_bulkChunk.paths);
+}
+
+void ChezmoiService::resolveBulkTargets(BulkChunk *chunk) const
+{
+    // Requested files are known by name; what requested directories hold is only known from the diffs
+    const QDir destDir(QDir::cleanPath(getDestinationDirectory()));
+    chunk->targets.clear();
+    chunk->directories.clear();
+    for (const QString &path : std::as_const(chunk->paths)) {
+        const QString absolutePath = QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+        const QString relativePath = destDir.relativeFilePath(absolutePath);
+        if (relativePath == ".."_L1 || relativePath.startsWith("../"_L1) || QDir::isAbsolutePath(relativePath)) {
             continue;
         }
+        if (QFileInfo(absolutePath).isDir()) {
+            chunk->directories << relativePath + u'/';
+        } else {
+            chunk->targets << relativePath;
+        }
+    }
+    std::sort(chunk->targets.begin(), chunk->targets.end());
+}
+
+bool ChezmoiService::BulkChunk::covers(const QString &target) const
+{
+    return targets.contains(target) || std::any_of(directories.cbegin(), directories.cend(), [&target](const QString &directory) {
+        return target.startsWith(directory);
+    });
+}
+
+void ChezmoiService::onBulkOutput()
+{
+    m_bulkParser.feed(m_bulkProcess->readAllStandardOutput(), [this](QByteArrayView line) {
+        applyBulkLine(line);
+    });
+}
+
+void ChezmoiService::applyBulkLine(QByteArrayView line)
+{
+    // add and forget show each source file they write or delete as a diff, apply each target it writes
+    const QByteArrayView path = ChezmoiOutputParser::parseDiffLine(line);
+    if (path.isEmpty()) {
+        return;
+    }
+    if (m_bulkChunk.command == "apply"_L1) {
+        const QString target = QString::fromUtf8(path);
+        m_bulkTargets.insert(target, QString());
+        Q_EMIT fileApplied(target, true);
+    } else {
+        const QString sourcePath = QString::fromUtf8(path);
+        m_bulkTargets.insert(targetRelativePath(sourcePath), sourcePath);
+    }
+    
+    // A directory can stand for any number of files, so a run is only complete once chezmoi exits
+    m_bulkChunkDone = qMin(m_bulkChunkDone + 1, int(m_bulkChunk.paths.size()) - 1);
+    reportBulkProgress();
+}
+
+void ChezmoiService::reportBulkProgress()
+{
+    const int percentage = m_bulkTotal > 0 ? int(qint64(m_bulkDone + m_bulkChunkDone) * 100 / m_bulkTotal) : 100;
+    if (percentage != m_bulkProgress) {
+        m_bulkProgress = percentage;
+        Q_EMIT progressUpdated(percentage);
+    }
+}
+
+void ChezmoiService::onBulkFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    onBulkOutput();
+    m_bulkParser.finish([this](QByteArrayView line) {
+        applyBulkLine(line);
+    });
+    
+    const BulkChunk chunk = m_bulkChunk;
+    const bool success = exitStatus == QProcess::NormalExit && exitCode == 0;
+    const QByteArray errorOutput = m_bulkProcess->readAllStandardError();
+    if (!success) {
+        QString error = QString::fromUtf8(errorOutput).trimmed();
+        if (error.isEmpty()) {
+            error = m_bulkProcess->errorString();
+        }
+        LOG_ERROR(QStringLiteral("chezmoi %1 of %2 files failed: %3").arg(chunk.command).arg(chunk.paths.size()).arg(error));
+        m_bulkErrors << error;
+    }
+    
+    if (chunk.command == "apply"_L1) {
+        finishApplyChunk(chunk, success, errorOutput);
+    } else if (!success) {
+        // chezmoi stops at the first file it cannot handle, so only a reload can tell which ones went through
+        Q_EMIT managedFilesChanged();
+    } else {
+        QSet<QString> targets(chunk.targets.cbegin(), chunk.targets.cend());
+        for (auto it = m_bulkTargets.cbegin(); it != m_bulkTargets.cend(); ++it) {
+            if (chunk.covers(it.key())) {
+                targets.insert(it.key());
+            }
+        }
         
-        // Parse chezmoi status format: "MM filename"
-        // First character: difference between last written state and actual state
-        // Second character: difference between actual state and target state
-        if (line.length() >= 3) {
-            QString statusChars = line.left(2);
-            QString filePath = line.mid(3).trimmed();
-            
-            // Convert status characters to a descriptive status
-            QString status = u"unchanged"_s;
-            if (statusChars.contains(u'M')) {
-                status = u"modified"_s;
-            } else if (statusChars.contains(u'A')) {
-                status = u"added"_s;
-            } else if (statusChars.contains(u'D')) {
-                status = u"deleted"_s;
-            } else if (statusChars.contains(u'R')) {
-                status = u"script"_s;
+        QStringList targetPaths(targets.cbegin(), targets.cend());
+        std::sort(targetPaths.begin(), targetPaths.end());
+        if (!targetPaths.isEmpty()) {
+            if (chunk.command == "forget"_L1) {
+                Q_EMIT filesForgotten(targetPaths);
+            } else {
+                finishAddChunk(targetPaths);
             }
-            
-            statuses[filePath] = status;
-            LOG_DEBUG(QStringLiteral("File status: %1 -> %2").arg(filePath, status));
         }
     }
     
-    LOG_INFO(QStringLiteral("Found %1 files with status changes").arg(statuses.size()));
-    return statuses;
+    m_bulkDone += int(chunk.paths.size());
+    m_bulkChunkDone = 0;
+    reportBulkProgress();
+    startNextBulkChunk();
 }
 
-bool ChezmoiService::addFile(const QString &filePath)
+void ChezmoiService::finishAddChunk(const QStringList &targetPaths)
 {
-    if (m_chezmoiPath.isEmpty()) {
-        return false;
+    // Each diff names the source chezmoi wrote, which is all a new row needs besides its status
+    FileStatusBatch files(getChezmoiDirectory(), getDestinationDirectory());
+    files.reserve(targetPaths.size());
+    for (const QString &target : targetPaths) {
+        const QString sourcePath = m_bulkTargets.value(target);
+        bool isTemplate = false;
+        if (!sourcePath.isEmpty()) {
+            targetRelativePath(sourcePath, &isTemplate);
+        }
+        files.append(target, ChezmoiStatus(), isTemplate ? FileStatusBatch::Template : 0);
+        files.appendSourcePath(sourcePath);
     }
+    files.collectMetadata();
+    Q_EMIT filesAdded(files);
     
-    m_currentOperation = QStringLiteral("add");
-    return runChezmoiCommand({QStringLiteral("add"), filePath}, true);
+    // Templates and chezmoi's own transformations can leave a new file out of sync, so they get a real status
+    for (const QString &target : targetPaths) {
+        m_pendingStatusPaths.insert(target);
+    }
+    if (!m_statusBatchTimer->isActive()) {
+        m_statusBatchTimer->start();
+    }
 }
 
-bool ChezmoiService::removeFile(const QString &filePath)
+void ChezmoiService::finishApplyChunk(const BulkChunk &chunk, bool success, QByteArrayView errorOutput)
 {
-    if (m_chezmoiPath.isEmpty()) {
-        return false;
+    // With --keep-going chezmoi names every file it could not apply and carries on with the rest
+    const QDir destDir(QDir::cleanPath(getDestinationDirectory()));
+    QSet<QString> failed;
+    auto addFailure = [&failed, &destDir](QByteArrayView line) {
+        const QByteArrayView path = ChezmoiOutputParser::parseErrorLine(line);
+        if (!path.isEmpty()) {
+            const QString name = QString::fromUtf8(path);
+            failed.insert(QDir::isAbsolutePath(name) ? destDir.relativeFilePath(name) : name);
+        }
+    };
+    ChezmoiOutputParser parser;
+    parser.feed(errorOutput, addFailure);
+    parser.finish(addFailure);
+    
+    // Files without a diff were up to date already, unless chezmoi failed without naming the files
+    for (const QString &target : chunk.targets) {
+        const bool applied = failed.isEmpty() ? success : !failed.contains(target);
+        if (!applied || !m_bulkTargets.contains(target)) {
+            Q_EMIT fileApplied(target, applied);
+        }
     }
     
-    m_currentOperation = QStringLiteral("remove");
-    return runChezmoiCommand({QStringLiteral("remove"), filePath}, true);
+    // Nothing else can have changed, so only these rows ask chezmoi for their status again
+    for (const QString &target : chunk.targets) {
+        m_pendingStatusPaths.insert(target);
+    }
+    for (auto it = m_bulkTargets.cbegin(); it != m_bulkTargets.cend(); ++it) {
+        if (chunk.covers(it.key())) {
+            m_pendingStatusPaths.insert(it.key());
+        }
+    }
+    if (!m_pendingStatusPaths.isEmpty() && !m_statusBatchTimer->isActive()) {
+        m_statusBatchTimer->start();
+    }
 }
 
 bool ChezmoiService::applyChanges()
@@ -223,44 +906,44 @@ bool ChezmoiService::updateRepository()
     return runChezmoiCommand({QStringLiteral("update")}, true);
 }
 
+ChezmoiConfig *ChezmoiService::config() const
+{
+    return m_config.get();
+}
+
+qint64 ChezmoiService::savedQuerySpawns() const
+{
+    return m_savedSpawns.loadRelaxed();
+}
+
 QString ChezmoiService::getChezmoiDirectory() const
 {
+    if (m_config->isValid()) {
+        return m_config->sourceDir();
+    }
+    
     if (m_chezmoiPath.isEmpty()) {
         QString fallback = QDir::homePath() + QStringLiteral("/.local/share/chezmoi");
         LOG_WARNING(QStringLiteral("Chezmoi executable not found, using fallback directory: %1").arg(fallback));
         return fallback;
     }
     
-    QProcess process;
     LOG_DEBUG("Running 'chezmoi source-path' to get source directory"_L1);
-    process.start(m_chezmoiPath, {QStringLiteral("source-path")});
-    process.waitForFinished();
-    
-    if (process.exitCode() == 0) {
-        QString result = QString::fromUtf8(process.readAllStandardOutput()).trimmed();
+    QByteArray output;
+    if (runQuery({QStringLiteral("source-path")}, &output)) {
+        QString result = QString::fromUtf8(output).trimmed();
         LOG_INFO(QStringLiteral("Chezmoi source directory: %1").arg(result));
         return result;
     } else {
-        QString error = QString::fromUtf8(process.readAllStandardError());
         QString fallback = QDir::homePath() + QStringLiteral("/.local/share/chezmoi");
-        LOG_WARNING(QStringLiteral("Failed to get chezmoi source directory (exit code: %1, error: %2), using fallback: %3")
-                   .arg(process.exitCode()).arg(error).arg(fallback));
+        LOG_WARNING(QStringLiteral("Failed to get chezmoi source directory, using fallback: %1").arg(fallback));
         return fallback;
     }
 }
 
 QString ChezmoiService::getConfigFile() const
 {
-    QProcess process;
-    process.start(m_chezmoiPath, {QStringLiteral("dump-config")});
-    process.waitForFinished();
-    
-    if (process.exitCode() == 0) {
-        // Parse the config to find the config file path
-        // For now, return the default location
-    }
-    
-    return QDir::homePath() + QStringLiteral("/.config/chezmoi/chezmoi.toml");
+    return m_config->filePath();
 }
 
 bool ChezmoiService::runChezmoiCommand(const QStringList &arguments, bool async)
@@ -297,6 +980,134 @@ bool ChezmoiService::runChezmoiCommand(const QStringList &arguments, bool async)
     }
 }
 
+bool ChezmoiService::runQuery(const QStringList &arguments, QByteArray *output) const
+{
+    if (m_chezmoiPath.isEmpty()) {
+        LOG_ERROR("Cannot run chezmoi query: executable not found"_L1);
+        return false;
+    }
+    
+    // A config change can change the answer, so queries from before it are not joined
+    const QString key = QString::number(m_config->generation()) + u'\0' + arguments.join(u'\0');
+    std::shared_ptr<InFlightQuery> query;
+    {
+        QMutexLocker locker(&m_queryMutex);
+        query = m_inFlightQueries.value(key);
+        if (query) {
+            const qint64 saved = m_savedSpawns.fetchAndAddRelaxed(1) + 1;
+            LOG_DEBUG(QStringLiteral("Joining in-flight chezmoi %1 (%2 spawns saved)").arg(arguments.join(u' ')).arg(saved));
+            while (!query->finished) {
+                m_queryFinished.wait(&m_queryMutex);
+            }
+            if (query->succeeded) {
+                *output = query->output;
+            }
+            return query->succeeded;
+        }
+        query = std::make_shared<InFlightQuery>();
+        m_inFlightQueries.insert(key, query);
+    }
+    
+    // Waiters only read the result once finished is set under the lock
+    const bool succeeded = spawnQuery(arguments, &query->output);
+    {
+        QMutexLocker locker(&m_queryMutex);
+        query->succeeded = succeeded;
+        query->finished = true;
+        m_inFlightQueries.remove(key);
+    }
+    m_queryFinished.wakeAll();
+    
+    if (succeeded) {
+        *output = query->output;
+    }
+    return succeeded;
+}
+
+bool ChezmoiService::spawnQuery(const QStringList &arguments, QByteArray *output) const
+{
+    // A private process per query, so read-only queries can run on worker threads next to m_process
+    QProcess process;
+    LOG_DEBUG(QStringLiteral("Running chezmoi query: %1 %2").arg(m_chezmoiPath, arguments.join(u' ')));
+    process.start(m_chezmoiPath, arguments);
+    
+    if (!process.waitForFinished(QueryTimeoutMs) && process.state() != QProcess::NotRunning) {
+        LOG_ERROR(QStringLiteral("chezmoi %1 did not finish within %2 ms, killing it").arg(arguments.join(u' ')).arg(QueryTimeoutMs));
+        process.kill();
+        process.waitForFinished();
+        return false;
+    }
+    if (process.error() == QProcess::FailedToStart || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        LOG_ERROR(QStringLiteral("chezmoi %1 failed with exit code %2, error: %3")
+                  .arg(arguments.join(u' ')).arg(process.exitCode())
+                  .arg(QString::fromUtf8(process.readAllStandardError()).trimmed()));
+        return false;
+    }
+    
+    *output = process.readAllStandardOutput();
+    return true;
+}
+
+bool ChezmoiService::runStreamingQuery(const QStringList &arguments, const LineHandler &onLine, const std::function<void()> &onChunk) const
+{
+    if (m_chezmoiPath.isEmpty()) {
+        LOG_ERROR("Cannot run chezmoi query: executable not found"_L1);
+        return false;
+    }
+    
+    // Like runQuery, but lines are parsed while chezmoi is still writing them
+    QProcess process;
+    LOG_DEBUG(QStringLiteral("Running chezmoi query: %1 %2").arg(m_chezmoiPath, arguments.join(u' ')));
+    process.start(m_chezmoiPath, arguments);
+    
+    ChezmoiOutputParser parser;
+    qint64 bytes = 0;
+    auto consume = [&]() {
+        const QByteArray chunk = process.readAllStandardOutput();
+        if (!chunk.isEmpty()) {
+            bytes += chunk.size();
+            parser.feed(chunk, onLine);
+            if (onChunk) {
+                onChunk();
+            }
+        }
+    };
+    
+    if (!process.waitForStarted(QueryTimeoutMs)) {
+        LOG_ERROR(QStringLiteral("chezmoi %1 failed to start: %2").arg(arguments.join(u' '), process.errorString()));
+        process.kill();
+        return false;
+    }
+    
+    // waitForReadyRead() returns false once the process has exited and its output is drained,
+    // or with a Timedout error once chezmoi has been silent for too long
+    while (process.waitForReadyRead(QueryStallMs)) {
+        consume();
+    }
+    if (process.error() == QProcess::Timedout) {
+        LOG_ERROR(QStringLiteral("chezmoi %1 wrote nothing for %2 ms, killing it").arg(arguments.join(u' ')).arg(QueryStallMs));
+        process.kill();
+        process.waitForFinished();
+        return false;
+    }
+    process.waitForFinished();
+    consume();
+    parser.finish(onLine);
+    if (onChunk) {
+        onChunk();
+    }
+    
+    if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0 || process.error() == QProcess::FailedToStart) {
+        LOG_ERROR(QStringLiteral("chezmoi %1 failed with exit code %2, error: %3")
+                  .arg(arguments.join(u' ')).arg(process.exitCode())
+                  .arg(QString::fromUtf8(process.readAllStandardError()).trimmed()));
+        return false;
+    }
+    
+    LOG_DEBUG(QStringLiteral("chezmoi %1 streamed %2 bytes").arg(arguments.join(u' ')).arg(bytes));
+    return true;
+}
+
 void ChezmoiService::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
     // Only emit operationCompleted for async operations (when m_currentOperation is set)
@@ -349,18 +1160,20 @@ QString ChezmoiService::getCatFileContent(const QString &filePath)
     
     LOG_DEBUG(QStringLiteral("Getting file content via chezmoi cat: %1").arg(filePath));
     
-    if (!runChezmoiCommand({QStringLiteral("cat"), filePath}, false)) {
+    // Two tabs opening the same file share one 'chezmoi cat'
+    QByteArray output;
+    if (!runQuery({QStringLiteral("cat"), filePath}, &output)) {
         LOG_WARNING(QStringLiteral("Failed to run 'chezmoi cat' for file: %1").arg(filePath));
         return QString();
     }
     
-    QString content = QString::fromUtf8(m_process->readAllStandardOutput());
+    QString content = QString::fromUtf8(output);
     LOG_DEBUG(QStringLiteral("Retrieved content (%1 chars) for file: %2").arg(content.length()).arg(filePath));
     
     return content;
 }
 
-QString ChezmoiService::getSourcePath(const QString &filePath)
+QString ChezmoiService::getSourcePath(const QString &filePath) const
 {
     if (m_chezmoiPath.isEmpty()) {
         LOG_ERROR("Cannot get source path: chezmoi executable not found"_L1);
@@ -369,12 +1182,14 @@ QString ChezmoiService::getSourcePath(const QString &filePath)
     
     LOG_DEBUG(QStringLiteral("Getting source path for file: %1").arg(filePath));
     
-    if (!runChezmoiCommand({QStringLiteral("source-path"), filePath}, false)) {
+    // runQuery uses a local process, so this can be called from worker threads without touching m_process
+    QByteArray output;
+    if (!runQuery({QStringLiteral("source-path"), filePath}, &output)) {
         LOG_WARNING(QStringLiteral("Failed to run 'chezmoi source-path' for file: %1").arg(filePath));
         return QString();
     }
     
-    QString sourcePath = QString::fromUtf8(m_process->readAllStandardOutput()).trimmed();
+    QString sourcePath = QString::fromUtf8(output).trimmed();
     LOG_DEBUG(QStringLiteral("Source path for %1: %2").arg(filePath, sourcePath));
     
     return sourcePath;
@@ -382,6 +1197,10 @@ QString ChezmoiService::getSourcePath(const QString &filePath)
 
 QString ChezmoiService::getDestinationDirectory() const
 {
+    if (m_config->isValid()) {
+        return m_config->destDir();
+    }
+    
     if (m_chezmoiPath.isEmpty()) {
         LOG_ERROR("Cannot get destination directory: chezmoi executable not found"_L1);
         return QString();
@@ -389,16 +1208,14 @@ QString ChezmoiService::getDestinationDirectory() const
     
     LOG_DEBUG("Getting destination directory from chezmoi config"_L1);
     
-    // Use a temporary process since we need this to be synchronous and not interfere with m_process
-    QProcess tempProcess;
-    tempProcess.start(m_chezmoiPath, {QStringLiteral("dump-config"), QStringLiteral("--format=json")});
-    
-    if (!tempProcess.waitForFinished() || tempProcess.exitCode() != 0) {
+    // runQuery uses a local process, so this stays synchronous without interfering with m_process
+    QByteArray configOutput;
+    if (!runQuery({QStringLiteral("dump-config"), QStringLiteral("--format=json")}, &configOutput)) {
         LOG_WARNING("Failed to get chezmoi config, falling back to home directory"_L1);
         return QDir::homePath();
     }
     
-    QString output = QString::fromUtf8(tempProcess.readAllStandardOutput());
+    QString output = QString::fromUtf8(configOutput);
     
     // Parse the JSON to extract destDir
     // Simple parsing since we only need destDir
@@ -442,28 +1259,89 @@ QString ChezmoiService::convertToTargetPath(const QString &sourcePath) const
         relativePath = relativePath.mid(1);
     }
     
-    // Remove chezmoi prefixes from the filename
-    // This is a simplified conversion - chezmoi has complex rules for filename mapping
-    QStringList pathComponents = relativePath.split(u'/');
-    for (QString &component : pathComponents) {
-        // Remove common chezmoi prefixes
-        if (component.startsWith(QStringLiteral("dot_"))) {
-            component = u'.' + component.mid(4);
-        } else if (component.startsWith(QStringLiteral("private_"))) {
-            component = component.mid(8);
-        } else if (component.startsWith(QStringLiteral("executable_"))) {
-            component = component.mid(11);
+    QString targetPath = destDir + u'/' + targetRelativePath(relativePath);
+    LOG_DEBUG(QStringLiteral("Converted source path %1 to target path %2").arg(sourcePath, targetPath));
+    
+    return targetPath;
+}
+
+QString ChezmoiService::targetRelativePath(const QString &sourceRelativePath, bool *isTemplate)
+{
+    // Every component but the last names a directory, whose attributes differ from a file's
+    const QStringList components = sourceRelativePath.split(u'/', Qt::SkipEmptyParts);
+    QStringList targetComponents;
+    targetComponents.reserve(components.size());
+    for (qsizetype i = 0; i + 1 < components.size(); ++i) {
+        targetComponents.append(directoryTargetName(components.at(i)));
+    }
+    bool templated = false;
+    if (!components.isEmpty()) {
+        targetComponents.append(fileTargetName(components.last(), &templated));
+    }
+    if (isTemplate) {
+        *isTemplate = templated;
+    }
+    return targetComponents.join(u'/');
+}
+
+std::shared_ptr<const IgnoreMatcher> ChezmoiService::ignoreMatcher() const
+{
+    const QString ignorePath = QDir(getChezmoiDirectory()).filePath(QStringLiteral(".chezmoiignore"));
+    QByteArray contents;
+    QFile file(ignorePath);
+    if (file.open(QIODevice::ReadOnly)) {
+        contents = file.readAll();
+    }
+    
+    // Template data mostly comes from the config, so its generation stands in for the data
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(m_config->generation()));
+    hash.addData(contents);
+    const QByteArray key = hash.result();
+    {
+        QMutexLocker locker(&m_ignoreMutex);
+        if (m_ignoreMatcher && m_ignoreKey == key) {
+            return m_ignoreMatcher;
         }
-        // Remove .tmpl suffix for templates
-        if (component.endsWith(QStringLiteral(".tmpl"))) {
-            component = component.left(component.length() - 5);
+    }
+    
+    // Without template actions the file is its own rendering, and chezmoi need not be asked
+    QByteArray rendered = contents;
+    if (contents.contains("{{")) {
+        if (!runQuery({QStringLiteral("execute-template"), QStringLiteral("--file"), ignorePath}, &rendered)) {
+            LOG_WARNING(QStringLiteral("Could not render %1").arg(ignorePath));
+            return nullptr;
         }
     }
     
-    QString targetPath = destDir + u'/' + pathComponents.join(u'/');
-    LOG_DEBUG(QStringLiteral("Converted source path %1 to target path %2").arg(sourcePath, targetPath));
+    auto matcher = std::make_shared<IgnoreMatcher>();
+    matcher->compile(QString::fromUtf8(rendered));
+    LOG_DEBUG(QStringLiteral("Compiled %1 ignore patterns from %2").arg(matcher->patternCount()).arg(ignorePath));
     
-    return targetPath;
+    QMutexLocker locker(&m_ignoreMutex);
+    m_ignoreMatcher = matcher;
+    m_ignoreKey = key;
+    return matcher;
+}
+
+bool ChezmoiService::isIgnoredSource(const QString &sourcePath) const
+{
+    // Special files and directories shape other targets, whatever their own name would map to
+    const QString relativePath = sourcePath.mid(m_watchedSourceDir.size() + 1);
+    const QStringList components = relativePath.split(u'/');
+    for (const QString &component : components) {
+        if (component.startsWith(".chezmoi"_L1) || component == ".git"_L1) {
+            return false;
+        }
+    }
+    
+    // Only consulted once compiled; compiling can mean running chezmoi, which this thread must not wait for
+    std::shared_ptr<const IgnoreMatcher> matcher;
+    {
+        QMutexLocker locker(&m_ignoreMutex);
+        matcher = m_ignoreMatcher;
+    }
+    return matcher && matcher->isIgnored(targetRelativePath(relativePath));
 }
 
 QString ChezmoiService::getTemplateData()
@@ -475,12 +1353,13 @@ QString ChezmoiService::getTemplateData()
     
     LOG_DEBUG("Getting template data from chezmoi"_L1);
     
-    if (!runChezmoiCommand({QStringLiteral("data"), QStringLiteral("--format=json")}, false)) {
+    QByteArray output;
+    if (!runQuery({QStringLiteral("data"), QStringLiteral("--format=json")}, &output)) {
         LOG_WARNING("Failed to run 'chezmoi data --format=json'"_L1);
         return QString();
     }
     
-    QString data = QString::fromUtf8(m_process->readAllStandardOutput());
+    QString data = QString::fromUtf8(output);
     LOG_DEBUG(QStringLiteral("Retrieved template data (%1 chars)").arg(data.length()));
     
     return data;
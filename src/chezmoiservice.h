@@ -1,62 +1,184 @@
 #ifndef CHEZMOISERVICE_H
 #define CHEZMOISERVICE_H
 
+#include <QAtomicInteger>
+#include <QMutex>
 #include <QObject>
 #include <QProcess>
 #include <QStringList>
-#include <QFileInfo>
 #include <QHash>
+#include <QSet>
+#include <QWaitCondition>
+#include <functional>
 #include <memory>
 
+#include "chezmoioutputparser.h"
+#include "chezmoistatus.h"
+#include "filestatusbatch.h"
+
+class ChezmoiConfig;
+class FileWatcher;
+class IgnoreMatcher;
+class QTimer;
+
 class ChezmoiService : public QObject
 {
     Q_OBJECT
 
 public:
+    using PartialBatchHandler = std::function<void(const FileStatusBatch &)>;
+
     explicit ChezmoiService(QObject *parent = nullptr);
+    // Runs executablePath instead of looking chezmoi up; an empty path looks it up as usual
+    explicit ChezmoiService(const QString &executablePath, QObject *parent = nullptr);
     ~ChezmoiService() override;
 
-    struct FileStatus {
-        QString path;
-        QString status; // "managed", "unmanaged", "modified", etc.
-        bool isTemplate;
-        QFileInfo sourceFile;
-        QFileInfo targetFile;
-    };
-
     bool isChezmoiInitialized() const;
     bool initializeRepository(const QString &repositoryUrl = QString());
-    QList<FileStatus> getManagedFiles();
-    QHash<QString, QString> getFileStatuses();
-    bool addFile(const QString &filePath);
-    bool removeFile(const QString &filePath);
+    FileStatusBatch getManagedFiles(bool includeStatuses = true, const PartialBatchHandler &onPartial = {}) const;
+    QHash<QString, ChezmoiStatus> getFileStatuses() const;
+    QHash<QString, ChezmoiStatus> getTargetChanges(const QStringList &targetPaths) const;
+    QString getStateFile() const;
+    // Source paths are absolute, as chezmoi lists them; an empty one leaves that file to directory rescans
+    void watchManagedFiles(const QHash<QString, QString> &sourcePathsByTarget);
+    // Add or forget any number of files with as few chezmoi runs as the argument limit allows. The runs
+    // go one after another, reporting progress per file and the targets of every run as it finishes.
+    bool addFiles(const QStringList &filePaths);
+    bool forgetFiles(const QStringList &filePaths);
+    // Applies just these targets, streaming each file's result and refreshing only their statuses
+    bool applyFiles(const QStringList &filePaths);
+    bool isBulkRunning() const;
     bool applyChanges();
     bool updateRepository();
     QString getChezmoiDirectory() const;
     QString getConfigFile() const;
     QString getCatFileContent(const QString &filePath);
-    QString getSourcePath(const QString &filePath);
+    QString getSourcePath(const QString &filePath) const;
     QString getDestinationDirectory() const;
     QString convertToTargetPath(const QString &sourcePath) const;
+    // The source directory's .chezmoiignore, compiled; chezmoi only renders it when it is a template, and
+    // only again once its contents or the config change. Null when it could not be rendered.
+    std::shared_ptr<const IgnoreMatcher> ignoreMatcher() const;
     QString getTemplateData();
+    ChezmoiConfig *config() const;
+    qint64 savedQuerySpawns() const;
+    // Splits paths into runs whose arguments take at most budget bytes each
+    static QList<QStringList> chunkArguments(const QStringList &paths, qsizetype budget);
+    // The target chezmoi makes of a path relative to the source directory, stripping attribute prefixes in
+    // chezmoi's order for each entry type and the encryption, .tmpl and .literal suffixes
+    static QString targetRelativePath(const QString &sourceRelativePath, bool *isTemplate = nullptr);
 
 Q_SIGNALS:
     void operationCompleted(bool success, const QString &message);
-    void fileStatusChanged(const QString &filePath, const QString &status);
+    void fileStatusChanged(const QString &filePath, ChezmoiStatus status);
+    void managedFilesChanged();
     void progressUpdated(int percentage);
+    // The files one finished bulk run added, with their sources and template flags; their statuses follow
+    // as fileStatusChanged
+    void filesAdded(const FileStatusBatch &files);
+    // Target paths, relative to the destination directory, of one finished bulk run
+    void filesForgotten(const QStringList &targetPaths);
+    void applyStarted(const QStringList &targetPaths);
+    void fileApplied(const QString &targetPath, bool success);
+    // A bulk operation keeps rows current as it goes, so unlike operationCompleted this asks for no reload
+    void bulkCompleted(bool success, const QString &message);
+    void configurationChanged(const QStringList &keys);
 
 private Q_SLOTS:
     void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void onProcessError(QProcess::ProcessError error);
+    void onWatchedPathsChanged(const QStringList &paths);
+    void flushStatusBatch();
+    void onStatusBatchOutput();
+    void onStatusBatchFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onBulkOutput();
+    void onBulkFinished(int exitCode, QProcess::ExitStatus exitStatus);
 
 private:
+    using LineHandler = std::function<void(QByteArrayView)>;
+
+    // One chezmoi process whose output every caller asking the same question shares
+    struct InFlightQuery {
+        bool finished = false;
+        bool succeeded = false;
+        QByteArray output;
+    };
+    
+    // One 'chezmoi add', 'forget' or 'apply' run of a bulk operation
+    struct BulkChunk {
+        QString command;
+        QStringList paths;
+        QStringList targets;     // requested files, relative to the destination directory
+        QStringList directories; // requested directories, each ending in '/'
+        
+        bool covers(const QString &target) const;
+    };
+    
+    // What 'chezmoi managed' tells about the source of each target
+    struct ManagedSources {
+        QHash<QString, QString> pathsByTarget; // relative to the source directory
+        QSet<QString> templates;               // targets rendered from a .tmpl source
+    };
+
     bool runChezmoiCommand(const QStringList &arguments, bool async = false);
-    QString getChezmoiExecutable() const;
-    void parseStatusOutput(const QString &output);
+    bool runQuery(const QStringList &arguments, QByteArray *output) const;
+    bool spawnQuery(const QStringList &arguments, QByteArray *output) const;
+    bool runStreamingQuery(const QStringList &arguments, const LineHandler &onLine,
+                           const std::function<void()> &onChunk = {}) const;
+    ManagedSources getManagedSources() const;
+    void applyStatusBatchLine(QByteArrayView line);
+    bool queueBulk(const QString &command, const QStringList &filePaths);
+    void startNextBulkChunk();
+    void resolveBulkTargets(BulkChunk *chunk) const;
+    void finishAddChunk(const QStringList &targetPaths);
+    void finishApplyChunk(const BulkChunk &chunk, bool success, QByteArrayView errorOutput);
+    void applyBulkLine(QByteArrayView line);
+    void reportBulkProgress();
+    static QStringList bulkArguments(const QString &command);
+    static qsizetype argumentBudget();
+    bool isIgnoredSource(const QString &sourcePath) const;
+    static QString getChezmoiExecutable();
 
     std::unique_ptr<QProcess> m_process;
+    std::unique_ptr<ChezmoiConfig> m_config;
     QString m_chezmoiPath;
     QString m_currentOperation;
+    
+    // Live status: watched source and target paths map back to target paths, and edits are
+    // collected for a short window before one 'chezmoi status <paths>' runs for just those
+    FileWatcher *m_fileWatcher;
+    QHash<QString, QString> m_watchedPaths;
+    QString m_watchedSourceDir;
+    QString m_watchedDestDir;
+    QSet<QString> m_pendingStatusPaths;
+    QSet<QString> m_batchPaths;
+    QTimer *m_statusBatchTimer;
+    std::unique_ptr<QProcess> m_statusProcess;
+    ChezmoiOutputParser m_statusBatchParser;
+    
+    // Bulk add and forget run chunk by chunk on a process of their own, so apply and update are never trampled
+    std::unique_ptr<QProcess> m_bulkProcess;
+    QList<BulkChunk> m_bulkQueue;
+    BulkChunk m_bulkChunk;
+    ChezmoiOutputParser m_bulkParser;
+    QHash<QString, QString> m_bulkTargets; // diffed target -> source path relative to the source directory, empty for apply
+    QStringList m_bulkErrors;
+    int m_bulkTotal;
+    int m_bulkDone;
+    int m_bulkChunkDone;
+    int m_bulkProgress;
+    
+    // Single-flight: concurrent identical queries, keyed by arguments and config generation,
+    // wait for the first one's process instead of starting their own
+    mutable QMutex m_queryMutex;
+    mutable QWaitCondition m_queryFinished;
+    mutable QHash<QString, std::shared_ptr<InFlightQuery>> m_inFlightQueries;
+    mutable QAtomicInteger<qint64> m_savedSpawns;
+    
+    // Compiled .chezmoiignore, valid while the file's bytes and the config generation match m_ignoreKey
+    mutable QMutex m_ignoreMutex;
+    mutable std::shared_ptr<const IgnoreMatcher> m_ignoreMatcher;
+    mutable QByteArray m_ignoreKey;
 };
 
 #endif // CHEZMOISERVICE_H
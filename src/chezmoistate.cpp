@@ -0,0 +1,151 @@
+#include "chezmoistate.h"
+#include "boltdatabase.h"
+#include "filehasher.h"
+#include "logger.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+QByteArray readLink(const QString &path)
+{
+    QByteArray target(4096, Qt::Uninitialized);
+    const ssize_t length = ::readlink(QFile::encodeName(path).constData(), target.data(), size_t(target.size()));
+    if (length < 0) {
+        return QByteArray();
+    }
+    target.truncate(length);
+    return target;
+}
+}
+
+ChezmoiState::ChezmoiState()
+    : m_valid(false)
+    , m_entries()
+{
+}
+
+QString ChezmoiState::defaultPath(const QString &configFile)
+{
+    // chezmoi keeps its state next to its configuration file
+    const QString configDir = configFile.isEmpty()
+        ? QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + "/chezmoi"_L1
+        : QFileInfo(configFile).path();
+    return configDir + "/chezmoistate.boltdb"_L1;
+}
+
+bool ChezmoiState::load(const QString &databasePath)
+{
+    m_entries.clear();
+
+    BoltDatabase database(databasePath);
+    m_valid = database.isValid();
+    if (!m_valid) {
+        return false;
+    }
+
+    // Keys are absolute target paths, values JSON like {"type":"file","mode":420,"contentsSHA256":"<hex>"}.
+    // A database without the bucket belongs to a chezmoi that has not applied anything yet.
+    database.forEach({QByteArrayLiteral("entryState")}, [this](const QByteArray &key, const QByteArray &value) {
+        const QJsonObject object = QJsonDocument::fromJson(value).object();
+        EntryState state;
+        state.type = object.value("type"_L1).toString();
+        state.mode = quint32(object.value("mode"_L1).toInteger());
+        state.contentsSha256 = QByteArray::fromHex(object.value("contentsSHA256"_L1).toString().toLatin1());
+        m_entries.insert(QString::fromUtf8(key), state);
+    });
+
+    LOG_DEBUG(QStringLiteral("ChezmoiState: %1 entry states at transaction %2")
+              .arg(m_entries.size()).arg(database.transactionId()));
+    return true;
+}
+
+bool ChezmoiState::isValid() const
+{
+    return m_valid;
+}
+
+int ChezmoiState::size() const
+{
+    return m_entries.size();
+}
+
+bool ChezmoiState::contains(const QString &targetPath) const
+{
+    return m_entries.contains(targetPath);
+}
+
+ChezmoiState::EntryState ChezmoiState::entryState(const QString &targetPath) const
+{
+    return m_entries.value(targetPath);
+}
+
+ChezmoiState::TargetChange ChezmoiState::compareTarget(const QString &targetPath) const
+{
+    const auto it = m_entries.constFind(targetPath);
+    if (it == m_entries.constEnd() || it->type == "script"_L1) {
+        return TargetChange::Unknown;
+    }
+    const EntryState &state = *it;
+
+    struct stat info;
+    const bool exists = ::lstat(QFile::encodeName(targetPath).constData(), &info) == 0;
+
+    if (state.type == "remove"_L1) {
+        return exists ? TargetChange::Modified : TargetChange::Unchanged;
+    }
+    if (!exists) {
+        return TargetChange::Missing;
+    }
+
+    if (state.type == "dir"_L1) {
+        return S_ISDIR(info.st_mode) ? TargetChange::Unchanged : TargetChange::Modified;
+    }
+
+    if (state.type == "symlink"_L1) {
+        if (!S_ISLNK(info.st_mode)) {
+            return TargetChange::Modified;
+        }
+        if (state.contentsSha256.isEmpty()) {
+            return TargetChange::Unchanged;
+        }
+        const QByteArray linkHash = QCryptographicHash::hash(readLink(targetPath), QCryptographicHash::Sha256);
+        return linkHash == state.contentsSha256 ? TargetChange::Unchanged : TargetChange::Modified;
+    }
+
+    if (state.type == "file"_L1) {
+        if (!S_ISREG(info.st_mode)) {
+            return TargetChange::Modified;
+        }
+        // Compare the cheap stat data before hashing
+        const quint32 permissions = state.mode & 0777;
+        if (permissions != 0 && (info.st_mode & 0777) != permissions) {
+            return TargetChange::Modified;
+        }
+        if (state.contentsSha256.isEmpty()) {
+            return info.st_size == 0 ? TargetChange::Unchanged : TargetChange::Modified;
+        }
+        return FileHasher::instance()->hash(targetPath) == state.contentsSha256 ? TargetChange::Unchanged : TargetChange::Modified;
+    }
+
+    return TargetChange::Unknown;
+}
+
+QList<ChezmoiState::TargetChange> ChezmoiState::compareTargets(const QStringList &targetPaths) const
+{
+    // Hashing is I/O and CPU bound per file, so spread it over the global thread pool
+    return QtConcurrent::blockingMapped<QList<TargetChange>>(targetPaths, [this](const QString &targetPath) {
+        return compareTarget(targetPath);
+    });
+}
@@ -0,0 +1,51 @@
+#ifndef CHEZMOISTATE_H
+#define CHEZMOISTATE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief chezmoi's persistent state, read from its bbolt database
+ *
+ * Holds the entry state chezmoi recorded when it last wrote each target,
+ * which is what the first column of 'chezmoi status' compares the
+ * destination against. Comparing targets hashes them in parallel.
+ */
+class ChezmoiState
+{
+public:
+    enum class TargetChange {
+        Unknown,   // chezmoi has no record of writing this target
+        Unchanged,
+        Modified,  // contents, mode or type differ from what chezmoi last wrote
+        Missing
+    };
+
+    struct EntryState {
+        QString type;              // "file", "dir", "symlink", "remove" or "script"
+        quint32 mode = 0;
+        QByteArray contentsSha256; // raw digest, empty when chezmoi stored none
+    };
+
+    ChezmoiState();
+
+    static QString defaultPath(const QString &configFile);
+
+    bool load(const QString &databasePath);
+    bool isValid() const;
+    int size() const;
+    bool contains(const QString &targetPath) const;
+    EntryState entryState(const QString &targetPath) const;
+
+    TargetChange compareTarget(const QString &targetPath) const;
+    QList<TargetChange> compareTargets(const QStringList &targetPaths) const;
+
+private:
+    bool m_valid;
+    QHash<QString, EntryState> m_entries; // keyed by absolute target path
+};
+
+#endif // CHEZMOISTATE_H
@@ -0,0 +1,66 @@
+#include "chezmoistatus.h"
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+ChezmoiStatus::Change changeFromCode(char code)
+{
+    switch (code) {
+    case 'A': return ChezmoiStatus::Added;
+    case 'D': return ChezmoiStatus::Deleted;
+    case 'M': return ChezmoiStatus::Modified;
+    case 'R': return ChezmoiStatus::Run;
+    default: return ChezmoiStatus::NoChange;
+    }
+}
+
+QChar codeForChange(ChezmoiStatus::Change change)
+{
+    static constexpr char16_t codes[] = u" RDAM";
+    return QChar(codes[qMin(int(change), 4)]);
+}
+
+QString describeChange(ChezmoiStatus::Change change)
+{
+    switch (change) {
+    case ChezmoiStatus::Added: return u"added"_s;
+    case ChezmoiStatus::Deleted: return u"deleted"_s;
+    case ChezmoiStatus::Modified: return u"modified"_s;
+    case ChezmoiStatus::Run: return u"script would run"_s;
+    case ChezmoiStatus::NoChange: break;
+    }
+    return u"unchanged"_s;
+}
+}
+
+ChezmoiStatus ChezmoiStatus::fromCodes(char actualCode, char targetCode)
+{
+    return ChezmoiStatus(changeFromCode(actualCode), changeFromCode(targetCode));
+}
+
+QString ChezmoiStatus::codes() const
+{
+    const QChar chars[] = {codeForChange(actualChange()), codeForChange(targetChange())};
+    return QString(chars, 2);
+}
+
+QString ChezmoiStatus::name() const
+{
+    switch (summary()) {
+    case Modified: return u"modified"_s;
+    case Added: return u"added"_s;
+    case Deleted: return u"deleted"_s;
+    case Run: return u"script"_s;
+    case NoChange: break;
+    }
+    return u"managed"_s;
+}
+
+QString ChezmoiStatus::description() const
+{
+    if (isClean()) {
+        return u"Up to date"_s;
+    }
+    return QStringLiteral("Since last apply: %1\nOn next apply: %2")
+        .arg(describeChange(actualChange()), describeChange(targetChange()));
+}
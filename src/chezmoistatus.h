@@ -0,0 +1,61 @@
+#ifndef CHEZMOISTATUS_H
+#define CHEZMOISTATUS_H
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * @brief Both columns of a 'chezmoi status' line, packed into one byte
+ *
+ * The first column compares the target with what chezmoi last wrote there,
+ * the second compares it with what 'chezmoi apply' would write. Each is one
+ * of ' ', A, D, M or R. Predicates are plain bit tests; strings are only
+ * built for display.
+ */
+class ChezmoiStatus
+{
+public:
+    // Ordered by how much attention they need, so the larger of two changes wins a summary
+    enum Change : quint8 {
+        NoChange = 0,
+        Run = 1,      // R, a script would run
+        Deleted = 2,  // D
+        Added = 3,    // A
+        Modified = 4  // M
+    };
+
+    constexpr ChezmoiStatus() = default;
+    constexpr ChezmoiStatus(Change actualChange, Change targetChange)
+        : m_bits(quint8(actualChange << 4 | targetChange))
+    {
+    }
+
+    static ChezmoiStatus fromCodes(char actualCode, char targetCode);
+    static constexpr ChezmoiStatus fromBits(quint8 bits)
+    {
+        ChezmoiStatus status;
+        status.m_bits = bits;
+        return status;
+    }
+
+    constexpr Change actualChange() const { return Change(m_bits >> 4); }
+    constexpr Change targetChange() const { return Change(m_bits & 0x0f); }
+    constexpr Change summary() const { return qMax(actualChange(), targetChange()); }
+    constexpr quint8 bits() const { return m_bits; }
+
+    constexpr bool isClean() const { return m_bits == 0; }
+    constexpr bool isDirty() const { return summary() >= Deleted; }
+    // Changed since chezmoi wrote it, and apply would overwrite that change
+    constexpr bool isConflict() const { return actualChange() >= Deleted && targetChange() >= Deleted; }
+
+    constexpr bool operator==(const ChezmoiStatus &other) const = default;
+
+    QString codes() const;
+    QString name() const;
+    QString description() const;
+
+private:
+    quint8 m_bits = 0;
+};
+
+#endif // CHEZMOISTATUS_H
@@ -0,0 +1,257 @@
+#include "commitlogmodel.h"
+#include "logger.h"
+
+#include <QLocale>
+#include <KLocalizedString>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+constexpr int PageSize = 200;
+constexpr char RecordSeparator = '\x1e';
+constexpr char FieldSeparator = '\x1f';
+}
+
+CommitLogModel::CommitLogModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_process()
+    , m_buffer()
+    , m_entries()
+    , m_visibleCount(0)
+    , m_fetchPending(false)
+    , m_workTree()
+{
+}
+
+CommitLogModel::~CommitLogModel()
+{
+    clear();
+}
+
+void CommitLogModel::start(const QString &workTree, const QString &path)
+{
+    clear();
+
+    m_workTree = workTree;
+    m_process = std::make_unique<QProcess>();
+    m_process->setWorkingDirectory(workTree);
+
+    connect(m_process.get(), &QProcess::readyReadStandardOutput, this, &CommitLogModel::onReadyRead);
+    connect(m_process.get(), QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &CommitLogModel::onProcessFinished);
+
+    // One record per commit: header fields, then the file's path in that commit from --name-only
+    m_process->start("git"_L1, {
+        "-c"_L1, "core.quotePath=false"_L1,
+        "log"_L1, "--follow"_L1, "--name-only"_L1,
+        "--format=%x1e%H%x1f%h%x1f%an%x1f%at%x1f%s"_L1,
+        "--"_L1, path
+    });
+
+    LOG_DEBUG(QStringLiteral("Streaming history of %1 in %2").arg(path, workTree));
+    Q_EMIT loadingChanged(true);
+}
+
+void CommitLogModel::clear()
+{
+    if (m_process) {
+        m_process->disconnect(this);
+        m_process->kill();
+        m_process->waitForFinished(1000);
+        m_process.reset();
+        Q_EMIT loadingChanged(false);
+    }
+
+    beginResetModel();
+    m_buffer.clear();
+    m_entries.clear();
+    m_visibleCount = 0;
+    m_fetchPending = false;
+    m_workTree.clear();
+    endResetModel();
+}
+
+bool CommitLogModel::isLoading() const
+{
+    return m_process && m_process->state() != QProcess::NotRunning;
+}
+
+const CommitLogModel::Entry *CommitLogModel::entry(int row) const
+{
+    if (row < 0 || row >= m_visibleCount) {
+        return nullptr;
+    }
+    return &m_entries.at(row);
+}
+
+void CommitLogModel::onReadyRead()
+{
+    m_buffer += m_process->readAllStandardOutput();
+    parseBuffer(false);
+}
+
+void CommitLogModel::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    m_buffer += m_process->readAllStandardOutput();
+    parseBuffer(true);
+
+    if (exitCode != 0 || exitStatus != QProcess::NormalExit) {
+        LOG_WARNING(QStringLiteral("git log failed: %1").arg(QString::fromUtf8(m_process->readAllStandardError()).trimmed()));
+    }
+
+    LOG_DEBUG(QStringLiteral("History loaded: %1 commits").arg(m_entries.size()));
+    Q_EMIT loadingChanged(false);
+}
+
+void CommitLogModel::parseBuffer(bool final)
+{
+    qsizetype start = m_buffer.indexOf(RecordSeparator);
+    if (start < 0) {
+        if (final) {
+            m_buffer.clear();
+        }
+        return;
+    }
+
+    const int parsedBefore = m_entries.size();
+
+    // A record is only complete once the next separator (or the end of output) has arrived
+    while (start < m_buffer.size()) {
+        qsizetype next = m_buffer.indexOf(RecordSeparator, start + 1);
+        if (next < 0) {
+            if (!final) {
+                break;
+            }
+            next = m_buffer.size();
+        }
+        parseRecord(m_buffer.mid(start + 1, next - start - 1));
+        start = next;
+    }
+    m_buffer.remove(0, start);
+
+    const int parsed = m_entries.size() - parsedBefore;
+    if (parsed == 0) {
+        return;
+    }
+
+    // Show the first page as soon as it exists, and satisfy a view that asked for more while we waited
+    if (m_visibleCount < PageSize) {
+        revealRows(PageSize - m_visibleCount);
+    } else if (m_fetchPending) {
+        m_fetchPending = false;
+        revealRows(PageSize);
+    }
+}
+
+void CommitLogModel::parseRecord(const QByteArray &record)
+{
+    const qsizetype headerEnd = record.indexOf('\n');
+    const QList<QByteArray> fields = record.left(headerEnd < 0 ? record.size() : headerEnd).split(FieldSeparator);
+    if (fields.size() != 5) {
+        return;
+    }
+
+    Entry entry;
+    entry.id = QString::fromLatin1(fields[0]);
+    entry.shortId = QString::fromLatin1(fields[1]);
+    entry.author = QString::fromUtf8(fields[2]);
+    entry.time = QDateTime::fromSecsSinceEpoch(fields[3].toLongLong());
+    entry.subject = QString::fromUtf8(fields[4]);
+
+    if (headerEnd >= 0) {
+        const QList<QByteArray> lines = record.mid(headerEnd + 1).split('\n');
+        for (const QByteArray &line : lines) {
+            if (!line.trimmed().isEmpty()) {
+                entry.path = QString::fromUtf8(line);
+                break;
+            }
+        }
+    }
+
+    m_entries.append(entry);
+}
+
+void CommitLogModel::revealRows(int count)
+{
+    const int available = m_entries.size() - m_visibleCount;
+    const int rows = qMin(count, available);
+    if (rows <= 0) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), m_visibleCount, m_visibleCount + rows - 1);
+    m_visibleCount += rows;
+    endInsertRows();
+}
+
+int CommitLogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_visibleCount;
+}
+
+int CommitLogModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant CommitLogModel::data(const QModelIndex &index, int role) const
+{
+    const Entry *commit = index.isValid() ? entry(index.row()) : nullptr;
+    if (!commit) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+        switch (index.column()) {
+        case SubjectColumn: return commit->subject;
+        case AuthorColumn: return commit->author;
+        case DateColumn: return QLocale().toString(commit->time, QLocale::ShortFormat);
+        case CommitColumn: return commit->shortId;
+        }
+        break;
+
+    case Qt::ToolTipRole:
+        return QStringLiteral("%1\n%2\n%3").arg(commit->id, commit->path, commit->subject);
+    }
+
+    return QVariant();
+}
+
+QVariant CommitLogModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (section) {
+    case SubjectColumn: return i18n("Subject");
+    case AuthorColumn: return i18n("Author");
+    case DateColumn: return i18n("Date");
+    case CommitColumn: return i18n("Commit");
+    }
+
+    return QVariant();
+}
+
+bool CommitLogModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return false;
+    }
+    return m_visibleCount < m_entries.size() || isLoading();
+}
+
+void CommitLogModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    if (m_visibleCount < m_entries.size()) {
+        revealRows(PageSize);
+    } else if (isLoading()) {
+        // Nothing buffered yet; hand out the next page as soon as git produces it
+        m_fetchPending = true;
+    }
+}
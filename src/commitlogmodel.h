@@ -0,0 +1,74 @@
+#ifndef COMMITLOGMODEL_H
+#define COMMITLOGMODEL_H
+
+#include <QAbstractTableModel>
+#include <QDateTime>
+#include <QProcess>
+#include <memory>
+
+/**
+ * @brief Lazily paged list of the commits touching one file
+ *
+ * Streams `git log --follow` output as it is produced and exposes it to views
+ * one page at a time through canFetchMore()/fetchMore(), so the first page
+ * shows up long before git has walked a large history.
+ */
+class CommitLogModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        SubjectColumn,
+        AuthorColumn,
+        DateColumn,
+        CommitColumn,
+        ColumnCount
+    };
+
+    struct Entry {
+        QString id;
+        QString shortId;
+        QString author;
+        QDateTime time;
+        QString subject;
+        QString path; // path of the file in this commit, which differs before a rename
+    };
+
+    explicit CommitLogModel(QObject *parent = nullptr);
+    ~CommitLogModel() override;
+
+    void start(const QString &workTree, const QString &path);
+    void clear();
+    bool isLoading() const;
+    const Entry *entry(int row) const;
+    const QString &workTree() const { return m_workTree; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+Q_SIGNALS:
+    void loadingChanged(bool loading);
+
+private Q_SLOTS:
+    void onReadyRead();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    void parseBuffer(bool final);
+    void parseRecord(const QByteArray &record);
+    void revealRows(int count);
+
+    std::unique_ptr<QProcess> m_process;
+    QByteArray m_buffer;
+    QList<Entry> m_entries;
+    int m_visibleCount;
+    bool m_fetchPending;
+    QString m_workTree;
+};
+
+#endif // COMMITLOGMODEL_H
@@ -1,4 +1,5 @@
 #include "configeditor.h"
+#include "chezmoiconfig.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -14,9 +15,31 @@
 #include <QStandardPaths>
 #include <QDir>
 #include <QSettings>
+#include <QHash>
+#include <QTimer>
+#include <QHideEvent>
 
-ConfigEditor::ConfigEditor(QWidget *parent)
+namespace {
+// Edits are persisted once typing has settled for this long
+constexpr int SaveDelayMs = 500;
+
+// Settings that chezmoi itself reads, mapped to their key in chezmoi's config file
+const QHash<QString, QString> &chezmoiConfigKeys()
+{
+    static const QHash<QString, QString> keys = {
+        {QStringLiteral("sourceDirectory"), QStringLiteral("sourceDir")},
+        {QStringLiteral("workingTree"), QStringLiteral("workingTree")},
+        {QStringLiteral("useBuiltinGit"), QStringLiteral("useBuiltinGit")},
+        {QStringLiteral("gitAutoCommit"), QStringLiteral("git.commitMessageTemplate")},
+        {QStringLiteral("gitAutoPush"), QStringLiteral("git.autoPush")},
+    };
+    return keys;
+}
+}
+
+ConfigEditor::ConfigEditor(ChezmoiConfig *chezmoiConfig, QWidget *parent)
     : QWidget(parent)
+    , m_chezmoiConfig(chezmoiConfig)
     , m_mainLayout(nullptr)
     , m_generalGroup(nullptr)
     , m_sourceDirectoryEdit(nullptr)
@@ -34,13 +57,36 @@ ConfigEditor::ConfigEditor(QWidget *parent)
     , m_gitAutoPushCheck(nullptr)
     , m_advancedGroup(nullptr)
     , m_customConfigEdit(nullptr)
+    , m_values()
+    , m_persistedValues()
+    , m_dirtyKeys()
+    , m_saveTimer(new QTimer(this))
 {
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(SaveDelayMs);
+    connect(m_saveTimer, &QTimer::timeout, this, [this]() {
+        flush(true);
+    });
+
     setupUI();
-    connectSignals();
     loadConfiguration();
+    connectSignals();
+
+    // Pick up edits made to chezmoi's config outside DotWeaver, unless the user is mid-edit here
+    if (m_chezmoiConfig) {
+        connect(m_chezmoiConfig, &ChezmoiConfig::changed, this, [this]() {
+            if (!hasPendingChanges()) {
+                loadConfiguration();
+            }
+        });
+    }
 }
 
-ConfigEditor::~ConfigEditor() = default;
+ConfigEditor::~ConfigEditor()
+{
+    // Receivers may already be gone during teardown, so persist without notifying
+    flush(false);
+}
 
 void ConfigEditor::setupUI()
 {
@@ -65,8 +111,10 @@ void ConfigEditor::setupUI()
     generalLayout->addRow(tr("Source Directory:"), sourceDirLayout);
     
     m_workingTreeEdit = new QLineEdit(this);
-    m_workingTreeEdit->setPlaceholderText(tr("~"));
-    generalLayout->addRow(tr("Working Tree:"), m_workingTreeEdit);
+    m_workingTreeEdit->setPlaceholderText(tr("Same as source directory"));
+    m_workingTreeEdit->setToolTip(tr("Directory chezmoi runs git in; only differs from the source directory "
+                                     "when the source directory is a subdirectory of the repository"));
+    generalLayout->addRow(tr("Git Working Tree:"), m_workingTreeEdit);
     
     m_useBuiltinGitCheck = new QCheckBox(tr("Use built-in Git functionality"), this);
     generalLayout->addRow(m_useBuiltinGitCheck);
@@ -138,17 +186,39 @@ void ConfigEditor::setupUI()
 
 void ConfigEditor::connectSignals()
 {
-    connect(m_sourceDirectoryEdit, &QLineEdit::textChanged, this, &ConfigEditor::onConfigValueChanged);
-    connect(m_workingTreeEdit, &QLineEdit::textChanged, this, &ConfigEditor::onConfigValueChanged);
-    connect(m_useBuiltinGitCheck, &QCheckBox::toggled, this, &ConfigEditor::onConfigValueChanged);
-    connect(m_editorCommandEdit, &QLineEdit::textChanged, this, &ConfigEditor::onConfigValueChanged);
-    connect(m_autoSaveCheck, &QCheckBox::toggled, this, &ConfigEditor::onConfigValueChanged);
-    connect(m_autoSaveIntervalSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, &ConfigEditor::onConfigValueChanged);
-    connect(m_templateLeftDelimEdit, &QLineEdit::textChanged, this, &ConfigEditor::onConfigValueChanged);
-    connect(m_templateRightDelimEdit, &QLineEdit::textChanged, this, &ConfigEditor::onConfigValueChanged);
-    connect(m_gitAutoCommitEdit, &QLineEdit::textChanged, this, &ConfigEditor::onConfigValueChanged);
-    connect(m_gitAutoPushCheck, &QCheckBox::toggled, this, &ConfigEditor::onConfigValueChanged);
-    connect(m_customConfigEdit, &QTextEdit::textChanged, this, &ConfigEditor::onConfigValueChanged);
+    connect(m_sourceDirectoryEdit, &QLineEdit::textChanged, this, [this](const QString &text) {
+        setValue(QStringLiteral("sourceDirectory"), text);
+    });
+    connect(m_workingTreeEdit, &QLineEdit::textChanged, this, [this](const QString &text) {
+        setValue(QStringLiteral("workingTree"), text);
+    });
+    connect(m_useBuiltinGitCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        setValue(QStringLiteral("useBuiltinGit"), checked);
+    });
+    connect(m_editorCommandEdit, &QLineEdit::textChanged, this, [this](const QString &text) {
+        setValue(QStringLiteral("editorCommand"), text);
+    });
+    connect(m_autoSaveCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        setValue(QStringLiteral("autoSave"), checked);
+    });
+    connect(m_autoSaveIntervalSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, [this](int value) {
+        setValue(QStringLiteral("autoSaveInterval"), value);
+    });
+    connect(m_templateLeftDelimEdit, &QLineEdit::textChanged, this, [this](const QString &text) {
+        setValue(QStringLiteral("templateLeftDelim"), text);
+    });
+    connect(m_templateRightDelimEdit, &QLineEdit::textChanged, this, [this](const QString &text) {
+        setValue(QStringLiteral("templateRightDelim"), text);
+    });
+    connect(m_gitAutoCommitEdit, &QLineEdit::textChanged, this, [this](const QString &text) {
+        setValue(QStringLiteral("gitAutoCommit"), text);
+    });
+    connect(m_gitAutoPushCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        setValue(QStringLiteral("gitAutoPush"), checked);
+    });
+    connect(m_customConfigEdit, &QTextEdit::textChanged, this, [this]() {
+        setValue(QStringLiteral("customConfig"), m_customConfigEdit->toPlainText());
+    });
     
     // Enable/disable auto-save interval based on auto-save checkbox
     connect(m_autoSaveCheck, &QCheckBox::toggled, m_autoSaveIntervalSpin, &QSpinBox::setEnabled);
@@ -156,70 +226,148 @@ void ConfigEditor::connectSignals()
 
 void ConfigEditor::loadConfiguration()
 {
+    // Anything not yet written would be overwritten by the reload
+    m_saveTimer->stop();
+    m_dirtyKeys.clear();
+
     QSettings settings(QStringLiteral("DotWeaver"), QStringLiteral("DotWeaver"));
     
-    // General settings
-    QString defaultSourceDir = QDir::homePath() + QStringLiteral("/.local/share/chezmoi");
-    m_sourceDirectoryEdit->setText(settings.value(QStringLiteral("sourceDirectory"), defaultSourceDir).toString());
-    m_workingTreeEdit->setText(settings.value(QStringLiteral("workingTree"), QDir::homePath()).toString());
-    m_useBuiltinGitCheck->setChecked(settings.value(QStringLiteral("useBuiltinGit"), true).toBool());
-    
-    // Editor settings
     QString defaultEditor = QStringLiteral("kate");
     if (QStandardPaths::findExecutable(QStringLiteral("kwrite")).isEmpty() == false) {
         defaultEditor = QStringLiteral("kwrite");
     } else if (QStandardPaths::findExecutable(QStringLiteral("gedit")).isEmpty() == false) {
         defaultEditor = QStringLiteral("gedit");
     }
-    m_editorCommandEdit->setText(settings.value(QStringLiteral("editorCommand"), defaultEditor).toString());
-    m_autoSaveCheck->setChecked(settings.value(QStringLiteral("autoSave"), false).toBool());
-    m_autoSaveIntervalSpin->setValue(settings.value(QStringLiteral("autoSaveInterval"), 30).toInt());
+
+    const QString defaultSourceDir = m_chezmoiConfig ? m_chezmoiConfig->sourceDir() : QString(QDir::homePath() + QStringLiteral("/.local/share/chezmoi"));
+    const QVariantMap defaults = {
+        {QStringLiteral("sourceDirectory"), defaultSourceDir},
+        // chezmoi's git working tree defaults to the source directory, never to the home directory
+        {QStringLiteral("workingTree"), m_chezmoiConfig ? m_chezmoiConfig->workingTree() : defaultSourceDir},
+        {QStringLiteral("useBuiltinGit"), true},
+        {QStringLiteral("editorCommand"), defaultEditor},
+        {QStringLiteral("autoSave"), false},
+        {QStringLiteral("autoSaveInterval"), 30},
+        {QStringLiteral("templateLeftDelim"), QStringLiteral("{{")},
+        {QStringLiteral("templateRightDelim"), QStringLiteral("}}")},
+        {QStringLiteral("gitAutoCommit"), QString()},
+        {QStringLiteral("gitAutoPush"), false},
+        {QStringLiteral("customConfig"), QStringLiteral("# Add custom chezmoi configuration here\n")},
+    };
+
+    m_values.clear();
+    for (auto it = defaults.constBegin(); it != defaults.constEnd(); ++it) {
+        QVariant value;
+        if (isStoredInChezmoiConfig(it.key())) {
+            value = m_chezmoiConfig->value(chezmoiConfigKeys().value(it.key()), it.value());
+        } else {
+            value = settings.value(it.key(), it.value());
+        }
+        // INI and TOML values may not have the widget's type; match it so comparisons hold
+        value.convert(it.value().metaType());
+        m_values.insert(it.key(), value);
+    }
+    m_persistedValues = m_values;
+
+    // The widgets echo back the values just loaded, which setValue() ignores
+
+    // General settings
+    m_sourceDirectoryEdit->setText(m_values.value(QStringLiteral("sourceDirectory")).toString());
+    m_workingTreeEdit->setText(m_values.value(QStringLiteral("workingTree")).toString());
+    m_useBuiltinGitCheck->setChecked(m_values.value(QStringLiteral("useBuiltinGit")).toBool());
+    
+    // Editor settings
+    m_editorCommandEdit->setText(m_values.value(QStringLiteral("editorCommand")).toString());
+    m_autoSaveCheck->setChecked(m_values.value(QStringLiteral("autoSave")).toBool());
+    m_autoSaveIntervalSpin->setValue(m_values.value(QStringLiteral("autoSaveInterval")).toInt());
     
     // Template settings
-    m_templateLeftDelimEdit->setText(settings.value(QStringLiteral("templateLeftDelim"), QStringLiteral("{{")).toString());
-    m_templateRightDelimEdit->setText(settings.value(QStringLiteral("templateRightDelim"), QStringLiteral("}}")).toString());
+    m_templateLeftDelimEdit->setText(m_values.value(QStringLiteral("templateLeftDelim")).toString());
+    m_templateRightDelimEdit->setText(m_values.value(QStringLiteral("templateRightDelim")).toString());
     
     // Git settings
-    m_gitAutoCommitEdit->setText(settings.value(QStringLiteral("gitAutoCommit"), QStringLiteral("Auto-commit from KChezmoi")).toString());
-    m_gitAutoPushCheck->setChecked(settings.value(QStringLiteral("gitAutoPush"), false).toBool());
+    m_gitAutoCommitEdit->setText(m_values.value(QStringLiteral("gitAutoCommit")).toString());
+    m_gitAutoPushCheck->setChecked(m_values.value(QStringLiteral("gitAutoPush")).toBool());
     
     // Advanced settings
-    m_customConfigEdit->setPlainText(settings.value(QStringLiteral("customConfig"), QStringLiteral("# Add custom chezmoi configuration here\n")).toString());
-    
+    m_customConfigEdit->setPlainText(m_values.value(QStringLiteral("customConfig")).toString());
+
     // Update UI state
     m_autoSaveIntervalSpin->setEnabled(m_autoSaveCheck->isChecked());
 }
 
 void ConfigEditor::saveConfiguration()
 {
+    flush(true);
+}
+
+bool ConfigEditor::hasPendingChanges() const
+{
+    return !m_dirtyKeys.isEmpty();
+}
+
+void ConfigEditor::setValue(const QString &key, const QVariant &value)
+{
+    if (m_values.value(key) == value) {
+        return;
+    }
+    m_values.insert(key, value);
+
+    // Typing a value back to what is on disk leaves nothing to write
+    if (m_persistedValues.value(key) == value) {
+        m_dirtyKeys.remove(key);
+    } else {
+        m_dirtyKeys.insert(key);
+    }
+
+    if (m_dirtyKeys.isEmpty()) {
+        m_saveTimer->stop();
+    } else {
+        m_saveTimer->start();
+    }
+}
+
+void ConfigEditor::flush(bool notify)
+{
+    m_saveTimer->stop();
+    if (m_dirtyKeys.isEmpty()) {
+        return;
+    }
+
+    QStringList changedKeys(m_dirtyKeys.cbegin(), m_dirtyKeys.cend());
+    changedKeys.sort();
+    m_dirtyKeys.clear();
+
     QSettings settings(QStringLiteral("DotWeaver"), QStringLiteral("DotWeaver"));
-    
-    // General settings
-    settings.setValue(QStringLiteral("sourceDirectory"), m_sourceDirectoryEdit->text());
-    settings.setValue(QStringLiteral("workingTree"), m_workingTreeEdit->text());
-    settings.setValue(QStringLiteral("useBuiltinGit"), m_useBuiltinGitCheck->isChecked());
-    
-    // Editor settings
-    settings.setValue(QStringLiteral("editorCommand"), m_editorCommandEdit->text());
-    settings.setValue(QStringLiteral("autoSave"), m_autoSaveCheck->isChecked());
-    settings.setValue(QStringLiteral("autoSaveInterval"), m_autoSaveIntervalSpin->value());
-    
-    // Template settings
-    settings.setValue(QStringLiteral("templateLeftDelim"), m_templateLeftDelimEdit->text());
-    settings.setValue(QStringLiteral("templateRightDelim"), m_templateRightDelimEdit->text());
-    
-    // Git settings
-    settings.setValue(QStringLiteral("gitAutoCommit"), m_gitAutoCommitEdit->text());
-    settings.setValue(QStringLiteral("gitAutoPush"), m_gitAutoPushCheck->isChecked());
-    
-    // Advanced settings
-    settings.setValue(QStringLiteral("customConfig"), m_customConfigEdit->toPlainText());
-    
+    bool chezmoiConfigChanged = false;
+    for (const QString &key : std::as_const(changedKeys)) {
+        const QVariant value = m_values.value(key);
+        if (isStoredInChezmoiConfig(key)) {
+            m_chezmoiConfig->setValue(chezmoiConfigKeys().value(key), value);
+            chezmoiConfigChanged = true;
+        } else {
+            settings.setValue(key, value);
+        }
+        m_persistedValues.insert(key, value);
+    }
     settings.sync();
+    if (chezmoiConfigChanged) {
+        m_chezmoiConfig->save();
+    }
+
+    if (notify) {
+        Q_EMIT configurationChanged(changedKeys);
+    }
+}
+
+bool ConfigEditor::isStoredInChezmoiConfig(const QString &key) const
+{
+    return m_chezmoiConfig && m_chezmoiConfig->isValid() && chezmoiConfigKeys().contains(key);
 }
 
-void ConfigEditor::onConfigValueChanged()
+void ConfigEditor::hideEvent(QHideEvent *event)
 {
-    saveConfiguration();
-    Q_EMIT configurationChanged();
+    // Closing the settings dialog should not leave edits waiting on the timer
+    flush(true);
+    QWidget::hideEvent(event);
 }
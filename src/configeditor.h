@@ -2,6 +2,9 @@
 #define CONFIGEDITOR_H
 
 #include <QWidget>
+#include <QSet>
+#include <QStringList>
+#include <QVariantMap>
 
 class QVBoxLayout;
 class QFormLayout;
@@ -10,28 +13,35 @@ class QCheckBox;
 class QSpinBox;
 class QTextEdit;
 class QGroupBox;
+class QTimer;
+class ChezmoiConfig;
 
 class ConfigEditor : public QWidget
 {
     Q_OBJECT
 
 public:
-    explicit ConfigEditor(QWidget *parent = nullptr);
+    explicit ConfigEditor(ChezmoiConfig *chezmoiConfig, QWidget *parent = nullptr);
     ~ConfigEditor() override;
 
     void loadConfiguration();
     void saveConfiguration();
+    bool hasPendingChanges() const;
 
 Q_SIGNALS:
-    void configurationChanged();
+    void configurationChanged(const QStringList &changedKeys);
 
-private Q_SLOTS:
-    void onConfigValueChanged();
+protected:
+    void hideEvent(QHideEvent *event) override;
 
 private:
     void setupUI();
     void connectSignals();
+    void setValue(const QString &key, const QVariant &value);
+    void flush(bool notify);
+    bool isStoredInChezmoiConfig(const QString &key) const;
 
+    ChezmoiConfig *m_chezmoiConfig;
     QVBoxLayout *m_mainLayout;
     
     // General settings
@@ -59,6 +69,12 @@ private:
     // Advanced settings
     QGroupBox *m_advancedGroup;
     QTextEdit *m_customConfigEdit;
+    
+    // In-memory settings; only keys that differ from what is on disk are written back
+    QVariantMap m_values;
+    QVariantMap m_persistedValues;
+    QSet<QString> m_dirtyKeys;
+    QTimer *m_saveTimer;
 };
 
 #endif // CONFIGEDITOR_H
@@ -0,0 +1,404 @@
+#include "contentsearch.h"
+#include "logger.h"
+
+#include <QFile>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// Bytes checked for a NUL to tell binary files apart, the same heuristic git uses
+constexpr qsizetype BinaryProbeBytes = 8000;
+
+// Matches a worker collects before handing them to the GUI thread
+constexpr qsizetype BatchSize = 256;
+
+// Longer lines are cut in the results, so minified files don't flood the view
+constexpr qsizetype MaxLineTextLength = 300;
+
+char asciiLower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? char(c + ('a' - 'A')) : c;
+}
+
+bool equalAt(const char *data, QByteArrayView needle, bool caseSensitive)
+{
+    if (caseSensitive) {
+        return std::memcmp(data, needle.data(), size_t(needle.size())) == 0;
+    }
+    for (qsizetype i = 0; i < needle.size(); ++i) {
+        if (asciiLower(data[i]) != asciiLower(needle[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Offset of the next '\n' at or after from, or the end of the contents
+qsizetype lineEndAt(QByteArrayView contents, qsizetype from)
+{
+    const void *newline = std::memchr(contents.data() + from, '\n', size_t(contents.size() - from));
+    return newline ? static_cast<const char *>(newline) - contents.data() : contents.size();
+}
+}
+
+struct ContentSearch::Run {
+    Run(const QStringList &searchFiles, const Pattern &searchPattern)
+        : files(searchFiles)
+        , pattern(searchPattern)
+    {
+    }
+
+    const QStringList files;
+    const Pattern pattern;
+    QAtomicInteger<qint64> nextFile{0};
+    QAtomicInt cancelled{0};
+    QAtomicInt activeWorkers{0};
+};
+
+ContentSearch::Pattern::Pattern(const QString &text, const Options &options)
+    : m_literal()
+    , m_caseSensitive(options.caseSensitive)
+    , m_useRegex(options.regularExpression)
+    , m_regex()
+{
+    QString literal = options.regularExpression ? requiredLiteral(text) : text;
+
+    // ASCII folding can't compare other scripts without regard to case; QRegularExpression can
+    const bool asciiOnly = std::all_of(literal.cbegin(), literal.cend(), [](QChar c) { return c.unicode() < 0x80; });
+    if (!m_caseSensitive && !asciiOnly) {
+        m_useRegex = true;
+        literal.clear();
+    }
+    m_literal = literal.toUtf8();
+
+    if (m_useRegex) {
+        m_regex.setPattern(options.regularExpression ? text : QRegularExpression::escape(text));
+        m_regex.setPatternOptions(m_caseSensitive ? QRegularExpression::NoPatternOption
+                                                  : QRegularExpression::CaseInsensitiveOption);
+        m_regex.optimize();
+    }
+}
+
+bool ContentSearch::Pattern::isValid() const
+{
+    return m_useRegex ? !m_regex.pattern().isEmpty() && m_regex.isValid() : !m_literal.isEmpty();
+}
+
+QString ContentSearch::Pattern::errorString() const
+{
+    if (m_useRegex && !m_regex.isValid()) {
+        return m_regex.errorString();
+    }
+    return isValid() ? QString() : QStringLiteral("Empty search pattern");
+}
+
+QList<ContentSearch::Match> ContentSearch::Pattern::searchFile(const QString &filePath) const
+{
+    QList<Match> matches;
+    if (filePath.contains("/.git/"_L1)) {
+        return matches;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return matches;
+    }
+
+    // Mapped rather than read, so pages are only touched where the scan goes
+    QByteArray buffer;
+    QByteArrayView contents;
+    if (const uchar *mapped = file.map(0, file.size())) {
+        contents = QByteArrayView(reinterpret_cast<const char *>(mapped), file.size());
+    } else {
+        buffer = file.readAll();
+        contents = buffer;
+    }
+
+    if (std::memchr(contents.data(), 0, size_t(qMin(contents.size(), BinaryProbeBytes)))) {
+        return matches;
+    }
+
+    // Line numbers are counted lazily, only up to where the next match is
+    int line = 0;
+    qsizetype lineStart = 0;
+    auto seek = [&](qsizetype position) {
+        const char *cursor = contents.data() + lineStart;
+        const char *target = contents.data() + position;
+        while (const void *newline = std::memchr(cursor, '\n', size_t(target - cursor))) {
+            ++line;
+            cursor = static_cast<const char *>(newline) + 1;
+        }
+        lineStart = cursor - contents.data();
+    };
+    auto lineText = [&](qsizetype lineEnd) {
+        QByteArrayView text = contents.sliced(lineStart, lineEnd - lineStart);
+        if (text.endsWith('\r')) {
+            text.chop(1);
+        }
+        return QString::fromUtf8(text);
+    };
+    auto addMatch = [&](const QString &text, qsizetype column, qsizetype length) {
+        Match match;
+        match.filePath = filePath;
+        match.line = line;
+        match.column = int(column);
+        match.length = int(length);
+        match.lineText = text.size() > MaxLineTextLength ? text.first(MaxLineTextLength) : text;
+        matches.append(match);
+    };
+
+    // One result per line, like grep
+    qsizetype position = 0;
+    while (position < contents.size()) {
+        if (!m_literal.isEmpty()) {
+            const qsizetype found = findLiteral(contents, m_literal, position, m_caseSensitive);
+            if (found < 0) {
+                break;
+            }
+            position = found;
+        }
+        seek(position);
+        const qsizetype lineEnd = lineEndAt(contents, position);
+        const QString text = lineText(lineEnd);
+
+        if (!m_useRegex) {
+            addMatch(text, QString::fromUtf8(contents.sliced(lineStart, position - lineStart)).size(),
+                     QString::fromUtf8(contents.sliced(position, m_literal.size())).size());
+        } else if (const QRegularExpressionMatch match = m_regex.match(text); match.hasMatch()) {
+            addMatch(text, match.capturedStart(), match.capturedLength());
+        }
+        position = lineEnd + 1;
+    }
+    return matches;
+}
+
+ContentSearch::ContentSearch(QObject *parent)
+    : QObject(parent)
+    , m_run()
+    , m_workers()
+    , m_runId(0)
+    , m_errorString()
+{
+}
+
+ContentSearch::~ContentSearch()
+{
+    if (m_run) {
+        m_run->cancelled.storeRelaxed(1);
+    }
+    waitForWorkers();
+}
+
+bool ContentSearch::start(const QStringList &files, const QString &pattern, const Options &options)
+{
+    cancel();
+
+    const Pattern prepared(pattern, options);
+    if (!prepared.isValid()) {
+        m_errorString = prepared.errorString();
+        LOG_WARNING(QStringLiteral("ContentSearch: Invalid pattern '%1': %2").arg(pattern, m_errorString));
+        return false;
+    }
+    m_errorString.clear();
+
+    // Workers from cancelled searches may still be finishing their current file
+    m_workers.removeIf([](const QFuture<void> &worker) { return worker.isFinished(); });
+
+    auto run = std::make_shared<Run>(files, prepared);
+    m_run = run;
+    const quint64 runId = ++m_runId;
+    const int workerCount = qBound(1, QThreadPool::globalInstance()->maxThreadCount(), qMax(1, int(files.size())));
+    run->activeWorkers.storeRelaxed(workerCount);
+    LOG_INFO(QStringLiteral("ContentSearch: Searching %1 files for '%2' on %3 threads")
+             .arg(files.size()).arg(pattern).arg(workerCount));
+
+    for (int i = 0; i < workerCount; ++i) {
+        m_workers.append(QtConcurrent::run([this, run, runId]() {
+            auto deliver = [this, runId](const QList<Match> &matches) {
+                QMetaObject::invokeMethod(this, [this, runId, matches]() {
+                    if (runId == m_runId) {
+                        Q_EMIT matchesFound(matches);
+                    }
+                }, Qt::QueuedConnection);
+            };
+
+            QList<Match> batch;
+            for (qint64 index = run->nextFile.fetchAndAddRelaxed(1);
+                 index < run->files.size() && !run->cancelled.loadRelaxed();
+                 index = run->nextFile.fetchAndAddRelaxed(1)) {
+                batch += run->pattern.searchFile(run->files.at(index));
+                if (batch.size() >= BatchSize) {
+                    deliver(std::exchange(batch, {}));
+                }
+            }
+            if (!batch.isEmpty() && !run->cancelled.loadRelaxed()) {
+                deliver(batch);
+            }
+
+            // The last worker out reports the end, after every batch it and the others posted
+            if (run->activeWorkers.fetchAndSubOrdered(1) == 1) {
+                QMetaObject::invokeMethod(this, [this, runId]() {
+                    if (runId == m_runId) {
+                        m_run.reset();
+                        Q_EMIT finished(false);
+                    }
+                }, Qt::QueuedConnection);
+            }
+        }));
+    }
+    return true;
+}
+
+void ContentSearch::cancel()
+{
+    if (!m_run) {
+        return;
+    }
+
+    // Batches already posted carry the old id and are dropped on arrival
+    m_run->cancelled.storeRelaxed(1);
+    m_run.reset();
+    ++m_runId;
+    LOG_INFO("ContentSearch: Search cancelled"_L1);
+    Q_EMIT finished(true);
+}
+
+bool ContentSearch::isRunning() const
+{
+    return m_run != nullptr;
+}
+
+QString ContentSearch::errorString() const
+{
+    return m_errorString;
+}
+
+void ContentSearch::waitForWorkers()
+{
+    for (QFuture<void> &worker : m_workers) {
+        worker.waitForFinished();
+    }
+    m_workers.clear();
+}
+
+qsizetype ContentSearch::findLiteral(QByteArrayView haystack, QByteArrayView needle, qsizetype from, bool caseSensitive)
+{
+    const qsizetype length = needle.size();
+    if (length == 0) {
+        return from <= haystack.size() ? from : -1;
+    }
+
+    const char *data = haystack.data();
+    const qsizetype size = haystack.size();
+    qsizetype i = from;
+#if defined(__SSE2__)
+    // Sixteen candidate positions at a time: both the first and the last byte of the needle
+    // have to line up before the bytes between are compared. Without regard to case, setting
+    // bit 0x20 on both sides folds ASCII letters together; the comparison sorts out the rest.
+    const char fold = caseSensitive ? 0 : 0x20;
+    const __m128i foldMask = _mm_set1_epi8(fold);
+    const __m128i first = _mm_set1_epi8(char(needle.front() | fold));
+    const __m128i last = _mm_set1_epi8(char(needle.back() | fold));
+    for (; i + length - 1 + 16 <= size; i += 16) {
+        const __m128i head = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)), foldMask);
+        const __m128i tail = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + length - 1)), foldMask);
+        quint32 candidates = quint32(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last))));
+        while (candidates) {
+            const qsizetype candidate = i + qCountTrailingZeroBits(candidates);
+            if (equalAt(data + candidate, needle, caseSensitive)) {
+                return candidate;
+            }
+            candidates &= candidates - 1;
+        }
+    }
+#endif
+    for (; i + length <= size; ++i) {
+        if (equalAt(data + i, needle, caseSensitive)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+QString ContentSearch::requiredLiteral(const QString &pattern)
+{
+    // Only plain characters outside groups are certain to be in a match; anything clever gives up
+    QString best;
+    QString current;
+    int depth = 0;
+    auto endRun = [&]() {
+        if (current.size() > best.size()) {
+            best = current;
+        }
+        current.clear();
+    };
+
+    for (qsizetype i = 0; i < pattern.size(); ++i) {
+        const QChar c = pattern.at(i);
+        QChar literal;
+        if (c == u'\\') {
+            if (i + 1 >= pattern.size()) {
+                break;
+            }
+            literal = pattern.at(++i);
+            if (literal.isLetterOrNumber()) {
+                // \d, \w, \b, back-references and the like are classes or assertions
+                endRun();
+                continue;
+            }
+        } else if (c == u'|' || (c == u'(' && pattern.mid(i + 1, 1) == "?"_L1)) {
+            // Alternatives and inline options can make any run optional
+            return QString();
+        } else if (c == u'[') {
+            endRun();
+            qsizetype end = i + 1;
+            if (end < pattern.size() && pattern.at(end) == u'^') {
+                ++end;
+            }
+            if (end < pattern.size() && pattern.at(end) == u']') {
+                ++end;
+            }
+            while (end < pattern.size() && pattern.at(end) != u']') {
+                end += pattern.at(end) == u'\\' ? 2 : 1;
+            }
+            i = end;
+            continue;
+        } else if (c == u'(' || c == u')') {
+            endRun();
+            depth += c == u'(' ? 1 : -1;
+            continue;
+        } else if (c == u'*' || c == u'?' || c == u'{') {
+            // The quantified character may not be there at all
+            if (!current.isEmpty()) {
+                current.chop(1);
+            }
+            endRun();
+            if (c == u'{') {
+                const qsizetype end = pattern.indexOf(u'}', i);
+                i = end < 0 ? pattern.size() : end;
+            }
+            continue;
+        } else if (c == u'.' || c == u'^' || c == u'$' || c == u'+') {
+            endRun();
+            continue;
+        } else {
+            literal = c;
+        }
+
+        if (depth == 0) {
+            current += literal;
+        }
+    }
+    endRun();
+    return best;
+}
@@ -0,0 +1,92 @@
+#ifndef CONTENTSEARCH_H
+#define CONTENTSEARCH_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFuture>
+#include <QList>
+#include <QObject>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+/**
+ * @brief Searches the contents of many files at once, reporting matching lines as they are found
+ *
+ * Files are memory-mapped and shared out to the global thread pool one at
+ * a time. A literal search runs entirely on an SSE2 scan for the first and
+ * last byte of the text; a regular expression is only run on lines that
+ * contain its longest required literal, when it has one. Binary files and
+ * anything under a .git directory are skipped. Matches arrive in batches
+ * through matchesFound() until finished(); cancel() stops the workers
+ * between files and drops whatever they have not delivered yet.
+ */
+class ContentSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options {
+        bool regularExpression = false;
+        bool caseSensitive = false;
+    };
+
+    struct Match {
+        QString filePath;
+        int line = 0;   // zero-based
+        int column = 0; // zero-based, in characters
+        int length = 0;
+        QString lineText;
+    };
+
+    // What one search looks for, prepared once and shared by the workers
+    class Pattern
+    {
+    public:
+        Pattern(const QString &text, const Options &options);
+
+        bool isValid() const;
+        QString errorString() const;
+        // Bytes every matching line must contain, empty when nothing is certain
+        const QByteArray &literal() const { return m_literal; }
+
+        QList<Match> searchFile(const QString &filePath) const;
+
+    private:
+        QByteArray m_literal;
+        bool m_caseSensitive;
+        bool m_useRegex;
+        QRegularExpression m_regex;
+    };
+
+    explicit ContentSearch(QObject *parent = nullptr);
+    ~ContentSearch() override;
+
+    // Replaces any running search; false when the pattern is empty or not a valid expression
+    bool start(const QStringList &files, const QString &pattern, const Options &options);
+    void cancel();
+    bool isRunning() const;
+    QString errorString() const;
+
+    // Offset of needle in haystack at or after from, or -1; case-insensitive matching folds ASCII only
+    static qsizetype findLiteral(QByteArrayView haystack, QByteArrayView needle, qsizetype from, bool caseSensitive);
+    // Longest run of characters a regular expression cannot match without, or empty
+    static QString requiredLiteral(const QString &pattern);
+
+Q_SIGNALS:
+    void matchesFound(const QList<ContentSearch::Match> &matches);
+    void finished(bool cancelled);
+
+private:
+    struct Run;
+
+    void waitForWorkers();
+
+    std::shared_ptr<Run> m_run;
+    QList<QFuture<void>> m_workers;
+    quint64 m_runId;
+    QString m_errorString;
+};
+
+#endif // CONTENTSEARCH_H
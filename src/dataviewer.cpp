@@ -1,6 +1,7 @@
 #include "dataviewer.h"
 #include "chezmoiservice.h"
 #include "logger.h"
+#include "memoryregistry.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -35,7 +36,14 @@ DataViewer::DataViewer(const QString &jsonData, QWidget *parent)
     , m_copyPathButton(nullptr)
     , m_mainLayout(nullptr)
     , m_buttonLayout(nullptr)
+    , m_data()
+    , m_memoryReporter(0)
 {
+    // Estimated from the compact JSON, which is about what the parsed values hold
+    m_memoryReporter = MemoryRegistry::instance()->add(QStringLiteral("Template data"), [this]() {
+        return MemoryRegistry::Usage{QJsonDocument(m_data).toJson(QJsonDocument::Compact).size(), m_data.size()};
+    });
+    
     setWindowTitle(i18n("Chezmoi Template Data"));
     setWindowIcon(QIcon::fromTheme(QStringLiteral("code-context")));
     resize(800, 600);
@@ -44,6 +52,11 @@ DataViewer::DataViewer(const QString &jsonData, QWidget *parent)
     loadJsonData(jsonData);
 }
 
+DataViewer::~DataViewer()
+{
+    MemoryRegistry::instance()->remove(m_memoryReporter);
+}
+
 void DataViewer::setupUI()
 {
     m_mainLayout = new QVBoxLayout(this);
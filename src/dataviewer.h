@@ -24,7 +24,7 @@ class DataViewer : public QDialog
 
 public:
     explicit DataViewer(const QString &jsonData, QWidget *parent = nullptr);
-    ~DataViewer() override = default;
+    ~DataViewer() override;
 
 public Q_SLOTS:
     void expandAllItems();
@@ -54,6 +54,7 @@ private:
     QHBoxLayout *m_buttonLayout;
     
     QJsonObject m_data;
+    quint64 m_memoryReporter;
 };
 
 #endif // DATAVIEWER_H
@@ -0,0 +1,304 @@
+#include "dotfilefiltermodel.h"
+#include "logger.h"
+
+using namespace Qt::Literals::StringLiterals;
+
+DotfileFilterModel::DotfileFilterModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+    , m_manager(nullptr)
+    , m_sourceConnections()
+    , m_nodes()
+    , m_nodeByItem()
+    , m_files()
+    , m_foldedPaths()
+    , m_visibleFiles(0)
+    , m_filterText()
+    , m_changes(AllChanges)
+    , m_templatesOnly(false)
+    , m_invalidatePending(false)
+{
+}
+
+void DotfileFilterModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    for (const QMetaObject::Connection &connection : std::as_const(m_sourceConnections)) {
+        disconnect(connection);
+    }
+    m_sourceConnections.clear();
+
+    // Connected ahead of the base class, so the nodes are current by the time it filters new rows
+    m_manager = qobject_cast<DotfileManager *>(sourceModel);
+    if (m_manager) {
+        m_sourceConnections = {
+            connect(m_manager, &QAbstractItemModel::modelReset, this, &DotfileFilterModel::rebuild),
+            connect(m_manager, &QAbstractItemModel::rowsInserted, this, &DotfileFilterModel::onRowsInserted),
+            connect(m_manager, &QAbstractItemModel::rowsAboutToBeRemoved, this, &DotfileFilterModel::onRowsAboutToBeRemoved),
+            connect(m_manager, &QAbstractItemModel::dataChanged, this, &DotfileFilterModel::onDataChanged),
+        };
+    } else if (sourceModel) {
+        LOG_WARNING("DotfileFilterModel: Source is not a DotfileManager, nothing will be filtered"_L1);
+    }
+
+    rebuild();
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+}
+
+QString DotfileFilterModel::filterText() const
+{
+    return m_filterText;
+}
+
+void DotfileFilterModel::setFilterText(const QString &text)
+{
+    const QString folded = text.trimmed().toLower();
+    if (folded == m_filterText) {
+        return;
+    }
+
+    // Longer text can only drop files and shorter text can only add them, so the rest keep their answer
+    const bool narrowing = folded.contains(m_filterText);
+    const bool widening = m_filterText.contains(folded);
+    m_filterText = folded;
+
+    bool changed = false;
+    for (const qsizetype index : std::as_const(m_files)) {
+        const Node &node = m_nodes.at(index);
+        if (!node.item || (narrowing && !node.textMatch) || (widening && node.textMatch)) {
+            continue;
+        }
+        changed |= updateNode(index, matchesText(node), node.statusMatch);
+    }
+
+    if (changed) {
+        invalidateRowsFilter();
+    }
+}
+
+DotfileFilterModel::ChangeMask DotfileFilterModel::changeFilter() const
+{
+    return m_changes;
+}
+
+void DotfileFilterModel::setChangeFilter(ChangeMask changes)
+{
+    if (changes == m_changes) {
+        return;
+    }
+    m_changes = changes;
+    recheckStatuses();
+}
+
+bool DotfileFilterModel::templatesOnly() const
+{
+    return m_templatesOnly;
+}
+
+void DotfileFilterModel::setTemplatesOnly(bool templatesOnly)
+{
+    if (templatesOnly == m_templatesOnly) {
+        return;
+    }
+    m_templatesOnly = templatesOnly;
+    recheckStatuses();
+}
+
+bool DotfileFilterModel::isFiltering() const
+{
+    return !m_filterText.isEmpty() || m_changes != AllChanges || m_templatesOnly;
+}
+
+int DotfileFilterModel::visibleFileCount() const
+{
+    return m_visibleFiles;
+}
+
+bool DotfileFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    if (!isFiltering()) {
+        return true;
+    }
+
+    // Rows the nodes have not caught up with yet stay visible until they do
+    const QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
+    const qsizetype node = m_nodeByItem.value(index.internalPointer(), -1);
+    return node < 0 || m_nodes.at(node).visibleFiles > 0;
+}
+
+void DotfileFilterModel::rebuild()
+{
+    m_nodes.clear();
+    m_nodeByItem.clear();
+    m_files.clear();
+    m_foldedPaths.clear();
+    m_visibleFiles = 0;
+
+    if (!m_manager) {
+        return;
+    }
+
+    const int rows = m_manager->rowCount();
+    for (int row = 0; row < rows; ++row) {
+        addSubtree(static_cast<const DotfileManager::DotfileItem *>(m_manager->index(row, 0).internalPointer()), -1);
+    }
+}
+
+void DotfileFilterModel::onRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    const qsizetype parentNode = parent.isValid() ? m_nodeByItem.value(parent.internalPointer(), -1) : -1;
+    const int visibleBefore = m_visibleFiles;
+    for (int row = first; row <= last; ++row) {
+        addSubtree(static_cast<const DotfileManager::DotfileItem *>(m_manager->index(row, 0, parent).internalPointer()), parentNode);
+    }
+
+    // A file showing up can reveal directories above it that were hidden
+    if (m_visibleFiles != visibleBefore) {
+        scheduleInvalidate();
+    }
+}
+
+void DotfileFilterModel::onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    const int visibleBefore = m_visibleFiles;
+    for (int row = first; row <= last; ++row) {
+        removeSubtree(static_cast<const DotfileManager::DotfileItem *>(m_manager->index(row, 0, parent).internalPointer()));
+    }
+
+    if (m_visibleFiles != visibleBefore) {
+        scheduleInvalidate();
+    }
+}
+
+void DotfileFilterModel::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    // Directories repaint with their files; only files carry a status of their own
+    bool changed = false;
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const QModelIndex index = topLeft.siblingAtRow(row);
+        const qsizetype node = m_nodeByItem.value(index.internalPointer(), -1);
+        if (node >= 0 && m_nodes.at(node).isFile) {
+            changed |= updateNode(node, m_nodes.at(node).textMatch, matchesStatus(m_nodes.at(node).item));
+        }
+    }
+
+    if (changed) {
+        scheduleInvalidate();
+    }
+}
+
+void DotfileFilterModel::addSubtree(const DotfileManager::DotfileItem *item, qsizetype parent)
+{
+    if (!item) {
+        return;
+    }
+
+    // Copied first: appending a view of the pool to itself could read freed memory
+    const QString parentPath = parent >= 0
+        ? QStringView(m_foldedPaths).sliced(m_nodes.at(parent).pathStart, m_nodes.at(parent).pathLength).toString() + u'/'
+        : QString();
+
+    Node node;
+    node.item = item;
+    node.parent = parent;
+    node.pathStart = quint32(m_foldedPaths.size());
+    m_foldedPaths += parentPath;
+    m_foldedPaths += item->name.toLower();
+    node.pathLength = quint32(m_foldedPaths.size()) - node.pathStart;
+    node.isFile = !item->isDirectory;
+    node.textMatch = false;
+    node.statusMatch = false;
+    node.visibleFiles = 0;
+
+    const qsizetype index = m_nodes.size();
+    m_nodes.append(node);
+    m_nodeByItem.insert(item, index);
+
+    if (node.isFile) {
+        m_files.append(index);
+        updateNode(index, matchesText(node), matchesStatus(item));
+    }
+
+    for (const DotfileManager::DotfileItem *child : item->children) {
+        addSubtree(child, index);
+    }
+}
+
+void DotfileFilterModel::removeSubtree(const DotfileManager::DotfileItem *item)
+{
+    const auto it = m_nodeByItem.constFind(item);
+    if (it == m_nodeByItem.cend()) {
+        return;
+    }
+    const qsizetype index = it.value();
+    m_nodeByItem.erase(it);
+
+    for (const DotfileManager::DotfileItem *child : item->children) {
+        removeSubtree(child);
+    }
+
+    // The node stays as a tombstone so other indices remain valid; the next reset compacts
+    if (m_nodes.at(index).isFile) {
+        updateNode(index, false, false);
+    }
+    m_nodes[index].item = nullptr;
+}
+
+bool DotfileFilterModel::updateNode(qsizetype node, bool textMatch, bool statusMatch)
+{
+    Node &target = m_nodes[node];
+    const bool wasVisible = target.textMatch && target.statusMatch;
+    target.textMatch = textMatch;
+    target.statusMatch = statusMatch;
+
+    const bool visible = textMatch && statusMatch;
+    if (visible == wasVisible) {
+        return false;
+    }
+
+    const int delta = visible ? 1 : -1;
+    for (qsizetype ancestor = node; ancestor >= 0; ancestor = m_nodes.at(ancestor).parent) {
+        m_nodes[ancestor].visibleFiles += delta;
+    }
+    m_visibleFiles += delta;
+    return true;
+}
+
+bool DotfileFilterModel::matchesText(const Node &node) const
+{
+    return m_filterText.isEmpty()
+        || QStringView(m_foldedPaths).sliced(node.pathStart, node.pathLength).contains(m_filterText);
+}
+
+bool DotfileFilterModel::matchesStatus(const DotfileManager::DotfileItem *item) const
+{
+    return (m_changes & changeBit(item->status.summary())) && (!m_templatesOnly || item->isTemplate);
+}
+
+void DotfileFilterModel::recheckStatuses()
+{
+    bool changed = false;
+    for (const qsizetype index : std::as_const(m_files)) {
+        const Node &node = m_nodes.at(index);
+        if (node.item) {
+            changed |= updateNode(index, node.textMatch, matchesStatus(node.item));
+        }
+    }
+
+    if (changed) {
+        invalidateRowsFilter();
+    }
+}
+
+void DotfileFilterModel::scheduleInvalidate()
+{
+    // Source signals are still being delivered to the base class, so re-filtering waits for the event loop
+    if (m_invalidatePending) {
+        return;
+    }
+    m_invalidatePending = true;
+    QMetaObject::invokeMethod(this, [this]() {
+        m_invalidatePending = false;
+        if (isFiltering()) {
+            invalidateRowsFilter();
+        }
+    }, Qt::QueuedConnection);
+}
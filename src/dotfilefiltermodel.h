@@ -0,0 +1,94 @@
+#ifndef DOTFILEFILTERMODEL_H
+#define DOTFILEFILTERMODEL_H
+
+#include <QHash>
+#include <QList>
+#include <QSortFilterProxyModel>
+
+#include "chezmoistatus.h"
+#include "dotfilemanager.h"
+
+/**
+ * @brief Narrows the dotfile tree by path text, change type and template flag
+ *
+ * Every node keeps whether it passes the text and status filters, and
+ * every directory keeps how many files below it pass both, so deciding
+ * whether a row is shown is one lookup. Changing the text only rechecks
+ * the files whose answer can change: the matching ones when the text
+ * grows, the others when it shrinks. Source inserts, removals and status
+ * updates adjust the counts along the affected branch only.
+ */
+class DotfileFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    // One bit per ChezmoiStatus::Change, tested against a file's status summary
+    using ChangeMask = quint8;
+    static constexpr ChangeMask changeBit(ChezmoiStatus::Change change) { return ChangeMask(1u << change); }
+    static constexpr ChangeMask AllChanges = 0x1f;
+    static constexpr ChangeMask DirtyChanges = ChangeMask(1u << ChezmoiStatus::Deleted | 1u << ChezmoiStatus::Added
+                                                          | 1u << ChezmoiStatus::Modified);
+
+    explicit DotfileFilterModel(QObject *parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
+    // Case-insensitive substring of the relative target path
+    QString filterText() const;
+    void setFilterText(const QString &text);
+
+    ChangeMask changeFilter() const;
+    void setChangeFilter(ChangeMask changes);
+
+    bool templatesOnly() const;
+    void setTemplatesOnly(bool templatesOnly);
+
+    bool isFiltering() const;
+    int visibleFileCount() const;
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private Q_SLOTS:
+    void rebuild();
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+private:
+    struct Node {
+        const DotfileManager::DotfileItem *item; // null once removed from the source
+        qsizetype parent;                        // -1 at the top level
+        quint32 pathStart;                       // lower-cased relative path in m_foldedPaths
+        quint32 pathLength;
+        bool isFile;
+        bool textMatch;
+        bool statusMatch;
+        int visibleFiles; // files at or below this node passing both filters
+    };
+
+    void addSubtree(const DotfileManager::DotfileItem *item, qsizetype parent);
+    void removeSubtree(const DotfileManager::DotfileItem *item);
+    bool updateNode(qsizetype node, bool textMatch, bool statusMatch);
+    bool matchesText(const Node &node) const;
+    bool matchesStatus(const DotfileManager::DotfileItem *item) const;
+    void recheckStatuses();
+    void scheduleInvalidate();
+
+    DotfileManager *m_manager;
+    QList<QMetaObject::Connection> m_sourceConnections;
+
+    QList<Node> m_nodes;
+    QHash<const void*, qsizetype> m_nodeByItem;
+    QList<qsizetype> m_files;
+    QString m_foldedPaths;
+    int m_visibleFiles;
+
+    QString m_filterText;
+    ChangeMask m_changes;
+    bool m_templatesOnly;
+    bool m_invalidatePending;
+};
+
+#endif // DOTFILEFILTERMODEL_H
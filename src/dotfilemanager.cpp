@@ -2,6 +2,7 @@
 #include "chezmoiservice.h"
 #include "logger.h"
 
+#include <algorithm>
 #include <memory>
 #include <QDir>
 #include <QFileInfo>
@@ -9,25 +10,80 @@
 #include <QDebug>
 #include <QStringList>
 #include <QColor>
+#include <QLocale>
 #include <QMimeDatabase>
 #include <QMimeType>
+#include <QSet>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
 
 using namespace Qt::Literals::StringLiterals;
 
+namespace {
+// Icons resolved per event loop pass; small enough to keep scrolling and typing smooth
+constexpr int IconBatchSize = 64;
+
+// Below this many added or removed files a reload is applied row by row, keeping expansion and selection
+constexpr int MinRowsForReset = 256;
+}
+
 DotfileManager::DotfileManager(QObject *parent)
     : QAbstractItemModel(parent)
     , m_chezmoiService(nullptr)
     , m_rootItem(std::make_unique<DotfileItem>())
+    , m_inventoryWatcher()
+    , m_statusWatcher()
+    , m_refreshPending(false)
+    , m_itemsByPath()
+    , m_inventoryCache()
+    , m_warmStartAttempted(false)
+    , m_cacheWriter()
+    , m_pendingIcons()
+    , m_nextPendingIcon(0)
+    , m_iconTimer(new QTimer(this))
+    , m_memoryReporter(0)
 {
+    m_memoryReporter = MemoryRegistry::instance()->add(QStringLiteral("File tree"), [this]() {
+        return memoryUsage();
+    });
+    
+    m_iconTimer->setSingleShot(true);
+    m_iconTimer->setInterval(0);
+    connect(m_iconTimer, &QTimer::timeout, this, &DotfileManager::resolvePendingIcons);
+    
+    connect(&m_inventoryWatcher, &QFutureWatcher<FileStatusBatch>::finished,
+            this, &DotfileManager::onInventoryLoaded);
+    connect(&m_statusWatcher, &QFutureWatcher<QHash<QString, ChezmoiStatus>>::finished,
+            this, &DotfileManager::onStatusesLoaded);
 }
 
-DotfileManager::~DotfileManager() = default;
+DotfileManager::~DotfileManager()
+{
+    MemoryRegistry::instance()->remove(m_memoryReporter);
+    
+    // Workers run chezmoi through the service
+    m_inventoryWatcher.waitForFinished();
+    m_statusWatcher.waitForFinished();
+    m_cacheWriter.waitForFinished();
+}
 
 void DotfileManager::setChezmoiService(ChezmoiService *service)
 {
+    if (m_chezmoiService) {
+        disconnect(m_chezmoiService, nullptr, this, nullptr);
+    }
     m_chezmoiService = service;
+    if (m_chezmoiService) {
+        // Single edits arrive as per-row updates; anything bigger asks for a reload
+        connect(m_chezmoiService, &ChezmoiService::fileStatusChanged, this, &DotfileManager::onFileStatusChanged);
+        connect(m_chezmoiService, &ChezmoiService::managedFilesChanged, this, &DotfileManager::refreshFiles);
+        // Bulk add and forget report each finished chezmoi run, so rows change while the rest still runs
+        connect(m_chezmoiService, &ChezmoiService::filesAdded, this, &DotfileManager::onFilesAdded);
+        connect(m_chezmoiService, &ChezmoiService::filesForgotten, this, &DotfileManager::onFilesForgotten);
+        connect(m_chezmoiService, &ChezmoiService::applyStarted, this, &DotfileManager::onApplyStarted);
+        connect(m_chezmoiService, &ChezmoiService::fileApplied, this, &DotfileManager::onFileApplied);
+    }
     LOG_INFO(QStringLiteral("DotfileManager: ChezmoiService set to %1").arg(service ? "valid pointer"_L1 : "nullptr"_L1));
-    refreshFiles();
 }
 
 void DotfileManager::refreshFiles()
@@ -39,44 +95,529 @@ void DotfileManager::refreshFiles()
         return;
     }
     
-    beginResetModel();
+    if (isLoading()) {
+        // Requests arriving mid-load collapse into a single reload afterwards
+        m_refreshPending = true;
+        return;
+    }
     
-    // Clear existing data
-    m_rootItem = std::make_unique<DotfileItem>();
+    // On the first load show the last snapshot straight away; chezmoi's answer is merged into it
+    if (!m_warmStartAttempted) {
+        m_warmStartAttempted = true;
+        if (m_itemsByPath.isEmpty() && loadInventoryCache()) {
+            m_iconTimer->start();
+            Q_EMIT filesRefreshed();
+        }
+    }
     
-    buildFileTree();
+    // With nothing on screen yet, rows are added as chezmoi lists them
+    const bool streamRows = m_itemsByPath.isEmpty();
+    ChezmoiService *service = m_chezmoiService;
+    m_inventoryWatcher.setFuture(QtConcurrent::run([this, service, streamRows]() {
+        ChezmoiService::PartialBatchHandler onPartial;
+        if (streamRows) {
+            onPartial = [this](const FileStatusBatch &partial) {
+                QMetaObject::invokeMethod(this, [this, partial]() {
+                    onInventoryPartial(partial);
+                }, Qt::QueuedConnection);
+            };
+        }
+        return service->getManagedFiles(false, onPartial);
+    }));
+}
+
+bool DotfileManager::isLoading() const
+{
+    return m_inventoryWatcher.isRunning() || m_statusWatcher.isRunning();
+}
+
+int DotfileManager::fileCount() const
+{
+    return m_itemsByPath.size();
+}
+
+QStringList DotfileManager::managedPaths() const
+{
+    QStringList paths = m_itemsByPath.keys();
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+QStringList DotfileManager::managedSourcePaths() const
+{
+    const QStringList targets = managedPaths();
+    QStringList paths;
+    paths.reserve(targets.size());
+    for (const QString &target : targets) {
+        const QString &sourcePath = m_itemsByPath.value(target)->fullPath;
+        if (!sourcePath.isEmpty()) {
+            paths.append(sourcePath);
+        }
+    }
+    return paths;
+}
+
+MemoryRegistry::Usage DotfileManager::memoryUsage() const
+{
+    MemoryRegistry::Usage usage;
+    
+    QList<const DotfileItem*> stack{m_rootItem.get()};
+    while (!stack.isEmpty()) {
+        const DotfileItem *item = stack.takeLast();
+        usage.objects += 1;
+        usage.bytes += qint64(sizeof(DotfileItem))
+                       + MemoryRegistry::stringBytes(item->name)
+                       + MemoryRegistry::stringBytes(item->fullPath)
+                       + MemoryRegistry::stringBytes(item->iconName)
+                       + MemoryRegistry::stringBytes(item->linkTarget)
+                       + item->children.capacity() * qint64(sizeof(DotfileItem*));
+        for (const DotfileItem *child : item->children) {
+            stack.append(child);
+        }
+    }
     
+    // The path index keeps its own copy of every relative path
+    for (auto it = m_itemsByPath.cbegin(); it != m_itemsByPath.cend(); ++it) {
+        usage.bytes += qint64(sizeof(QString) + sizeof(DotfileItem*)) + MemoryRegistry::stringBytes(it.key());
+    }
+    usage.bytes += m_pendingIcons.capacity() * qint64(sizeof(DotfileItem*));
+    return usage;
+}
+
+void DotfileManager::onInventoryLoaded()
+{
+    // Taken rather than copied; the tree reads the batch's columns directly
+    const FileStatusBatch files = m_inventoryWatcher.future().takeResult();
+    
+    if (m_itemsByPath.isEmpty()) {
+        setInventory(files);
+    } else {
+        mergeInventory(files);
+    }
+    watchManagedFiles();
+    Q_EMIT filesRefreshed();
+    
+    if (m_refreshPending) {
+        m_refreshPending = false;
+        refreshFiles();
+        return;
+    }
+    
+    m_iconTimer->start();
+    
+    ChezmoiService *service = m_chezmoiService;
+    const QStringList paths = m_itemsByPath.keys();
+    m_statusWatcher.setFuture(QtConcurrent::run([this, service, paths]() {
+        // Compiled here, off the GUI thread, so the file watcher can screen new source files against it
+        service->ignoreMatcher();
+        
+        // Edited targets can be shown from chezmoi's state database while 'chezmoi status' runs
+        const QHash<QString, ChezmoiStatus> targetChanges = service->getTargetChanges(paths);
+        if (!targetChanges.isEmpty()) {
+            QMetaObject::invokeMethod(this, [this, targetChanges]() {
+                applyStatuses(targetChanges, false);
+            }, Qt::QueuedConnection);
+        }
+        return service->getFileStatuses();
+    }));
+}
+
+void DotfileManager::setInventory(const FileStatusBatch &files)
+{
+    beginResetModel();
+    buildFileTree(files);
     endResetModel();
+}
+
+void DotfileManager::onInventoryPartial(const FileStatusBatch &files)
+{
+    if (m_itemsByPath.isEmpty()) {
+        setInventory(files);
+    } else {
+        for (qsizetype i = 0; i < files.size(); ++i) {
+            if (!m_itemsByPath.contains(files.path(i).toString())) {
+                insertFile(files, i);
+            }
+        }
+    }
+    m_iconTimer->start();
+}
+
+void DotfileManager::onStatusesLoaded()
+{
+    applyStatuses(m_statusWatcher.result());
+    Q_EMIT statusesRefreshed();
+    
+    if (m_refreshPending) {
+        m_refreshPending = false;
+        refreshFiles();
+        return;
+    }
+    
+    writeInventoryCache();
+}
+
+void DotfileManager::onFileStatusChanged(const QString &relativePath, ChezmoiStatus status)
+{
+    DotfileItem *item = m_itemsByPath.value(relativePath);
+    if (!item) {
+        return;
+    }
+    
+    // The watcher saw this target or its source change, so one stat keeps the details current
+    const QString targetPath = m_chezmoiService->getDestinationDirectory() + u'/' + relativePath;
+    QString linkTarget;
+    const FileMetadata::Record metadata = FileMetadata::stat(targetPath, &linkTarget);
+    if (metadata != item->metadata || linkTarget != item->linkTarget) {
+        item->metadata = metadata;
+        item->linkTarget = linkTarget;
+        const QModelIndex index = indexForItem(item);
+        Q_EMIT dataChanged(index.siblingAtColumn(SizeColumn), index.siblingAtColumn(PermissionsColumn), {Qt::DisplayRole});
+    }
+    applyStatuses({{relativePath, status}}, false);
+}
+
+void DotfileManager::onFilesAdded(const FileStatusBatch &files)
+{
+    // Rows go in with the sources chezmoi just wrote; their statuses follow from the service's per-row refresh
+    int added = 0;
+    for (qsizetype i = 0; i < files.size(); ++i) {
+        if (!m_itemsByPath.contains(files.path(i).toString())) {
+            insertFile(files, i);
+            ++added;
+        }
+    }
+    if (added == 0) {
+        return;
+    }
+    LOG_INFO(QStringLiteral("DotfileManager: Added %1 files").arg(added));
+    
+    m_iconTimer->start();
     Q_EMIT filesRefreshed();
 }
 
-void DotfileManager::buildFileTree()
+void DotfileManager::onFilesForgotten(const QStringList &relativePaths)
 {
-    if (!m_chezmoiService) {
-        LOG_WARNING("DotfileManager: Cannot build file tree - no ChezmoiService"_L1);
+    int removed = 0;
+    for (const QString &path : relativePaths) {
+        if (m_itemsByPath.contains(path)) {
+            removeFile(path);
+            ++removed;
+        }
+    }
+    if (removed == 0) {
         return;
     }
     
-    LOG_INFO("DotfileManager: Building file tree..."_L1);
-    auto files = m_chezmoiService->getManagedFiles();
-    LOG_INFO(QStringLiteral("DotfileManager: Received %1 files from ChezmoiService").arg(files.size()));
+    LOG_INFO(QStringLiteral("DotfileManager: Removed %1 forgotten files").arg(removed));
+    Q_EMIT filesRefreshed();
+}
+
+void DotfileManager::onApplyStarted(const QStringList &relativePaths)
+{
+    for (const QString &path : relativePaths) {
+        setApplyState(path, Applying);
+    }
+}
+
+void DotfileManager::onFileApplied(const QString &relativePath, bool success)
+{
+    // The status that follows comes from the service's per-row refresh, not from a reload
+    setApplyState(relativePath, success ? Applied : ApplyFailed);
+}
+
+void DotfileManager::setApplyState(const QString &relativePath, ApplyState state)
+{
+    DotfileItem *item = m_itemsByPath.value(relativePath);
+    if (!item || item->applyState == state) {
+        return;
+    }
+    item->applyState = state;
+    const QModelIndex index = indexForItem(item);
+    Q_EMIT dataChanged(index, index.siblingAtColumn(StatusColumn), {Qt::DisplayRole, Qt::DecorationRole, Qt::ToolTipRole});
+}
+
+void DotfileManager::watchManagedFiles()
+{
+    QHash<QString, QString> sourcePathsByTarget;
+    sourcePathsByTarget.reserve(m_itemsByPath.size());
+    for (auto it = m_itemsByPath.cbegin(); it != m_itemsByPath.cend(); ++it) {
+        sourcePathsByTarget.insert(it.key(), it.value()->fullPath);
+    }
+    m_chezmoiService->watchManagedFiles(sourcePathsByTarget);
+}
+
+bool DotfileManager::loadInventoryCache()
+{
+    const QString sourceDir = m_chezmoiService->getChezmoiDirectory();
+    QList<InventoryCache::Entry> entries;
+    if (sourceDir.isEmpty() || !m_inventoryCache.load(sourceDir, &entries)) {
+        return false;
+    }
     
-    for (const auto &file : files) {
-        LOG_DEBUG(QStringLiteral("DotfileManager: Adding file to tree: %1").arg(file.path));
-        addFileToTree(file.path, file.sourceFile.absoluteFilePath(), file.status, file.isTemplate);
+    beginResetModel();
+    m_pendingIcons.clear();
+    m_nextPendingIcon = 0;
+    m_rootItem = std::make_unique<DotfileItem>();
+    const QDir source(sourceDir);
+    for (const auto &entry : std::as_const(entries)) {
+        const QString sourcePath = entry.sourcePath.isEmpty() ? QString() : source.filePath(entry.sourcePath);
+        DotfileItem *item = addFileToTree(entry.path, sourcePath, entry.status, entry.isTemplate());
+        if (item) {
+            item->iconName = entry.iconName;
+        }
+    }
+    endResetModel();
+    
+    LOG_INFO(QStringLiteral("DotfileManager: Restored %1 files from the inventory cache").arg(m_itemsByPath.size()));
+    return true;
+}
+
+void DotfileManager::writeInventoryCache()
+{
+    if (!m_chezmoiService || m_cacheWriter.isRunning()) {
+        return;
+    }
+    
+    // Snapshot on this thread; the worker only touches the copy and the filesystem
+    QList<InventoryCache::Entry> entries;
+    entries.reserve(m_itemsByPath.size());
+    for (auto it = m_itemsByPath.cbegin(); it != m_itemsByPath.cend(); ++it) {
+        const DotfileItem *item = it.value();
+        InventoryCache::Entry entry;
+        entry.path = it.key();
+        entry.sourcePath = item->fullPath;
+        entry.status = item->status;
+        entry.iconName = item->iconName;
+        entry.attributes = item->isTemplate ? InventoryCache::Template : 0;
+        
+        // Target details come from the metadata collected with the inventory
+        const FileMetadata::Record &target = item->metadata;
+        if (target.isSymLink()) {
+            entry.attributes |= InventoryCache::TargetExists | InventoryCache::TargetSymlink;
+        } else if (target.exists()) {
+            entry.attributes |= InventoryCache::TargetExists;
+            if (target.isExecutable()) {
+                entry.attributes |= InventoryCache::TargetExecutable;
+            }
+            if (!(target.permissions() & 0044)) {
+                entry.attributes |= InventoryCache::TargetPrivate;
+            }
+            entry.targetMtime = target.mtimeNs / 1000000;
+        }
+        entries.append(entry);
+    }
+    
+    ChezmoiService *service = m_chezmoiService;
+    const InventoryCache cache = m_inventoryCache;
+    m_cacheWriter = QtConcurrent::run([service, cache, entries]() {
+        const QString sourceDir = service->getChezmoiDirectory();
+        const QDir source(sourceDir);
+        
+        QStringList sourcePaths;
+        sourcePaths.reserve(entries.size());
+        for (const auto &entry : entries) {
+            sourcePaths << entry.sourcePath;
+        }
+        const FileMetadata sourceMetadata = FileMetadata::collect(sourcePaths);
+        
+        QList<InventoryCache::Entry> resolved = entries;
+        for (qsizetype i = 0; i < resolved.size(); ++i) {
+            auto &entry = resolved[i];
+            if (!entry.sourcePath.isEmpty()) {
+                entry.sourcePath = source.relativeFilePath(entry.sourcePath);
+            }
+            if (sourceMetadata.at(i).exists()) {
+                entry.sourceMtime = sourceMetadata.at(i).mtimeNs / 1000000;
+            }
+        }
+        
+        if (!sourceDir.isEmpty()) {
+            cache.save(sourceDir, resolved);
+        }
+    });
+}
+
+void DotfileManager::buildFileTree(const FileStatusBatch &files)
+{
+    LOG_INFO(QStringLiteral("DotfileManager: Building file tree from %1 files").arg(files.size()));
+    
+    // Keep the last known statuses until the new ones arrive, so colours don't flash on reload
+    QHash<QString, ChezmoiStatus> previousStatuses;
+    for (auto it = m_itemsByPath.cbegin(); it != m_itemsByPath.cend(); ++it) {
+        previousStatuses.insert(it.key(), it.value()->status);
+    }
+    
+    m_itemsByPath.clear();
+    m_pendingIcons.clear();
+    m_nextPendingIcon = 0;
+    m_rootItem = std::make_unique<DotfileItem>();
+    
+    for (qsizetype i = 0; i < files.size(); ++i) {
+        const QString path = files.path(i).toString();
+        LOG_DEBUG(QStringLiteral("DotfileManager: Adding file to tree: %1").arg(path));
+        const ChezmoiStatus status = previousStatuses.value(path, files.status(i));
+        DotfileItem *item = addFileToTree(path, files.sourcePath(i), status, files.isTemplate(i));
+        if (item) {
+            item->metadata = files.targetMetadata(i);
+            item->linkTarget = files.targetLinkTarget(i);
+        }
     }
     
+    // chezmoi orders whole paths, which is not sibling name order ("a-c" sorts before "a/b"),
+    // and later inserts binary search for their row
+    sortChildren(m_rootItem.get());
+    
     LOG_INFO(QStringLiteral("DotfileManager: Tree building complete, root has %1 children").arg(m_rootItem->children.size()));
 }
 
-void DotfileManager::addFileToTree(const QString &relativePath, const QString &fullPath, const QString &status, bool isTemplate)
+void DotfileManager::mergeInventory(const FileStatusBatch &files)
+{
+    QSet<QString> incoming;
+    incoming.reserve(files.size());
+    QList<qsizetype> added;
+    for (qsizetype i = 0; i < files.size(); ++i) {
+        const QString path = files.path(i).toString();
+        if (!m_itemsByPath.contains(path)) {
+            added.append(i);
+        }
+        incoming.insert(path);
+    }
+    
+    QStringList removed;
+    for (auto it = m_itemsByPath.cbegin(); it != m_itemsByPath.cend(); ++it) {
+        if (!incoming.contains(it.key())) {
+            removed.append(it.key());
+        }
+    }
+    
+    // A wholesale change, like a different source directory, is cheaper as one reset
+    if (added.size() + removed.size() > qMax(MinRowsForReset, int(m_itemsByPath.size() / 2))) {
+        beginResetModel();
+        buildFileTree(files);
+        endResetModel();
+        m_iconTimer->start();
+        return;
+    }
+    
+    for (const QString &path : std::as_const(removed)) {
+        removeFile(path);
+    }
+    for (const qsizetype i : std::as_const(added)) {
+        insertFile(files, i);
+    }
+    
+    // Files that stayed may still have been renamed in the source directory, become templates
+    // or had their targets rewritten
+    int updated = 0;
+    for (qsizetype i = 0; i < files.size(); ++i) {
+        DotfileItem *item = m_itemsByPath.value(files.path(i).toString());
+        const QString fullPath = files.sourcePath(i);
+        const FileMetadata::Record &metadata = files.targetMetadata(i);
+        const QString linkTarget = files.targetLinkTarget(i);
+        if (!item || (item->fullPath == fullPath && item->isTemplate == files.isTemplate(i)
+                      && item->metadata == metadata && item->linkTarget == linkTarget)) {
+            continue;
+        }
+        item->fullPath = fullPath;
+        item->isTemplate = files.isTemplate(i);
+        item->metadata = metadata;
+        item->linkTarget = linkTarget;
+        
+        const QModelIndex index = indexForItem(item);
+        Q_EMIT dataChanged(index, index.siblingAtColumn(columnCount() - 1));
+        ++updated;
+    }
+    
+    if (!m_pendingIcons.isEmpty()) {
+        m_iconTimer->start();
+    }
+    
+    LOG_INFO(QStringLiteral("DotfileManager: Merged inventory, %1 added, %2 removed, %3 updated")
+             .arg(added.size()).arg(removed.size()).arg(updated));
+}
+
+void DotfileManager::applyStatuses(const QHash<QString, ChezmoiStatus> &statuses, bool complete)
+{
+    QSet<DotfileItem*> changedItems;
+    auto apply = [this, &changedItems](DotfileItem *item, ChezmoiStatus status) {
+        // A finished apply shows its result until the row's next status, which tells more
+        const bool applyFinished = item->applyState == Applied || item->applyState == ApplyFailed;
+        if (item->status == status && !applyFinished) {
+            return;
+        }
+        item->status = status;
+        if (applyFinished) {
+            item->applyState = NotApplied;
+        }
+        
+        // Directory colours summarize their children, so ancestors repaint too
+        for (DotfileItem *changed = item; changed && changed != m_rootItem.get(); changed = changed->parent) {
+            changedItems.insert(changed);
+        }
+    };
+    
+    if (complete) {
+        // Files missing from a full status listing have no differences
+        for (auto it = m_itemsByPath.cbegin(); it != m_itemsByPath.cend(); ++it) {
+            apply(it.value(), statuses.value(it.key()));
+        }
+    } else {
+        for (auto it = statuses.cbegin(); it != statuses.cend(); ++it) {
+            if (DotfileItem *item = m_itemsByPath.value(it.key())) {
+                apply(item, it.value());
+            }
+        }
+    }
+    
+    for (DotfileItem *item : std::as_const(changedItems)) {
+        const QModelIndex index = indexForItem(item);
+        Q_EMIT dataChanged(index, index.siblingAtColumn(columnCount() - 1), {Qt::DisplayRole, Qt::DecorationRole, Qt::ForegroundRole, Qt::ToolTipRole});
+    }
+    
+    LOG_INFO(QStringLiteral("DotfileManager: Applied statuses, %1 rows changed").arg(changedItems.size()));
+}
+
+void DotfileManager::resolvePendingIcons()
+{
+    const int end = qMin(m_nextPendingIcon + IconBatchSize, int(m_pendingIcons.size()));
+    for (; m_nextPendingIcon < end; ++m_nextPendingIcon) {
+        DotfileItem *item = m_pendingIcons.at(m_nextPendingIcon);
+        // Names restored from the cache skip the MIME lookup
+        if (item->iconName.isEmpty()) {
+            item->iconName = getFileIconName(item->name);
+        }
+        item->icon = QIcon::fromTheme(item->iconName);
+        item->iconResolved = true;
+        
+        const QModelIndex index = indexForItem(item);
+        Q_EMIT dataChanged(index, index, {Qt::DecorationRole});
+    }
+    
+    if (m_nextPendingIcon < m_pendingIcons.size()) {
+        m_iconTimer->start();
+    } else {
+        m_pendingIcons.clear();
+        m_nextPendingIcon = 0;
+    }
+}
+
+QModelIndex DotfileManager::indexForItem(DotfileItem *item) const
+{
+    if (!item || !item->parent) {
+        return QModelIndex();
+    }
+    return createIndex(item->parent->children.indexOf(item), 0, item);
+}
+
+DotfileManager::DotfileItem *DotfileManager::addFileToTree(const QString &relativePath, const QString &fullPath, ChezmoiStatus status, bool isTemplate)
 {
     LOG_DEBUG(QStringLiteral("DotfileManager: addFileToTree called with path: %1").arg(relativePath));
     
     QStringList pathParts = relativePath.split(QLatin1Char('/'), Qt::SkipEmptyParts);
     if (pathParts.isEmpty()) {
         LOG_WARNING(QStringLiteral("DotfileManager: Empty path parts for: %1").arg(relativePath));
-        return;
+        return nullptr;
     }
     
     LOG_DEBUG(QStringLiteral("DotfileManager: Path parts: %1").arg(pathParts.join(", "_L1)));
@@ -96,7 +637,10 @@ void DotfileManager::addFileToTree(const QString &relativePath, const QString &f
     fileItem->isDirectory = false; // chezmoi excluded directories, so this is always a file/symlink
     
     currentParent->children.append(fileItem);
+    m_itemsByPath.insert(relativePath, fileItem);
+    m_pendingIcons.append(fileItem);
     LOG_DEBUG(QStringLiteral("DotfileManager: Added file item: %1 (parent has %2 children)").arg(pathParts.last()).arg(currentParent->children.size()));
+    return fileItem;
 }
 
 DotfileManager::DotfileItem *DotfileManager::findOrCreateParent(const QString &name, DotfileItem *parent)
@@ -116,6 +660,94 @@ DotfileManager::DotfileItem *DotfileManager::findOrCreateParent(const QString &n
     return dirItem;
 }
 
+void DotfileManager::insertFile(const FileStatusBatch &files, qsizetype index)
+{
+    const QString path = files.path(index).toString();
+    const QStringList pathParts = path.split(QLatin1Char('/'), Qt::SkipEmptyParts);
+    if (pathParts.isEmpty()) {
+        return;
+    }
+    
+    DotfileItem *currentParent = m_rootItem.get();
+    for (int i = 0; i < pathParts.size() - 1; ++i) {
+        DotfileItem *dirItem = nullptr;
+        for (auto *child : std::as_const(currentParent->children)) {
+            if (child->name == pathParts[i] && child->isDirectory) {
+                dirItem = child;
+                break;
+            }
+        }
+        if (!dirItem) {
+            dirItem = new DotfileItem(pathParts[i], currentParent);
+            dirItem->isDirectory = true;
+            insertChild(currentParent, dirItem);
+        }
+        currentParent = dirItem;
+    }
+    
+    auto *fileItem = new DotfileItem(pathParts.last(), currentParent);
+    fileItem->fullPath = files.sourcePath(index);
+    fileItem->status = files.status(index);
+    fileItem->isTemplate = files.isTemplate(index);
+    fileItem->metadata = files.targetMetadata(index);
+    fileItem->linkTarget = files.targetLinkTarget(index);
+    insertChild(currentParent, fileItem);
+    
+    m_itemsByPath.insert(path, fileItem);
+    m_pendingIcons.append(fileItem);
+}
+
+void DotfileManager::sortChildren(DotfileItem *parent)
+{
+    std::sort(parent->children.begin(), parent->children.end(),
+              [](const DotfileItem *a, const DotfileItem *b) { return a->name < b->name; });
+    for (DotfileItem *child : std::as_const(parent->children)) {
+        if (child->isDirectory) {
+            sortChildren(child);
+        }
+    }
+}
+
+void DotfileManager::insertChild(DotfileItem *parent, DotfileItem *child)
+{
+    // buildFileTree() leaves every directory's children in name order
+    const auto position = std::lower_bound(parent->children.cbegin(), parent->children.cend(), child->name,
+                                           [](const DotfileItem *item, const QString &name) { return item->name < name; });
+    const int row = int(position - parent->children.cbegin());
+    
+    beginInsertRows(indexForItem(parent), row, row);
+    parent->children.insert(row, child);
+    endInsertRows();
+}
+
+void DotfileManager::removeFile(const QString &relativePath)
+{
+    DotfileItem *item = m_itemsByPath.take(relativePath);
+    if (!item) {
+        return;
+    }
+    
+    const qsizetype pending = m_pendingIcons.indexOf(item, m_nextPendingIcon);
+    if (pending >= 0) {
+        m_pendingIcons.remove(pending);
+    }
+    
+    // Directories only exist to hold files, so empty ones go with their last child
+    while (item != m_rootItem.get()) {
+        DotfileItem *parentItem = item->parent;
+        const int row = int(parentItem->children.indexOf(item));
+        beginRemoveRows(indexForItem(parentItem), row, row);
+        parentItem->children.removeAt(row);
+        endRemoveRows();
+        delete item;
+        
+        if (!parentItem->children.isEmpty()) {
+            break;
+        }
+        item = parentItem;
+    }
+}
+
 QModelIndex DotfileManager::index(int row, int column, const QModelIndex &parent) const
 {
     if (!hasIndex(row, column, parent)) {
@@ -172,7 +804,7 @@ int DotfileManager::rowCount(const QModelIndex &parent) const
 int DotfileManager::columnCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent)
-    return 1; // Just the name/file tree
+    return ColumnCount;
 }
 
 QVariant DotfileManager::data(const QModelIndex &index, int role) const
@@ -189,21 +821,55 @@ QVariant DotfileManager::data(const QModelIndex &index, int role) const
     switch (role) {
     case Qt::DisplayRole:
         switch (index.column()) {
-        case 0: return item->name;
-        case 1: return item->status;
-        case 2: return item->isTemplate ? QStringLiteral("Template") : 
-                       item->isDirectory ? QStringLiteral("Directory") : QStringLiteral("File");
+        case NameColumn: return item->name;
+        case StatusColumn:
+            switch (item->applyState) {
+            case Applying: return QStringLiteral("Applying...");
+            case Applied: return QStringLiteral("Done");
+            case ApplyFailed: return QStringLiteral("Failed");
+            case NotApplied: break;
+            }
+            return item->isDirectory ? QVariant() : QVariant(item->status.codes());
+        case TypeColumn: return item->isTemplate ? QStringLiteral("Template") : 
+                       item->isDirectory ? QStringLiteral("Directory") :
+                       item->metadata.isSymLink() ? QStringLiteral("Symlink") : QStringLiteral("File");
+        }
+        // Details describe the target, and are only known for files
+        if (item->isDirectory || !item->metadata.exists()) {
+            break;
+        }
+        switch (index.column()) {
+        case SizeColumn: return QLocale().formattedDataSize(item->metadata.size);
+        case ModifiedColumn: return QLocale().toString(item->metadata.lastModified(), QLocale::ShortFormat);
+        case PermissionsColumn: return FileMetadata::formatMode(item->metadata.mode);
+        }
+        break;
+        
+    case Qt::TextAlignmentRole:
+        if (index.column() == SizeColumn) {
+            return QVariant(Qt::AlignRight | Qt::AlignVCenter);
         }
         break;
         
     case Qt::DecorationRole:
-        if (index.column() == 0) {
-            return getFileIcon(item->fullPath, item->isDirectory, item->isTemplate);
+        if (index.column() == NameColumn) {
+            if (item->isDirectory) {
+                return QIcon::fromTheme(QStringLiteral("folder"));
+            }
+            // The outcome of the last selective apply is worth more than the file type
+            switch (item->applyState) {
+            case Applying: return QIcon::fromTheme(QStringLiteral("view-refresh"));
+            case Applied: return QIcon::fromTheme(QStringLiteral("dialog-ok-apply"));
+            case ApplyFailed: return QIcon::fromTheme(QStringLiteral("dialog-error"));
+            case NotApplied: break;
+            }
+            // Until the batch resolver reaches this file, show the generic icon
+            return item->iconResolved ? item->icon : QIcon::fromTheme(QStringLiteral("text-x-generic"));
         }
         break;
         
     case Qt::ForegroundRole:
-        if (index.column() == 0) {
+        if (index.column() == NameColumn) {
             QColor itemColor = getItemColor(item);
             // Only return a color if it's not the default (for special status files)
             if (itemColor.isValid()) {
@@ -213,8 +879,27 @@ QVariant DotfileManager::data(const QModelIndex &index, int role) const
         }
         break;
         
-    case Qt::ToolTipRole:
-        return item->fullPath;
+    case Qt::ToolTipRole: {
+        // Directories, and files chezmoi has not listed a source for yet, have no source path to show
+        QStringList toolTip;
+        if (!item->fullPath.isEmpty()) {
+            toolTip << item->fullPath;
+        }
+        if (!item->linkTarget.isEmpty()) {
+            toolTip << QStringLiteral("\u2192 %1").arg(item->linkTarget);
+        }
+        if (!item->isDirectory && !item->status.isClean()) {
+            toolTip << item->status.description();
+        }
+        if (item->applyState == Applying) {
+            toolTip << QStringLiteral("Applying...");
+        } else if (item->applyState == Applied) {
+            toolTip << QStringLiteral("Applied");
+        } else if (item->applyState == ApplyFailed) {
+            toolTip << QStringLiteral("Apply failed");
+        }
+        return toolTip.isEmpty() ? QVariant() : QVariant(toolTip.join(u'\n'));
+    }
     }
     
     return QVariant();
@@ -226,8 +911,13 @@ QVariant DotfileManager::headerData(int section, Qt::Orientation orientation, in
         return QVariant();
     }
     
-    if (section == 0) {
-        return QStringLiteral("Files");
+    switch (section) {
+    case NameColumn: return QStringLiteral("Name");
+    case StatusColumn: return QStringLiteral("Status");
+    case TypeColumn: return QStringLiteral("Type");
+    case SizeColumn: return QStringLiteral("Size");
+    case ModifiedColumn: return QStringLiteral("Modified");
+    case PermissionsColumn: return QStringLiteral("Permissions");
     }
     
     return QVariant();
@@ -239,6 +929,48 @@ QString DotfileManager::getFilePath(const QModelIndex &index) const
     return item ? item->fullPath : QString();
 }
 
+QStringList DotfileManager::targetPaths(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return QStringList();
+    }
+    
+    // Item names are path components, so the names on the way up spell out the target path
+    DotfileItem *item = getItem(index);
+    QStringList components;
+    for (const DotfileItem *ancestor = item; ancestor && ancestor != m_rootItem.get(); ancestor = ancestor->parent) {
+        components.prepend(ancestor->name);
+    }
+    
+    QStringList paths;
+    QList<QPair<const DotfileItem*, QString>> stack;
+    stack.append({item, components.join(u'/')});
+    while (!stack.isEmpty()) {
+        const auto [current, path] = stack.takeLast();
+        if (!current->isDirectory) {
+            paths.append(path);
+            continue;
+        }
+        for (const DotfileItem *child : current->children) {
+            stack.append({child, path + u'/' + child->name});
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+QStringList DotfileManager::pendingApplyPaths() const
+{
+    QStringList paths;
+    for (auto it = m_itemsByPath.cbegin(); it != m_itemsByPath.cend(); ++it) {
+        if (it.value()->status.targetChange() != ChezmoiStatus::NoChange) {
+            paths.append(it.key());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
 bool DotfileManager::isTemplate(const QModelIndex &index) const
 {
     DotfileItem *item = getItem(index);
@@ -263,13 +995,18 @@ QColor DotfileManager::getItemColor(DotfileItem *item) const
     }
     
     // Colors similar to VS Code - only return valid colors for special status
-    if (item->status == u"modified"_s) {
+    switch (item->status.summary()) {
+    case ChezmoiStatus::Modified:
         return QColor(255, 193, 7); // Dark gold/amber for modified files
-    } else if (item->status == u"added"_s) {
+    case ChezmoiStatus::Added:
         return QColor(108, 218, 118); // Green for added files
-    } else if (item->status == u"deleted"_s) {
+    case ChezmoiStatus::Deleted:
         return QColor(248, 81, 73); // Red for deleted files
-    } else if (item->isDirectory && hasModifiedChildren(item)) {
+    case ChezmoiStatus::Run:
+    case ChezmoiStatus::NoChange:
+        break;
+    }
+    if (item->isDirectory && hasModifiedChildren(item)) {
         return QColor(255, 193, 7); // Dark gold for directories with modified children
     }
     
@@ -285,7 +1022,7 @@ bool DotfileManager::hasModifiedChildren(DotfileItem *item) const
     
     // Check if any direct children are modified
     for (DotfileItem *child : item->children) {
-        if (child->status == u"modified"_s || child->status == u"added"_s || child->status == u"deleted"_s) {
+        if (child->status.isDirty()) {
             return true;
         }
         
@@ -298,93 +1035,78 @@ bool DotfileManager::hasModifiedChildren(DotfileItem *item) const
     return false;
 }
 
-QIcon DotfileManager::getFileIcon(const QString &filePath, bool isDirectory, bool isTemplate) const
+QString DotfileManager::getFileIconName(const QString &fileName) const
 {
-    // Handle directories first
-    if (isDirectory) {
-        return QIcon::fromTheme(QStringLiteral("folder"));
-    }
-    
-    // Handle template files with a special overlay or different icon
-    if (isTemplate) {
-        // For templates, we can either use a special template icon or the MIME type icon with template indicator
-        // Let's use the MIME type icon but could add template indication later
-    }
+    // Only the name is worked out here, so it can be cached and turned back into an icon cheaply
     
     // Use MIME database to get the appropriate icon
     static QMimeDatabase mimeDb;
     
-    // Get MIME type from file path
-    QMimeType mimeType = mimeDb.mimeTypeForFile(filePath);
-    QString iconName = mimeType.iconName();
-    
-    // Try to get the icon from theme
-    QIcon icon = QIcon::fromTheme(iconName);
+    // The target's name decides, as source names carry chezmoi's prefixes and suffixes
+    QMimeType mimeType = mimeDb.mimeTypeForFile(fileName, QMimeDatabase::MatchExtension);
     
-    // If no icon found, try generic icon name
-    if (icon.isNull() && !mimeType.genericIconName().isEmpty()) {
-        icon = QIcon::fromTheme(mimeType.genericIconName());
+    // Try the icon from theme, then the generic icon name
+    if (QIcon::hasThemeIcon(mimeType.iconName())) {
+        return mimeType.iconName();
+    }
+    if (!mimeType.genericIconName().isEmpty() && QIcon::hasThemeIcon(mimeType.genericIconName())) {
+        return mimeType.genericIconName();
     }
     
-    // If still no icon, try fallbacks based on MIME type category
-    if (icon.isNull()) {
-        QString mimeTypeName = mimeType.name();
-        if (mimeTypeName.startsWith(QStringLiteral("text/"))) {
-            icon = QIcon::fromTheme(QStringLiteral("text-x-generic"));
-        } else if (mimeTypeName.startsWith(QStringLiteral("image/"))) {
-            icon = QIcon::fromTheme(QStringLiteral("image-x-generic"));
-        } else if (mimeTypeName.startsWith(QStringLiteral("audio/"))) {
-            icon = QIcon::fromTheme(QStringLiteral("audio-x-generic"));
-        } else if (mimeTypeName.startsWith(QStringLiteral("video/"))) {
-            icon = QIcon::fromTheme(QStringLiteral("video-x-generic"));
-        }
+    // Then fallbacks based on MIME type category
+    QString iconName;
+    QString mimeTypeName = mimeType.name();
+    if (mimeTypeName.startsWith(QStringLiteral("text/"))) {
+        iconName = QStringLiteral("text-x-generic");
+    } else if (mimeTypeName.startsWith(QStringLiteral("image/"))) {
+        iconName = QStringLiteral("image-x-generic");
+    } else if (mimeTypeName.startsWith(QStringLiteral("audio/"))) {
+        iconName = QStringLiteral("audio-x-generic");
+    } else if (mimeTypeName.startsWith(QStringLiteral("video/"))) {
+        iconName = QStringLiteral("video-x-generic");
+    }
+    if (!iconName.isEmpty() && QIcon::hasThemeIcon(iconName)) {
+        return iconName;
     }
     
     // Additional fallback to specific file type icons for common dotfiles
-    if (icon.isNull()) {
-        QString fileName = QFileInfo(filePath).fileName().toLower();
-        
-        // Common shell files
-        if (fileName.contains(QStringLiteral("bash")) || fileName.contains(QStringLiteral("zsh")) || 
-            fileName.contains(QStringLiteral("fish")) || fileName.endsWith(QStringLiteral(".sh"))) {
-            icon = QIcon::fromTheme(QStringLiteral("application-x-shellscript"));
-        }
-        // Git files
-        else if (fileName.contains(QStringLiteral("git"))) {
-            icon = QIcon::fromTheme(QStringLiteral("git"));
-        }
-        // Vim files
-        else if (fileName.contains(QStringLiteral("vim")) || fileName.endsWith(QStringLiteral(".vim"))) {
-            icon = QIcon::fromTheme(QStringLiteral("text-x-script"));
-        }
-        // SSH files
-        else if (fileName.contains(QStringLiteral("ssh"))) {
-            icon = QIcon::fromTheme(QStringLiteral("network-server"));
-        }
-        // Config files
-        else if (fileName.contains(QStringLiteral("config")) || fileName.contains(QStringLiteral("conf"))) {
-            icon = QIcon::fromTheme(QStringLiteral("preferences-other"));
-        }
-        // Environment files
-        else if (fileName.contains(QStringLiteral("env")) || fileName.contains(QStringLiteral("profile"))) {
-            icon = QIcon::fromTheme(QStringLiteral("preferences-desktop-environment"));
-        }
+    iconName.clear();
+    const QString lowerName = fileName.toLower();
+    
+    // Common shell files
+    if (lowerName.contains(QStringLiteral("bash")) || lowerName.contains(QStringLiteral("zsh")) || 
+        lowerName.contains(QStringLiteral("fish")) || lowerName.endsWith(QStringLiteral(".sh"))) {
+        iconName = QStringLiteral("application-x-shellscript");
+    }
+    // Git files
+    else if (lowerName.contains(QStringLiteral("git"))) {
+        iconName = QStringLiteral("git");
+    }
+    // Vim files
+    else if (lowerName.contains(QStringLiteral("vim")) || lowerName.endsWith(QStringLiteral(".vim"))) {
+        iconName = QStringLiteral("text-x-script");
+    }
+    // SSH files
+    else if (lowerName.contains(QStringLiteral("ssh"))) {
+        iconName = QStringLiteral("network-server");
+    }
+    // Config files
+    else if (lowerName.contains(QStringLiteral("config")) || lowerName.contains(QStringLiteral("conf"))) {
+        iconName = QStringLiteral("preferences-other");
+    }
+    // Environment files
+    else if (lowerName.contains(QStringLiteral("env")) || lowerName.contains(QStringLiteral("profile"))) {
+        iconName = QStringLiteral("preferences-desktop-environment");
+    }
+    if (!iconName.isEmpty() && QIcon::hasThemeIcon(iconName)) {
+        return iconName;
     }
     
-    // Final fallback - always return a text file icon if nothing else worked
-    if (icon.isNull()) {
-        icon = QIcon::fromTheme(QStringLiteral("text-x-generic"));
-        // If even that fails (shouldn't happen in most themes), try alternatives
-        if (icon.isNull()) {
-            icon = QIcon::fromTheme(QStringLiteral("text-plain"));
-        }
-        if (icon.isNull()) {
-            icon = QIcon::fromTheme(QStringLiteral("document-new"));
+    // Final fallback - a text file icon, or alternatives if even that is missing from the theme
+    for (const QString &fallback : {QStringLiteral("text-x-generic"), QStringLiteral("text-plain")}) {
+        if (QIcon::hasThemeIcon(fallback)) {
+            return fallback;
         }
     }
-    
-    // For template files, we could add a small overlay or badge here in the future
-    // For now, templates just use the same icon as the base file type
-    
-    return icon;
+    return QStringLiteral("document-new");
 }
@@ -6,32 +6,64 @@
 #include <QModelIndex>
 #include <QVariant>
 #include <QColor>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QIcon>
 #include <memory>
 
-class ChezmoiService;
+#include "chezmoiservice.h"
+#include "inventorycache.h"
+#include "memoryregistry.h"
+
+class QTimer;
 
 class DotfileManager : public QAbstractItemModel
 {
     Q_OBJECT
 
 public:
+    // Where a file is in a selective apply; a result is kept until the next status for the row arrives
+    enum ApplyState : quint8 {
+        NotApplied,
+        Applying,
+        Applied,
+        ApplyFailed
+    };
+
     struct DotfileItem {
         QString name;
         QString fullPath;
-        QString status;
+        ChezmoiStatus status;
         bool isDirectory;
         bool isTemplate;
+        bool iconResolved;
+        ApplyState applyState;
+        QString iconName;
+        QIcon icon;
+        FileMetadata::Record metadata; // of the target, collected with the inventory
+        QString linkTarget;
         QList<DotfileItem*> children;
         DotfileItem *parent;
         
         DotfileItem(const QString &n = QString(), DotfileItem *p = nullptr)
-            : name(n), isDirectory(false), isTemplate(false), parent(p) {}
+            : name(n), isDirectory(false), isTemplate(false), iconResolved(false), applyState(NotApplied), parent(p) {}
         
         ~DotfileItem() {
             qDeleteAll(children);
         }
     };
 
+    enum Column {
+        NameColumn,
+        StatusColumn,
+        TypeColumn,
+        SizeColumn,
+        ModifiedColumn,
+        PermissionsColumn,
+        ColumnCount
+    };
+
     explicit DotfileManager(QObject *parent = nullptr);
     ~DotfileManager() override;
 
@@ -45,24 +77,78 @@ public:
 
     void setChezmoiService(ChezmoiService *service);
     void refreshFiles();
+    // Replaces the tree with files as they are, without asking chezmoi
+    void setInventory(const FileStatusBatch &files);
+    bool isLoading() const;
+    int fileCount() const;
+    // Target paths of every managed file, relative to the destination directory
+    QStringList managedPaths() const;
+    // Absolute source paths of every managed file whose source chezmoi has listed, in the same order
+    QStringList managedSourcePaths() const;
     QString getFilePath(const QModelIndex &index) const;
+    // Target paths of the file at index, or of every file below the directory at index
+    QStringList targetPaths(const QModelIndex &index) const;
+    // Target paths of every file 'chezmoi apply' would change, sorted
+    QStringList pendingApplyPaths() const;
     bool isTemplate(const QModelIndex &index) const;
+    MemoryRegistry::Usage memoryUsage() const;
 
 Q_SIGNALS:
     void fileModified(const QString &filePath);
     void filesRefreshed();
+    void statusesRefreshed();
+
+private Q_SLOTS:
+    void onInventoryLoaded();
+    void onInventoryPartial(const FileStatusBatch &files);
+    void onStatusesLoaded();
+    void onFileStatusChanged(const QString &relativePath, ChezmoiStatus status);
+    void onFilesAdded(const FileStatusBatch &files);
+    void onFilesForgotten(const QStringList &relativePaths);
+    void onApplyStarted(const QStringList &relativePaths);
+    void onFileApplied(const QString &relativePath, bool success);
+    void resolvePendingIcons();
 
 private:
-    void buildFileTree();
+    bool loadInventoryCache();
+    void writeInventoryCache();
+    void buildFileTree(const FileStatusBatch &files);
+    void mergeInventory(const FileStatusBatch &files);
+    void applyStatuses(const QHash<QString, ChezmoiStatus> &statuses, bool complete = true);
+    void watchManagedFiles();
+    QModelIndex indexForItem(DotfileItem *item) const;
     DotfileItem *getItem(const QModelIndex &index) const;
-    void addFileToTree(const QString &relativePath, const QString &fullPath, const QString &status, bool isTemplate);
+    DotfileItem *addFileToTree(const QString &relativePath, const QString &fullPath, ChezmoiStatus status, bool isTemplate);
     DotfileItem *findOrCreateParent(const QString &path, DotfileItem *root);
+    void insertFile(const FileStatusBatch &files, qsizetype index);
+    void sortChildren(DotfileItem *parent);
+    void insertChild(DotfileItem *parent, DotfileItem *child);
+    void removeFile(const QString &relativePath);
+    void setApplyState(const QString &relativePath, ApplyState state);
     QColor getItemColor(DotfileItem *item) const;
     bool hasModifiedChildren(DotfileItem *item) const;
-    QIcon getFileIcon(const QString &filePath, bool isDirectory, bool isTemplate) const;
+    QString getFileIconName(const QString &fileName) const;
 
     ChezmoiService *m_chezmoiService;
     std::unique_ptr<DotfileItem> m_rootItem;
+    
+    // Loading happens in two background stages: the managed inventory, then the slower status diff
+    QFutureWatcher<FileStatusBatch> m_inventoryWatcher;
+    QFutureWatcher<QHash<QString, ChezmoiStatus>> m_statusWatcher;
+    bool m_refreshPending;
+    QHash<QString, DotfileItem*> m_itemsByPath;
+    
+    // The last inventory is kept on disk so the tree can be shown before chezmoi answers
+    InventoryCache m_inventoryCache;
+    bool m_warmStartAttempted;
+    QFuture<void> m_cacheWriter;
+    
+    // Icons need MIME lookups, so they are resolved in batches once the tree is showing
+    QList<DotfileItem*> m_pendingIcons;
+    int m_nextPendingIcon;
+    QTimer *m_iconTimer;
+    
+    quint64 m_memoryReporter;
 };
 
 
@@ -0,0 +1,275 @@
+#include "filehasher.h"
+#include "logger.h"
+#include "memoryregistry.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtEndian>
+
+#include <cstring>
+#include <sys/stat.h>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// Large files are read this much at a time so hashing never holds a whole file in memory
+constexpr qint64 ChunkSize = 1024 * 1024;
+
+// Entries kept per algorithm; far above any dotfile repository, small enough to never matter
+constexpr qsizetype MaxCacheEntries = 100000;
+
+// Streaming XXH64, the 64-bit xxHash
+class Xxh64
+{
+public:
+    Xxh64()
+        : m_v{Prime1 + Prime2, Prime2, 0, 0 - Prime1}
+        , m_buffer{}
+        , m_buffered(0)
+        , m_total(0)
+    {
+    }
+
+    void addData(const uchar *data, qint64 size)
+    {
+        m_total += quint64(size);
+
+        if (m_buffered + size < 32) {
+            std::memcpy(m_buffer + m_buffered, data, size_t(size));
+            m_buffered += int(size);
+            return;
+        }
+
+        if (m_buffered > 0) {
+            const int fill = 32 - m_buffered;
+            std::memcpy(m_buffer + m_buffered, data, size_t(fill));
+            consume(m_buffer);
+            data += fill;
+            size -= fill;
+            m_buffered = 0;
+        }
+
+        for (; size >= 32; data += 32, size -= 32) {
+            consume(data);
+        }
+
+        std::memcpy(m_buffer, data, size_t(size));
+        m_buffered = int(size);
+    }
+
+    quint64 result() const
+    {
+        quint64 h;
+        if (m_total >= 32) {
+            h = rotl(m_v[0], 1) + rotl(m_v[1], 7) + rotl(m_v[2], 12) + rotl(m_v[3], 18);
+            for (const quint64 v : m_v) {
+                h = mergeRound(h, v);
+            }
+        } else {
+            h = Prime5;
+        }
+        h += m_total;
+
+        const uchar *p = m_buffer;
+        int remaining = m_buffered;
+        for (; remaining >= 8; p += 8, remaining -= 8) {
+            h ^= round(0, qFromLittleEndian<quint64>(p));
+            h = rotl(h, 27) * Prime1 + Prime4;
+        }
+        if (remaining >= 4) {
+            h ^= quint64(qFromLittleEndian<quint32>(p)) * Prime1;
+            h = rotl(h, 23) * Prime2 + Prime3;
+            p += 4;
+            remaining -= 4;
+        }
+        for (; remaining > 0; ++p, --remaining) {
+            h ^= *p * Prime5;
+            h = rotl(h, 11) * Prime1;
+        }
+
+        h ^= h >> 33;
+        h *= Prime2;
+        h ^= h >> 29;
+        h *= Prime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static constexpr quint64 Prime1 = 0x9E3779B185EBCA87ULL;
+    static constexpr quint64 Prime2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr quint64 Prime3 = 0x165667B19E3779F9ULL;
+    static constexpr quint64 Prime4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr quint64 Prime5 = 0x27D4EB2F165667C5ULL;
+
+    static quint64 rotl(quint64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    static quint64 round(quint64 acc, quint64 input)
+    {
+        acc += input * Prime2;
+        return rotl(acc, 31) * Prime1;
+    }
+
+    static quint64 mergeRound(quint64 acc, quint64 value)
+    {
+        acc ^= round(0, value);
+        return acc * Prime1 + Prime4;
+    }
+
+    void consume(const uchar *stripe)
+    {
+        for (int lane = 0; lane < 4; ++lane) {
+            m_v[lane] = round(m_v[lane], qFromLittleEndian<quint64>(stripe + lane * 8));
+        }
+    }
+
+    quint64 m_v[4];
+    uchar m_buffer[32];
+    int m_buffered;
+    quint64 m_total;
+};
+}
+
+FileHasher::FileHasher()
+    : m_lock()
+    , m_cache()
+    , m_cacheHits(0)
+    , m_bytesRead(0)
+    , m_memoryReporter(0)
+{
+    m_memoryReporter = MemoryRegistry::instance()->add(QStringLiteral("Hash cache"), [this]() {
+        MemoryRegistry::Usage usage;
+        QReadLocker locker(&m_lock);
+        for (const auto &cache : m_cache) {
+            for (auto it = cache.cbegin(); it != cache.cend(); ++it) {
+                usage.bytes += qint64(sizeof(QString) + sizeof(CacheEntry)) + MemoryRegistry::stringBytes(it.key())
+                               + it->digest.capacity();
+            }
+            usage.objects += cache.size();
+        }
+        return usage;
+    });
+}
+
+FileHasher::~FileHasher()
+{
+    MemoryRegistry::instance()->remove(m_memoryReporter);
+}
+
+FileHasher *FileHasher::instance()
+{
+    static FileHasher hasher;
+    return &hasher;
+}
+
+bool FileHasher::identify(const QString &path, Identity *identity)
+{
+    struct stat info;
+    if (::stat(QFile::encodeName(path).constData(), &info) != 0 || !S_ISREG(info.st_mode)) {
+        return false;
+    }
+    identity->device = quint64(info.st_dev);
+    identity->inode = quint64(info.st_ino);
+    identity->size = qint64(info.st_size);
+    identity->mtimeNs = qint64(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+QByteArray FileHasher::hash(const QString &path, Algorithm algorithm)
+{
+    Identity before;
+    if (!identify(path, &before)) {
+        return QByteArray();
+    }
+
+    QHash<QString, CacheEntry> &cache = m_cache[int(algorithm)];
+    {
+        QReadLocker locker(&m_lock);
+        const auto it = cache.constFind(path);
+        if (it != cache.constEnd() && it->identity == before) {
+            m_cacheHits.fetchAndAddRelaxed(1);
+            return it->digest;
+        }
+    }
+
+    const QByteArray digest = hashContents(path, algorithm);
+    if (digest.isEmpty()) {
+        return digest;
+    }
+
+    // A write that raced with the read must not be remembered under the old identity
+    Identity after;
+    if (identify(path, &after) && after == before) {
+        QWriteLocker locker(&m_lock);
+        if (cache.size() >= MaxCacheEntries) {
+            cache.clear();
+        }
+        cache.insert(path, {before, digest});
+    }
+    return digest;
+}
+
+QList<QByteArray> FileHasher::hashFiles(const QStringList &paths, Algorithm algorithm)
+{
+    // QtConcurrent hands out items to idle pool threads as they finish, so a few large files
+    // do not hold up the rest of the batch
+    return QtConcurrent::blockingMapped<QList<QByteArray>>(paths, [this, algorithm](const QString &path) {
+        return hash(path, algorithm);
+    });
+}
+
+void FileHasher::clear()
+{
+    QWriteLocker locker(&m_lock);
+    for (auto &cache : m_cache) {
+        cache.clear();
+    }
+}
+
+qint64 FileHasher::cacheHits() const
+{
+    return m_cacheHits.loadRelaxed();
+}
+
+qint64 FileHasher::bytesRead() const
+{
+    return m_bytesRead.loadRelaxed();
+}
+
+QByteArray FileHasher::hashContents(const QString &path, Algorithm algorithm)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        LOG_DEBUG(QStringLiteral("FileHasher: cannot read %1: %2").arg(path, file.errorString()));
+        return QByteArray();
+    }
+
+    QCryptographicHash sha256(QCryptographicHash::Sha256);
+    Xxh64 xxh64;
+    QByteArray chunk(qMin(ChunkSize, qMax<qint64>(file.size(), 1)), Qt::Uninitialized);
+
+    for (;;) {
+        const qint64 length = file.read(chunk.data(), chunk.size());
+        if (length < 0) {
+            LOG_DEBUG(QStringLiteral("FileHasher: read error in %1: %2").arg(path, file.errorString()));
+            return QByteArray();
+        }
+        if (length == 0) {
+            break;
+        }
+        m_bytesRead.fetchAndAddRelaxed(length);
+        if (algorithm == Algorithm::Sha256) {
+            sha256.addData(QByteArrayView(chunk.constData(), length));
+        } else {
+            xxh64.addData(reinterpret_cast<const uchar *>(chunk.constData()), length);
+        }
+    }
+
+    if (algorithm == Algorithm::Sha256) {
+        return sha256.result();
+    }
+    QByteArray digest(sizeof(quint64), Qt::Uninitialized);
+    qToBigEndian(xxh64.result(), digest.data());
+    return digest;
+}
@@ -0,0 +1,68 @@
+#ifndef FILEHASHER_H
+#define FILEHASHER_H
+
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Content hashes of files, cached by file identity
+ *
+ * A file's identity is its device, inode, size and nanosecond mtime; while
+ * that is unchanged the cached digest is returned without reading the file.
+ * Files are streamed in fixed-size chunks, and batches are spread over the
+ * global thread pool.
+ *
+ * All methods are thread-safe.
+ */
+class FileHasher
+{
+public:
+    enum class Algorithm {
+        Sha256, // 32 byte digest, comparable with what chezmoi records
+        Fast    // 8 byte XXH64 digest, for change detection only
+    };
+
+    struct Identity {
+        quint64 device = 0;
+        quint64 inode = 0;
+        qint64 size = -1;
+        qint64 mtimeNs = 0;
+
+        bool isValid() const { return size >= 0; }
+        bool operator==(const Identity &other) const = default;
+    };
+
+    FileHasher();
+    ~FileHasher();
+
+    static FileHasher *instance();
+    static bool identify(const QString &path, Identity *identity);
+
+    QByteArray hash(const QString &path, Algorithm algorithm = Algorithm::Sha256);
+    QList<QByteArray> hashFiles(const QStringList &paths, Algorithm algorithm = Algorithm::Sha256);
+    void clear();
+
+    qint64 cacheHits() const;
+    qint64 bytesRead() const;
+
+private:
+    struct CacheEntry {
+        Identity identity;
+        QByteArray digest;
+    };
+
+    QByteArray hashContents(const QString &path, Algorithm algorithm);
+
+    mutable QReadWriteLock m_lock;
+    QHash<QString, CacheEntry> m_cache[2]; // one per algorithm
+    QAtomicInteger<qint64> m_cacheHits;
+    QAtomicInteger<qint64> m_bytesRead;
+    quint64 m_memoryReporter;
+};
+
+#endif // FILEHASHER_H
@@ -0,0 +1,204 @@
+#include "filemetadata.h"
+#include "logger.h"
+
+#include <QFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// Paths handed to one pool task; stat calls are cheap, so tasks need a few to be worth scheduling
+constexpr qsizetype PathsPerTask = 128;
+
+// stat latency on network homes is waiting, not work, so the pool is never narrower than this, whatever the CPU count
+constexpr int MinStatThreads = 16;
+
+struct Chunk {
+    qsizetype begin;
+    qsizetype end;
+    QHash<qsizetype, QString> linkTargets;
+};
+
+QThreadPool *statPool()
+{
+    static QThreadPool *pool = [] {
+        auto *threadPool = new QThreadPool();
+        threadPool->setMaxThreadCount(qMax(QThread::idealThreadCount(), MinStatThreads));
+        threadPool->setExpiryTimeout(5000);
+        return threadPool;
+    }();
+    return pool;
+}
+
+QString readLink(const QByteArray &path, qint64 sizeHint)
+{
+    QByteArray target(qMax<qint64>(sizeHint, 64) + 1, Qt::Uninitialized);
+    const ssize_t length = ::readlink(path.constData(), target.data(), size_t(target.size()));
+    if (length < 0) {
+        return QString();
+    }
+    target.truncate(length);
+    return QFile::decodeName(target);
+}
+
+bool lstatRecord(const QByteArray &path, FileMetadata::Record *record)
+{
+    struct stat info;
+    if (::lstat(path.constData(), &info) != 0) {
+        return false;
+    }
+    record->size = qint64(info.st_size);
+    record->mtimeNs = qint64(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    record->inode = quint64(info.st_ino);
+    record->mode = quint32(info.st_mode);
+    return true;
+}
+
+bool statRecord(const QByteArray &path, FileMetadata::Record *record)
+{
+#ifdef STATX_BASIC_STATS
+    // statx asks for just the fields in the table and, on network filesystems, lets the
+    // kernel answer from its attribute cache instead of a round trip per file
+    static std::atomic<bool> statxMissing = false;
+    if (!statxMissing.load(std::memory_order_relaxed)) {
+        struct statx info;
+        if (::statx(AT_FDCWD, path.constData(), AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC,
+                    STATX_TYPE | STATX_MODE | STATX_INO | STATX_SIZE | STATX_MTIME, &info) == 0) {
+            record->size = qint64(info.stx_size);
+            record->mtimeNs = qint64(info.stx_mtime.tv_sec) * 1000000000 + info.stx_mtime.tv_nsec;
+            record->inode = quint64(info.stx_ino);
+            record->mode = quint32(info.stx_mode);
+            return true;
+        }
+        if (errno != ENOSYS) {
+            return false;
+        }
+        // Old kernels and some sandboxes reject the call outright
+        statxMissing.store(true, std::memory_order_relaxed);
+    }
+#endif
+    return lstatRecord(path, record);
+}
+}
+
+bool FileMetadata::Record::isDirectory() const
+{
+    return exists() && S_ISDIR(mode);
+}
+
+bool FileMetadata::Record::isSymLink() const
+{
+    return exists() && S_ISLNK(mode);
+}
+
+bool FileMetadata::Record::isExecutable() const
+{
+    return exists() && S_ISREG(mode) && (mode & 0111);
+}
+
+QDateTime FileMetadata::Record::lastModified() const
+{
+    return exists() ? QDateTime::fromMSecsSinceEpoch(mtimeNs / 1000000) : QDateTime();
+}
+
+FileMetadata::FileMetadata()
+    : m_records()
+    , m_linkTargets()
+{
+}
+
+FileMetadata::Record FileMetadata::stat(const QString &path, QString *linkTarget)
+{
+    Record record;
+    const QByteArray encodedPath = QFile::encodeName(path);
+    if (statRecord(encodedPath, &record) && linkTarget) {
+        *linkTarget = record.isSymLink() ? readLink(encodedPath, record.size) : QString();
+    }
+    return record;
+}
+
+FileMetadata FileMetadata::collect(const QStringList &paths)
+{
+    FileMetadata table;
+    table.m_records.resize(paths.size());
+
+    QList<Chunk> chunks;
+    chunks.reserve(paths.size() / PathsPerTask + 1);
+    for (qsizetype begin = 0; begin < paths.size(); begin += PathsPerTask) {
+        chunks.append({begin, qMin(begin + PathsPerTask, paths.size()), {}});
+    }
+
+    // Each task writes only its own slice of the table, so no locking is needed
+    Record *records = table.m_records.data();
+    auto statChunk = [&paths, records](Chunk &chunk) {
+        for (qsizetype i = chunk.begin; i < chunk.end; ++i) {
+            QString linkTarget;
+            records[i] = stat(paths.at(i), &linkTarget);
+            if (!linkTarget.isEmpty()) {
+                chunk.linkTargets.insert(i, linkTarget);
+            }
+        }
+    };
+    if (chunks.size() == 1) {
+        statChunk(chunks.first());
+    } else {
+        QtConcurrent::blockingMap(statPool(), chunks, statChunk);
+    }
+
+    for (const Chunk &chunk : std::as_const(chunks)) {
+        table.m_linkTargets.insert(chunk.linkTargets);
+    }
+
+    LOG_DEBUG(QStringLiteral("FileMetadata: Collected %1 paths in %2 tasks").arg(paths.size()).arg(chunks.size()));
+    return table;
+}
+
+QString FileMetadata::formatMode(quint32 mode)
+{
+    // The ls -l form, which users of a dotfile manager know best
+    QString text(10, u'-');
+    if (S_ISDIR(mode)) {
+        text[0] = u'd';
+    } else if (S_ISLNK(mode)) {
+        text[0] = u'l';
+    }
+    static const char16_t letters[] = u"rwxrwxrwx";
+    for (int bit = 0; bit < 9; ++bit) {
+        if (mode & (0400u >> bit)) {
+            text[bit + 1] = QChar(letters[bit]);
+        }
+    }
+    return text;
+}
+
+qsizetype FileMetadata::size() const
+{
+    return m_records.size();
+}
+
+const FileMetadata::Record &FileMetadata::at(qsizetype i) const
+{
+    return m_records.at(i);
+}
+
+QString FileMetadata::linkTarget(qsizetype i) const
+{
+    return m_linkTargets.value(i);
+}
+
+qint64 FileMetadata::byteSize() const
+{
+    qint64 bytes = m_records.capacity() * qint64(sizeof(Record));
+    for (const QString &target : m_linkTargets) {
+        bytes += qint64(sizeof(qsizetype) + sizeof(QString)) + target.capacity() * qint64(sizeof(QChar));
+    }
+    return bytes;
+}
@@ -0,0 +1,52 @@
+#ifndef FILEMETADATA_H
+#define FILEMETADATA_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief A compact table of lstat data for a batch of paths
+ *
+ * collect() stats every path once, spread over a small I/O thread pool, so
+ * consumers can show sizes, times and permissions without touching the
+ * filesystem again. Symlinks are not followed; their targets are kept on the
+ * side for the few paths that have one.
+ */
+class FileMetadata
+{
+public:
+    struct Record {
+        qint64 size = -1; // -1 when the path does not exist
+        qint64 mtimeNs = 0;
+        quint64 inode = 0;
+        quint32 mode = 0; // file type and permission bits, as in st_mode
+
+        bool exists() const { return size >= 0; }
+        bool isDirectory() const;
+        bool isSymLink() const;
+        bool isExecutable() const;
+        quint32 permissions() const { return mode & 07777; }
+        QDateTime lastModified() const;
+        bool operator==(const Record &other) const = default;
+    };
+
+    FileMetadata();
+
+    static Record stat(const QString &path, QString *linkTarget = nullptr);
+    static FileMetadata collect(const QStringList &paths);
+    static QString formatMode(quint32 mode);
+
+    qsizetype size() const;
+    const Record &at(qsizetype i) const;
+    QString linkTarget(qsizetype i) const;
+    qint64 byteSize() const;
+
+private:
+    QList<Record> m_records;
+    QHash<qsizetype, QString> m_linkTargets;
+};
+
+#endif // FILEMETADATA_H
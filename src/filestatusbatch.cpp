@@ -0,0 +1,182 @@
+#include "filestatusbatch.h"
+
+#include <QStringDecoder>
+#include <QStringList>
+
+namespace {
+// Handed out for files whose metadata has not been collected
+const FileMetadata::Record MissingRecord;
+
+QString joinPath(const QString &directory, QStringView path)
+{
+    QString result;
+    result.reserve(directory.size() + 1 + path.size());
+    result += directory;
+    result += u'/';
+    result += path;
+    return result;
+}
+}
+
+FileStatusBatch::FileStatusBatch()
+    : m_sourceDir()
+    , m_targetDir()
+    , m_pathPool()
+    , m_pathEnds()
+    , m_statuses()
+    , m_attributes()
+    , m_sourcePool()
+    , m_sourceEnds()
+    , m_metadata()
+{
+}
+
+FileStatusBatch::FileStatusBatch(const QString &sourceDir, const QString &targetDir)
+    : m_sourceDir(sourceDir)
+    , m_targetDir(targetDir)
+    , m_pathPool()
+    , m_pathEnds()
+    , m_statuses()
+    , m_attributes()
+    , m_sourcePool()
+    , m_sourceEnds()
+    , m_metadata()
+{
+}
+
+void FileStatusBatch::reserve(qsizetype count)
+{
+    // Dotfile paths average a few dozen characters
+    m_pathPool.reserve(count * 32);
+    m_pathEnds.reserve(count);
+    m_statuses.reserve(count);
+    m_attributes.reserve(count);
+}
+
+void FileStatusBatch::append(QStringView path, ChezmoiStatus status, quint8 attributes)
+{
+    m_pathPool.append(path);
+    m_pathEnds.append(quint32(m_pathPool.size()));
+    m_statuses.append(status);
+    m_attributes.append(attributes);
+}
+
+void FileStatusBatch::appendUtf8(QByteArrayView path, ChezmoiStatus status, quint8 attributes)
+{
+    // Decode straight into the pool; UTF-8 never takes fewer bytes than UTF-16 code units
+    const qsizetype start = m_pathPool.size();
+    m_pathPool.resize(start + path.size());
+    QStringDecoder decoder(QStringDecoder::Utf8);
+    const QChar *end = decoder.appendToBuffer(m_pathPool.data() + start, path);
+    m_pathPool.truncate(end - m_pathPool.constData());
+
+    m_pathEnds.append(quint32(m_pathPool.size()));
+    m_statuses.append(status);
+    m_attributes.append(attributes);
+}
+
+void FileStatusBatch::appendSourcePath(QStringView sourcePath)
+{
+    if (m_sourceEnds.size() >= size()) {
+        return;
+    }
+    if (m_sourceEnds.isEmpty()) {
+        m_sourcePool.reserve(m_pathPool.size() + size() * 4);
+        m_sourceEnds.reserve(size());
+    }
+    m_sourcePool.append(sourcePath);
+    m_sourceEnds.append(quint32(m_sourcePool.size()));
+}
+
+void FileStatusBatch::setAttributes(qsizetype i, quint8 attributes)
+{
+    m_attributes[i] = attributes;
+}
+
+void FileStatusBatch::collectMetadata()
+{
+    // Every source and target in one parallel batch, so views never stat them one by one
+    QStringList paths;
+    paths.reserve(size() * 2);
+    for (qsizetype i = 0; i < size(); ++i) {
+        paths << sourcePath(i) << targetPath(i);
+    }
+    m_metadata = FileMetadata::collect(paths);
+}
+
+qsizetype FileStatusBatch::size() const
+{
+    return m_pathEnds.size();
+}
+
+bool FileStatusBatch::isEmpty() const
+{
+    return m_pathEnds.isEmpty();
+}
+
+QStringView FileStatusBatch::path(qsizetype i) const
+{
+    const quint32 begin = i > 0 ? m_pathEnds.at(i - 1) : 0;
+    return QStringView(m_pathPool).sliced(begin, m_pathEnds.at(i) - begin);
+}
+
+ChezmoiStatus FileStatusBatch::status(qsizetype i) const
+{
+    return m_statuses.at(i);
+}
+
+quint8 FileStatusBatch::attributes(qsizetype i) const
+{
+    return m_attributes.at(i);
+}
+
+bool FileStatusBatch::isTemplate(qsizetype i) const
+{
+    return m_attributes.at(i) & Template;
+}
+
+QString FileStatusBatch::sourcePath(qsizetype i) const
+{
+    if (i >= m_sourceEnds.size()) {
+        return QString();
+    }
+    const quint32 begin = i > 0 ? m_sourceEnds.at(i - 1) : 0;
+    if (begin == m_sourceEnds.at(i)) {
+        return QString();
+    }
+    return joinPath(m_sourceDir, QStringView(m_sourcePool).sliced(begin, m_sourceEnds.at(i) - begin));
+}
+
+QString FileStatusBatch::targetPath(qsizetype i) const
+{
+    return joinPath(m_targetDir, path(i));
+}
+
+bool FileStatusBatch::hasMetadata() const
+{
+    return m_metadata.size() == size() * 2;
+}
+
+const FileMetadata::Record &FileStatusBatch::sourceMetadata(qsizetype i) const
+{
+    return hasMetadata() ? m_metadata.at(2 * i) : MissingRecord;
+}
+
+const FileMetadata::Record &FileStatusBatch::targetMetadata(qsizetype i) const
+{
+    return hasMetadata() ? m_metadata.at(2 * i + 1) : MissingRecord;
+}
+
+QString FileStatusBatch::targetLinkTarget(qsizetype i) const
+{
+    return hasMetadata() ? m_metadata.linkTarget(2 * i + 1) : QString();
+}
+
+qint64 FileStatusBatch::byteSize() const
+{
+    return (m_sourceDir.capacity() + m_targetDir.capacity() + m_pathPool.capacity() + m_sourcePool.capacity()) * qint64(sizeof(QChar))
+        + (m_pathEnds.capacity() + m_sourceEnds.capacity()) * qint64(sizeof(quint32))
+        + m_statuses.capacity() * qint64(sizeof(ChezmoiStatus))
+        + m_attributes.capacity() * qint64(sizeof(quint8))
+        + m_metadata.byteSize();
+}
@@ -0,0 +1,70 @@
+#ifndef FILESTATUSBATCH_H
+#define FILESTATUSBATCH_H
+
+#include <QByteArrayView>
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+#include "chezmoistatus.h"
+#include "filemetadata.h"
+
+/**
+ * @brief The managed files of one chezmoi query, stored column by column
+ *
+ * Relative target paths share one string pool, and statuses and attributes
+ * take a byte each, so a batch costs a few dozen bytes per file instead of a
+ * handful of heap-allocated strings. Source paths, which chezmoi lists
+ * separately, fill a second pool in row order once known. Absolute paths are
+ * built on request, and metadata is only present once collectMetadata() has
+ * run.
+ */
+class FileStatusBatch
+{
+public:
+    enum Attribute : quint8 {
+        Template = 0x1
+    };
+
+    FileStatusBatch();
+    FileStatusBatch(const QString &sourceDir, const QString &targetDir);
+
+    void reserve(qsizetype count);
+    void append(QStringView path, ChezmoiStatus status, quint8 attributes);
+    void appendUtf8(QByteArrayView path, ChezmoiStatus status, quint8 attributes);
+    // Source path of the next row without one, relative to the source directory; empty when it has none
+    void appendSourcePath(QStringView sourcePath);
+    void setAttributes(qsizetype i, quint8 attributes);
+    void collectMetadata();
+
+    qsizetype size() const;
+    bool isEmpty() const;
+    QStringView path(qsizetype i) const;
+    ChezmoiStatus status(qsizetype i) const;
+    quint8 attributes(qsizetype i) const;
+    bool isTemplate(qsizetype i) const;
+    // Empty until the row's source path has been appended
+    QString sourcePath(qsizetype i) const;
+    QString targetPath(qsizetype i) const;
+
+    bool hasMetadata() const;
+    const FileMetadata::Record &sourceMetadata(qsizetype i) const;
+    const FileMetadata::Record &targetMetadata(qsizetype i) const;
+    QString targetLinkTarget(qsizetype i) const;
+
+    // Heap bytes held by the columns
+    qint64 byteSize() const;
+
+private:
+    QString m_sourceDir;
+    QString m_targetDir;
+    QString m_pathPool;
+    QList<quint32> m_pathEnds; // path i spans [m_pathEnds[i - 1], m_pathEnds[i])
+    QList<ChezmoiStatus> m_statuses;
+    QList<quint8> m_attributes;
+    QString m_sourcePool;
+    QList<quint32> m_sourceEnds; // like m_pathEnds, for the first m_sourceEnds.size() rows
+    FileMetadata m_metadata; // rows 2i and 2i + 1 hold the source and target of file i
+};
+
+#endif // FILESTATUSBATCH_H
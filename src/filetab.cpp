@@ -1,6 +1,7 @@
 #include "filetab.h"
 #include "chezmoiservice.h"
 #include "logger.h"
+#include "memoryregistry.h"
 
 #include <QVBoxLayout>
 #include <QPushButton>
@@ -36,7 +37,13 @@ FileTab::FileTab(const QString &filePath, ChezmoiService *chezmoiService, QWidge
     , m_openExternalButton(nullptr)
     , m_mainLayout(nullptr)
     , m_bottomToolBar(nullptr)
+    , m_memoryReporter(0)
 {
+    m_memoryReporter = MemoryRegistry::instance()->add(QStringLiteral("Open documents"), [this]() {
+        const qint64 characters = m_document ? m_document->totalCharacters() : 0;
+        return MemoryRegistry::Usage{characters * qint64(sizeof(QChar)), 1};
+    });
+    
     // Extract just the filename for display
     QFileInfo fileInfo(filePath);
     m_fileName = fileInfo.fileName();
@@ -45,6 +52,11 @@ FileTab::FileTab(const QString &filePath, ChezmoiService *chezmoiService, QWidge
     loadFileContent();
 }
 
+FileTab::~FileTab()
+{
+    MemoryRegistry::instance()->remove(m_memoryReporter);
+}
+
 void FileTab::setupUI()
 {
     m_mainLayout = new QVBoxLayout(this);
@@ -159,6 +171,16 @@ void FileTab::refreshContent()
     LOG_INFO(QStringLiteral("Refreshed content for file tab: %1").arg(m_filePath));
 }
 
+void FileTab::goToLine(int line, int column)
+{
+    if (!m_textView) {
+        return;
+    }
+    
+    m_textView->setCursorPosition(KTextEditor::Cursor(line, column));
+    m_textView->setFocus();
+}
+
 void FileTab::openInExternalEditor()
 {
     if (m_filePath.isEmpty()) {
@@ -24,13 +24,15 @@ class FileTab : public QWidget
 
 public:
     explicit FileTab(const QString &filePath, ChezmoiService *chezmoiService, QWidget *parent = nullptr);
-    ~FileTab() override = default;
+    ~FileTab() override;
 
     const QString &filePath() const { return m_filePath; }
     const QString &fileName() const { return m_fileName; }
 
 public Q_SLOTS:
     void refreshContent();
+    // Zero-based, as KTextEditor counts
+    void goToLine(int line, int column = 0);
 
 private Q_SLOTS:
     void openInExternalEditor();
@@ -49,6 +51,7 @@ private:
     QPushButton *m_openExternalButton;
     QVBoxLayout *m_mainLayout;
     QToolBar *m_bottomToolBar;
+    quint64 m_memoryReporter;
 };
 
 #endif // FILETAB_H
@@ -0,0 +1,178 @@
+#include "filewatcher.h"
+#include "logger.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+#ifdef Q_OS_LINUX
+// Entry-level changes only; IN_MODIFY would fire for every write() while a file is being saved
+constexpr uint32_t WatchMask = IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                             | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+// Room for a few hundred events per read()
+constexpr size_t EventBufferSize = 64 * 1024;
+#endif
+}
+
+FileWatcher::FileWatcher(QObject *parent)
+    : QObject(parent)
+    , m_fd(-1)
+    , m_notifier(nullptr)
+    , m_watches()
+    , m_watchesByPath()
+{
+#ifdef Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        LOG_WARNING(QStringLiteral("FileWatcher: inotify unavailable: %1").arg(QString::fromLocal8Bit(std::strerror(errno))));
+        return;
+    }
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &FileWatcher::readEvents);
+#else
+    LOG_INFO("FileWatcher: no inotify on this platform, live updates are disabled"_L1);
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0) {
+        delete m_notifier;
+        ::close(m_fd);
+    }
+#endif
+}
+
+bool FileWatcher::isAvailable() const
+{
+    return m_fd >= 0;
+}
+
+bool FileWatcher::addDirectory(const QString &path, bool recursive)
+{
+    if (!isAvailable()) {
+        return false;
+    }
+    return addWatch(QDir::cleanPath(path), recursive);
+}
+
+void FileWatcher::clear()
+{
+#ifdef Q_OS_LINUX
+    for (auto it = m_watches.cbegin(); it != m_watches.cend(); ++it) {
+        inotify_rm_watch(m_fd, it.key());
+    }
+#endif
+    m_watches.clear();
+    m_watchesByPath.clear();
+}
+
+QStringList FileWatcher::directories() const
+{
+    return m_watchesByPath.keys();
+}
+
+bool FileWatcher::addWatch(const QString &path, bool recursive)
+{
+#ifdef Q_OS_LINUX
+    const int wd = inotify_add_watch(m_fd, QFile::encodeName(path).constData(), WatchMask);
+    if (wd < 0) {
+        // ENOSPC means fs.inotify.max_user_watches was reached
+        LOG_WARNING(QStringLiteral("FileWatcher: cannot watch %1: %2").arg(path, QString::fromLocal8Bit(std::strerror(errno))));
+        return false;
+    }
+    m_watches.insert(wd, {path, recursive});
+    m_watchesByPath.insert(path, wd);
+
+    if (recursive) {
+        const QStringList children = QDir(path).entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden | QDir::NoSymLinks);
+        for (const QString &child : children) {
+            // Version control metadata churns constantly and is never part of the watched state
+            if (child == ".git"_L1) {
+                continue;
+            }
+            addWatch(path + u'/' + child, true);
+        }
+    }
+    return true;
+#else
+    Q_UNUSED(path)
+    Q_UNUSED(recursive)
+    return false;
+#endif
+}
+
+void FileWatcher::readEvents()
+{
+#ifdef Q_OS_LINUX
+    alignas(inotify_event) char buffer[EventBufferSize];
+    QStringList changed;
+    QSet<QString> seen;
+    bool overflow = false;
+
+    for (;;) {
+        const ssize_t length = ::read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            // EAGAIN: the queue is drained
+            break;
+        }
+
+        for (const char *p = buffer; p < buffer + length;) {
+            const auto *event = reinterpret_cast<const inotify_event *>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+
+            const auto watch = m_watches.constFind(event->wd);
+            if (watch == m_watches.constEnd()) {
+                continue;
+            }
+            const QString directory = watch->path;
+            const bool recursive = watch->recursive;
+
+            if (event->mask & IN_IGNORED) {
+                m_watchesByPath.remove(directory);
+                m_watches.remove(event->wd);
+                continue;
+            }
+            if (event->mask & IN_MOVE_SELF) {
+                // The watch would keep reporting under the old name
+                inotify_rm_watch(m_fd, event->wd);
+            }
+
+            const QString path = event->len > 0 ? directory + u'/' + QFile::decodeName(event->name) : directory;
+            if (recursive && (event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                addWatch(path, true);
+            }
+            if (!seen.contains(path)) {
+                seen.insert(path);
+                changed.append(path);
+            }
+        }
+    }
+
+    if (overflow) {
+        LOG_WARNING("FileWatcher: inotify queue overflowed, events were lost"_L1);
+        Q_EMIT overflowed();
+    }
+    if (!changed.isEmpty()) {
+        Q_EMIT pathsChanged(changed);
+    }
+#endif
+}
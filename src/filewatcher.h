@@ -0,0 +1,53 @@
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+class QSocketNotifier;
+
+/**
+ * @brief Directory watcher built directly on inotify
+ *
+ * Unlike QFileSystemWatcher it reports which entry inside a directory
+ * changed, registers whole trees recursively (following directories created
+ * later) and tells its user when the kernel queue overflowed, in which case
+ * events were lost and everything should be rescanned.
+ */
+class FileWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileWatcher(QObject *parent = nullptr);
+    ~FileWatcher() override;
+
+    bool isAvailable() const;
+    bool addDirectory(const QString &path, bool recursive = false);
+    void clear();
+    QStringList directories() const;
+
+Q_SIGNALS:
+    /** Entries created, written, removed or renamed since the last emission, as absolute paths */
+    void pathsChanged(const QStringList &paths);
+    void overflowed();
+
+private Q_SLOTS:
+    void readEvents();
+
+private:
+    struct Watch {
+        QString path;
+        bool recursive;
+    };
+
+    bool addWatch(const QString &path, bool recursive);
+
+    int m_fd;
+    QSocketNotifier *m_notifier;
+    QHash<int, Watch> m_watches;
+    QHash<QString, int> m_watchesByPath;
+};
+
+#endif // FILEWATCHER_H
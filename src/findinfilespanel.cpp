@@ -0,0 +1,189 @@
+#include "findinfilespanel.h"
+#include "chezmoiservice.h"
+#include "dotfilemanager.h"
+#include "logger.h"
+#include "searchresultsmodel.h"
+
+#include <QCheckBox>
+#include <QDir>
+#include <QHBoxLayout>
+#include <QIcon>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListView>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <KLocalizedString>
+
+using namespace Qt::Literals::StringLiterals;
+
+FindInFilesPanel::FindInFilesPanel(DotfileManager *dotfileManager, ChezmoiService *chezmoiService, QWidget *parent)
+    : QWidget(parent)
+    , m_dotfileManager(dotfileManager)
+    , m_chezmoiService(chezmoiService)
+    , m_search(new ContentSearch(this))
+    , m_results(new SearchResultsModel(this))
+    , m_patternEdit(nullptr)
+    , m_regexCheck(nullptr)
+    , m_caseCheck(nullptr)
+    , m_targetsCheck(nullptr)
+    , m_searchButton(nullptr)
+    , m_statusLabel(nullptr)
+    , m_resultView(nullptr)
+    , m_fileCount(0)
+    , m_truncated(false)
+{
+    setupUI();
+
+    connect(m_search, &ContentSearch::matchesFound, this, &FindInFilesPanel::onMatchesFound);
+    connect(m_search, &ContentSearch::finished, this, &FindInFilesPanel::onSearchFinished);
+}
+
+FindInFilesPanel::~FindInFilesPanel()
+{
+    // Nothing should react to the search stopping as the panel goes away
+    m_search->disconnect(this);
+}
+
+void FindInFilesPanel::setupUI()
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    auto *patternLayout = new QHBoxLayout();
+    m_patternEdit = new QLineEdit(this);
+    m_patternEdit->setPlaceholderText(i18n("Search in managed files..."));
+    m_patternEdit->setClearButtonEnabled(true);
+    connect(m_patternEdit, &QLineEdit::returnPressed, this, &FindInFilesPanel::startSearch);
+    patternLayout->addWidget(m_patternEdit, 1);
+
+    m_searchButton = new QPushButton(QIcon::fromTheme(QStringLiteral("edit-find")), i18n("Search"), this);
+    connect(m_searchButton, &QPushButton::clicked, this, [this]() {
+        if (m_search->isRunning()) {
+            stopSearch();
+        } else {
+            startSearch();
+        }
+    });
+    patternLayout->addWidget(m_searchButton);
+    layout->addLayout(patternLayout);
+
+    auto *optionsLayout = new QHBoxLayout();
+    m_regexCheck = new QCheckBox(i18n("Regular expression"), this);
+    optionsLayout->addWidget(m_regexCheck);
+    m_caseCheck = new QCheckBox(i18n("Match case"), this);
+    optionsLayout->addWidget(m_caseCheck);
+    m_targetsCheck = new QCheckBox(i18n("Search target files"), this);
+    m_targetsCheck->setToolTip(i18n("Search the files as chezmoi writes them to the home directory instead of their sources"));
+    optionsLayout->addWidget(m_targetsCheck);
+    optionsLayout->addStretch(1);
+    m_statusLabel = new QLabel(this);
+    optionsLayout->addWidget(m_statusLabel);
+    layout->addLayout(optionsLayout);
+
+    m_resultView = new QListView(this);
+    m_resultView->setModel(m_results);
+    m_resultView->setUniformItemSizes(true);
+    m_resultView->setAlternatingRowColors(true);
+    m_resultView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    connect(m_resultView, &QListView::activated, this, &FindInFilesPanel::onResultActivated);
+    layout->addWidget(m_resultView);
+}
+
+void FindInFilesPanel::focusPattern()
+{
+    m_patternEdit->setFocus(Qt::ShortcutFocusReason);
+    m_patternEdit->selectAll();
+}
+
+void FindInFilesPanel::startSearch()
+{
+    const QString pattern = m_patternEdit->text();
+    if (pattern.isEmpty()) {
+        return;
+    }
+
+    // Targets are only listed by their relative path; sources carry their own
+    QString rootDirectory;
+    QStringList files;
+    if (m_targetsCheck->isChecked()) {
+        rootDirectory = m_chezmoiService->getDestinationDirectory();
+        const QDir destination(rootDirectory);
+        const QStringList relativePaths = m_dotfileManager->managedPaths();
+        files.reserve(relativePaths.size());
+        for (const QString &relativePath : relativePaths) {
+            files.append(destination.filePath(relativePath));
+        }
+    } else {
+        rootDirectory = m_chezmoiService->getChezmoiDirectory();
+        files = m_dotfileManager->managedSourcePaths();
+    }
+
+    m_search->cancel();
+    m_results->clear();
+    m_results->setRootDirectory(rootDirectory);
+    m_fileCount = int(files.size());
+    m_truncated = false;
+
+    ContentSearch::Options options;
+    options.regularExpression = m_regexCheck->isChecked();
+    options.caseSensitive = m_caseCheck->isChecked();
+    if (!m_search->start(files, pattern, options)) {
+        m_statusLabel->setText(i18n("Invalid pattern: %1", m_search->errorString()));
+        return;
+    }
+
+    m_searchButton->setText(i18n("Stop"));
+    m_searchButton->setIcon(QIcon::fromTheme(QStringLiteral("process-stop")));
+    updateStatus();
+}
+
+void FindInFilesPanel::stopSearch()
+{
+    m_search->cancel();
+}
+
+void FindInFilesPanel::onMatchesFound(const QList<ContentSearch::Match> &matches)
+{
+    m_results->appendMatches(matches);
+
+    // The rest would only be thrown away
+    if (m_results->isFull()) {
+        m_truncated = true;
+        LOG_INFO(QStringLiteral("FindInFilesPanel: Stopping at %1 matches").arg(SearchResultsModel::MaxResults));
+        m_search->cancel();
+        return;
+    }
+    updateStatus();
+}
+
+void FindInFilesPanel::onSearchFinished(bool cancelled)
+{
+    m_searchButton->setText(i18n("Search"));
+    m_searchButton->setIcon(QIcon::fromTheme(QStringLiteral("edit-find")));
+
+    if (m_truncated) {
+        m_statusLabel->setText(i18n("Showing the first %1 matches", SearchResultsModel::MaxResults));
+    } else if (cancelled) {
+        m_statusLabel->setText(i18np("Stopped after %1 match", "Stopped after %1 matches", m_results->rowCount()));
+    } else {
+        updateStatus();
+    }
+}
+
+void FindInFilesPanel::onResultActivated(const QModelIndex &index)
+{
+    if (const ContentSearch::Match *match = m_results->match(index.row())) {
+        Q_EMIT matchActivated(match->filePath, match->line, match->column);
+    }
+}
+
+void FindInFilesPanel::updateStatus()
+{
+    const QString matches = i18np("%1 match", "%1 matches", m_results->rowCount());
+    if (m_search->isRunning()) {
+        m_statusLabel->setText(i18np("Searching %1 file... %2", "Searching %1 files... %2", m_fileCount, matches));
+    } else {
+        m_statusLabel->setText(i18np("%2 in %1 file", "%2 in %1 files", m_fileCount, matches));
+    }
+}
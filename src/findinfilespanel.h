@@ -0,0 +1,64 @@
+#ifndef FINDINFILESPANEL_H
+#define FINDINFILESPANEL_H
+
+#include <QWidget>
+#include <QString>
+
+#include "contentsearch.h"
+
+class QCheckBox;
+class QLabel;
+class QLineEdit;
+class QListView;
+class QPushButton;
+class ChezmoiService;
+class DotfileManager;
+class SearchResultsModel;
+
+/**
+ * @brief Panel searching the contents of every managed file, listing matching lines as they are found
+ */
+class FindInFilesPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    FindInFilesPanel(DotfileManager *dotfileManager, ChezmoiService *chezmoiService, QWidget *parent = nullptr);
+    ~FindInFilesPanel() override;
+
+public Q_SLOTS:
+    void focusPattern();
+    void startSearch();
+    void stopSearch();
+
+Q_SIGNALS:
+    // line and column are zero-based
+    void matchActivated(const QString &filePath, int line, int column);
+
+private Q_SLOTS:
+    void onMatchesFound(const QList<ContentSearch::Match> &matches);
+    void onSearchFinished(bool cancelled);
+    void onResultActivated(const QModelIndex &index);
+
+private:
+    void setupUI();
+    void updateStatus();
+
+    DotfileManager *m_dotfileManager;
+    ChezmoiService *m_chezmoiService;
+    ContentSearch *m_search;
+    SearchResultsModel *m_results;
+
+    QLineEdit *m_patternEdit;
+    QCheckBox *m_regexCheck;
+    QCheckBox *m_caseCheck;
+    QCheckBox *m_targetsCheck;
+    QPushButton *m_searchButton;
+    QLabel *m_statusLabel;
+    QListView *m_resultView;
+
+    int m_fileCount;
+    bool m_truncated;
+};
+
+#endif // FINDINFILESPANEL_H
@@ -0,0 +1,255 @@
+#include "fuzzymatcher.h"
+
+#include <QVarLengthArray>
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+// Every matched character scores this much, before bonuses and penalties
+constexpr int MatchScore = 16;
+
+// A match right after a separator, such as the 'k' of 'kitty.conf'
+constexpr int SegmentStartBonus = 8;
+
+// A match directly after the previous one, worth more than a separator so runs beat scattered initials
+constexpr int ConsecutiveBonus = 12;
+
+// A match inside the file name rather than a directory
+constexpr int BasenameBonus = 4;
+
+// Per character skipped between the first and last match, up to MaxGapPenalty in total
+constexpr int GapPenalty = 2;
+constexpr int MaxGapPenalty = 3 * MatchScore;
+
+bool isSeparator(QChar c)
+{
+    return c == u'/' || c == u'.' || c == u'_' || c == u'-' || c == u' ';
+}
+
+// Matches the query backwards from the last character at or before end, each as far right as
+// it goes, and scores that alignment; the query must occur within [0, end]
+int scoreAlignment(QStringView path, QStringView query, qsizetype end, qsizetype basenameStart)
+{
+    const char16_t *data = path.utf16();
+    const char16_t *needle = query.utf16();
+
+    QVarLengthArray<qsizetype, 64> positions(query.size());
+    qsizetype position = end;
+    for (qsizetype q = query.size() - 1; q >= 0; --q) {
+        while (data[position] != needle[q]) {
+            --position;
+        }
+        positions[q] = position--;
+    }
+
+    int total = 0;
+    qsizetype previous = -2;
+    for (const qsizetype matched : positions) {
+        total += MatchScore;
+        if (matched == 0 || isSeparator(path.at(matched - 1))) {
+            total += SegmentStartBonus;
+        }
+        if (matched == previous + 1) {
+            total += ConsecutiveBonus;
+        }
+        if (matched >= basenameStart) {
+            total += BasenameBonus;
+        }
+        previous = matched;
+    }
+
+    const qsizetype gaps = (positions.last() - positions.first() + 1) - query.size();
+    total -= int(qMin<qsizetype>(gaps * GapPenalty, MaxGapPenalty));
+    return qMax(total, 0);
+}
+
+// Index of the first c in [from, end), or -1
+qsizetype findChar(const char16_t *data, qsizetype from, qsizetype end, char16_t c)
+{
+    qsizetype i = from;
+#if defined(__SSE2__)
+    // Eight UTF-16 units per compare
+    const __m128i needle = _mm_set1_epi16(short(c));
+    for (; i + 8 <= end; i += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(chunk, needle));
+        if (mask) {
+            return i + qCountTrailingZeroBits(quint32(mask)) / 2;
+        }
+    }
+#endif
+    for (; i < end; ++i) {
+        if (data[i] == c) {
+            return i;
+        }
+    }
+    return -1;
+}
+}
+
+FuzzyMatcher::FuzzyMatcher()
+    : m_paths()
+    , m_folded()
+    , m_starts()
+    , m_basenameStarts()
+    , m_masks()
+    , m_lastQuery()
+    , m_lastCandidates()
+{
+}
+
+void FuzzyMatcher::setPaths(const QStringList &paths)
+{
+    m_paths = paths;
+    m_folded.clear();
+    m_starts.clear();
+    m_basenameStarts.clear();
+    m_masks.clear();
+    m_lastQuery.clear();
+    m_lastCandidates.clear();
+
+    m_starts.reserve(paths.size() + 1);
+    m_basenameStarts.reserve(paths.size());
+    m_masks.reserve(paths.size());
+
+    for (const QString &path : paths) {
+        const QString folded = path.toLower();
+        m_starts.append(quint32(m_folded.size()));
+        m_basenameStarts.append(quint32(folded.lastIndexOf(u'/') + 1));
+        m_masks.append(characterMask(folded));
+        m_folded += folded;
+    }
+    m_starts.append(quint32(m_folded.size()));
+}
+
+qsizetype FuzzyMatcher::size() const
+{
+    return m_paths.size();
+}
+
+const QString &FuzzyMatcher::path(qsizetype i) const
+{
+    return m_paths.at(i);
+}
+
+qint64 FuzzyMatcher::byteSize() const
+{
+    // The original path strings are implicitly shared with whoever supplied them, so only the list counts
+    return m_folded.capacity() * qint64(sizeof(QChar))
+        + (m_starts.capacity() + m_basenameStarts.capacity()) * qint64(sizeof(quint32))
+        + m_masks.capacity() * qint64(sizeof(quint64))
+        + m_lastCandidates.capacity() * qint64(sizeof(qsizetype))
+        + m_paths.capacity() * qint64(sizeof(QString));
+}
+
+QStringView FuzzyMatcher::foldedPath(qsizetype i) const
+{
+    return QStringView(m_folded).sliced(m_starts.at(i), m_starts.at(i + 1) - m_starts.at(i));
+}
+
+QList<FuzzyMatcher::Match> FuzzyMatcher::match(QStringView query, qsizetype limit)
+{
+    QString folded = query.toString().toLower();
+    folded.remove(u' ');
+
+    QList<Match> matches;
+    if (folded.isEmpty()) {
+        m_lastQuery.clear();
+        m_lastCandidates.clear();
+        for (qsizetype i = 0; i < qMin(limit, size()); ++i) {
+            matches.append(Match{i, 0});
+        }
+        return matches;
+    }
+
+    // Anything matching "abc" also matched "ab", so a longer query only looks at those
+    const bool narrowing = !m_lastQuery.isEmpty() && folded.startsWith(m_lastQuery);
+    const qsizetype candidateCount = narrowing ? m_lastCandidates.size() : size();
+    const quint64 queryMask = characterMask(folded);
+
+    QList<qsizetype> candidates;
+    for (qsizetype c = 0; c < candidateCount; ++c) {
+        const qsizetype i = narrowing ? m_lastCandidates.at(c) : c;
+        if ((m_masks.at(i) & queryMask) != queryMask) {
+            continue;
+        }
+        const int pathScore = score(foldedPath(i), folded, m_basenameStarts.at(i));
+        if (pathScore != NoMatch) {
+            candidates.append(i);
+            matches.append(Match{i, pathScore});
+        }
+    }
+    m_lastQuery = folded;
+    m_lastCandidates = std::move(candidates);
+
+    // Higher scores first, then shorter paths, then inventory order
+    auto better = [this](const Match &a, const Match &b) {
+        if (a.score != b.score) {
+            return a.score > b.score;
+        }
+        const quint32 lengthA = m_starts.at(a.index + 1) - m_starts.at(a.index);
+        const quint32 lengthB = m_starts.at(b.index + 1) - m_starts.at(b.index);
+        return lengthA != lengthB ? lengthA < lengthB : a.index < b.index;
+    };
+    const qsizetype kept = qMin(limit, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + kept, matches.end(), better);
+    matches.resize(kept);
+    return matches;
+}
+
+int FuzzyMatcher::score(QStringView path, QStringView query, qsizetype basenameStart)
+{
+    if (query.isEmpty()) {
+        return 0;
+    }
+
+    const char16_t *data = path.utf16();
+    const char16_t *needle = query.utf16();
+    const qsizetype length = path.size();
+
+    // Leftmost match of the whole query, to find where the shortest match can end
+    qsizetype end = -1;
+    for (qsizetype q = 0, from = 0; q < query.size(); ++q) {
+        end = findChar(data, from, length, needle[q]);
+        if (end < 0) {
+            return NoMatch;
+        }
+        from = end + 1;
+    }
+
+    // Walking back from that end gives the tightest alignment; walking back from the end of the
+    // path gives the one furthest right, which usually lands in the file name
+    return qMax(scoreAlignment(path, query, end, basenameStart),
+                scoreAlignment(path, query, length - 1, basenameStart));
+}
+
+quint64 FuzzyMatcher::characterMask(QStringView text)
+{
+    // One bit per letter and digit, a few for separators, the rest of Unicode shares the remainder
+    quint64 mask = 0;
+    for (QChar c : text) {
+        const char16_t u = c.unicode();
+        int bit;
+        if (u >= u'a' && u <= u'z') {
+            bit = u - u'a';
+        } else if (u >= u'0' && u <= u'9') {
+            bit = 26 + (u - u'0');
+        } else if (u == u'.') {
+            bit = 36;
+        } else if (u == u'/') {
+            bit = 37;
+        } else if (u == u'_') {
+            bit = 38;
+        } else if (u == u'-') {
+            bit = 39;
+        } else {
+            bit = 40 + u % 24;
+        }
+        mask |= quint64(1) << bit;
+    }
+    return mask;
+}
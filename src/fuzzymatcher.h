@@ -0,0 +1,58 @@
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+/**
+ * @brief Ranks paths by how well a typed query matches them as a subsequence
+ *
+ * setPaths() builds the index once: every path lower-cased into one
+ * contiguous buffer, plus a 64-bit mask of the characters it contains so
+ * most paths are rejected without being scanned. Scanning for the next
+ * query character uses SSE2 where available. A query that extends the
+ * previous one only rescans the paths that matched before, so typing
+ * narrows the search instead of repeating it.
+ */
+class FuzzyMatcher
+{
+public:
+    struct Match {
+        qsizetype index;
+        int score;
+    };
+
+    // Returned by score() for paths that do not contain the query
+    static constexpr int NoMatch = -1;
+
+    FuzzyMatcher();
+
+    void setPaths(const QStringList &paths);
+    qsizetype size() const;
+    const QString &path(qsizetype i) const;
+    qint64 byteSize() const;
+
+    // Best matches first, at most limit of them; an empty query lists paths in order
+    QList<Match> match(QStringView query, qsizetype limit);
+
+    // Scores one path, with both arguments already lower-cased
+    static int score(QStringView path, QStringView query, qsizetype basenameStart);
+
+private:
+    static quint64 characterMask(QStringView text);
+    QStringView foldedPath(qsizetype i) const;
+
+    QStringList m_paths;
+    QString m_folded;
+    QList<quint32> m_starts;         // path i spans [m_starts[i], m_starts[i + 1])
+    QList<quint32> m_basenameStarts; // offset of the file name within path i
+    QList<quint64> m_masks;
+
+    // Paths that matched the last query, the starting point when the next one extends it
+    QString m_lastQuery;
+    QList<qsizetype> m_lastCandidates;
+};
+
+#endif // FUZZYMATCHER_H
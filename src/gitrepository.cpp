@@ -0,0 +1,1136 @@
+#include "gitrepository.h"
+#include "logger.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+constexpr int RawIdSize = 20;
+// git caps "repack --depth" at 4095
+constexpr int MaxDeltaDepth = 4095;
+constexpr int MaxRefDepth = 8;
+constexpr int MaxTreeDepth = 64;
+// Upper bound on commits visited by aheadBehind so a pathological history cannot stall the caller
+constexpr int MaxHistoryWalk = 200000;
+
+quint32 readBigEndian32(const uchar *data)
+{
+    return qFromBigEndian<quint32>(data);
+}
+
+quint64 readBigEndian64(const uchar *data)
+{
+    return qFromBigEndian<quint64>(data);
+}
+
+bool isHexId(const QByteArray &id)
+{
+    if (id.size() != RawIdSize * 2) {
+        return false;
+    }
+    return std::all_of(id.cbegin(), id.cend(), [](char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+    });
+}
+
+// Inflates a zlib stream. When expectedSize is known (packed objects) the input may extend past
+// the end of the stream; otherwise the output buffer grows until the stream ends.
+bool inflateBuffer(const uchar *input, qsizetype inputSize, qint64 expectedSize, QByteArray *output)
+{
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (inflateInit(&stream) != Z_OK) {
+        return false;
+    }
+
+    qsizetype capacity = expectedSize >= 0 ? qsizetype(expectedSize) + 1 : qMax<qsizetype>(inputSize * 4, 4096);
+    output->resize(capacity);
+
+    stream.next_in = const_cast<Bytef *>(input);
+    stream.avail_in = uInt(qMin<qsizetype>(inputSize, std::numeric_limits<uInt>::max()));
+
+    int ret = Z_OK;
+    while (ret != Z_STREAM_END) {
+        const qsizetype produced = qsizetype(stream.total_out);
+        if (produced == output->size()) {
+            if (expectedSize >= 0) {
+                break; // more data than the object header announced
+            }
+            output->resize(output->size() * 2);
+        }
+
+        stream.next_out = reinterpret_cast<Bytef *>(output->data() + produced);
+        stream.avail_out = uInt(output->size() - produced);
+        ret = inflate(&stream, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END) {
+            break;
+        }
+    }
+
+    const qsizetype produced = qsizetype(stream.total_out);
+    inflateEnd(&stream);
+
+    if (ret != Z_STREAM_END || (expectedSize >= 0 && produced != expectedSize)) {
+        output->clear();
+        return false;
+    }
+
+    output->resize(produced);
+    return true;
+}
+
+bool applyDelta(const QByteArray &base, const QByteArray &delta, QByteArray *output)
+{
+    const auto *p = reinterpret_cast<const uchar *>(delta.constData());
+    const uchar *end = p + delta.size();
+
+    auto readSize = [&p, end](quint64 *value) {
+        *value = 0;
+        int shift = 0;
+        uchar c = 0;
+        do {
+            if (p >= end || shift > 63) {
+                return false;
+            }
+            c = *p++;
+            *value |= quint64(c & 0x7f) << shift;
+            shift += 7;
+        } while (c & 0x80);
+        return true;
+    };
+
+    quint64 baseSize = 0;
+    quint64 resultSize = 0;
+    if (!readSize(&baseSize) || !readSize(&resultSize) || baseSize != quint64(base.size())) {
+        return false;
+    }
+
+    output->resize(qsizetype(resultSize));
+    char *out = output->data();
+    quint64 written = 0;
+
+    while (p < end) {
+        const uchar op = *p++;
+        if (op & 0x80) {
+            // Copy from base: bits 0-3 select offset bytes, bits 4-6 select size bytes
+            quint64 copyOffset = 0;
+            quint64 copySize = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (op & (1 << i)) {
+                    if (p >= end) {
+                        return false;
+                    }
+                    copyOffset |= quint64(*p++) << (8 * i);
+                }
+            }
+            for (int i = 0; i < 3; ++i) {
+                if (op & (0x10 << i)) {
+                    if (p >= end) {
+                        return false;
+                    }
+                    copySize |= quint64(*p++) << (8 * i);
+                }
+            }
+            if (copySize == 0) {
+                copySize = 0x10000;
+            }
+            if (copyOffset + copySize > baseSize || written + copySize > resultSize) {
+                return false;
+            }
+            std::memcpy(out + written, base.constData() + copyOffset, copySize);
+            written += copySize;
+        } else if (op != 0) {
+            // Insert the next op bytes literally
+            if (quint64(end - p) < op || written + op > resultSize) {
+                return false;
+            }
+            std::memcpy(out + written, p, op);
+            p += op;
+            written += op;
+        } else {
+            return false;
+        }
+    }
+
+    return written == resultSize;
+}
+
+QByteArray blobHash(const QByteArray &content)
+{
+    const QByteArray header = QByteArray("blob ") + QByteArray::number(content.size());
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(header);
+    hash.addData(QByteArrayView("\0", 1));
+    hash.addData(content);
+    return hash.result();
+}
+
+QByteArray fileBlobHash(const QByteArray &localPath, qint64 size)
+{
+    QFile file(QFile::decodeName(localPath));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    const QByteArray header = QByteArray("blob ") + QByteArray::number(size);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(header);
+    hash.addData(QByteArrayView("\0", 1));
+    if (!hash.addData(&file)) {
+        return QByteArray();
+    }
+    return hash.result();
+}
+
+QString parseSubject(const QByteArray &data, qsizetype messageStart)
+{
+    if (messageStart < 0 || messageStart >= data.size()) {
+        return QString();
+    }
+    qsizetype end = data.indexOf('\n', messageStart);
+    if (end < 0) {
+        end = data.size();
+    }
+    return QString::fromUtf8(data.mid(messageStart, end - messageStart)).trimmed();
+}
+
+// "Name <email> 1700000000 +0100" -> name and timestamp
+void parseSignature(const QByteArray &line, QString *name, qint64 *time)
+{
+    const qsizetype emailStart = line.indexOf('<');
+    const qsizetype emailEnd = line.lastIndexOf('>');
+    if (name && emailStart > 0) {
+        *name = QString::fromUtf8(line.left(emailStart)).trimmed();
+    }
+    if (emailEnd >= 0) {
+        const QList<QByteArray> fields = line.mid(emailEnd + 1).trimmed().split(' ');
+        if (!fields.isEmpty()) {
+            *time = fields.first().toLongLong();
+        }
+    }
+}
+}
+
+struct GitRepository::Pack {
+    std::unique_ptr<QFile> indexFile;
+    std::unique_ptr<QFile> packFile;
+    const uchar *index = nullptr;
+    qint64 indexSize = 0;
+    const uchar *data = nullptr;
+    qint64 dataSize = 0;
+    quint32 objectCount = 0;
+};
+
+int GitRepository::WorkTreeStatus::dirtyCount() const
+{
+    QSet<QString> paths;
+    for (const QStringList *list : {&modified, &deleted, &staged}) {
+        for (const QString &path : *list) {
+            paths.insert(path);
+        }
+    }
+    return paths.size();
+}
+
+GitRepository::GitRepository(const QString &workTree)
+    : m_workTree(QDir::cleanPath(workTree))
+    , m_gitDir(discoverGitDirectory(workTree))
+    , m_commonDir()
+    , m_packsLoaded(false)
+    , m_packs()
+{
+    m_commonDir = m_gitDir;
+
+    // Linked worktrees keep HEAD and index locally but share refs and objects
+    if (!m_gitDir.isEmpty()) {
+        QFile commonDirFile(m_gitDir + "/commondir"_L1);
+        if (commonDirFile.open(QIODevice::ReadOnly)) {
+            const QString commonDir = QString::fromUtf8(commonDirFile.readAll()).trimmed();
+            m_commonDir = QDir::cleanPath(QDir(m_gitDir).absoluteFilePath(commonDir));
+        }
+    }
+}
+
+GitRepository::~GitRepository() = default;
+
+QString GitRepository::discoverGitDirectory(const QString &workTree)
+{
+    if (workTree.isEmpty()) {
+        return QString();
+    }
+
+    const QString dotGit = workTree + "/.git"_L1;
+    QFileInfo info(dotGit);
+    QString gitDir;
+
+    if (info.isDir()) {
+        gitDir = dotGit;
+    } else if (info.isFile()) {
+        // Worktrees and submodules use a ".git" file pointing at the real git directory
+        QFile file(dotGit);
+        if (file.open(QIODevice::ReadOnly)) {
+            const QString line = QString::fromUtf8(file.readLine()).trimmed();
+            if (line.startsWith("gitdir:"_L1)) {
+                gitDir = QDir(workTree).absoluteFilePath(line.mid(7).trimmed());
+            }
+        }
+    }
+
+    if (gitDir.isEmpty() || !QFileInfo::exists(gitDir + "/HEAD"_L1)) {
+        return QString();
+    }
+    return QDir::cleanPath(gitDir);
+}
+
+bool GitRepository::isRepository(const QString &workTree)
+{
+    return !discoverGitDirectory(workTree).isEmpty();
+}
+
+QString GitRepository::findWorkTree(const QString &path)
+{
+    QDir dir(path);
+    do {
+        if (isRepository(dir.absolutePath())) {
+            return dir.absolutePath();
+        }
+    } while (dir.cdUp());
+
+    return QString();
+}
+
+bool GitRepository::isValid() const
+{
+    return !m_gitDir.isEmpty();
+}
+
+QString GitRepository::workTree() const
+{
+    return m_workTree;
+}
+
+QString GitRepository::gitDirectory() const
+{
+    return m_gitDir;
+}
+
+QString GitRepository::currentBranch() const
+{
+    QFile headFile(m_gitDir + "/HEAD"_L1);
+    if (!headFile.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    const QByteArray head = headFile.readAll().trimmed();
+    if (head.startsWith("ref: refs/heads/")) {
+        return QString::fromUtf8(head.mid(16));
+    }
+    return QString(); // detached
+}
+
+QByteArray GitRepository::resolveRef(const QString &refName) const
+{
+    if (!isValid()) {
+        return QByteArray();
+    }
+
+    QString name = refName;
+    for (int depth = 0; depth < MaxRefDepth; ++depth) {
+        // HEAD and other pseudo-refs live in the per-worktree directory
+        const bool perWorkTree = !name.startsWith("refs/"_L1);
+        QFile refFile((perWorkTree ? m_gitDir : m_commonDir) + u'/' + name);
+
+        QByteArray value;
+        if (refFile.open(QIODevice::ReadOnly)) {
+            value = refFile.readAll().trimmed();
+        } else {
+            value = lookupPackedRef(name);
+        }
+
+        if (value.startsWith("ref: ")) {
+            name = QString::fromUtf8(value.mid(5).trimmed());
+            continue;
+        }
+
+        return isHexId(value) ? value : QByteArray();
+    }
+
+    LOG_WARNING(QStringLiteral("Symbolic ref chain too deep while resolving %1").arg(refName));
+    return QByteArray();
+}
+
+QByteArray GitRepository::lookupPackedRef(const QString &refName) const
+{
+    QFile packedRefs(m_commonDir + "/packed-refs"_L1);
+    if (!packedRefs.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    const QByteArray wanted = refName.toUtf8();
+    const QList<QByteArray> lines = packedRefs.readAll().split('\n');
+    for (const QByteArray &line : lines) {
+        // Skip the header and peeled "^<id>" lines
+        if (line.isEmpty() || line.startsWith('#') || line.startsWith('^')) {
+            continue;
+        }
+        const qsizetype space = line.indexOf(' ');
+        if (space == RawIdSize * 2 && line.mid(space + 1).trimmed() == wanted) {
+            return line.left(space);
+        }
+    }
+    return QByteArray();
+}
+
+QByteArray GitRepository::headId() const
+{
+    return resolveRef(u"HEAD"_s);
+}
+
+QString GitRepository::upstreamRef() const
+{
+    const QString branch = currentBranch();
+    if (branch.isEmpty()) {
+        return QString();
+    }
+
+    QFile configFile(m_commonDir + "/config"_L1);
+    if (!configFile.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    const QString wantedSection = QStringLiteral("branch \"%1\"").arg(branch);
+    QString section;
+    QString remote;
+    QString merge;
+
+    const QList<QByteArray> lines = configFile.readAll().split('\n');
+    for (const QByteArray &rawLine : lines) {
+        const QString line = QString::fromUtf8(rawLine).trimmed();
+        if (line.isEmpty() || line.startsWith(u'#') || line.startsWith(u';')) {
+            continue;
+        }
+        if (line.startsWith(u'[') && line.endsWith(u']')) {
+            section = line.mid(1, line.length() - 2).trimmed();
+            continue;
+        }
+        if (section != wantedSection) {
+            continue;
+        }
+
+        const qsizetype equals = line.indexOf(u'=');
+        if (equals < 0) {
+            continue;
+        }
+        const QString key = line.left(equals).trimmed().toLower();
+        QString value = line.mid(equals + 1).trimmed();
+        if (value.length() >= 2 && value.startsWith(u'"') && value.endsWith(u'"')) {
+            value = value.mid(1, value.length() - 2);
+        }
+
+        if (key == "remote"_L1) {
+            remote = value;
+        } else if (key == "merge"_L1) {
+            merge = value;
+        }
+    }
+
+    if (remote.isEmpty() || merge.isEmpty()) {
+        return QString();
+    }
+    if (remote == "."_L1) {
+        return merge; // tracking a local branch
+    }
+    if (merge.startsWith("refs/heads/"_L1)) {
+        return QStringLiteral("refs/remotes/%1/%2").arg(remote, merge.mid(11));
+    }
+    return QString();
+}
+
+void GitRepository::loadPacks() const
+{
+    m_packsLoaded = true;
+
+    QDir packDir(m_commonDir + "/objects/pack"_L1);
+    const QStringList indexFiles = packDir.entryList({u"pack-*.idx"_s}, QDir::Files);
+
+    for (const QString &indexName : indexFiles) {
+        auto pack = std::make_unique<Pack>();
+        pack->indexFile = std::make_unique<QFile>(packDir.filePath(indexName));
+        pack->packFile = std::make_unique<QFile>(packDir.filePath(indexName.chopped(4) + ".pack"_L1));
+
+        if (!pack->indexFile->open(QIODevice::ReadOnly) || !pack->packFile->open(QIODevice::ReadOnly)) {
+            continue;
+        }
+
+        pack->indexSize = pack->indexFile->size();
+        pack->dataSize = pack->packFile->size();
+        pack->index = pack->indexFile->map(0, pack->indexSize);
+        pack->data = pack->packFile->map(0, pack->dataSize);
+        if (!pack->index || !pack->data) {
+            continue;
+        }
+
+        // Only version 2 indexes ("\377tOc", 2) are written by any git from the last decade
+        constexpr qint64 headerSize = 8 + 256 * 4;
+        if (pack->indexSize < headerSize || std::memcmp(pack->index, "\377tOc", 4) != 0
+            || readBigEndian32(pack->index + 4) != 2) {
+            LOG_WARNING(QStringLiteral("Unsupported pack index: %1").arg(indexName));
+            continue;
+        }
+        if (pack->dataSize < 12 || std::memcmp(pack->data, "PACK", 4) != 0) {
+            continue;
+        }
+
+        pack->objectCount = readBigEndian32(pack->index + 8 + 255 * 4);
+        const qint64 minimumSize = headerSize + qint64(pack->objectCount) * (RawIdSize + 4 + 4) + 2 * RawIdSize;
+        if (pack->indexSize < minimumSize) {
+            continue;
+        }
+
+        m_packs.push_back(std::move(pack));
+    }
+}
+
+bool GitRepository::findPackedObject(const QByteArray &rawId, const Pack **foundPack, quint64 *offset) const
+{
+    if (!m_packsLoaded) {
+        loadPacks();
+    }
+
+    const auto *id = reinterpret_cast<const uchar *>(rawId.constData());
+
+    for (const auto &pack : m_packs) {
+        const uchar *fanout = pack->index + 8;
+        quint32 low = id[0] == 0 ? 0 : readBigEndian32(fanout + 4 * (id[0] - 1));
+        quint32 high = readBigEndian32(fanout + 4 * id[0]);
+        const uchar *ids = fanout + 256 * 4;
+
+        while (low < high) {
+            const quint32 mid = low + (high - low) / 2;
+            const int cmp = std::memcmp(ids + qint64(mid) * RawIdSize, id, RawIdSize);
+            if (cmp == 0) {
+                const uchar *offsets = ids + qint64(pack->objectCount) * (RawIdSize + 4);
+                const quint32 smallOffset = readBigEndian32(offsets + qint64(mid) * 4);
+                if (smallOffset & 0x80000000u) {
+                    // Packs larger than 2 GiB store the offset in a separate 64-bit table
+                    const uchar *largeOffsets = offsets + qint64(pack->objectCount) * 4;
+                    const qint64 position = (largeOffsets - pack->index) + qint64(smallOffset & 0x7fffffffu) * 8;
+                    if (position + 8 > pack->indexSize) {
+                        return false;
+                    }
+                    *offset = readBigEndian64(pack->index + position);
+                } else {
+                    *offset = smallOffset;
+                }
+                *foundPack = pack.get();
+                return true;
+            }
+            if (cmp < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool GitRepository::readPackedObject(const Pack &pack, quint64 offset, QByteArray *type, QByteArray *data) const
+{
+    // Delta chains are walked iteratively: "git repack --depth" allows chains far deeper than the stack should go
+    QList<QByteArray> deltas;
+    QByteArray base;
+    const uchar *end = pack.data + pack.dataSize;
+
+    for (;;) {
+        if (deltas.size() > MaxDeltaDepth || offset >= quint64(pack.dataSize)) {
+            return false;
+        }
+
+        const uchar *p = pack.data + offset;
+        uchar c = *p++;
+        const int objectType = (c >> 4) & 0x7;
+        quint64 size = c & 0x0f;
+        int shift = 4;
+        while (c & 0x80) {
+            if (p >= end || shift > 60) {
+                return false;
+            }
+            c = *p++;
+            size |= quint64(c & 0x7f) << shift;
+            shift += 7;
+        }
+
+        if (objectType >= 1 && objectType <= 4) {
+            static const QByteArray typeNames[] = {"commit", "tree", "blob", "tag"};
+            *type = typeNames[objectType - 1];
+            if (!inflateBuffer(p, end - p, qint64(size), &base)) {
+                return false;
+            }
+            break;
+        }
+
+        if (objectType == 6) {
+            // OFS_DELTA: base lives earlier in the same pack
+            if (p >= end) {
+                return false;
+            }
+            c = *p++;
+            quint64 distance = c & 0x7f;
+            while (c & 0x80) {
+                if (p >= end) {
+                    return false;
+                }
+                c = *p++;
+                distance = ((distance + 1) << 7) | (c & 0x7f);
+            }
+            if (distance == 0 || distance > offset) {
+                return false;
+            }
+
+            QByteArray delta;
+            if (!inflateBuffer(p, end - p, qint64(size), &delta)) {
+                return false;
+            }
+            deltas.append(delta);
+            offset -= distance;
+            continue;
+        }
+
+        if (objectType == 7) {
+            // REF_DELTA: base named by object id, possibly in another pack or loose
+            if (end - p < RawIdSize) {
+                return false;
+            }
+            const QByteArray baseId = QByteArray(reinterpret_cast<const char *>(p), RawIdSize).toHex();
+            p += RawIdSize;
+
+            QByteArray delta;
+            if (!inflateBuffer(p, end - p, qint64(size), &delta) || !readObject(baseId, type, &base)) {
+                return false;
+            }
+            deltas.append(delta);
+            break;
+        }
+
+        return false;
+    }
+
+    for (auto it = deltas.crbegin(); it != deltas.crend(); ++it) {
+        QByteArray result;
+        if (!applyDelta(base, *it, &result)) {
+            return false;
+        }
+        base = std::move(result);
+    }
+    *data = std::move(base);
+    return true;
+}
+
+bool GitRepository::readLooseObject(const QByteArray &id, QByteArray *type, QByteArray *data) const
+{
+    const QString path = QStringLiteral("%1/objects/%2/%3")
+                             .arg(m_commonDir, QString::fromLatin1(id.left(2)), QString::fromLatin1(id.mid(2)));
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const QByteArray compressed = file.readAll();
+    QByteArray raw;
+    if (!inflateBuffer(reinterpret_cast<const uchar *>(compressed.constData()), compressed.size(), -1, &raw)) {
+        LOG_WARNING(QStringLiteral("Corrupt loose object: %1").arg(path));
+        return false;
+    }
+
+    // Header: "<type> <size>\0"
+    const qsizetype nul = raw.indexOf('\0');
+    const qsizetype space = raw.indexOf(' ');
+    if (nul < 0 || space < 0 || space > nul) {
+        return false;
+    }
+
+    *type = raw.left(space);
+    *data = raw.mid(nul + 1);
+    return raw.mid(space + 1, nul - space - 1).toLongLong() == data->size();
+}
+
+bool GitRepository::readObject(const QByteArray &id, QByteArray *type, QByteArray *data) const
+{
+    if (!isValid() || !isHexId(id)) {
+        return false;
+    }
+
+    if (readLooseObject(id, type, data)) {
+        return true;
+    }
+
+    const Pack *pack = nullptr;
+    quint64 offset = 0;
+    if (findPackedObject(QByteArray::fromHex(id), &pack, &offset)) {
+        return readPackedObject(*pack, offset, type, data);
+    }
+
+    return false;
+}
+
+GitRepository::Commit GitRepository::readCommit(const QByteArray &id) const
+{
+    Commit commit;
+
+    QByteArray type;
+    QByteArray data;
+    if (!readObject(id, &type, &data) || type != "commit") {
+        return commit;
+    }
+
+    commit.id = id;
+
+    qsizetype position = 0;
+    while (position < data.size()) {
+        qsizetype lineEnd = data.indexOf('\n', position);
+        if (lineEnd < 0) {
+            lineEnd = data.size();
+        }
+        if (lineEnd == position) {
+            // Blank line separates headers from the message
+            commit.subject = parseSubject(data, lineEnd + 1);
+            break;
+        }
+
+        const QByteArray line = data.mid(position, lineEnd - position);
+        if (line.startsWith("tree ")) {
+            commit.treeId = line.mid(5);
+        } else if (line.startsWith("parent ")) {
+            commit.parents.append(line.mid(7));
+        } else if (line.startsWith("author ")) {
+            parseSignature(line.mid(7), &commit.authorName, &commit.authorTime);
+        } else if (line.startsWith("committer ")) {
+            parseSignature(line.mid(10), nullptr, &commit.commitTime);
+        }
+
+        position = lineEnd + 1;
+    }
+
+    return commit;
+}
+
+bool GitRepository::readFileAtCommit(const QByteArray &commitId, const QString &path, QByteArray *data) const
+{
+    const Commit commit = readCommit(commitId);
+    if (!commit.isValid()) {
+        return false;
+    }
+
+    QByteArray objectId = commit.treeId;
+    const QList<QByteArray> components = path.toUtf8().split('/');
+
+    for (const QByteArray &component : components) {
+        QByteArray type;
+        QByteArray tree;
+        if (component.isEmpty() || !readObject(objectId, &type, &tree) || type != "tree") {
+            return false;
+        }
+
+        // Entries: "<octal mode> <name>\0<20-byte id>"
+        QByteArray childId;
+        qsizetype position = 0;
+        while (position < tree.size()) {
+            const qsizetype space = tree.indexOf(' ', position);
+            const qsizetype nul = tree.indexOf('\0', position);
+            if (space < 0 || nul < 0 || space > nul || nul + 1 + RawIdSize > tree.size()) {
+                return false;
+            }
+            if (nul - space - 1 == component.size()
+                && std::memcmp(tree.constData() + space + 1, component.constData(), component.size()) == 0) {
+                childId = tree.mid(nul + 1, RawIdSize).toHex();
+                break;
+            }
+            position = nul + 1 + RawIdSize;
+        }
+
+        if (childId.isEmpty()) {
+            return false;
+        }
+        objectId = childId;
+    }
+
+    QByteArray type;
+    return readObject(objectId, &type, data) && type == "blob";
+}
+
+bool GitRepository::aheadBehind(const QByteArray &localId, const QByteArray &upstreamId, int *ahead, int *behind) const
+{
+    *ahead = 0;
+    *behind = 0;
+
+    if (localId.isEmpty() || upstreamId.isEmpty()) {
+        return false;
+    }
+    if (localId == upstreamId) {
+        return true;
+    }
+
+    // Walk both histories newest-first, painting commits with the side(s) that reach them, and stop
+    // once every queued commit is reachable from both. Commits left with a single colour are the
+    // ahead/behind ones. A commit whose colour grows after it was walked is walked again, so equal
+    // or skewed commit times cannot leave stale colours behind.
+    enum : quint8 { Local = 1, Upstream = 2, Both = Local | Upstream };
+
+    struct QueueItem {
+        qint64 time;
+        QByteArray id;
+        bool operator<(const QueueItem &other) const { return time < other.time; }
+    };
+
+    QHash<QByteArray, quint8> flags;
+    QHash<QByteArray, quint8> propagated;
+    QHash<QByteArray, Commit> commits;
+    std::vector<QueueItem> queue;
+
+    auto enqueue = [&](const QByteArray &id) {
+        auto it = commits.find(id);
+        if (it == commits.end()) {
+            it = commits.insert(id, readCommit(id));
+        }
+        queue.push_back({it->commitTime, id});
+        std::push_heap(queue.begin(), queue.end());
+        return it->isValid();
+    };
+
+    flags.insert(localId, Local);
+    flags.insert(upstreamId, Upstream);
+    if (!enqueue(localId) || !enqueue(upstreamId)) {
+        return false;
+    }
+
+    int visited = 0;
+    while (!queue.empty()) {
+        const bool anyInteresting = std::any_of(queue.cbegin(), queue.cend(), [&flags](const QueueItem &item) {
+            return flags.value(item.id) != Both;
+        });
+        if (!anyInteresting) {
+            break;
+        }
+        if (++visited > MaxHistoryWalk) {
+            LOG_WARNING("History too large to compute ahead/behind counts"_L1);
+            return false;
+        }
+
+        std::pop_heap(queue.begin(), queue.end());
+        const QueueItem item = queue.back();
+        queue.pop_back();
+
+        const quint8 flag = flags.value(item.id);
+        if (propagated.value(item.id) == flag) {
+            continue;
+        }
+        propagated.insert(item.id, flag);
+
+        const QList<QByteArray> parents = commits.value(item.id).parents;
+        for (const QByteArray &parent : parents) {
+            const quint8 previous = flags.value(parent);
+            const quint8 updated = previous | flag;
+            if (updated != previous) {
+                flags.insert(parent, updated);
+                enqueue(parent);
+            }
+        }
+    }
+
+    for (auto it = flags.cbegin(); it != flags.cend(); ++it) {
+        if (it.value() == Local) {
+            (*ahead)++;
+        } else if (it.value() == Upstream) {
+            (*behind)++;
+        }
+    }
+
+    return true;
+}
+
+bool GitRepository::readIndex(QList<IndexEntry> *entries, QByteArray *cacheTreeId) const
+{
+    QFile indexFile(m_gitDir + "/index"_L1);
+    if (!indexFile.open(QIODevice::ReadOnly)) {
+        return !indexFile.exists(); // a fresh repository has no index yet
+    }
+
+    const QByteArray content = indexFile.readAll();
+    const auto *data = reinterpret_cast<const uchar *>(content.constData());
+    const qsizetype size = content.size() - RawIdSize; // trailing checksum
+
+    if (size < 12 || std::memcmp(data, "DIRC", 4) != 0) {
+        return false;
+    }
+
+    const quint32 version = readBigEndian32(data + 4);
+    const quint32 count = readBigEndian32(data + 8);
+    if (version < 2 || version > 4) {
+        LOG_WARNING(QStringLiteral("Unsupported git index version %1").arg(version));
+        return false;
+    }
+
+    entries->reserve(count);
+    qsizetype position = 12;
+    QByteArray previousPath;
+
+    for (quint32 i = 0; i < count; ++i) {
+        constexpr qsizetype fixedSize = 62;
+        if (position + fixedSize > size) {
+            return false;
+        }
+
+        const uchar *entry = data + position;
+        IndexEntry indexEntry;
+        indexEntry.mtimeSeconds = readBigEndian32(entry + 8);
+        indexEntry.inode = readBigEndian32(entry + 20);
+        indexEntry.mode = readBigEndian32(entry + 24);
+        indexEntry.size = readBigEndian32(entry + 36);
+        indexEntry.id = QByteArray(reinterpret_cast<const char *>(entry + 40), RawIdSize);
+
+        const quint16 flags = qFromBigEndian<quint16>(entry + 60);
+        indexEntry.stage = (flags >> 12) & 0x3;
+        qsizetype headerSize = fixedSize;
+        if (version >= 3 && (flags & 0x4000)) {
+            const quint16 extendedFlags = qFromBigEndian<quint16>(entry + 62);
+            // skip-worktree (sparse checkout) and intent-to-add entries have nothing to compare
+            indexEntry.skipWorkTree = extendedFlags & (0x4000 | 0x2000);
+            headerSize += 2;
+        }
+        if (flags & 0x8000) {
+            indexEntry.skipWorkTree = true; // assume-valid
+        }
+
+        const uchar *name = entry + headerSize;
+        if (version == 4) {
+            // Prefix-compressed: varint count of bytes to strip from the previous path, then a NUL-terminated suffix
+            const uchar *p = name;
+            if (p >= data + size) {
+                return false;
+            }
+            uchar c = *p++;
+            quint64 strip = c & 0x7f;
+            while (c & 0x80) {
+                if (p >= data + size) {
+                    return false;
+                }
+                c = *p++;
+                strip = ((strip + 1) << 7) | (c & 0x7f);
+            }
+            const auto *suffixEnd = static_cast<const uchar *>(std::memchr(p, 0, (data + size) - p));
+            if (!suffixEnd || strip > quint64(previousPath.size())) {
+                return false;
+            }
+            indexEntry.path = previousPath.left(previousPath.size() - qsizetype(strip))
+                + QByteArray(reinterpret_cast<const char *>(p), suffixEnd - p);
+            position = (suffixEnd + 1) - data;
+        } else {
+            const auto *nameEnd = static_cast<const uchar *>(std::memchr(name, 0, (data + size) - name));
+            if (!nameEnd) {
+                return false;
+            }
+            indexEntry.path = QByteArray(reinterpret_cast<const char *>(name), nameEnd - name);
+            // Entries are NUL-padded to a multiple of eight bytes
+            const qsizetype entryLength = headerSize + indexEntry.path.size();
+            position += (entryLength + 8) & ~qsizetype(7);
+        }
+
+        previousPath = indexEntry.path;
+        entries->append(indexEntry);
+    }
+
+    // Extensions: only the cache tree is of interest, for a cheap "nothing staged" check
+    while (cacheTreeId && position + 8 <= size) {
+        const uchar *extension = data + position;
+        const quint32 extensionSize = readBigEndian32(extension + 4);
+        if (std::memcmp(extension, "TREE", 4) == 0) {
+            // Root entry: "\0<entry count> <subtree count>\n<20-byte id>", count -1 means invalidated
+            const QByteArray tree(reinterpret_cast<const char *>(extension + 8), qMin<qsizetype>(extensionSize, size - position - 8));
+            const qsizetype newline = tree.indexOf('\n');
+            if (!tree.isEmpty() && tree.at(0) == '\0' && newline > 0) {
+                const QByteArray entryCount = tree.mid(1, newline - 1).split(' ').value(0);
+                if (entryCount.toInt() >= 0 && tree.size() >= newline + 1 + RawIdSize) {
+                    *cacheTreeId = tree.mid(newline + 1, RawIdSize).toHex();
+                }
+            }
+            break;
+        }
+        position += 8 + extensionSize;
+    }
+
+    return true;
+}
+
+bool GitRepository::flattenTree(const QByteArray &treeId, const QByteArray &prefix,
+                                QHash<QByteArray, QPair<QByteArray, quint32>> *entries, int depth) const
+{
+    if (depth > MaxTreeDepth) {
+        return false;
+    }
+
+    QByteArray type;
+    QByteArray data;
+    if (!readObject(treeId, &type, &data) || type != "tree") {
+        return false;
+    }
+
+    // Entries: "<octal mode> <name>\0<20-byte id>"
+    qsizetype position = 0;
+    while (position < data.size()) {
+        const qsizetype space = data.indexOf(' ', position);
+        const qsizetype nul = data.indexOf('\0', position);
+        if (space < 0 || nul < 0 || space > nul || nul + 1 + RawIdSize > data.size()) {
+            return false;
+        }
+
+        bool ok = false;
+        const quint32 mode = data.mid(position, space - position).toUInt(&ok, 8);
+        const QByteArray name = data.mid(space + 1, nul - space - 1);
+        const QByteArray id = data.mid(nul + 1, RawIdSize);
+        position = nul + 1 + RawIdSize;
+
+        const QByteArray path = prefix.isEmpty() ? name : prefix + '/' + name;
+        if (mode == 040000) {
+            if (!flattenTree(id.toHex(), path, entries, depth + 1)) {
+                return false;
+            }
+        } else {
+            entries->insert(path, qMakePair(id, mode));
+        }
+    }
+
+    return true;
+}
+
+bool GitRepository::workTreeEntryMatches(const IndexEntry &entry, qint64 indexMtime, bool *exists) const
+{
+    const QByteArray localPath = QFile::encodeName(m_workTree) + '/' + entry.path;
+
+    struct stat info;
+    if (::lstat(localPath.constData(), &info) != 0) {
+        *exists = false;
+        return false;
+    }
+    *exists = true;
+
+    const quint32 indexType = entry.mode & 0170000;
+    if (indexType == 0160000) {
+        return true; // submodule: its own repository decides
+    }
+    if ((indexType == 0120000) != S_ISLNK(info.st_mode) || (indexType == 0100000) != S_ISREG(info.st_mode)) {
+        return false;
+    }
+    if (S_ISREG(info.st_mode) && bool(entry.mode & 0100) != bool(info.st_mode & S_IXUSR)) {
+        return false;
+    }
+    if (quint32(info.st_size) != entry.size) {
+        return false;
+    }
+
+    // Stat data matching is only trustworthy when the file is older than the index ("racy git")
+    const bool statMatches = quint32(info.st_mtime) == entry.mtimeSeconds && quint32(info.st_ino) == entry.inode;
+    if (statMatches && qint64(info.st_mtime) < indexMtime) {
+        return true;
+    }
+
+    QByteArray hash;
+    if (S_ISLNK(info.st_mode)) {
+        QByteArray target(info.st_size > 0 ? info.st_size : 256, Qt::Uninitialized);
+        const ssize_t length = ::readlink(localPath.constData(), target.data(), target.size());
+        if (length < 0) {
+            return false;
+        }
+        target.resize(length);
+        hash = blobHash(target);
+    } else {
+        hash = fileBlobHash(localPath, info.st_size);
+    }
+
+    return hash == entry.id;
+}
+
+GitRepository::WorkTreeStatus GitRepository::workTreeStatus() const
+{
+    WorkTreeStatus status;
+    if (!isValid()) {
+        return status;
+    }
+
+    QList<IndexEntry> entries;
+    QByteArray cacheTreeId;
+    if (!readIndex(&entries, &cacheTreeId)) {
+        LOG_WARNING(QStringLiteral("Could not read git index in %1").arg(m_gitDir));
+        return status;
+    }
+
+    struct stat indexInfo;
+    const QByteArray indexPath = QFile::encodeName(m_gitDir + "/index"_L1);
+    const qint64 indexMtime = ::stat(indexPath.constData(), &indexInfo) == 0 ? qint64(indexInfo.st_mtime) : 0;
+
+    QSet<QByteArray> conflicted;
+    for (const IndexEntry &entry : std::as_const(entries)) {
+        if (entry.stage != 0) {
+            if (!conflicted.contains(entry.path)) {
+                conflicted.insert(entry.path);
+                status.modified.append(QString::fromUtf8(entry.path));
+            }
+            continue;
+        }
+        if (entry.skipWorkTree) {
+            continue;
+        }
+
+        bool exists = false;
+        if (!workTreeEntryMatches(entry, indexMtime, &exists)) {
+            (exists ? status.modified : status.deleted).append(QString::fromUtf8(entry.path));
+        }
+    }
+
+    // Staged changes: skip the tree walk when the cache tree says the index still matches HEAD
+    const Commit head = readCommit(headId());
+    if (head.isValid() && cacheTreeId != head.treeId) {
+        QHash<QByteArray, QPair<QByteArray, quint32>> headEntries;
+        if (flattenTree(head.treeId, QByteArray(), &headEntries, 0)) {
+            for (const IndexEntry &entry : std::as_const(entries)) {
+                if (entry.stage != 0) {
+                    continue;
+                }
+                const auto it = headEntries.constFind(entry.path);
+                if (it == headEntries.cend() || it->first != entry.id || it->second != entry.mode) {
+                    status.staged.append(QString::fromUtf8(entry.path));
+                }
+                headEntries.remove(entry.path);
+            }
+            for (auto it = headEntries.cbegin(); it != headEntries.cend(); ++it) {
+                if (!conflicted.contains(it.key())) {
+                    status.staged.append(QString::fromUtf8(it.key()));
+                }
+            }
+        }
+    } else if (!head.isValid()) {
+        // Unborn branch: everything in the index is staged
+        for (const IndexEntry &entry : std::as_const(entries)) {
+            if (entry.stage == 0) {
+                status.staged.append(QString::fromUtf8(entry.path));
+            }
+        }
+    }
+
+    status.valid = true;
+    return status;
+}
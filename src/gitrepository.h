@@ -0,0 +1,106 @@
+#ifndef GITREPOSITORY_H
+#define GITREPOSITORY_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <vector>
+
+class QFile;
+
+/**
+ * @brief Read-only, in-process reader for a git repository
+ *
+ * Resolves HEAD through loose and packed refs, reads loose and packed objects
+ * and compares the index against the work tree using stat data, all without
+ * spawning git. Object ids are 40 character lowercase hex strings.
+ *
+ * Pack files are mapped lazily, so an instance must not be shared between threads.
+ */
+class GitRepository
+{
+public:
+    struct Commit {
+        QByteArray id;
+        QByteArray treeId;
+        QList<QByteArray> parents;
+        QString authorName;
+        qint64 authorTime = 0;
+        qint64 commitTime = 0;
+        QString subject;
+
+        bool isValid() const { return !id.isEmpty(); }
+    };
+
+    struct WorkTreeStatus {
+        bool valid = false;
+        QStringList modified; // tracked files whose content differs from the index
+        QStringList deleted;  // tracked files missing from the work tree
+        QStringList staged;   // paths whose index entry differs from HEAD
+
+        int dirtyCount() const;
+    };
+
+    explicit GitRepository(const QString &workTree);
+    ~GitRepository();
+
+    GitRepository(const GitRepository &) = delete;
+    GitRepository &operator=(const GitRepository &) = delete;
+
+    static bool isRepository(const QString &workTree);
+    static QString findWorkTree(const QString &path);
+
+    bool isValid() const;
+    QString workTree() const;
+    QString gitDirectory() const;
+
+    QString currentBranch() const;
+    QByteArray resolveRef(const QString &refName) const;
+    QByteArray headId() const;
+    QString upstreamRef() const;
+
+    bool readObject(const QByteArray &id, QByteArray *type, QByteArray *data) const;
+    Commit readCommit(const QByteArray &id) const;
+    bool readFileAtCommit(const QByteArray &commitId, const QString &path, QByteArray *data) const;
+    bool aheadBehind(const QByteArray &localId, const QByteArray &upstreamId, int *ahead, int *behind) const;
+    WorkTreeStatus workTreeStatus() const;
+
+private:
+    struct Pack;
+
+    struct IndexEntry {
+        QByteArray path;
+        QByteArray id; // raw 20 bytes
+        quint32 mode = 0;
+        quint32 mtimeSeconds = 0;
+        quint32 inode = 0;
+        quint32 size = 0;
+        int stage = 0;
+        bool skipWorkTree = false;
+    };
+
+    static QString discoverGitDirectory(const QString &workTree);
+
+    bool readLooseObject(const QByteArray &id, QByteArray *type, QByteArray *data) const;
+    bool readPackedObject(const Pack &pack, quint64 offset, QByteArray *type, QByteArray *data) const;
+    bool findPackedObject(const QByteArray &rawId, const Pack **pack, quint64 *offset) const;
+    void loadPacks() const;
+
+    QByteArray lookupPackedRef(const QString &refName) const;
+    bool readIndex(QList<IndexEntry> *entries, QByteArray *cacheTreeId) const;
+    bool flattenTree(const QByteArray &treeId, const QByteArray &prefix,
+                     QHash<QByteArray, QPair<QByteArray, quint32>> *entries, int depth) const;
+    bool workTreeEntryMatches(const IndexEntry &entry, qint64 indexMtime, bool *exists) const;
+
+    QString m_workTree;
+    QString m_gitDir;
+    QString m_commonDir;
+
+    mutable bool m_packsLoaded;
+    mutable std::vector<std::unique_ptr<Pack>> m_packs;
+};
+
+#endif // GITREPOSITORY_H
@@ -0,0 +1,182 @@
+#include "gitstatuswatcher.h"
+#include "chezmoiservice.h"
+#include "gitrepository.h"
+#include "logger.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// Git touches several files per operation (lock, rename, reflog); wait for it to settle
+constexpr int RefreshDebounceMs = 250;
+}
+
+GitStatusWatcher::GitStatusWatcher(ChezmoiService *chezmoiService, QObject *parent)
+    : QObject(parent)
+    , m_chezmoiService(chezmoiService)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_debounceTimer(new QTimer(this))
+    , m_futureWatcher()
+    , m_summary()
+    , m_repositoryPath()
+    , m_refreshPending(false)
+{
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(RefreshDebounceMs);
+    connect(m_debounceTimer, &QTimer::timeout, this, &GitStatusWatcher::startRefresh);
+
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &GitStatusWatcher::onPathChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &GitStatusWatcher::onPathChanged);
+    connect(&m_futureWatcher, &QFutureWatcher<GitSummary>::finished, this, &GitStatusWatcher::onSummaryReady);
+
+    if (m_chezmoiService) {
+        connect(m_chezmoiService, &ChezmoiService::configurationChanged, this, [this](const QStringList &keys) {
+            // The repository moves with the source directory
+            if (keys.contains("sourcedir"_L1)) {
+                m_repositoryPath.clear();
+                refresh();
+            }
+        });
+    }
+}
+
+GitStatusWatcher::~GitStatusWatcher()
+{
+    // The worker may still be talking to the chezmoi service
+    m_futureWatcher.waitForFinished();
+}
+
+void GitStatusWatcher::refresh()
+{
+    m_debounceTimer->stop();
+    startRefresh();
+}
+
+void GitStatusWatcher::onPathChanged(const QString &path)
+{
+    LOG_DEBUG(QStringLiteral("Git metadata changed: %1").arg(path));
+    m_debounceTimer->start();
+}
+
+void GitStatusWatcher::startRefresh()
+{
+    if (m_futureWatcher.isRunning()) {
+        m_refreshPending = true;
+        return;
+    }
+
+    ChezmoiService *service = m_chezmoiService;
+    const QString repositoryPath = m_repositoryPath;
+    m_futureWatcher.setFuture(QtConcurrent::run([service, repositoryPath]() {
+        QString path = repositoryPath;
+        if (path.isEmpty() && service) {
+            path = service->getChezmoiDirectory();
+        }
+        return computeSummary(path);
+    }));
+}
+
+void GitStatusWatcher::onSummaryReady()
+{
+    m_summary = m_futureWatcher.result();
+
+    if (m_summary.repositoryPath != m_repositoryPath) {
+        m_repositoryPath = m_summary.repositoryPath;
+    }
+    // Git replaces HEAD, refs and index by renaming lock files, which drops them from the watch list
+    updateWatchedPaths();
+
+    Q_EMIT summaryChanged(m_summary);
+
+    if (m_refreshPending) {
+        m_refreshPending = false;
+        startRefresh();
+    }
+}
+
+void GitStatusWatcher::updateWatchedPaths()
+{
+    const QStringList watched = m_watcher->files() + m_watcher->directories();
+    if (!watched.isEmpty()) {
+        m_watcher->removePaths(watched);
+    }
+
+    if (m_repositoryPath.isEmpty()) {
+        return;
+    }
+
+    const QString gitDir = GitRepository(m_repositoryPath).gitDirectory();
+    if (gitDir.isEmpty()) {
+        return;
+    }
+
+    QStringList paths;
+    paths << gitDir;
+    for (const QString &file : {"HEAD"_L1, "index"_L1, "packed-refs"_L1}) {
+        const QString filePath = gitDir + u'/' + file;
+        if (QFileInfo::exists(filePath)) {
+            paths << filePath;
+        }
+    }
+
+    // Branch names may contain slashes, so every directory below refs/heads and refs/remotes counts
+    for (const QString &refsRoot : {"/refs/heads"_L1, "/refs/remotes"_L1}) {
+        const QString rootPath = gitDir + refsRoot;
+        if (!QFileInfo(rootPath).isDir()) {
+            continue;
+        }
+        paths << rootPath;
+        QDirIterator it(rootPath, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            paths << it.next();
+        }
+    }
+
+    const QStringList failed = m_watcher->addPaths(paths);
+    if (!failed.isEmpty()) {
+        LOG_WARNING(QStringLiteral("Could not watch git paths: %1").arg(failed.join(", "_L1)));
+    }
+}
+
+GitSummary GitStatusWatcher::computeSummary(const QString &repositoryPath)
+{
+    GitSummary summary;
+    summary.repositoryPath = repositoryPath;
+
+    GitRepository repository(repositoryPath);
+    if (!repository.isValid()) {
+        LOG_DEBUG(QStringLiteral("No git repository in %1").arg(repositoryPath));
+        return summary;
+    }
+
+    const GitRepository::WorkTreeStatus workTree = repository.workTreeStatus();
+    if (!workTree.valid) {
+        return summary;
+    }
+
+    summary.valid = true;
+    summary.branch = repository.currentBranch();
+    summary.dirtyFiles = workTree.dirtyCount();
+
+    const QByteArray headId = repository.headId();
+    const GitRepository::Commit head = repository.readCommit(headId);
+    if (head.isValid()) {
+        summary.shortHash = QString::fromLatin1(head.id.left(7));
+        summary.commitTime = QDateTime::fromSecsSinceEpoch(head.commitTime);
+        summary.subject = head.subject;
+    }
+
+    const QString upstream = repository.upstreamRef();
+    if (!upstream.isEmpty()) {
+        const QByteArray upstreamId = repository.resolveRef(upstream);
+        summary.hasUpstream = repository.aheadBehind(headId, upstreamId, &summary.ahead, &summary.behind);
+    }
+
+    return summary;
+}
@@ -0,0 +1,67 @@
+#ifndef GITSTATUSWATCHER_H
+#define GITSTATUSWATCHER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QString>
+
+class QFileSystemWatcher;
+class QTimer;
+class ChezmoiService;
+
+/**
+ * @brief Snapshot of the chezmoi source repository's git state
+ */
+struct GitSummary {
+    bool valid = false;
+    QString repositoryPath;
+    QString branch;
+    QString shortHash;
+    QString subject;
+    QDateTime commitTime;
+    bool hasUpstream = false;
+    int ahead = 0;
+    int behind = 0;
+    int dirtyFiles = 0;
+};
+
+/**
+ * @brief Watches the source repository's HEAD, refs and index and recomputes
+ * the git summary off the GUI thread whenever they change
+ */
+class GitStatusWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GitStatusWatcher(ChezmoiService *chezmoiService, QObject *parent = nullptr);
+    ~GitStatusWatcher() override;
+
+    const GitSummary &summary() const { return m_summary; }
+
+public Q_SLOTS:
+    void refresh();
+
+Q_SIGNALS:
+    void summaryChanged(const GitSummary &summary);
+
+private Q_SLOTS:
+    void onPathChanged(const QString &path);
+    void onSummaryReady();
+
+private:
+    static GitSummary computeSummary(const QString &repositoryPath);
+    void startRefresh();
+    void updateWatchedPaths();
+
+    ChezmoiService *m_chezmoiService;
+    QFileSystemWatcher *m_watcher;
+    QTimer *m_debounceTimer;
+    QFutureWatcher<GitSummary> m_futureWatcher;
+    GitSummary m_summary;
+    QString m_repositoryPath;
+    bool m_refreshPending;
+};
+
+#endif // GITSTATUSWATCHER_H
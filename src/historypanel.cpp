@@ -0,0 +1,267 @@
+#include "historypanel.h"
+#include "chezmoiservice.h"
+#include "commitlogmodel.h"
+#include "gitrepository.h"
+#include "logger.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QLabel>
+#include <QProcess>
+#include <QSplitter>
+#include <QTabWidget>
+#include <QTreeView>
+#include <QVBoxLayout>
+#include <QtConcurrent/QtConcurrentRun>
+#include <KTextEditor/Document>
+#include <KTextEditor/Editor>
+#include <KTextEditor/View>
+#include <KLocalizedString>
+
+using namespace Qt::Literals::StringLiterals;
+
+HistoryPanel::HistoryPanel(ChezmoiService *chezmoiService, QWidget *parent)
+    : QWidget(parent)
+    , m_chezmoiService(chezmoiService)
+    , m_model(new CommitLogModel(this))
+    , m_commitView(nullptr)
+    , m_statusLabel(nullptr)
+    , m_detailTabs(nullptr)
+    , m_contentDocument(nullptr)
+    , m_diffDocument(nullptr)
+    , m_locationWatcher()
+    , m_revisionWatcher()
+    , m_filePath()
+    , m_loadedFilePath()
+    , m_selectedCommitId()
+{
+    setupUI();
+
+    connect(&m_locationWatcher, &QFutureWatcher<Location>::finished, this, &HistoryPanel::onLocationResolved);
+    connect(&m_revisionWatcher, &QFutureWatcher<Revision>::finished, this, &HistoryPanel::onRevisionLoaded);
+    connect(m_model, &CommitLogModel::loadingChanged, this, &HistoryPanel::onLoadingChanged);
+}
+
+HistoryPanel::~HistoryPanel()
+{
+    // Workers may still be using the chezmoi service
+    m_locationWatcher.waitForFinished();
+    m_revisionWatcher.waitForFinished();
+}
+
+void HistoryPanel::setupUI()
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    m_statusLabel = new QLabel(i18n("Select a file to see its history"), this);
+    layout->addWidget(m_statusLabel);
+
+    auto *splitter = new QSplitter(Qt::Horizontal, this);
+
+    m_commitView = new QTreeView(this);
+    m_commitView->setModel(m_model);
+    m_commitView->setRootIsDecorated(false);
+    m_commitView->setUniformRowHeights(true);
+    m_commitView->setAlternatingRowColors(true);
+    m_commitView->header()->setStretchLastSection(false);
+    m_commitView->header()->setSectionResizeMode(CommitLogModel::SubjectColumn, QHeaderView::Stretch);
+    connect(m_commitView->selectionModel(), &QItemSelectionModel::currentRowChanged,
+            this, &HistoryPanel::onCurrentCommitChanged);
+    splitter->addWidget(m_commitView);
+
+    m_detailTabs = new QTabWidget(this);
+    m_detailTabs->setDocumentMode(true);
+
+    auto *editor = KTextEditor::Editor::instance();
+    if (editor) {
+        m_diffDocument = editor->createDocument(this);
+        m_diffDocument->setHighlightingMode(QStringLiteral("Diff"));
+        m_diffDocument->setReadWrite(false);
+        m_detailTabs->addTab(m_diffDocument->createView(this), i18n("Diff"));
+
+        m_contentDocument = editor->createDocument(this);
+        m_contentDocument->setReadWrite(false);
+        m_detailTabs->addTab(m_contentDocument->createView(this), i18n("Content"));
+    } else {
+        LOG_ERROR("Failed to get KTextEditor instance for history panel"_L1);
+    }
+    splitter->addWidget(m_detailTabs);
+    splitter->setSizes({400, 600});
+
+    layout->addWidget(splitter);
+}
+
+void HistoryPanel::setFile(const QString &filePath)
+{
+    if (filePath == m_filePath) {
+        return;
+    }
+    m_filePath = filePath;
+
+    // Resolving the source path and streaming git log only pays off while the panel is visible
+    if (isVisible()) {
+        loadFile();
+    }
+}
+
+void HistoryPanel::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (m_loadedFilePath != m_filePath) {
+        loadFile();
+    }
+}
+
+void HistoryPanel::loadFile()
+{
+    m_loadedFilePath = m_filePath;
+    m_selectedCommitId.clear();
+    m_model->clear();
+    setDocumentText(m_contentDocument, QString());
+    setDocumentText(m_diffDocument, QString());
+
+    if (m_filePath.isEmpty()) {
+        m_statusLabel->setText(i18n("Select a file to see its history"));
+        return;
+    }
+
+    m_statusLabel->setText(i18n("Loading history..."));
+
+    if (m_locationWatcher.isRunning()) {
+        // onLocationResolved notices the path changed and starts over
+        return;
+    }
+
+    ChezmoiService *service = m_chezmoiService;
+    const QString filePath = m_filePath;
+    m_locationWatcher.setFuture(QtConcurrent::run([service, filePath]() {
+        return resolveLocation(service, filePath);
+    }));
+}
+
+HistoryPanel::Location HistoryPanel::resolveLocation(ChezmoiService *service, const QString &filePath)
+{
+    Location location;
+    if (!service) {
+        return location;
+    }
+
+    const QString targetPath = service->convertToTargetPath(filePath);
+    const QString sourcePath = service->getSourcePath(targetPath);
+    if (sourcePath.isEmpty()) {
+        return location;
+    }
+
+    location.workTree = GitRepository::findWorkTree(QFileInfo(sourcePath).absolutePath());
+    if (!location.workTree.isEmpty()) {
+        location.relativePath = QDir(location.workTree).relativeFilePath(sourcePath);
+    }
+    return location;
+}
+
+void HistoryPanel::onLocationResolved()
+{
+    if (m_loadedFilePath != m_filePath) {
+        loadFile();
+        return;
+    }
+
+    const Location location = m_locationWatcher.result();
+    if (location.workTree.isEmpty()) {
+        m_statusLabel->setText(i18n("This file is not tracked in a git repository"));
+        return;
+    }
+
+    m_statusLabel->setText(location.relativePath);
+    m_model->start(location.workTree, location.relativePath);
+}
+
+void HistoryPanel::onLoadingChanged(bool loading)
+{
+    if (!loading && m_model->rowCount() == 0 && !m_model->workTree().isEmpty()) {
+        m_statusLabel->setText(i18n("No commits touch this file yet"));
+    }
+}
+
+void HistoryPanel::onCurrentCommitChanged(const QModelIndex &current)
+{
+    const CommitLogModel::Entry *entry = m_model->entry(current.row());
+    if (!entry) {
+        return;
+    }
+
+    m_selectedCommitId = entry->id;
+    if (m_revisionWatcher.isRunning()) {
+        // onRevisionLoaded picks up the latest selection when the current load finishes
+        return;
+    }
+
+    const QString workTree = m_model->workTree();
+    const QString commitId = entry->id;
+    const QString path = entry->path;
+    m_revisionWatcher.setFuture(QtConcurrent::run([workTree, commitId, path]() {
+        return loadRevision(workTree, commitId, path);
+    }));
+}
+
+HistoryPanel::Revision HistoryPanel::loadRevision(const QString &workTree, const QString &commitId, const QString &path)
+{
+    Revision revision;
+    revision.commitId = commitId;
+
+    GitRepository repository(workTree);
+    QByteArray content;
+    if (!repository.readFileAtCommit(commitId.toLatin1(), path, &content)) {
+        revision.content = i18n("The file does not exist in this revision");
+    } else if (content.contains('\0')) {
+        revision.content = i18n("Binary file (%1 bytes)", content.size());
+    } else {
+        revision.content = QString::fromUtf8(content);
+    }
+
+    QProcess diffProcess;
+    diffProcess.setWorkingDirectory(workTree);
+    diffProcess.start("git"_L1, {
+        "-c"_L1, "core.quotePath=false"_L1,
+        "show"_L1, "--format=%H%n%an <%ae>%n%ad%n%n%B"_L1, "--patch"_L1, "--find-renames"_L1,
+        commitId, "--"_L1, path
+    });
+    if (diffProcess.waitForFinished() && diffProcess.exitCode() == 0) {
+        revision.diff = QString::fromUtf8(diffProcess.readAllStandardOutput());
+    } else {
+        revision.diff = i18n("Could not compute the diff for this revision");
+    }
+
+    return revision;
+}
+
+void HistoryPanel::onRevisionLoaded()
+{
+    const Revision revision = m_revisionWatcher.result();
+
+    if (revision.commitId != m_selectedCommitId) {
+        // The selection moved on while we were loading
+        const QModelIndex current = m_commitView->currentIndex();
+        if (current.isValid()) {
+            onCurrentCommitChanged(current);
+        }
+        return;
+    }
+
+    setDocumentText(m_contentDocument, revision.content);
+    setDocumentText(m_diffDocument, revision.diff);
+}
+
+void HistoryPanel::setDocumentText(KTextEditor::Document *document, const QString &text)
+{
+    if (!document) {
+        return;
+    }
+
+    document->setReadWrite(true);
+    document->setText(text);
+    document->setReadWrite(false);
+    document->setModified(false);
+}
@@ -0,0 +1,76 @@
+#ifndef HISTORYPANEL_H
+#define HISTORYPANEL_H
+
+#include <QWidget>
+#include <QFutureWatcher>
+#include <QString>
+
+class QLabel;
+class QTabWidget;
+class QTreeView;
+class ChezmoiService;
+class CommitLogModel;
+
+namespace KTextEditor {
+    class Document;
+    class View;
+}
+
+/**
+ * @brief Panel listing the git history of the selected dotfile, with the content
+ * and diff of the selected revision
+ */
+class HistoryPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit HistoryPanel(ChezmoiService *chezmoiService, QWidget *parent = nullptr);
+    ~HistoryPanel() override;
+
+public Q_SLOTS:
+    void setFile(const QString &filePath);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
+private Q_SLOTS:
+    void onLocationResolved();
+    void onCurrentCommitChanged(const QModelIndex &current);
+    void onRevisionLoaded();
+    void onLoadingChanged(bool loading);
+
+private:
+    struct Location {
+        QString workTree;
+        QString relativePath;
+    };
+
+    struct Revision {
+        QString commitId;
+        QString content;
+        QString diff;
+    };
+
+    void setupUI();
+    void loadFile();
+    void setDocumentText(KTextEditor::Document *document, const QString &text);
+    static Location resolveLocation(ChezmoiService *service, const QString &filePath);
+    static Revision loadRevision(const QString &workTree, const QString &commitId, const QString &path);
+
+    ChezmoiService *m_chezmoiService;
+    CommitLogModel *m_model;
+    QTreeView *m_commitView;
+    QLabel *m_statusLabel;
+    QTabWidget *m_detailTabs;
+    KTextEditor::Document *m_contentDocument;
+    KTextEditor::Document *m_diffDocument;
+
+    QFutureWatcher<Location> m_locationWatcher;
+    QFutureWatcher<Revision> m_revisionWatcher;
+    QString m_filePath;
+    QString m_loadedFilePath;
+    QString m_selectedCommitId;
+};
+
+#endif // HISTORYPANEL_H
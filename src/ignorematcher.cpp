@@ -0,0 +1,405 @@
+#include "ignorematcher.h"
+
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+// A pattern full of braces could otherwise expand into millions
+constexpr qsizetype MaxBraceExpansions = 256;
+
+// Offset of the '}' closing the '{' at open, or -1
+qsizetype closingBrace(const QString &pattern, qsizetype open)
+{
+    int depth = 0;
+    for (qsizetype i = open; i < pattern.size(); ++i) {
+        const QChar c = pattern.at(i);
+        if (c == u'\\') {
+            ++i;
+        } else if (c == u'{') {
+            ++depth;
+        } else if (c == u'}' && --depth == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+}
+
+IgnoreMatcher::IgnoreMatcher()
+    : m_nodes(1)
+    , m_edges()
+    , m_globs()
+    , m_tokens()
+    , m_ranges()
+    , m_patternCount(0)
+{
+}
+
+void IgnoreMatcher::compile(const QString &text)
+{
+    m_nodes = QList<Node>(1);
+    m_edges.clear();
+    m_globs.clear();
+    m_tokens.clear();
+    m_ranges.clear();
+    m_patternCount = 0;
+
+    QList<qint32> globNodes;
+    const QStringList lines = text.split(u'\n');
+    for (QString line : lines) {
+        // Same reading as chezmoi: '#' starts a comment anywhere, and '!' makes an exclude
+        const qsizetype comment = line.indexOf(u'#');
+        if (comment >= 0) {
+            line.truncate(comment);
+        }
+        line = line.trimmed();
+        Kind kind = Include;
+        if (line.startsWith(u'!')) {
+            kind = Exclude;
+            line.remove(0, 1);
+        }
+        while (line.size() > 1 && line.endsWith(u'/')) {
+            line.chop(1);
+        }
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        ++m_patternCount;
+        for (const QString &pattern : expandBraces(line)) {
+            addPattern(pattern, kind, &globNodes);
+        }
+    }
+
+    // Each node's globs sit next to each other, in the order they were written
+    QList<qsizetype> order(m_globs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&globNodes](qsizetype a, qsizetype b) {
+        return globNodes.at(a) < globNodes.at(b);
+    });
+    QList<Glob> sorted;
+    sorted.reserve(m_globs.size());
+    for (const qsizetype index : std::as_const(order)) {
+        Node &node = m_nodes[globNodes.at(index)];
+        if (node.globCount == 0) {
+            node.globStart = quint32(sorted.size());
+        }
+        ++node.globCount;
+        sorted.append(m_globs.at(index));
+    }
+    m_globs = sorted;
+}
+
+bool IgnoreMatcher::isEmpty() const
+{
+    return m_patternCount == 0;
+}
+
+qsizetype IgnoreMatcher::patternCount() const
+{
+    return m_patternCount;
+}
+
+bool IgnoreMatcher::isIgnored(QStringView path) const
+{
+    if (m_patternCount == 0 || path.isEmpty()) {
+        return false;
+    }
+
+    // Kinds of the patterns matching path.first(length), for the whole path and each directory above it
+    const qsizetype size = path.size();
+    QVarLengthArray<quint8, 256> kinds(size + 1);
+    std::fill(kinds.begin(), kinds.end(), quint8(0));
+    auto isBoundary = [&](qsizetype length) {
+        return length > 0 && (length == size || path.at(length) == u'/');
+    };
+
+    // One walk down the trie; every node passed hands its globs the rest of the path
+    qint32 node = 0;
+    for (qsizetype depth = 0; node >= 0; ++depth) {
+        const Node &current = m_nodes.at(node);
+        if (current.exactKinds && isBoundary(depth)) {
+            kinds[depth] |= current.exactKinds;
+        }
+
+        for (quint32 g = current.globStart; g < current.globStart + current.globCount; ++g) {
+            const Glob &glob = m_globs.at(g);
+            int slashes = 0;
+            for (qsizetype end = depth; end <= size; ++end) {
+                if (end > depth && path.at(end - 1) == u'/') {
+                    ++slashes;
+                }
+                if (glob.fixedDepth && slashes > glob.slashes) {
+                    break;
+                }
+                if (!isBoundary(end) || (kinds[end] & glob.kind)
+                    || (glob.fixedDepth && slashes != glob.slashes)) {
+                    continue;
+                }
+                if (matchGlob(glob, path.sliced(depth, end - depth))) {
+                    kinds[end] |= glob.kind;
+                }
+            }
+        }
+
+        if (depth == size) {
+            break;
+        }
+        node = child(node, path.at(depth).unicode());
+    }
+
+    // The shallowest ignored directory hides everything below it, whatever matches deeper down
+    for (qsizetype length = 1; length <= size; ++length) {
+        if ((kinds[length] & Include) && !(kinds[length] & Exclude)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QList<bool> IgnoreMatcher::classify(const QStringList &paths) const
+{
+    QList<bool> ignored;
+    ignored.reserve(paths.size());
+    for (const QString &path : paths) {
+        ignored.append(isIgnored(path));
+    }
+    return ignored;
+}
+
+QStringList IgnoreMatcher::expandBraces(const QString &pattern)
+{
+    qsizetype open = -1;
+    for (qsizetype i = 0; i < pattern.size(); ++i) {
+        if (pattern.at(i) == u'\\') {
+            ++i;
+        } else if (pattern.at(i) == u'{') {
+            open = i;
+            break;
+        }
+    }
+    const qsizetype close = open >= 0 ? closingBrace(pattern, open) : -1;
+    if (close < 0) {
+        return {pattern};
+    }
+
+    // Split the outermost group at its own commas; nested groups are expanded with the suffix
+    QStringList alternatives;
+    int depth = 0;
+    qsizetype start = open + 1;
+    for (qsizetype i = open + 1; i < close; ++i) {
+        const QChar c = pattern.at(i);
+        if (c == u'\\') {
+            ++i;
+        } else if (c == u'{') {
+            ++depth;
+        } else if (c == u'}') {
+            --depth;
+        } else if (c == u',' && depth == 0) {
+            alternatives.append(pattern.mid(start, i - start));
+            start = i + 1;
+        }
+    }
+    alternatives.append(pattern.mid(start, close - start));
+
+    const QString prefix = pattern.left(open);
+    const QString suffix = pattern.mid(close + 1);
+    QStringList expanded;
+    for (const QString &alternative : std::as_const(alternatives)) {
+        for (const QString &rest : expandBraces(alternative + suffix)) {
+            if (expanded.size() >= MaxBraceExpansions) {
+                return expanded;
+            }
+            expanded.append(prefix + rest);
+        }
+    }
+    return expanded;
+}
+
+void IgnoreMatcher::addPattern(const QString &pattern, Kind kind, QList<qint32> *globNodes)
+{
+    QList<Token> tokens;
+    auto literal = [&tokens](QChar c) {
+        tokens.append(Token{Token::Literal, false, c.unicode(), 0, 0});
+    };
+
+    for (qsizetype i = 0; i < pattern.size(); ++i) {
+        const QChar c = pattern.at(i);
+        if (c == u'\\' && i + 1 < pattern.size()) {
+            literal(pattern.at(++i));
+        } else if (c == u'*') {
+            qsizetype end = i + 1;
+            while (end < pattern.size() && pattern.at(end) == u'*') {
+                ++end;
+            }
+            // ** only spans directories as a whole component; elsewhere it is a plain *
+            const bool wholeComponent = end - i > 1 && (i == 0 || pattern.at(i - 1) == u'/')
+                                        && (end == pattern.size() || pattern.at(end) == u'/');
+            if (wholeComponent && end == pattern.size()) {
+                if (!tokens.isEmpty() && tokens.last().type == Token::Literal && tokens.last().character == u'/') {
+                    tokens.last().type = Token::TrailingAll;
+                } else {
+                    tokens.append(Token{Token::AnyRest, false, 0, 0, 0});
+                }
+            } else if (wholeComponent) {
+                tokens.append(Token{Token::AnyDirs, false, 0, 0, 0});
+                ++end; // the '/' is part of it
+            } else {
+                tokens.append(Token{Token::Star, false, 0, 0, 0});
+            }
+            i = end - 1;
+        } else if (c == u'?') {
+            tokens.append(Token{Token::AnyChar, false, 0, 0, 0});
+        } else if (c == u'[') {
+            Token token{Token::Class, false, 0, quint32(m_ranges.size()), 0};
+            qsizetype j = i + 1;
+            if (j < pattern.size() && (pattern.at(j) == u'!' || pattern.at(j) == u'^')) {
+                token.negated = true;
+                ++j;
+            }
+            bool closed = false;
+            for (bool first = true; j < pattern.size(); first = false) {
+                QChar low = pattern.at(j);
+                if (low == u']' && !first) {
+                    closed = true;
+                    break;
+                }
+                if (low == u'\\' && j + 1 < pattern.size()) {
+                    low = pattern.at(++j);
+                }
+                QChar high = low;
+                if (j + 2 < pattern.size() && pattern.at(j + 1) == u'-' && pattern.at(j + 2) != u']') {
+                    j += 2;
+                    high = pattern.at(j) == u'\\' && j + 1 < pattern.size() ? pattern.at(++j) : pattern.at(j);
+                }
+                m_ranges.append(low.unicode());
+                m_ranges.append(high.unicode());
+                ++token.rangeCount;
+                ++j;
+            }
+            if (!closed) {
+                // An unclosed bracket is just a character
+                m_ranges.resize(token.rangeStart);
+                literal(c);
+                continue;
+            }
+            tokens.append(token);
+            i = j;
+        } else {
+            literal(c);
+        }
+    }
+
+    // The literal run in front goes into the trie
+    qint32 node = 0;
+    qsizetype prefixLength = 0;
+    for (; prefixLength < tokens.size() && tokens.at(prefixLength).type == Token::Literal; ++prefixLength) {
+        const quint64 key = edgeKey(node, tokens.at(prefixLength).character);
+        const auto it = m_edges.constFind(key);
+        if (it != m_edges.cend()) {
+            node = it.value();
+        } else {
+            m_nodes.append(Node());
+            node = qint32(m_nodes.size() - 1);
+            m_edges.insert(key, node);
+        }
+    }
+
+    if (prefixLength == tokens.size()) {
+        m_nodes[node].exactKinds |= kind;
+        return;
+    }
+
+    Glob glob;
+    glob.tokenStart = quint32(m_tokens.size());
+    glob.tokenCount = quint32(tokens.size() - prefixLength);
+    glob.slashes = 0;
+    glob.fixedDepth = true;
+    glob.kind = kind;
+    for (qsizetype t = prefixLength; t < tokens.size(); ++t) {
+        const Token &token = tokens.at(t);
+        if (token.type == Token::Literal && token.character == u'/') {
+            ++glob.slashes;
+        } else if (token.type == Token::AnyDirs || token.type == Token::AnyRest || token.type == Token::TrailingAll) {
+            glob.fixedDepth = false;
+        }
+        m_tokens.append(token);
+    }
+    m_globs.append(glob);
+    globNodes->append(node);
+}
+
+qint32 IgnoreMatcher::child(qint32 node, char16_t character) const
+{
+    return m_edges.value(edgeKey(node, character), -1);
+}
+
+bool IgnoreMatcher::matchGlob(const Glob &glob, QStringView text) const
+{
+    const Token *begin = m_tokens.constData() + glob.tokenStart;
+    return matchTokens(begin, begin + glob.tokenCount, text, 0);
+}
+
+bool IgnoreMatcher::matchTokens(const Token *token, const Token *end, QStringView text, qsizetype position) const
+{
+    const qsizetype size = text.size();
+    for (; token != end; ++token) {
+        switch (token->type) {
+        case Token::Literal:
+            if (position >= size || text.at(position).unicode() != token->character) {
+                return false;
+            }
+            ++position;
+            break;
+        case Token::AnyChar:
+            if (position >= size || text.at(position) == u'/') {
+                return false;
+            }
+            ++position;
+            break;
+        case Token::Class:
+            if (position >= size || text.at(position) == u'/' || !inClass(*token, text.at(position).unicode())) {
+                return false;
+            }
+            ++position;
+            break;
+        case Token::Star:
+            // Shortest first, never past the end of the component
+            for (qsizetype next = position; ; ++next) {
+                if (matchTokens(token + 1, end, text, next)) {
+                    return true;
+                }
+                if (next >= size || text.at(next) == u'/') {
+                    return false;
+                }
+            }
+        case Token::AnyDirs:
+            if (matchTokens(token + 1, end, text, position)) {
+                return true;
+            }
+            for (qsizetype next = position; next < size; ++next) {
+                if (text.at(next) == u'/' && matchTokens(token + 1, end, text, next + 1)) {
+                    return true;
+                }
+            }
+            return false;
+        case Token::AnyRest:
+            return true;
+        case Token::TrailingAll:
+            return position == size || text.at(position) == u'/';
+        }
+    }
+    return position == size;
+}
+
+bool IgnoreMatcher::inClass(const Token &token, char16_t character) const
+{
+    bool found = false;
+    for (quint32 r = 0; r < token.rangeCount && !found; ++r) {
+        const quint32 range = token.rangeStart + 2 * r;
+        found = character >= m_ranges.at(range) && character <= m_ranges.at(range + 1);
+    }
+    return found != token.negated;
+}
@@ -0,0 +1,95 @@
+#ifndef IGNOREMATCHER_H
+#define IGNOREMATCHER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+/**
+ * @brief Decides which target paths a rendered .chezmoiignore leaves out, without asking chezmoi
+ *
+ * compile() splits every pattern into its literal prefix and the glob
+ * after it. Prefixes go into one character trie, so a path is walked once
+ * and only meets the globs hanging off the prefixes it actually shares;
+ * patterns without wildcards end at a trie node and cost nothing more.
+ * The glob tails are compiled to small token programs. As in chezmoi,
+ * '!' patterns are excludes and win over includes, and ignoring a
+ * directory ignores everything below it.
+ */
+class IgnoreMatcher
+{
+public:
+    IgnoreMatcher();
+
+    // Replaces the patterns with those of a rendered .chezmoiignore
+    void compile(const QString &text);
+    bool isEmpty() const;
+    qsizetype patternCount() const;
+
+    // path is a target path relative to the destination directory, separated by '/'
+    bool isIgnored(QStringView path) const;
+    QList<bool> classify(const QStringList &paths) const;
+
+    // The patterns {a,b} stands for, as separate patterns
+    static QStringList expandBraces(const QString &pattern);
+
+private:
+    enum Kind : quint8 {
+        Include = 1,
+        Exclude = 2
+    };
+
+    struct Token {
+        enum Type : quint8 {
+            Literal,
+            AnyChar,     // ?
+            Star,        // * within one path component
+            AnyDirs,     // **/ as zero or more whole components
+            AnyRest,     // a pattern that is just **
+            TrailingAll, // /** at the end: the directory itself or anything below it
+            Class        // [...]
+        };
+        Type type;
+        bool negated;
+        char16_t character;
+        quint32 rangeStart; // Class ranges are pairs in m_ranges
+        quint32 rangeCount;
+    };
+
+    struct Glob {
+        quint32 tokenStart;
+        quint32 tokenCount;
+        int slashes;     // literal '/' in the tokens
+        bool fixedDepth; // false when ** can span any number of components
+        Kind kind;
+    };
+
+    struct Node {
+        quint8 exactKinds = 0; // kinds of the wildcard-free patterns ending here
+        quint32 globStart = 0; // globs whose literal prefix ends here, in m_globs
+        quint32 globCount = 0;
+    };
+
+    // Appends the node each new glob hangs off to globNodes
+    void addPattern(const QString &pattern, Kind kind, QList<qint32> *globNodes);
+    qint32 child(qint32 node, char16_t character) const;
+    bool matchGlob(const Glob &glob, QStringView text) const;
+    bool matchTokens(const Token *token, const Token *end, QStringView text, qsizetype position) const;
+    bool inClass(const Token &token, char16_t character) const;
+
+    static quint64 edgeKey(qint32 node, char16_t character)
+    {
+        return quint64(quint32(node)) << 16 | character;
+    }
+
+    QList<Node> m_nodes;
+    QHash<quint64, qint32> m_edges;
+    QList<Glob> m_globs;
+    QList<Token> m_tokens;
+    QList<char16_t> m_ranges;
+    qsizetype m_patternCount;
+};
+
+#endif // IGNOREMATCHER_H
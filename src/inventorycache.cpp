@@ -0,0 +1,224 @@
+#include "inventorycache.h"
+#include "logger.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cstring>
+#include <tuple>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+
+constexpr char Magic[4] = {'D', 'W', 'I', 'C'};
+
+// Written in host byte order: the cache never leaves the machine that wrote it
+struct Header {
+    char magic[4];
+    quint32 version;
+    quint32 entryCount;
+    quint32 stringPoolSize;
+    quint32 sourceDirOffset;
+    quint32 sourceDirLength;
+    quint64 checksum; // FNV-1a over the records and the string pool
+};
+static_assert(sizeof(Header) == 32, "cache header layout must not depend on the compiler");
+
+struct Record {
+    quint32 pathOffset;
+    quint32 pathLength;
+    quint32 sourceOffset;
+    quint32 sourceLength;
+    quint32 iconOffset;
+    quint32 iconLength;
+    quint16 attributes;
+    quint8 status; // ChezmoiStatus bits
+    quint8 reserved8;
+    quint32 reserved32;
+    qint64 sourceMtime;
+    qint64 targetMtime;
+};
+static_assert(sizeof(Record) == 48, "cache record layout must not depend on the compiler");
+
+quint64 fnv1a(const char *data, qsizetype size, quint64 hash = 14695981039346656037ULL)
+{
+    for (qsizetype i = 0; i < size; ++i) {
+        hash ^= static_cast<uchar>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+}
+
+InventoryCache::InventoryCache(const QString &filePath)
+    : m_filePath(filePath)
+{
+}
+
+QString InventoryCache::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/inventory.cache"_L1;
+}
+
+bool InventoryCache::load(const QString &sourceDir, QList<Entry> *entries) const
+{
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 size = file.size();
+    if (size < qint64(sizeof(Header))) {
+        LOG_INFO(QStringLiteral("Ignoring truncated inventory cache %1").arg(m_filePath));
+        return false;
+    }
+
+    const uchar *data = file.map(0, size);
+    if (!data) {
+        LOG_WARNING(QStringLiteral("Cannot map inventory cache %1: %2").arg(m_filePath, file.errorString()));
+        return false;
+    }
+
+    auto reject = [this](const QString &reason) {
+        LOG_INFO(QStringLiteral("Ignoring inventory cache %1: %2").arg(m_filePath, reason));
+        return false;
+    };
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0) {
+        return reject(QStringLiteral("not a cache file"));
+    }
+    if (header.version != FormatVersion) {
+        return reject(QStringLiteral("format version %1, expected %2").arg(header.version).arg(FormatVersion));
+    }
+
+    const qint64 recordsSize = qint64(header.entryCount) * qint64(sizeof(Record));
+    if (qint64(sizeof(Header)) + recordsSize + header.stringPoolSize != size) {
+        return reject(QStringLiteral("size does not match its header"));
+    }
+
+    const char *records = reinterpret_cast<const char *>(data) + sizeof(Header);
+    const char *pool = records + recordsSize;
+    if (fnv1a(pool, header.stringPoolSize, fnv1a(records, recordsSize)) != header.checksum) {
+        return reject(QStringLiteral("checksum mismatch"));
+    }
+
+    auto readString = [&header, pool](quint32 offset, quint32 length, QString *out) {
+        if (quint64(offset) + length > header.stringPoolSize) {
+            return false;
+        }
+        *out = QString::fromUtf8(pool + offset, length);
+        return true;
+    };
+
+    QString storedSourceDir;
+    if (!readString(header.sourceDirOffset, header.sourceDirLength, &storedSourceDir)) {
+        return reject(QStringLiteral("corrupt source directory"));
+    }
+    if (storedSourceDir != sourceDir) {
+        return reject(QStringLiteral("taken from %1").arg(storedSourceDir));
+    }
+
+    // Icon names repeat across most entries; decode each distinct one once and share it
+    QHash<quint64, QString> sharedStrings;
+    auto readShared = [&](quint32 offset, quint32 length, QString *out) {
+        const quint64 key = (quint64(offset) << 32) | length;
+        const auto it = sharedStrings.constFind(key);
+        if (it != sharedStrings.constEnd()) {
+            *out = *it;
+            return true;
+        }
+        if (!readString(offset, length, out)) {
+            return false;
+        }
+        sharedStrings.insert(key, *out);
+        return true;
+    };
+
+    QList<Entry> result;
+    result.reserve(header.entryCount);
+    for (quint32 i = 0; i < header.entryCount; ++i) {
+        Record record;
+        std::memcpy(&record, records + qint64(i) * qint64(sizeof(Record)), sizeof(Record));
+
+        Entry entry;
+        if (!readString(record.pathOffset, record.pathLength, &entry.path)
+            || !readString(record.sourceOffset, record.sourceLength, &entry.sourcePath)
+            || !readShared(record.iconOffset, record.iconLength, &entry.iconName)) {
+            return reject(QStringLiteral("record %1 points outside the string pool").arg(i));
+        }
+        entry.attributes = record.attributes;
+        entry.status = ChezmoiStatus::fromBits(record.status);
+        entry.sourceMtime = record.sourceMtime;
+        entry.targetMtime = record.targetMtime;
+        result.append(entry);
+    }
+
+    file.unmap(const_cast<uchar *>(data));
+    *entries = std::move(result);
+    LOG_DEBUG(QStringLiteral("Loaded %1 entries from inventory cache").arg(entries->size()));
+    return true;
+}
+
+bool InventoryCache::save(const QString &sourceDir, const QList<Entry> &entries) const
+{
+    QByteArray pool;
+    QHash<QString, QPair<quint32, quint32>> interned;
+    auto intern = [&pool, &interned](const QString &string) -> QPair<quint32, quint32> {
+        const auto it = interned.constFind(string);
+        if (it != interned.constEnd()) {
+            return *it;
+        }
+        const QByteArray utf8 = string.toUtf8();
+        const QPair<quint32, quint32> ref(quint32(pool.size()), quint32(utf8.size()));
+        pool += utf8;
+        interned.insert(string, ref);
+        return ref;
+    };
+
+    QByteArray records;
+    records.reserve(entries.size() * qsizetype(sizeof(Record)));
+    for (const Entry &entry : entries) {
+        Record record = {};
+        std::tie(record.pathOffset, record.pathLength) = intern(entry.path);
+        std::tie(record.sourceOffset, record.sourceLength) = intern(entry.sourcePath);
+        std::tie(record.iconOffset, record.iconLength) = intern(entry.iconName);
+        record.attributes = entry.attributes;
+        record.status = entry.status.bits();
+        record.sourceMtime = entry.sourceMtime;
+        record.targetMtime = entry.targetMtime;
+        records.append(reinterpret_cast<const char *>(&record), sizeof(Record));
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = FormatVersion;
+    header.entryCount = quint32(entries.size());
+    std::tie(header.sourceDirOffset, header.sourceDirLength) = intern(sourceDir);
+    header.stringPoolSize = quint32(pool.size());
+    header.checksum = fnv1a(pool.constData(), pool.size(), fnv1a(records.constData(), records.size()));
+
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        LOG_WARNING(QStringLiteral("Cannot write inventory cache %1: %2").arg(m_filePath, file.errorString()));
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    file.write(records);
+    file.write(pool);
+    if (!file.commit()) {
+        LOG_WARNING(QStringLiteral("Cannot write inventory cache %1: %2").arg(m_filePath, file.errorString()));
+        return false;
+    }
+
+    LOG_DEBUG(QStringLiteral("Wrote %1 entries to inventory cache (%2 bytes)")
+              .arg(entries.size()).arg(sizeof(Header) + records.size() + pool.size()));
+    return true;
+}
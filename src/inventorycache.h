@@ -0,0 +1,55 @@
+#ifndef INVENTORYCACHE_H
+#define INVENTORYCACHE_H
+
+#include <QList>
+#include <QString>
+
+#include "chezmoistatus.h"
+
+/**
+ * @brief On-disk snapshot of the last loaded inventory, used for warm starts
+ *
+ * The file is a fixed header, a table of fixed-size records and a pool of
+ * UTF-8 strings that records point into, so loading is a single mmap and a
+ * linear scan. Snapshots are tied to the source directory they were taken
+ * from and are ignored when the format version, source directory or checksum
+ * does not match.
+ */
+class InventoryCache
+{
+public:
+    enum Attribute : quint16 {
+        Template = 0x1,
+        TargetExists = 0x2,
+        TargetSymlink = 0x4,
+        TargetExecutable = 0x8,
+        TargetPrivate = 0x10
+    };
+
+    struct Entry {
+        QString path;          // target path relative to the destination directory
+        QString sourcePath;    // relative to the source directory
+        ChezmoiStatus status;
+        QString iconName;
+        quint16 attributes = 0;
+        qint64 sourceMtime = -1; // ms since epoch, -1 when unknown
+        qint64 targetMtime = -1;
+
+        bool isTemplate() const { return attributes & Template; }
+    };
+
+    static constexpr quint32 FormatVersion = 3;
+
+    explicit InventoryCache(const QString &filePath = defaultPath());
+
+    static QString defaultPath();
+
+    const QString &filePath() const { return m_filePath; }
+    bool load(const QString &sourceDir, QList<Entry> *entries) const;
+    bool save(const QString &sourceDir, const QList<Entry> &entries) const;
+
+private:
+    QString m_filePath;
+};
+
+#endif // INVENTORYCACHE_H
@@ -1,5 +1,6 @@
 #include "logviewer.h"
 #include "logger.h"
+#include "memoryregistry.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -23,13 +24,25 @@ LogViewer::LogViewer(QWidget *parent)
     , m_refreshButton(nullptr)
     , m_clearButton(nullptr)
     , m_saveButton(nullptr)
+    , m_memoryButton(nullptr)
     , m_closeButton(nullptr)
+    , m_memoryReporter(0)
 {
+    // The whole log file is held in the text view while the viewer is open
+    m_memoryReporter = MemoryRegistry::instance()->add(QStringLiteral("Log viewer"), [this]() {
+        return MemoryRegistry::Usage{m_logTextEdit->document()->characterCount() * qint64(sizeof(QChar)), 1};
+    });
+    
     setupUI();
     // Call refreshLog after UI is set up
     QMetaObject::invokeMethod(this, &LogViewer::refreshLog, Qt::QueuedConnection);
 }
 
+LogViewer::~LogViewer()
+{
+    MemoryRegistry::instance()->remove(m_memoryReporter);
+}
+
 void LogViewer::setupUI()
 {
     setWindowTitle(i18n("DotWeaver Log Viewer"));
@@ -63,6 +76,11 @@ void LogViewer::setupUI()
     connect(m_saveButton, &QPushButton::clicked, this, &LogViewer::saveLog);
     buttonLayout->addWidget(m_saveButton);
     
+    m_memoryButton = new QPushButton(i18n("&Memory Usage"), this);
+    m_memoryButton->setToolTip(i18n("Write the memory held by the file tree, caches and open documents to the log"));
+    connect(m_memoryButton, &QPushButton::clicked, this, &LogViewer::logMemoryUsage);
+    buttonLayout->addWidget(m_memoryButton);
+    
     buttonLayout->addStretch();
     
     m_closeButton = new QPushButton(i18n("&Close"), this);
@@ -131,3 +149,9 @@ void LogViewer::saveLog()
         Logger::error(QStringLiteral("Failed to save log to: %1").arg(fileName), QStringLiteral("LogViewer"));
     }
 }
+
+void LogViewer::logMemoryUsage()
+{
+    LOG_INFO(MemoryRegistry::instance()->report());
+    refreshLog();
+}
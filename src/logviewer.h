@@ -16,11 +16,13 @@ class LogViewer : public QDialog
 
 public:
     explicit LogViewer(QWidget *parent = nullptr);
+    ~LogViewer() override;
 
 private Q_SLOTS:
     void refreshLog();
     void clearLog();
     void saveLog();
+    void logMemoryUsage();
 
 private:
     void setupUI();
@@ -29,7 +31,9 @@ private:
     QPushButton *m_refreshButton;
     QPushButton *m_clearButton;
     QPushButton *m_saveButton;
+    QPushButton *m_memoryButton;
     QPushButton *m_closeButton;
+    quint64 m_memoryReporter;
 };
 
 #endif // LOGVIEWER_H
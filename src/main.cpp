@@ -3,15 +3,20 @@
 #include <KLocalizedString>
 #include <QCommandLineParser>
 #include <QDebug>
+#include <QElapsedTimer>
 
 #include "mainwindow.h"
 #include "logger.h"
+#include "startupprofiler.h"
 #include "dotweaver_version.h"
 
 using namespace Qt::Literals::StringLiterals;
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+    
     QApplication app(argc, argv);
     
     QIcon appIcon = QIcon::fromTheme(QStringLiteral("dotweaver"), QIcon(QStringLiteral(":/icons/dotweaver.png")));
@@ -44,10 +49,16 @@ int main(int argc, char *argv[])
 
     QCommandLineParser parser;
     aboutData.setupCommandLine(&parser);
+    QCommandLineOption measureStartupOption(QStringLiteral("measure-startup"),
+        i18n("Print startup timings as JSON and quit once the file tree has loaded"));
+    parser.addOption(measureStartupOption);
     parser.process(app);
     aboutData.processCommandLine(&parser);
 
     MainWindow window;
+    if (parser.isSet(measureStartupOption)) {
+        new StartupProfiler(startupTimer, &window, window.dotfileManager(), &window);
+    }
     window.show();
 
     return app.exec();
@@ -5,8 +5,13 @@
 #include "filetab.h"
 #include "logger.h"
 #include "logviewer.h"
+#include "memoryregistry.h"
 #include "dataviewer.h"
 #include "statusbar.h"
+#include "historypanel.h"
+#include "quickopendialog.h"
+#include "dotfilefiltermodel.h"
+#include "findinfilespanel.h"
 
 
 #include <KAboutApplicationDialog>
@@ -30,26 +35,49 @@
 #include <QProcess>
 #include <QStatusBar>
 #include <QToolBar>
+#include <QFileDialog>
 #include <QFileSystemModel>
 #include <QIcon>
 #include <QStandardPaths>
 #include <QMenu>
 #include <QPoint>
+#include <QDockWidget>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QSet>
+#include <QTimer>
 
+#include <algorithm>
 #include <memory>
 
 using namespace Qt::Literals::StringLiterals;
 
+namespace {
+// Typing pauses shorter than this refilter the tree once, not once per key
+constexpr int TreeFilterDelayMs = 200;
+}
+
 
 MainWindow::MainWindow(QWidget *parent)
     : KXmlGuiWindow(parent)
     , m_fileTreeView(nullptr)
+    , m_treeFilter(nullptr)
+    , m_sidebar(nullptr)
+    , m_treeFilterEdit(nullptr)
+    , m_statusFilterCombo(nullptr)
+    , m_treeFilterTimer(nullptr)
     , m_editorTabs(nullptr)
     , m_splitter(nullptr)
     , m_chezmoiService(std::make_unique<ChezmoiService>(this))
     , m_dotfileManager(std::make_unique<DotfileManager>(this))
-    , m_configEditor(std::make_unique<ConfigEditor>(this))
+    , m_configEditor(std::make_unique<ConfigEditor>(m_chezmoiService->config(), this))
     , m_statusBar(nullptr)
+    , m_historyPanel(nullptr)
+    , m_historyDock(nullptr)
+    , m_findInFilesPanel(nullptr)
+    , m_findInFilesDock(nullptr)
+    , m_quickOpenDialog(nullptr)
+    , m_quickOpenStale(true)
     , m_currentFile()
 {
     QIcon appIcon = QIcon::fromTheme(QStringLiteral("dotweaver"), QIcon(QStringLiteral(":/icons/dotweaver.png")));
@@ -62,11 +90,33 @@ MainWindow::MainWindow(QWidget *parent)
             this, &MainWindow::refreshFiles);
     connect(m_dotfileManager.get(), &DotfileManager::fileModified,
             this, &MainWindow::onFileModified);
+    connect(m_dotfileManager.get(), &DotfileManager::filesRefreshed, this, [this]() {
+        m_quickOpenStale = true;
+    });
+    connect(m_chezmoiService.get(), &ChezmoiService::configurationChanged,
+            this, &MainWindow::onConfigurationChanged);
     
     loadDotfiles();
 }
 
-MainWindow::~MainWindow() = default;
+MainWindow::~MainWindow()
+{
+    // The config editor flushes pending edits as it goes away; nothing here should react to them
+    disconnect(m_chezmoiService.get(), nullptr, this, nullptr);
+    
+    // The status bar and history panel may still be resolving paths through the service on worker threads
+    delete m_statusBar;
+    m_statusBar = nullptr;
+    delete m_historyDock;
+    m_historyDock = nullptr;
+    delete m_findInFilesDock;
+    m_findInFilesDock = nullptr;
+}
+
+DotfileManager *MainWindow::dotfileManager() const
+{
+    return m_dotfileManager.get();
+}
 
 void MainWindow::setupUI()
 {
@@ -81,13 +131,52 @@ void MainWindow::setupUI()
     // Create horizontal splitter
     m_splitter = new QSplitter(Qt::Horizontal, this);
     
-    // Left panel - File tree
-    m_fileTreeView = new QTreeView(this);
-    m_fileTreeView->setMinimumWidth(150);
-    m_fileTreeView->setModel(m_dotfileManager.get());
+    // Left panel - Filter bar above the file tree
+    m_sidebar = new QWidget(this);
+    m_sidebar->setMinimumWidth(150);
+    auto *sidebarLayout = new QVBoxLayout(m_sidebar);
+    sidebarLayout->setContentsMargins(0, 0, 0, 0);
+    sidebarLayout->setSpacing(2);
+    
+    auto *filterLayout = new QHBoxLayout();
+    m_treeFilterEdit = new QLineEdit(m_sidebar);
+    m_treeFilterEdit->setPlaceholderText(i18n("Filter files..."));
+    m_treeFilterEdit->setClearButtonEnabled(true);
+    filterLayout->addWidget(m_treeFilterEdit, 1);
+    
+    // Each entry holds the change mask it filters on; templates are a flag of their own
+    m_statusFilterCombo = new QComboBox(m_sidebar);
+    m_statusFilterCombo->addItem(i18n("All Files"), int(DotfileFilterModel::AllChanges));
+    m_statusFilterCombo->addItem(i18n("Changed"), int(DotfileFilterModel::DirtyChanges));
+    m_statusFilterCombo->addItem(i18n("Modified"), int(DotfileFilterModel::changeBit(ChezmoiStatus::Modified)));
+    m_statusFilterCombo->addItem(i18n("Added"), int(DotfileFilterModel::changeBit(ChezmoiStatus::Added)));
+    m_statusFilterCombo->addItem(i18n("Deleted"), int(DotfileFilterModel::changeBit(ChezmoiStatus::Deleted)));
+    m_statusFilterCombo->addItem(i18n("Templates"), -1);
+    filterLayout->addWidget(m_statusFilterCombo);
+    sidebarLayout->addLayout(filterLayout);
+    
+    m_treeFilterTimer = new QTimer(this);
+    m_treeFilterTimer->setSingleShot(true);
+    m_treeFilterTimer->setInterval(TreeFilterDelayMs);
+    connect(m_treeFilterTimer, &QTimer::timeout, this, &MainWindow::onTreeFilterChanged);
+    connect(m_treeFilterEdit, &QLineEdit::textChanged, m_treeFilterTimer, qOverload<>(&QTimer::start));
+    connect(m_statusFilterCombo, &QComboBox::currentIndexChanged, this, &MainWindow::onTreeFilterChanged);
+    
+    m_treeFilter = new DotfileFilterModel(this);
+    m_treeFilter->setSourceModel(m_dotfileManager.get());
+    
+    m_fileTreeView = new QTreeView(m_sidebar);
+    m_fileTreeView->setModel(m_treeFilter);
     m_fileTreeView->setHeaderHidden(true);
     m_fileTreeView->setIndentation(15);
     m_fileTreeView->setRootIsDecorated(true);
+    m_fileTreeView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    sidebarLayout->addWidget(m_fileTreeView);
+    
+    // Status and type are shown through colours and icons; the target details are opt-in
+    for (int column = DotfileManager::StatusColumn; column < DotfileManager::ColumnCount; ++column) {
+        m_fileTreeView->setColumnHidden(column, true);
+    }
     
     // Add context menu for expand/collapse
     m_fileTreeView->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -98,6 +187,10 @@ void MainWindow::setupUI()
     connect(m_fileTreeView, &QTreeView::doubleClicked,
             this, &MainWindow::onFileDoubleClicked);
     
+    // Keep the history panel following the selected file
+    connect(m_fileTreeView->selectionModel(), &QItemSelectionModel::currentChanged,
+            this, &MainWindow::onTreeCurrentChanged);
+    
     // Right panel - Editor tabs
     m_editorTabs = new QTabWidget(this);
     m_editorTabs->setTabsClosable(true);
@@ -109,7 +202,7 @@ void MainWindow::setupUI()
             this, &MainWindow::onTabCloseRequested);
     
     // Add widgets to splitter
-    m_splitter->addWidget(m_fileTreeView);
+    m_splitter->addWidget(m_sidebar);
     m_splitter->addWidget(m_editorTabs);
     
     // Set initial splitter sizes (25% for tree, 75% for editor)
@@ -122,6 +215,12 @@ void MainWindow::setupUI()
     // Setup status bar
     setupStatusBar();
     
+    // Setup history dock
+    setupHistoryPanel();
+    
+    // Setup find in files dock
+    setupFindInFilesPanel();
+    
     setWindowTitle(i18n("Home"));
     resize(1000, 700);
 }
@@ -135,6 +234,30 @@ void MainWindow::setupStatusBar()
     m_statusBar = new ::StatusBar(qtStatusBar, m_chezmoiService.get(), this);
 }
 
+void MainWindow::setupHistoryPanel()
+{
+    m_historyPanel = new HistoryPanel(m_chezmoiService.get(), this);
+    
+    m_historyDock = new QDockWidget(i18n("History"), this);
+    m_historyDock->setObjectName(QStringLiteral("historyDock"));
+    m_historyDock->setWidget(m_historyPanel);
+    addDockWidget(Qt::BottomDockWidgetArea, m_historyDock);
+    m_historyDock->hide();
+}
+
+void MainWindow::setupFindInFilesPanel()
+{
+    m_findInFilesPanel = new FindInFilesPanel(m_dotfileManager.get(), m_chezmoiService.get(), this);
+    connect(m_findInFilesPanel, &FindInFilesPanel::matchActivated,
+            this, &MainWindow::openFileAtLine);
+    
+    m_findInFilesDock = new QDockWidget(i18n("Find in Files"), this);
+    m_findInFilesDock->setObjectName(QStringLiteral("findInFilesDock"));
+    m_findInFilesDock->setWidget(m_findInFilesPanel);
+    addDockWidget(Qt::BottomDockWidgetArea, m_findInFilesDock);
+    m_findInFilesDock->hide();
+}
+
 void MainWindow::setupActions()
 {
     // File menu actions
@@ -149,9 +272,43 @@ void MainWindow::setupActions()
     auto *syncAction = actionCollection()->addAction(QStringLiteral("sync"));
     syncAction->setText(i18n("&Sync Files"));
     syncAction->setIcon(QIcon::fromTheme(QStringLiteral("folder-sync")));
+    syncAction->setToolTip(i18n("Apply every file with pending changes"));
     KActionCollection::setDefaultShortcut(syncAction, QKeySequence(Qt::CTRL | Qt::Key_S));
     connect(syncAction, &QAction::triggered, this, &MainWindow::syncFiles);
     
+    auto *applySelectedAction = actionCollection()->addAction(QStringLiteral("apply_selected"));
+    applySelectedAction->setText(i18n("&Apply Selected Files"));
+    applySelectedAction->setIcon(QIcon::fromTheme(QStringLiteral("dialog-ok-apply")));
+    applySelectedAction->setToolTip(i18n("Apply only the files selected in the tree"));
+    connect(applySelectedAction, &QAction::triggered, this, &MainWindow::applySelectedFiles);
+    
+    auto *quickOpenAction = actionCollection()->addAction(QStringLiteral("quick_open"));
+    quickOpenAction->setText(i18n("&Quick Open..."));
+    quickOpenAction->setIcon(QIcon::fromTheme(QStringLiteral("quickopen")));
+    quickOpenAction->setToolTip(i18n("Open a managed file by typing part of its path"));
+    KActionCollection::setDefaultShortcut(quickOpenAction, QKeySequence(Qt::CTRL | Qt::Key_P));
+    connect(quickOpenAction, &QAction::triggered, this, &MainWindow::showQuickOpen);
+    
+    // Edit menu
+    auto *addFileAction = actionCollection()->addAction(QStringLiteral("add_file"));
+    addFileAction->setText(i18n("&Add Files..."));
+    addFileAction->setIcon(QIcon::fromTheme(QStringLiteral("list-add")));
+    addFileAction->setToolTip(i18n("Start managing files from the home directory with chezmoi"));
+    connect(addFileAction, &QAction::triggered, this, &MainWindow::addFiles);
+    
+    auto *removeFileAction = actionCollection()->addAction(QStringLiteral("remove_file"));
+    removeFileAction->setText(i18n("&Forget Selected Files"));
+    removeFileAction->setIcon(QIcon::fromTheme(QStringLiteral("list-remove")));
+    removeFileAction->setToolTip(i18n("Stop managing the files selected in the tree, leaving them in place"));
+    connect(removeFileAction, &QAction::triggered, this, &MainWindow::forgetSelectedFiles);
+    
+    auto *findInFilesAction = actionCollection()->addAction(QStringLiteral("find_in_files"));
+    findInFilesAction->setText(i18n("F&ind in Files..."));
+    findInFilesAction->setIcon(QIcon::fromTheme(QStringLiteral("edit-find")));
+    findInFilesAction->setToolTip(i18n("Search the contents of every managed file"));
+    KActionCollection::setDefaultShortcut(findInFilesAction, QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_F));
+    connect(findInFilesAction, &QAction::triggered, this, &MainWindow::showFindInFiles);
+    
     // View menu
     auto *toggleSidebarAction = actionCollection()->addAction(QStringLiteral("toggle_sidebar"));
     toggleSidebarAction->setText(i18n("Toggle &Sidebar"));
@@ -175,6 +332,13 @@ void MainWindow::setupActions()
     KActionCollection::setDefaultShortcut(collapseAllAction, QKeySequence(Qt::CTRL | Qt::Key_Minus));
     connect(collapseAllAction, &QAction::triggered, this, &MainWindow::collapseAllItems);
     
+    auto *showHistoryAction = m_historyDock->toggleViewAction();
+    showHistoryAction->setText(i18n("File &History"));
+    showHistoryAction->setIcon(QIcon::fromTheme(QStringLiteral("view-history")));
+    showHistoryAction->setToolTip(i18n("Show the git history of the selected file"));
+    actionCollection()->addAction(QStringLiteral("show_history"), showHistoryAction);
+    KActionCollection::setDefaultShortcut(showHistoryAction, QKeySequence(Qt::CTRL | Qt::Key_H));
+    
     // Settings menu
     KStandardAction::preferences(this, &MainWindow::openSettings, actionCollection());
     
@@ -191,6 +355,12 @@ void MainWindow::setupActions()
     viewDataAction->setToolTip(i18n("View chezmoi template variables"));
     connect(viewDataAction, &QAction::triggered, this, &MainWindow::showDataViewer);
     
+    auto *memoryUsageAction = actionCollection()->addAction(QStringLiteral("log_memory_usage"));
+    memoryUsageAction->setText(i18n("Log &Memory Usage"));
+    memoryUsageAction->setIcon(QIcon::fromTheme(QStringLiteral("memory")));
+    memoryUsageAction->setToolTip(i18n("Write the memory held by the file tree, caches and open documents to the log"));
+    connect(memoryUsageAction, &QAction::triggered, this, &MainWindow::logMemoryUsage);
+    
     // Help menu
     KStandardAction::aboutApp(this, &MainWindow::showAbout, actionCollection());
     
@@ -214,17 +384,64 @@ void MainWindow::refreshFiles()
     loadDotfiles();
 }
 
+void MainWindow::onConfigurationChanged(const QStringList &changedKeys)
+{
+    LOG_DEBUG(QStringLiteral("chezmoi configuration changed: %1").arg(changedKeys.join(", "_L1)));
+
+    // Only the locations of the managed files affect what the tree shows
+    if (changedKeys.contains("sourcedir"_L1) || changedKeys.contains("destdir"_L1)) {
+        refreshFiles();
+    }
+}
+
 void MainWindow::syncFiles()
 {
-    LOG_INFO("Starting file sync"_L1);
-    m_chezmoiService->applyChanges();
+    // Until the statuses are in, nobody knows which files are pending, so everything is applied
+    if (m_dotfileManager->isLoading()) {
+        LOG_INFO("Starting file sync"_L1);
+        m_chezmoiService->applyChanges();
+        return;
+    }
+    
+    const QStringList targetPaths = m_dotfileManager->pendingApplyPaths();
+    if (targetPaths.isEmpty()) {
+        m_statusBar->setCenterText(i18n("Nothing to apply"));
+        return;
+    }
+    applyTargets(targetPaths);
+}
+
+void MainWindow::applySelectedFiles()
+{
+    applyTargets(selectedTargetPaths());
+}
+
+void MainWindow::applyTargets(const QStringList &targetPaths)
+{
+    if (targetPaths.isEmpty()) {
+        return;
+    }
+    
+    // chezmoi is given the targets explicitly; rows show their progress and only they are refreshed
+    const QString destDir = m_chezmoiService->getDestinationDirectory();
+    QStringList filePaths;
+    filePaths.reserve(targetPaths.size());
+    for (const QString &path : targetPaths) {
+        filePaths << destDir + u'/' + path;
+    }
+    
+    LOG_INFO(QStringLiteral("Applying %1 files").arg(filePaths.size()));
+    m_statusBar->setCenterText(QString());
+    if (!m_chezmoiService->applyFiles(filePaths)) {
+        KMessageBox::error(this, i18n("Could not run chezmoi to apply the files."));
+    }
 }
 
 void MainWindow::toggleSidebar()
 {
-    if (m_fileTreeView) {
-        bool isVisible = m_fileTreeView->isVisible();
-        m_fileTreeView->setVisible(!isVisible);
+    if (m_sidebar) {
+        bool isVisible = m_sidebar->isVisible();
+        m_sidebar->setVisible(!isVisible);
         
         // Update the action state
         auto *action = actionCollection()->action(QStringLiteral("toggle_sidebar"));
@@ -248,6 +465,24 @@ void MainWindow::collapseAllItems()
     }
 }
 
+void MainWindow::onTreeFilterChanged()
+{
+    // The status filter applies at once and takes any pending text with it
+    m_treeFilterTimer->stop();
+    
+    const int changes = m_statusFilterCombo->currentData().toInt();
+    m_treeFilter->setTemplatesOnly(changes < 0);
+    m_treeFilter->setChangeFilter(changes < 0 ? DotfileFilterModel::AllChanges : DotfileFilterModel::ChangeMask(changes));
+    m_treeFilter->setFilterText(m_treeFilterEdit->text());
+    
+    // Matches can be deep in the tree, so a narrowed tree is shown fully expanded; it only holds matches and their ancestors
+    if (m_treeFilter->isFiltering()) {
+        m_fileTreeView->expandAll();
+    }
+    
+    LOG_DEBUG(QStringLiteral("Tree filter: %1 files shown").arg(m_treeFilter->visibleFileCount()));
+}
+
 void MainWindow::showTreeContextMenu(const QPoint &position)
 {
     if (!m_fileTreeView) {
@@ -256,6 +491,14 @@ void MainWindow::showTreeContextMenu(const QPoint &position)
     
     QMenu contextMenu(this);
     
+    contextMenu.addAction(actionCollection()->action(QStringLiteral("add_file")));
+    if (m_fileTreeView->selectionModel()->hasSelection()) {
+        contextMenu.addAction(actionCollection()->action(QStringLiteral("apply_selected")));
+        contextMenu.addAction(actionCollection()->action(QStringLiteral("remove_file")));
+    }
+    
+    contextMenu.addSeparator();
+    
     auto *expandAllAction = contextMenu.addAction(QIcon::fromTheme(QStringLiteral("expand-all")), 
                                                   i18n("Expand All"));
     connect(expandAllAction, &QAction::triggered, this, &MainWindow::expandAllItems);
@@ -266,6 +509,17 @@ void MainWindow::showTreeContextMenu(const QPoint &position)
     
     contextMenu.addSeparator();
     
+    auto *detailsAction = contextMenu.addAction(QIcon::fromTheme(QStringLiteral("view-list-details")), 
+                                                i18n("Show Details"));
+    detailsAction->setCheckable(true);
+    detailsAction->setChecked(!m_fileTreeView->isColumnHidden(DotfileManager::SizeColumn));
+    connect(detailsAction, &QAction::toggled, this, [this](bool checked) {
+        for (int column : {DotfileManager::SizeColumn, DotfileManager::ModifiedColumn, DotfileManager::PermissionsColumn}) {
+            m_fileTreeView->setColumnHidden(column, !checked);
+        }
+        m_fileTreeView->setHeaderHidden(!checked);
+    });
+    
     auto *refreshAction = contextMenu.addAction(QIcon::fromTheme(QStringLiteral("view-refresh")), 
                                                 i18n("Refresh"));
     connect(refreshAction, &QAction::triggered, this, &MainWindow::refreshFiles);
@@ -279,6 +533,11 @@ void MainWindow::showAbout()
     dialog.exec();
 }
 
+void MainWindow::logMemoryUsage()
+{
+    LOG_INFO(MemoryRegistry::instance()->report());
+}
+
 void MainWindow::showLogViewer()
 {
     auto *logViewer = new LogViewer(this);
@@ -312,6 +571,100 @@ void MainWindow::showDataViewer()
     LOG_INFO("Data viewer opened"_L1);
 }
 
+void MainWindow::showQuickOpen()
+{
+    if (!m_quickOpenDialog) {
+        m_quickOpenDialog = new QuickOpenDialog(this);
+        connect(m_quickOpenDialog, &QuickOpenDialog::fileChosen,
+                this, &MainWindow::openFileInTab);
+    }
+    
+    // The index is rebuilt once per inventory change, not per keystroke
+    if (m_quickOpenStale) {
+        m_quickOpenDialog->setPaths(m_chezmoiService->getDestinationDirectory(), m_dotfileManager->managedPaths());
+        m_quickOpenStale = false;
+    }
+    
+    m_quickOpenDialog->popup();
+}
+
+void MainWindow::showFindInFiles()
+{
+    m_findInFilesDock->show();
+    m_findInFilesDock->raise();
+    m_findInFilesPanel->focusPattern();
+}
+
+void MainWindow::addFiles()
+{
+    const QStringList filePaths = QFileDialog::getOpenFileNames(this, i18n("Add Files to chezmoi"),
+                                                                m_chezmoiService->getDestinationDirectory());
+    if (filePaths.isEmpty()) {
+        return;
+    }
+    
+    // Rows appear as each chezmoi run finishes; the status bar shows how far it has got
+    LOG_INFO(QStringLiteral("Adding %1 files to chezmoi").arg(filePaths.size()));
+    if (!m_chezmoiService->addFiles(filePaths)) {
+        KMessageBox::error(this, i18n("Could not run chezmoi to add the files."));
+    }
+}
+
+void MainWindow::forgetSelectedFiles()
+{
+    const QStringList targetPaths = selectedTargetPaths();
+    if (targetPaths.isEmpty()) {
+        return;
+    }
+    
+    const int answer = KMessageBox::warningContinueCancel(
+        this,
+        i18np("Stop managing %1 file with chezmoi? The file itself is left in place.",
+              "Stop managing %1 files with chezmoi? The files themselves are left in place.", targetPaths.size()),
+        i18n("Forget Files"),
+        KGuiItem(i18n("Forget"), QStringLiteral("list-remove")));
+    if (answer != KMessageBox::Continue) {
+        return;
+    }
+    
+    const QString destDir = m_chezmoiService->getDestinationDirectory();
+    QStringList filePaths;
+    filePaths.reserve(targetPaths.size());
+    for (const QString &path : targetPaths) {
+        filePaths << destDir + u'/' + path;
+    }
+    
+    LOG_INFO(QStringLiteral("Forgetting %1 files").arg(filePaths.size()));
+    if (!m_chezmoiService->forgetFiles(filePaths)) {
+        KMessageBox::error(this, i18n("Could not run chezmoi to forget the files."));
+    }
+}
+
+QStringList MainWindow::selectedTargetPaths() const
+{
+    // A selected directory stands for the files below it that the filter shows; overlapping selections count once
+    QSet<QString> paths;
+    QModelIndexList pending = m_fileTreeView->selectionModel()->selectedRows();
+    while (!pending.isEmpty()) {
+        const QModelIndex index = pending.takeLast();
+        const int rows = m_treeFilter->rowCount(index);
+        for (int row = 0; row < rows; ++row) {
+            pending.append(m_treeFilter->index(row, 0, index));
+        }
+        
+        const QModelIndex sourceIndex = m_treeFilter->mapToSource(index);
+        if (rows == 0 && m_dotfileManager->rowCount(sourceIndex) == 0) {
+            for (const QString &path : m_dotfileManager->targetPaths(sourceIndex)) {
+                paths.insert(path);
+            }
+        }
+    }
+    
+    QStringList sorted(paths.cbegin(), paths.cend());
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
 void MainWindow::onFileSelected(const QString &filePath)
 {
     m_currentFile = filePath;
@@ -324,20 +677,31 @@ void MainWindow::onFileDoubleClicked(const QModelIndex &index)
         return;
     }
     
-    // Get the file path from the model
-    QString filePath = m_dotfileManager->getFilePath(index);
-    if (filePath.isEmpty()) {
-        LOG_DEBUG("Double-clicked item has no file path (likely a directory)"_L1);
+    // Directories always have children in the model, even when the filter hides them
+    const QModelIndex sourceIndex = m_treeFilter->mapToSource(index);
+    if (m_dotfileManager->rowCount(sourceIndex) > 0) {
+        LOG_DEBUG("Double-clicked item is a directory"_L1);
         return;
     }
     
-    // Convert source path to target path for display/editing
-    QString targetPath = m_chezmoiService->convertToTargetPath(filePath);
+    // The tree knows the target path itself; the source path may not be listed yet
+    const QStringList targets = m_dotfileManager->targetPaths(sourceIndex);
+    if (targets.size() != 1) {
+        return;
+    }
+    const QString targetPath = m_chezmoiService->getDestinationDirectory() + u'/' + targets.first();
     
-    LOG_INFO(QStringLiteral("Double-clicked file: %1 -> target: %2").arg(filePath, targetPath));
+    LOG_INFO(QStringLiteral("Double-clicked file: %1").arg(targetPath));
     openFileInTab(targetPath);
 }
 
+void MainWindow::onTreeCurrentChanged(const QModelIndex &current)
+{
+    if (m_historyPanel) {
+        m_historyPanel->setFile(m_dotfileManager->getFilePath(m_treeFilter->mapToSource(current)));
+    }
+}
+
 void MainWindow::onTabCloseRequested(int index)
 {
     if (index < 0 || index >= m_editorTabs->count()) {
@@ -385,6 +749,16 @@ void MainWindow::openFileInTab(const QString &filePath)
     LOG_INFO(QStringLiteral("Opened new tab for file: %1").arg(filePath));
 }
 
+void MainWindow::openFileAtLine(const QString &filePath, int line, int column)
+{
+    openFileInTab(filePath);
+    
+    // Opening loads the document synchronously, so the cursor can be placed straight away
+    if (FileTab *fileTab = findTabByFilePath(filePath)) {
+        fileTab->goToLine(line, column);
+    }
+}
+
 FileTab* MainWindow::findTabByFilePath(const QString &filePath)
 {
     for (int i = 0; i < m_editorTabs->count(); ++i) {
@@ -410,6 +784,6 @@ void MainWindow::loadDotfiles()
     // Set up the connection between services
     m_dotfileManager->setChezmoiService(m_chezmoiService.get());
     
-    // Refresh the file tree
+    // Loads in the background; the tree fills in once chezmoi answers
     m_dotfileManager->refreshFiles();
 }
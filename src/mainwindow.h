@@ -15,6 +15,14 @@ class FileTab;
 class ChezmoiService;
 class DotfileManager;
 class ConfigEditor;
+class HistoryPanel;
+class QDockWidget;
+class QuickOpenDialog;
+class FindInFilesPanel;
+class DotfileFilterModel;
+class QLineEdit;
+class QComboBox;
+class QTimer;
 
 class MainWindow : public KXmlGuiWindow
 {
@@ -24,31 +32,52 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow() override;
 
+    DotfileManager *dotfileManager() const;
+
 private Q_SLOTS:
     void openSettings();
     void refreshFiles();
     void syncFiles();
+    void applySelectedFiles();
     void showAbout();
     void showLogViewer();
+    void logMemoryUsage();
     void showDataViewer();
+    void showQuickOpen();
+    void showFindInFiles();
+    void addFiles();
+    void forgetSelectedFiles();
     void toggleSidebar();
     void expandAllItems();
     void collapseAllItems();
+    void onTreeFilterChanged();
     void showTreeContextMenu(const QPoint &position);
     void onFileSelected(const QString &filePath);
     void onFileDoubleClicked(const QModelIndex &index);
+    void onTreeCurrentChanged(const QModelIndex &current);
     void onTabCloseRequested(int index);
+    void openFileAtLine(const QString &filePath, int line, int column);
     void onFileModified();
+    void onConfigurationChanged(const QStringList &changedKeys);
 
 private:
     void setupUI();
     void setupActions();
     void setupStatusBar();
+    void setupHistoryPanel();
+    void setupFindInFilesPanel();
     void loadDotfiles();
     void openFileInTab(const QString &filePath);
     FileTab* findTabByFilePath(const QString &filePath);
+    QStringList selectedTargetPaths() const;
+    void applyTargets(const QStringList &targetPaths);
 
     QTreeView *m_fileTreeView;
+    DotfileFilterModel *m_treeFilter;
+    QWidget *m_sidebar;
+    QLineEdit *m_treeFilterEdit;
+    QComboBox *m_statusFilterCombo;
+    QTimer *m_treeFilterTimer;
     QTabWidget *m_editorTabs;
     QSplitter *m_splitter;
     
@@ -56,6 +85,12 @@ private:
     std::unique_ptr<DotfileManager> m_dotfileManager;
     std::unique_ptr<ConfigEditor> m_configEditor;
     ::StatusBar *m_statusBar;
+    HistoryPanel *m_historyPanel;
+    QDockWidget *m_historyDock;
+    FindInFilesPanel *m_findInFilesPanel;
+    QDockWidget *m_findInFilesDock;
+    QuickOpenDialog *m_quickOpenDialog;
+    bool m_quickOpenStale;
     
     QString m_currentFile;
 };
@@ -0,0 +1,95 @@
+#include "memoryregistry.h"
+
+#include <QLocale>
+#include <algorithm>
+
+using namespace Qt::Literals::StringLiterals;
+
+MemoryRegistry::MemoryRegistry()
+    : m_mutex()
+    , m_reporters()
+    , m_nextId(1)
+{
+}
+
+MemoryRegistry *MemoryRegistry::instance()
+{
+    static MemoryRegistry registry;
+    return &registry;
+}
+
+quint64 MemoryRegistry::add(const QString &name, const Reporter &reporter)
+{
+    QMutexLocker locker(&m_mutex);
+    const quint64 id = m_nextId++;
+    m_reporters.insert(id, Registration{name, reporter});
+    return id;
+}
+
+void MemoryRegistry::remove(quint64 id)
+{
+    QMutexLocker locker(&m_mutex);
+    m_reporters.remove(id);
+}
+
+QList<MemoryRegistry::Entry> MemoryRegistry::snapshot() const
+{
+    QList<Entry> entries;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const Registration &registration : m_reporters) {
+            const Usage usage = registration.reporter();
+            auto it = std::find_if(entries.begin(), entries.end(), [&registration](const Entry &entry) {
+                return entry.name == registration.name;
+            });
+            if (it == entries.end()) {
+                entries.append(Entry{registration.name, usage});
+            } else {
+                it->usage.bytes += usage.bytes;
+                it->usage.objects += usage.objects;
+            }
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.usage.bytes > b.usage.bytes;
+    });
+    return entries;
+}
+
+MemoryRegistry::Usage MemoryRegistry::usage(const QString &name) const
+{
+    for (const Entry &entry : snapshot()) {
+        if (entry.name == name) {
+            return entry.usage;
+        }
+    }
+    return Usage();
+}
+
+QString MemoryRegistry::report() const
+{
+    const QList<Entry> entries = snapshot();
+    const QLocale locale;
+
+    Usage total;
+    QString text = u"Memory usage:\n"_s;
+    for (const Entry &entry : entries) {
+        text += QStringLiteral("  %1 %2 in %3 objects\n")
+                    .arg(entry.name + u':', -24)
+                    .arg(locale.formattedDataSize(entry.usage.bytes), 10)
+                    .arg(entry.usage.objects);
+        total.bytes += entry.usage.bytes;
+        total.objects += entry.usage.objects;
+    }
+    text += QStringLiteral("  %1 %2 in %3 objects")
+                .arg(u"Total:"_s, -24)
+                .arg(locale.formattedDataSize(total.bytes), 10)
+                .arg(total.objects);
+    return text;
+}
+
+qint64 MemoryRegistry::stringBytes(const QString &string)
+{
+    return string.capacity() * qint64(sizeof(QChar));
+}
@@ -0,0 +1,60 @@
+#ifndef MEMORYREGISTRY_H
+#define MEMORYREGISTRY_H
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <functional>
+
+/**
+ * @brief Live byte and object counts of the application's larger structures
+ *
+ * Subsystems add a reporter when they are created and remove it when they
+ * go away. Reporters are only called when a snapshot is taken, from the
+ * thread taking it, so they should read state owned by that thread (the GUI
+ * thread in practice). Byte counts are estimates of the heap memory held,
+ * not exact allocator figures.
+ */
+class MemoryRegistry
+{
+public:
+    struct Usage {
+        qint64 bytes = 0;
+        qint64 objects = 0;
+    };
+
+    struct Entry {
+        QString name;
+        Usage usage;
+    };
+
+    using Reporter = std::function<Usage()>;
+
+    static MemoryRegistry *instance();
+
+    quint64 add(const QString &name, const Reporter &reporter);
+    void remove(quint64 id);
+
+    // Reporters with the same name are summed; largest first
+    QList<Entry> snapshot() const;
+    Usage usage(const QString &name) const;
+    QString report() const;
+
+    // Heap bytes behind a string, zero for literals and empty strings
+    static qint64 stringBytes(const QString &string);
+
+private:
+    MemoryRegistry();
+
+    struct Registration {
+        QString name;
+        Reporter reporter;
+    };
+
+    mutable QMutex m_mutex;
+    QMap<quint64, Registration> m_reporters;
+    quint64 m_nextId;
+};
+
+#endif // MEMORYREGISTRY_H
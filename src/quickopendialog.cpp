@@ -0,0 +1,142 @@
+#include "quickopendialog.h"
+#include "logger.h"
+#include "memoryregistry.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QVBoxLayout>
+#include <KLocalizedString>
+
+namespace {
+// Rows shown for a query; past this nobody scrolls, they type another character
+constexpr qsizetype MaxResults = 200;
+
+// Width of the palette relative to the main window
+constexpr double WidthFraction = 0.6;
+}
+
+QuickOpenDialog::QuickOpenDialog(QWidget *parent)
+    : QDialog(parent)
+    , m_matcher()
+    , m_rootDirectory()
+    , m_queryEdit(nullptr)
+    , m_resultList(nullptr)
+    , m_memoryReporter(0)
+{
+    m_memoryReporter = MemoryRegistry::instance()->add(QStringLiteral("Quick open index"), [this]() {
+        return MemoryRegistry::Usage{m_matcher.byteSize(), m_matcher.size()};
+    });
+
+    setWindowFlags(Qt::Popup);
+    setupUI();
+}
+
+QuickOpenDialog::~QuickOpenDialog()
+{
+    MemoryRegistry::instance()->remove(m_memoryReporter);
+}
+
+void QuickOpenDialog::setupUI()
+{
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->setSpacing(4);
+
+    m_queryEdit = new QLineEdit(this);
+    m_queryEdit->setPlaceholderText(i18n("Type part of a managed file's path..."));
+    m_queryEdit->setClearButtonEnabled(true);
+    m_queryEdit->installEventFilter(this);
+    layout->addWidget(m_queryEdit);
+
+    m_resultList = new QListWidget(this);
+    m_resultList->setUniformItemSizes(true);
+    m_resultList->setFocusPolicy(Qt::NoFocus);
+    layout->addWidget(m_resultList);
+
+    connect(m_queryEdit, &QLineEdit::textChanged, this, &QuickOpenDialog::updateResults);
+    connect(m_queryEdit, &QLineEdit::returnPressed, this, &QuickOpenDialog::chooseCurrent);
+    connect(m_resultList, &QListWidget::itemActivated, this, &QuickOpenDialog::chooseCurrent);
+}
+
+void QuickOpenDialog::setPaths(const QString &rootDirectory, const QStringList &relativePaths)
+{
+    m_rootDirectory = rootDirectory;
+    m_matcher.setPaths(relativePaths);
+    LOG_DEBUG(QStringLiteral("QuickOpenDialog: Indexed %1 paths").arg(relativePaths.size()));
+
+    if (isVisible()) {
+        updateResults(m_queryEdit->text());
+    }
+}
+
+void QuickOpenDialog::popup()
+{
+    // Top centre of the window, like the command palettes of editors
+    if (QWidget *window = parentWidget() ? parentWidget()->window() : nullptr) {
+        const int width = int(window->width() * WidthFraction);
+        resize(width, window->height() / 2);
+        move(window->mapToGlobal(QPoint((window->width() - width) / 2, window->height() / 10)));
+    }
+
+    m_queryEdit->clear();
+    updateResults(QString());
+    show();
+    raise();
+    activateWindow();
+    m_queryEdit->setFocus();
+}
+
+bool QuickOpenDialog::eventFilter(QObject *watched, QEvent *event)
+{
+    // Arrow keys move through the results while typing continues in the line edit
+    if (watched == m_queryEdit && event->type() == QEvent::KeyPress) {
+        switch (static_cast<QKeyEvent *>(event)->key()) {
+        case Qt::Key_Up:
+        case Qt::Key_Down:
+        case Qt::Key_PageUp:
+        case Qt::Key_PageDown:
+            QCoreApplication::sendEvent(m_resultList, event);
+            return true;
+        default:
+            break;
+        }
+    }
+    return QDialog::eventFilter(watched, event);
+}
+
+void QuickOpenDialog::updateResults(const QString &query)
+{
+    const QList<FuzzyMatcher::Match> matches = m_matcher.match(query, MaxResults);
+
+    // Rows are reused between keystrokes, so typing only changes their text
+    m_resultList->setUpdatesEnabled(false);
+    while (m_resultList->count() > matches.size()) {
+        delete m_resultList->takeItem(m_resultList->count() - 1);
+    }
+    for (qsizetype i = 0; i < matches.size(); ++i) {
+        const QString &path = m_matcher.path(matches.at(i).index);
+        if (i < m_resultList->count()) {
+            m_resultList->item(int(i))->setText(path);
+        } else {
+            m_resultList->addItem(path);
+        }
+    }
+    m_resultList->setCurrentRow(matches.isEmpty() ? -1 : 0);
+    m_resultList->setUpdatesEnabled(true);
+}
+
+void QuickOpenDialog::chooseCurrent()
+{
+    QListWidgetItem *item = m_resultList->currentItem();
+    if (!item) {
+        return;
+    }
+
+    const QString filePath = QDir(m_rootDirectory).filePath(item->text());
+    LOG_INFO(QStringLiteral("Quick open: %1").arg(filePath));
+    accept();
+    Q_EMIT fileChosen(filePath);
+}
@@ -0,0 +1,47 @@
+#ifndef QUICKOPENDIALOG_H
+#define QUICKOPENDIALOG_H
+
+#include <QDialog>
+#include <QStringList>
+
+#include "fuzzymatcher.h"
+
+class QLineEdit;
+class QListWidget;
+
+/**
+ * @brief Palette for opening any managed file by typing part of its path
+ */
+class QuickOpenDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit QuickOpenDialog(QWidget *parent = nullptr);
+    ~QuickOpenDialog() override;
+
+    // Paths are shown relative to rootDirectory and joined to it when chosen
+    void setPaths(const QString &rootDirectory, const QStringList &relativePaths);
+    void popup();
+
+Q_SIGNALS:
+    void fileChosen(const QString &filePath);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private Q_SLOTS:
+    void updateResults(const QString &query);
+    void chooseCurrent();
+
+private:
+    void setupUI();
+
+    FuzzyMatcher m_matcher;
+    QString m_rootDirectory;
+    QLineEdit *m_queryEdit;
+    QListWidget *m_resultList;
+    quint64 m_memoryReporter;
+};
+
+#endif // QUICKOPENDIALOG_H
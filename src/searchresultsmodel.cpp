@@ -0,0 +1,98 @@
+#include "searchresultsmodel.h"
+#include "memoryregistry.h"
+
+#include <QDir>
+
+using namespace Qt::Literals::StringLiterals;
+
+SearchResultsModel::SearchResultsModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_matches()
+    , m_rootDirectory()
+    , m_memoryReporter(0)
+{
+    m_memoryReporter = MemoryRegistry::instance()->add(QStringLiteral("Search results"), [this]() {
+        qint64 bytes = m_matches.capacity() * qint64(sizeof(ContentSearch::Match));
+        for (const ContentSearch::Match &match : std::as_const(m_matches)) {
+            // Matches from one file share its path, so only the line text is counted per match
+            bytes += MemoryRegistry::stringBytes(match.lineText);
+        }
+        return MemoryRegistry::Usage{bytes, m_matches.size()};
+    });
+}
+
+SearchResultsModel::~SearchResultsModel()
+{
+    MemoryRegistry::instance()->remove(m_memoryReporter);
+}
+
+void SearchResultsModel::setRootDirectory(const QString &rootDirectory)
+{
+    beginResetModel();
+    m_rootDirectory = rootDirectory.isEmpty() || rootDirectory.endsWith(u'/') ? rootDirectory : rootDirectory + u'/';
+    endResetModel();
+}
+
+int SearchResultsModel::appendMatches(const QList<ContentSearch::Match> &matches)
+{
+    const int count = int(qMin(matches.size(), qsizetype(MaxResults) - m_matches.size()));
+    if (count <= 0) {
+        return 0;
+    }
+
+    beginInsertRows(QModelIndex(), int(m_matches.size()), int(m_matches.size()) + count - 1);
+    m_matches.append(matches.first(count));
+    endInsertRows();
+    return count;
+}
+
+void SearchResultsModel::clear()
+{
+    beginResetModel();
+    m_matches.clear();
+    m_matches.squeeze();
+    endResetModel();
+}
+
+bool SearchResultsModel::isFull() const
+{
+    return m_matches.size() >= MaxResults;
+}
+
+const ContentSearch::Match *SearchResultsModel::match(int row) const
+{
+    if (row < 0 || row >= m_matches.size()) {
+        return nullptr;
+    }
+    return &m_matches.at(row);
+}
+
+int SearchResultsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_matches.size());
+}
+
+QVariant SearchResultsModel::data(const QModelIndex &index, int role) const
+{
+    const ContentSearch::Match *result = index.isValid() ? match(index.row()) : nullptr;
+    if (!result) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return QStringLiteral("%1:%2: %3").arg(displayPath(result->filePath)).arg(result->line + 1).arg(result->lineText.trimmed());
+    case Qt::ToolTipRole:
+        return QStringLiteral("%1:%2").arg(QDir::toNativeSeparators(result->filePath)).arg(result->line + 1);
+    default:
+        return QVariant();
+    }
+}
+
+QString SearchResultsModel::displayPath(const QString &filePath) const
+{
+    if (!m_rootDirectory.isEmpty() && filePath.startsWith(m_rootDirectory)) {
+        return filePath.mid(m_rootDirectory.size());
+    }
+    return filePath;
+}
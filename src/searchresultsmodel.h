@@ -0,0 +1,45 @@
+#ifndef SEARCHRESULTSMODEL_H
+#define SEARCHRESULTSMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+
+#include "contentsearch.h"
+
+/**
+ * @brief Matching lines of a content search, appended as the search finds them
+ *
+ * Rows read "path:line: text" with the path relative to the searched
+ * directory. The list stops growing at MaxResults so a pattern matching
+ * nearly every line cannot bury the view.
+ */
+class SearchResultsModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MaxResults = 10000;
+
+    explicit SearchResultsModel(QObject *parent = nullptr);
+    ~SearchResultsModel() override;
+
+    // Paths under rootDirectory are shown relative to it
+    void setRootDirectory(const QString &rootDirectory);
+    // Returns how many of the matches were kept
+    int appendMatches(const QList<ContentSearch::Match> &matches);
+    void clear();
+    bool isFull() const;
+    const ContentSearch::Match *match(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    QString displayPath(const QString &filePath) const;
+
+    QList<ContentSearch::Match> m_matches;
+    QString m_rootDirectory;
+    quint64 m_memoryReporter;
+};
+
+#endif // SEARCHRESULTSMODEL_H
@@ -0,0 +1,94 @@
+#include "startupprofiler.h"
+#include "dotfilemanager.h"
+#include "logger.h"
+
+#include <QApplication>
+#include <QEvent>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+#include <QWidget>
+
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+// Give up on a stuck chezmoi rather than hang a benchmark run forever
+constexpr int MeasurementTimeoutMs = 120000;
+}
+
+StartupProfiler::StartupProfiler(const QElapsedTimer &startTimer, QWidget *window, DotfileManager *model, QObject *parent)
+    : QObject(parent)
+    , m_startTimer(startTimer)
+    , m_window(window)
+    , m_model(model)
+    , m_firstPaintMs(-1)
+    , m_treePopulatedMs(-1)
+    , m_statusesResolvedMs(-1)
+    , m_reported(false)
+{
+    // The first paint may land on any child of the window, so watch them all until it happens
+    qApp->installEventFilter(this);
+    connect(m_model, &DotfileManager::filesRefreshed, this, &StartupProfiler::onFilesRefreshed);
+    connect(m_model, &DotfileManager::statusesRefreshed, this, &StartupProfiler::onStatusesRefreshed);
+    QTimer::singleShot(MeasurementTimeoutMs, this, &StartupProfiler::onTimeout);
+}
+
+bool StartupProfiler::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Paint && m_firstPaintMs < 0 && watched->isWidgetType()
+        && static_cast<QWidget *>(watched)->window() == m_window) {
+        m_firstPaintMs = m_startTimer.elapsed();
+        qApp->removeEventFilter(this);
+        finishIfComplete();
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void StartupProfiler::onFilesRefreshed()
+{
+    if (m_treePopulatedMs < 0) {
+        m_treePopulatedMs = m_startTimer.elapsed();
+    }
+}
+
+void StartupProfiler::onStatusesRefreshed()
+{
+    if (m_statusesResolvedMs < 0) {
+        m_statusesResolvedMs = m_startTimer.elapsed();
+    }
+    finishIfComplete();
+}
+
+void StartupProfiler::onTimeout()
+{
+    report(true);
+}
+
+void StartupProfiler::finishIfComplete()
+{
+    if (m_firstPaintMs >= 0 && m_treePopulatedMs >= 0 && m_statusesResolvedMs >= 0) {
+        report(false);
+    }
+}
+
+void StartupProfiler::report(bool timedOut)
+{
+    if (m_reported) {
+        return;
+    }
+    m_reported = true;
+
+    QJsonObject result;
+    result.insert("firstPaintMs"_L1, m_firstPaintMs);
+    result.insert("treePopulatedMs"_L1, m_treePopulatedMs);
+    result.insert("statusesResolvedMs"_L1, m_statusesResolvedMs);
+    result.insert("files"_L1, m_model->fileCount());
+    result.insert("timedOut"_L1, timedOut);
+
+    const QByteArray json = QJsonDocument(result).toJson(QJsonDocument::Compact);
+    LOG_INFO(QStringLiteral("Startup timings: %1").arg(QString::fromUtf8(json)));
+    QTextStream(stdout) << json << Qt::endl;
+
+    QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+}
@@ -0,0 +1,45 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+
+class QWidget;
+class DotfileManager;
+
+/**
+ * @brief Times the startup milestones for --measure-startup
+ *
+ * Records when the main window first paints, when the file tree is populated
+ * and when file statuses have resolved, all relative to process start. Prints
+ * them to stdout as one JSON object and quits the application.
+ */
+class StartupProfiler : public QObject
+{
+    Q_OBJECT
+
+public:
+    StartupProfiler(const QElapsedTimer &startTimer, QWidget *window, DotfileManager *model, QObject *parent = nullptr);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private Q_SLOTS:
+    void onFilesRefreshed();
+    void onStatusesRefreshed();
+    void onTimeout();
+
+private:
+    void finishIfComplete();
+    void report(bool timedOut);
+
+    QElapsedTimer m_startTimer;
+    QWidget *m_window;
+    DotfileManager *m_model;
+    qint64 m_firstPaintMs;
+    qint64 m_treePopulatedMs;
+    qint64 m_statusesResolvedMs;
+    bool m_reported;
+};
+
+#endif // STARTUPPROFILER_H
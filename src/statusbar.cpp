@@ -1,10 +1,12 @@
 #include "statusbar.h"
 #include "chezmoiservice.h"
+#include "gitstatuswatcher.h"
 
 #include <QLabel>
+#include <QProgressBar>
 #include <QStatusBar>
-#include <QProcess>
 #include <QTimer>
+#include <KFormat>
 #include <KLocalizedString>
 
 using namespace Qt::Literals::StringLiterals;
@@ -16,16 +18,26 @@ StatusBar::StatusBar(QStatusBar *statusBar, ChezmoiService *chezmoiService, QWid
     , m_statusLeft(nullptr)
     , m_statusCenter(nullptr)
     , m_statusRight(nullptr)
-    , m_gitUpdateTimer(std::make_unique<QTimer>(this))
+    , m_progressBar(nullptr)
+    , m_gitWatcher(new GitStatusWatcher(chezmoiService, this))
+    , m_relativeTimeTimer(std::make_unique<QTimer>(this))
 {
     setupStatusWidgets();
     
-    // Setup timer for periodic git status updates
-    connect(m_gitUpdateTimer.get(), &QTimer::timeout, this, &StatusBar::onGitStatusTimer);
-    m_gitUpdateTimer->start(300000); // Update every 300 seconds
+    // Git state is pushed by the watcher; this timer only re-renders "x minutes ago" without touching git
+    connect(m_gitWatcher, &GitStatusWatcher::summaryChanged, this, &StatusBar::onGitSummaryChanged);
+    connect(m_relativeTimeTimer.get(), &QTimer::timeout, this, &StatusBar::onRelativeTimeTimer);
+    m_relativeTimeTimer->start(60000);
     
-    // Initial update
-    updateGitStatus();
+    // Bulk add, forget and apply report per-file progress until the last chezmoi run finishes
+    if (m_chezmoiService) {
+        connect(m_chezmoiService, &ChezmoiService::progressUpdated, this, &StatusBar::onProgressUpdated);
+        connect(m_chezmoiService, &ChezmoiService::operationCompleted, this, &StatusBar::onOperationCompleted);
+        connect(m_chezmoiService, &ChezmoiService::bulkCompleted, this, &StatusBar::onOperationCompleted);
+    }
+    
+    // Git can wait until the window has been shown
+    QTimer::singleShot(0, this, &StatusBar::updateGitStatus);
 }
 
 StatusBar::~StatusBar() = default;
@@ -36,6 +48,10 @@ void StatusBar::setupStatusWidgets()
     m_statusLeft = new QLabel(this);
     m_statusCenter = new QLabel(this);
     m_statusRight = new QLabel(this);
+    m_progressBar = new QProgressBar(this);
+    m_progressBar->setRange(0, 100);
+    m_progressBar->setMaximumWidth(150);
+    m_progressBar->hide();
     
     // Set initial text - swapped left and right
     m_statusLeft->setText(i18n("Git: Loading..."));
@@ -45,6 +61,7 @@ void StatusBar::setupStatusWidgets()
     // Add to status bar
     m_statusBar->addWidget(m_statusLeft, 1);
     m_statusBar->addPermanentWidget(m_statusCenter, 1);
+    m_statusBar->addPermanentWidget(m_progressBar, 0);
     m_statusBar->addPermanentWidget(m_statusRight, 0);
 }
 
@@ -68,44 +85,76 @@ void StatusBar::updateGitStatus()
         return;
     }
     
-    QString gitInfo = getGitInfo();
-    m_statusLeft->setText(gitInfo);
+    m_gitWatcher->refresh();
+}
+
+void StatusBar::onGitSummaryChanged(const GitSummary &summary)
+{
+    if (!m_statusLeft) {
+        return;
+    }
+    
+    m_statusLeft->setText(formatGitInfo(summary));
+    
+    if (summary.valid && !summary.shortHash.isEmpty()) {
+        m_statusLeft->setToolTip(i18n("%1\n%2", summary.subject, summary.repositoryPath));
+    } else {
+        m_statusLeft->setToolTip(summary.repositoryPath);
+    }
 }
 
-void StatusBar::onGitStatusTimer()
+void StatusBar::onRelativeTimeTimer()
 {
-    updateGitStatus();
+    if (m_statusLeft && m_gitWatcher->summary().valid) {
+        m_statusLeft->setText(formatGitInfo(m_gitWatcher->summary()));
+    }
 }
 
-QString StatusBar::getGitInfo()
+void StatusBar::onProgressUpdated(int percentage)
+{
+    m_progressBar->setValue(percentage);
+    m_progressBar->show();
+    m_statusRight->setText(i18n("Working..."));
+}
+
+void StatusBar::onOperationCompleted(bool success, const QString &message)
+{
+    m_progressBar->hide();
+    m_statusRight->setText(success ? i18n("Ready") : i18n("Failed"));
+    m_statusRight->setToolTip(success ? QString() : message);
+}
+
+QString StatusBar::formatGitInfo(const GitSummary &summary) const
 {
     if (!m_chezmoiService) {
         return i18n("Git: Service unavailable");
     }
     
-    QString chezmoiDir = m_chezmoiService->getChezmoiDirectory();
-    
-    // Get the last commit hash and time
-    QProcess gitProcess;
-    gitProcess.setWorkingDirectory(chezmoiDir);
+    if (!summary.valid) {
+        return i18n("Git: Not available");
+    }
     
-    // Get short commit hash and relative time
-    gitProcess.start("git"_L1, {
-        "log"_L1, "-1"_L1, "--format=%h|%ar"_L1
-    });
+    QStringList parts;
     
-    if (gitProcess.waitForFinished(3000) && gitProcess.exitCode() == 0) {
-        QString output = QString::fromUtf8(gitProcess.readAllStandardOutput()).trimmed();
-        QStringList parts = output.split('|'_L1);
-        
-        if (parts.size() == 2) {
-            QString hash = parts[0];
-            QString timeAgo = parts[1];
-            return QStringLiteral("%2 • %1").arg(hash, timeAgo);
-        } else {
-            return i18n("Git: No commits");
+    if (!summary.branch.isEmpty()) {
+        QString branch = summary.branch;
+        if (summary.hasUpstream && (summary.ahead > 0 || summary.behind > 0)) {
+            branch += QStringLiteral(" ↑%1 ↓%2").arg(summary.ahead).arg(summary.behind);
         }
+        parts << branch;
+    }
+    
+    if (summary.dirtyFiles > 0) {
+        parts << i18np("%1 changed file", "%1 changed files", summary.dirtyFiles);
+    }
+    
+    if (summary.shortHash.isEmpty()) {
+        parts << i18n("No commits");
     } else {
-        return i18n("Git: Not available");
+        KFormat format;
+        QString timeAgo = format.formatRelativeDateTime(summary.commitTime, QLocale::ShortFormat);
+        parts << QStringLiteral("%2 • %1").arg(summary.shortHash, timeAgo);
     }
+    
+    return parts.join(" • "_L1);
 }
@@ -5,7 +5,10 @@
 #include <QTimer>
 #include <memory>
 
+#include "gitstatuswatcher.h"
+
 class QLabel;
+class QProgressBar;
 class QStatusBar;
 class ChezmoiService;
 
@@ -22,11 +25,14 @@ public:
     void updateGitStatus();
 
 private Q_SLOTS:
-    void onGitStatusTimer();
+    void onGitSummaryChanged(const GitSummary &summary);
+    void onRelativeTimeTimer();
+    void onProgressUpdated(int percentage);
+    void onOperationCompleted(bool success, const QString &message);
 
 private:
     void setupStatusWidgets();
-    QString getGitInfo();
+    QString formatGitInfo(const GitSummary &summary) const;
 
     QStatusBar *m_statusBar;
     ChezmoiService *m_chezmoiService;
@@ -34,8 +40,10 @@ private:
     QLabel *m_statusLeft;
     QLabel *m_statusCenter;
     QLabel *m_statusRight;
+    QProgressBar *m_progressBar;
     
-    std::unique_ptr<QTimer> m_gitUpdateTimer;
+    GitStatusWatcher *m_gitWatcher;
+    std::unique_ptr<QTimer> m_relativeTimeTimer;
 };
 
 #endif // STATUSBAR_H
@@ -0,0 +1,127 @@
+// A stand-in for chezmoi that replays scripted output, for tests and benchmarks.
+//
+// Everything is read from the directory named by FAKE_CHEZMOI_DIR:
+//
+//   <command>.out           written to standard output ("managed.out", "status.out", ...)
+//   <command>.<value>.out   instead of <command>.out when --<option>=<value> is passed ("managed.source-relative.out")
+//   <command>.err           written to standard error
+//   cat/<target path>       output of 'cat <target path>', instead of cat.out
+//   fakechezmoi.ini         per-command behaviour, in a group named after the command:
+//       latencyMs=N         sleep before answering
+//       jitterMs=N          plus a random 0..N ms, reproducible through seed=N
+//       exitCode=N          exit with N after writing the output
+//       failEvery=N         exit with 1 on every Nth run of the command
+//       repeat=N            write the output N times, for huge outputs
+//       chunkBytes=N        flush output in pieces of N bytes, pausing chunkDelayMs=N between them
+//   spawns.log              one line is appended per run: the command and its arguments
+//
+// Missing files mean empty output and success, so only what a test needs has to be scripted.
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSettings>
+#include <QThread>
+
+#include <cstdio>
+
+namespace {
+
+// Runs of the command so far, including this one, counted from spawns.log
+int recordSpawn(const QDir &dir, const QStringList &arguments)
+{
+    QFile log(dir.filePath(QStringLiteral("spawns.log")));
+    if (!log.open(QIODevice::ReadWrite | QIODevice::Append | QIODevice::Text)) {
+        return 1;
+    }
+    const QByteArray command = arguments.value(0).toUtf8();
+    log.seek(0);
+    int runs = 1;
+    while (!log.atEnd()) {
+        const QByteArray line = log.readLine();
+        if (line.split(' ').value(0).trimmed() == command) {
+            ++runs;
+        }
+    }
+    log.write(arguments.join(u' ').toUtf8() + '\n');
+    return runs;
+}
+
+void writeOutput(FILE *stream, const QByteArray &data, int repeat, int chunkBytes, int chunkDelayMs)
+{
+    for (int i = 0; i < repeat; ++i) {
+        if (chunkBytes <= 0) {
+            std::fwrite(data.constData(), 1, size_t(data.size()), stream);
+            continue;
+        }
+        for (qsizetype offset = 0; offset < data.size(); offset += chunkBytes) {
+            std::fwrite(data.constData() + offset, 1, size_t(qMin<qsizetype>(chunkBytes, data.size() - offset)), stream);
+            std::fflush(stream);
+            QThread::msleep(chunkDelayMs);
+        }
+    }
+    std::fflush(stream);
+}
+
+QByteArray readFile(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList arguments = app.arguments().mid(1);
+    const QString command = arguments.value(0);
+
+    const QString dirPath = qEnvironmentVariable("FAKE_CHEZMOI_DIR");
+    if (dirPath.isEmpty() || command.isEmpty()) {
+        std::fputs("fakechezmoi: set FAKE_CHEZMOI_DIR and pass a command\n", stderr);
+        return 2;
+    }
+    const QDir dir(dirPath);
+    const int run = recordSpawn(dir, arguments);
+
+    QSettings settings(dir.filePath(QStringLiteral("fakechezmoi.ini")), QSettings::IniFormat);
+    settings.beginGroup(command);
+
+    int latencyMs = settings.value(QStringLiteral("latencyMs"), 0).toInt();
+    const int jitterMs = settings.value(QStringLiteral("jitterMs"), 0).toInt();
+    if (jitterMs > 0) {
+        QRandomGenerator random(settings.value(QStringLiteral("seed"), 1).toUInt() + quint32(run));
+        latencyMs += random.bounded(jitterMs + 1);
+    }
+    QThread::msleep(latencyMs);
+
+    QString outputName = command + QStringLiteral(".out");
+    for (const QString &argument : arguments) {
+        const qsizetype equals = argument.indexOf(u'=');
+        const QString variant = command + u'.' + argument.mid(equals + 1) + QStringLiteral(".out");
+        if (argument.startsWith(QLatin1String("--")) && equals > 0 && dir.exists(variant)) {
+            outputName = variant;
+            break;
+        }
+    }
+
+    QByteArray output;
+    if (command == QLatin1String("cat") && arguments.size() > 1 && dir.exists(QStringLiteral("cat/") + arguments.at(1))) {
+        output = readFile(dir.filePath(QStringLiteral("cat/") + arguments.at(1)));
+    } else {
+        output = readFile(dir.filePath(outputName));
+    }
+
+    writeOutput(stdout, output, settings.value(QStringLiteral("repeat"), 1).toInt(),
+                settings.value(QStringLiteral("chunkBytes"), 0).toInt(),
+                settings.value(QStringLiteral("chunkDelayMs"), 0).toInt());
+    writeOutput(stderr, readFile(dir.filePath(command + QStringLiteral(".err"))), 1, 0, 0);
+
+    const int failEvery = settings.value(QStringLiteral("failEvery"), 0).toInt();
+    if (failEvery > 0 && run % failEvery == 0) {
+        return 1;
+    }
+    return settings.value(QStringLiteral("exitCode"), 0).toInt();
+}
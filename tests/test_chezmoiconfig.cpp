@@ -0,0 +1,217 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include "chezmoiconfig.h"
+
+class TestChezmoiConfig : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testParseValues();
+    void testRoundTrip();
+    void testEditInPlace();
+    void testInsertKeys();
+    void testSave();
+    void testUnsupportedConfigs();
+    void testAccessorDefaults();
+
+private:
+    static const QString s_sample;
+};
+
+const QString TestChezmoiConfig::s_sample = QStringLiteral(
+    "# chezmoi configuration\n"
+    "sourceDir = \"~/dotfiles\"  # kept in git\n"
+    "umask = 0o022\n"
+    "\n"
+    "[data]\n"
+    "    email = 'me@example.com'\n"
+    "    packages = [\n"
+    "        \"vim\", # editor\n"
+    "        \"tmux\",\n"
+    "    ]\n"
+    "    motd = \"\"\"\n"
+    "Hello \\\n"
+    "    world\"\"\"\n"
+    "\n"
+    "[git]\n"
+    "    autoCommit = true\n"
+    "    autoPush = false # not yet\n"
+    "\n"
+    "[[textconv]]\n"
+    "    pattern = \"**/*.plist\"\n"
+    "\n"
+    "[diff]\n"
+    "    pager.command = \"delta\"\n"
+    "    exclude = { scripts = true }\n");
+
+void TestChezmoiConfig::testParseValues()
+{
+    ChezmoiConfig config;
+    QVERIFY(config.loadFromData(s_sample));
+    QVERIFY(config.isValid());
+
+    QCOMPARE(config.value(QStringLiteral("sourceDir")).toString(), QStringLiteral("~/dotfiles"));
+    QCOMPARE(config.value(QStringLiteral("umask")).toLongLong(), qlonglong(022));
+    QCOMPARE(config.value(QStringLiteral("data.email")).toString(), QStringLiteral("me@example.com"));
+    QCOMPARE(config.value(QStringLiteral("data.motd")).toString(), QStringLiteral("Hello world"));
+    QCOMPARE(config.value(QStringLiteral("diff.pager.command")).toString(), QStringLiteral("delta"));
+
+    // Lookups ignore case, like chezmoi's own
+    QCOMPARE(config.value(QStringLiteral("GIT.AUTOCOMMIT")).toBool(), true);
+    QVERIFY(config.gitAutoCommit());
+    QVERIFY(!config.gitAutoPush());
+
+    // Arrays, inline tables and arrays of tables are kept but not exposed
+    QVERIFY(config.contains(QStringLiteral("data.packages")));
+    QVERIFY(!config.value(QStringLiteral("data.packages")).isValid());
+    QVERIFY(!config.contains(QStringLiteral("textconv.pattern")));
+}
+
+void TestChezmoiConfig::testRoundTrip()
+{
+    ChezmoiConfig config;
+    QVERIFY(config.loadFromData(s_sample));
+    QCOMPARE(config.toData(), s_sample);
+
+    const QString noTrailingNewline = QStringLiteral("destDir = \"/srv/home\"\r\n[git]\r\nautoPush = true");
+    QVERIFY(config.loadFromData(noTrailingNewline));
+    QCOMPARE(config.toData(), noTrailingNewline);
+    QCOMPARE(config.destDir(), QStringLiteral("/srv/home"));
+}
+
+void TestChezmoiConfig::testEditInPlace()
+{
+    ChezmoiConfig config;
+    QVERIFY(config.loadFromData(s_sample));
+    const quint64 generation = config.generation();
+
+    config.setValue(QStringLiteral("git.autoPush"), true);
+    config.setValue(QStringLiteral("sourceDir"), QStringLiteral("/data/\"dots\""));
+    QVERIFY(config.hasPendingChanges());
+    QVERIFY(config.generation() > generation);
+
+    QString expected = s_sample;
+    expected.replace(QStringLiteral("autoPush = false # not yet"), QStringLiteral("autoPush = true # not yet"));
+    expected.replace(QStringLiteral("sourceDir = \"~/dotfiles\"  # kept in git"),
+                     QStringLiteral("sourceDir = \"/data/\\\"dots\\\"\"  # kept in git"));
+    QCOMPARE(config.toData(), expected);
+    QCOMPARE(config.sourceDir(), QStringLiteral("/data/\"dots\""));
+
+    // Setting the current value is not an edit
+    ChezmoiConfig unchanged;
+    QVERIFY(unchanged.loadFromData(s_sample));
+    unchanged.setValue(QStringLiteral("git.autoCommit"), true);
+    QVERIFY(!unchanged.hasPendingChanges());
+}
+
+void TestChezmoiConfig::testInsertKeys()
+{
+    ChezmoiConfig config;
+    QVERIFY(config.loadFromData(QStringLiteral(
+        "# top\n"
+        "[git]\n"
+        "    autoCommit = true\n"
+        "\n"
+        "[edit]\n"
+        "    command = \"vim\"\n")));
+
+    config.setValue(QStringLiteral("git.commitMessageTemplate"), QStringLiteral("update"));
+    config.setValue(QStringLiteral("destDir"), QStringLiteral("~"));
+    config.setValue(QStringLiteral("template.leftDelimiter"), QStringLiteral("[["));
+
+    QCOMPARE(config.toData(), QStringLiteral(
+        "# top\n"
+        "destDir = \"~\"\n"
+        "\n"
+        "[git]\n"
+        "    autoCommit = true\n"
+        "commitMessageTemplate = \"update\"\n"
+        "\n"
+        "[edit]\n"
+        "    command = \"vim\"\n"
+        "\n"
+        "[template]\n"
+        "leftDelimiter = \"[[\"\n"));
+
+    QCOMPARE(config.gitCommitMessageTemplate(), QStringLiteral("update"));
+    QCOMPARE(config.destDir(), QDir::homePath());
+    QCOMPARE(config.leftDelimiter(), QStringLiteral("[["));
+    QCOMPARE(config.rightDelimiter(), QStringLiteral("}}"));
+}
+
+void TestChezmoiConfig::testSave()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("chezmoi/chezmoi.toml"));
+
+    ChezmoiConfig config;
+    QVERIFY(config.load(path));
+    QVERIFY(config.toData().isEmpty());
+
+    QSignalSpy changedSpy(&config, &ChezmoiConfig::changed);
+
+    // Nothing to write yet
+    QVERIFY(config.save());
+    QVERIFY(!QFile::exists(path));
+    QCOMPARE(changedSpy.count(), 0);
+
+    config.setValue(QStringLiteral("git.autoPush"), true);
+    config.setValue(QStringLiteral("sourceDir"), QStringLiteral("/tmp/source"));
+    QVERIFY(config.save());
+    QVERIFY(!config.hasPendingChanges());
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(changedSpy.first().first().toStringList(), QStringList({QStringLiteral("git.autopush"), QStringLiteral("sourcedir")}));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(QString::fromUtf8(file.readAll()), QStringLiteral("sourceDir = \"/tmp/source\"\n\n[git]\nautoPush = true\n"));
+
+    ChezmoiConfig reloaded;
+    QVERIFY(reloaded.load(path));
+    QVERIFY(reloaded.gitAutoPush());
+    QCOMPARE(reloaded.sourceDir(), QStringLiteral("/tmp/source"));
+}
+
+void TestChezmoiConfig::testUnsupportedConfigs()
+{
+    ChezmoiConfig config;
+    QVERIFY(!config.loadFromData(QStringLiteral("[git]\nautoPush true\n")));
+    QVERIFY(!config.isValid());
+    QVERIFY(!config.loadFromData(QStringLiteral("a = 1\na = 2\n")));
+
+    // A YAML configuration is chezmoi's to read
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QFile yaml(dir.filePath(QStringLiteral("chezmoi.yaml")));
+    QVERIFY(yaml.open(QIODevice::WriteOnly));
+    yaml.write("sourceDir: /somewhere\n");
+    yaml.close();
+
+    QVERIFY(!config.load(dir.filePath(QStringLiteral("chezmoi.toml"))));
+    config.setValue(QStringLiteral("git.autoPush"), true);
+    QVERIFY(!config.save());
+    QVERIFY(!QFile::exists(dir.filePath(QStringLiteral("chezmoi.toml"))));
+}
+
+void TestChezmoiConfig::testAccessorDefaults()
+{
+    ChezmoiConfig config;
+    QVERIFY(config.loadFromData(QString()));
+
+    QVERIFY(config.sourceDir().endsWith(QStringLiteral("/chezmoi")));
+    QCOMPARE(config.workingTree(), config.sourceDir());
+    QCOMPARE(config.destDir(), QDir::homePath());
+    QCOMPARE(config.leftDelimiter(), QStringLiteral("{{"));
+    QVERIFY(!config.gitAutoCommit());
+    QVERIFY(config.gitCommitMessageTemplate().isEmpty());
+
+    QVERIFY(config.loadFromData(QStringLiteral("sourceDir = \"~/dots/../dotfiles\"\n")));
+    QCOMPARE(config.sourceDir(), QDir::homePath() + QStringLiteral("/dotfiles"));
+    QCOMPARE(config.workingTree(), config.sourceDir());
+}
+
+QTEST_GUILESS_MAIN(TestChezmoiConfig)
+#include "test_chezmoiconfig.moc"
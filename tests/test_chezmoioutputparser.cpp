@@ -0,0 +1,104 @@
+#include <QtTest/QtTest>
+#include "chezmoioutputparser.h"
+
+class TestChezmoiOutputParser : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testSplitAcrossChunks();
+    void testLineEndings();
+    void testParseStatusLine();
+    void testParseStatus();
+    void testParseDiffLine();
+    void testParseErrorLine();
+};
+
+void TestChezmoiOutputParser::testSplitAcrossChunks()
+{
+    ChezmoiOutputParser parser;
+    QList<QByteArray> lines;
+    auto collect = [&lines](QByteArrayView line) { lines.append(line.toByteArray()); };
+
+    parser.feed("first\nsec", collect);
+    QCOMPARE(lines.size(), qsizetype(1));
+    parser.feed("on", collect);
+    QCOMPARE(lines.size(), qsizetype(1));
+    parser.feed("d\nthird\n", collect);
+    parser.finish(collect);
+
+    QCOMPARE(lines, QList<QByteArray>({"first", "second", "third"}));
+}
+
+void TestChezmoiOutputParser::testLineEndings()
+{
+    ChezmoiOutputParser parser;
+    QList<QByteArray> lines;
+    auto collect = [&lines](QByteArrayView line) { lines.append(line.toByteArray()); };
+
+    // CRLF split between two chunks, and no newline after the last line
+    parser.feed("one\r", collect);
+    parser.feed("\ntwo\r\n\nlast", collect);
+    QCOMPARE(lines, QList<QByteArray>({"one", "two", ""}));
+
+    parser.finish(collect);
+    QCOMPARE(lines.last(), QByteArray("last"));
+
+    // Nothing is left over after finish()
+    parser.finish(collect);
+    QCOMPARE(lines.size(), qsizetype(4));
+}
+
+void TestChezmoiOutputParser::testParseStatusLine()
+{
+    QByteArrayView path;
+    ChezmoiStatus status;
+
+    QVERIFY(ChezmoiOutputParser::parseStatusLine(" M .bashrc", &path, &status));
+    QCOMPARE(path, QByteArrayView(".bashrc"));
+    QCOMPARE(status, ChezmoiStatus(ChezmoiStatus::NoChange, ChezmoiStatus::Modified));
+
+    QVERIFY(ChezmoiOutputParser::parseStatusLine("MA .config/my file.conf ", &path, &status));
+    QCOMPARE(path, QByteArrayView(".config/my file.conf"));
+    QVERIFY(status.isConflict());
+
+    QVERIFY(!ChezmoiOutputParser::parseStatusLine(" M", &path, &status));
+    QVERIFY(!ChezmoiOutputParser::parseStatusLine(" M    ", &path, &status));
+
+    QCOMPARE(ChezmoiOutputParser::parseManagedLine("  .vimrc \t"), QByteArrayView(".vimrc"));
+}
+
+void TestChezmoiOutputParser::testParseStatus()
+{
+    const QHash<QString, ChezmoiStatus> statuses = ChezmoiOutputParser::parseStatus(
+        " M .bashrc\r\n"
+        " A .config/nvim/init.lua\n"
+        "\n"
+        "R  .chezmoiscripts/install.sh");
+
+    QCOMPARE(statuses.size(), qsizetype(3));
+    QCOMPARE(statuses.value(QStringLiteral(".bashrc")), ChezmoiStatus(ChezmoiStatus::NoChange, ChezmoiStatus::Modified));
+    QCOMPARE(statuses.value(QStringLiteral(".config/nvim/init.lua")).targetChange(), ChezmoiStatus::Added);
+    QCOMPARE(statuses.value(QStringLiteral(".chezmoiscripts/install.sh")).actualChange(), ChezmoiStatus::Run);
+}
+
+void TestChezmoiOutputParser::testParseDiffLine()
+{
+    QCOMPARE(ChezmoiOutputParser::parseDiffLine("diff --git a/dot_bashrc b/dot_bashrc"), QByteArrayView("dot_bashrc"));
+    QCOMPARE(ChezmoiOutputParser::parseDiffLine("diff --git a/dot_config/my file b/dot_config/my file"),
+             QByteArrayView("dot_config/my file"));
+    QVERIFY(ChezmoiOutputParser::parseDiffLine("index 0000000..e69de29 100644").isEmpty());
+    QVERIFY(ChezmoiOutputParser::parseDiffLine("+diff --git a/x b/x").isEmpty());
+    QVERIFY(ChezmoiOutputParser::parseDiffLine("diff --git a/x").isEmpty());
+}
+
+void TestChezmoiOutputParser::testParseErrorLine()
+{
+    QCOMPARE(ChezmoiOutputParser::parseErrorLine("chezmoi: /home/user/.zshrc: has changed since chezmoi last wrote it"),
+             QByteArrayView("/home/user/.zshrc"));
+    QVERIFY(ChezmoiOutputParser::parseErrorLine("chezmoi: template error").isEmpty());
+    QVERIFY(ChezmoiOutputParser::parseErrorLine("warning: .zshrc: something").isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestChezmoiOutputParser)
+#include "test_chezmoioutputparser.moc"
@@ -1,19 +1,83 @@
 #include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QtConcurrent/QtConcurrentRun>
+#include "chezmoiconfig.h"
 #include "chezmoiservice.h"
+#include "filewatcher.h"
+#include "ignorematcher.h"
 
 class TestChezmoiService : public QObject
 {
     Q_OBJECT
 
 private Q_SLOTS:
+    void initTestCase();
+    void init();
     void testExecutablePath();
     void testDirectoryPath();
     void testInitialization();
+    void testExecutableOverride();
+    void testManagedFiles();
+    void testManagedSourcePaths();
+    void testWatchedSourceEdit();
+    void testQueryFailures();
+    void testQueryCoalescing();
+    void testIgnoreMatcher();
+    void testTargetRelativePath_data();
+    void testTargetRelativePath();
+    void testChunkArguments();
+    void testBulkAdd();
+    void testBulkForget();
+    void testSelectiveApply();
 
 private:
+    void script(const QString &name, const QByteArray &contents);
+    QByteArrayList spawns() const;
+    ChezmoiService *createFakeService();
+
     ChezmoiService *service;
+    std::unique_ptr<QTemporaryDir> m_fakeDir;
 };
 
+void TestChezmoiService::initTestCase()
+{
+    // Keep the user's chezmoi config out of the way
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void TestChezmoiService::init()
+{
+    // A fresh script for the fake chezmoi in every test
+    m_fakeDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_fakeDir->isValid());
+    qputenv("FAKE_CHEZMOI_DIR", m_fakeDir->path().toLocal8Bit());
+}
+
+void TestChezmoiService::script(const QString &name, const QByteArray &contents)
+{
+    QFile file(m_fakeDir->filePath(name));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(contents);
+}
+
+QByteArrayList TestChezmoiService::spawns() const
+{
+    QFile log(m_fakeDir->filePath(QStringLiteral("spawns.log")));
+    if (!log.open(QIODevice::ReadOnly)) {
+        return QByteArrayList();
+    }
+    QByteArrayList lines = log.readAll().split('\n');
+    lines.removeAll(QByteArray());
+    return lines;
+}
+
+ChezmoiService *TestChezmoiService::createFakeService()
+{
+    ChezmoiService *fake = new ChezmoiService(QStringLiteral(FAKE_CHEZMOI_PATH), this);
+    fake->config()->loadFromData(QStringLiteral("sourceDir = \"%1/source\"\ndestDir = \"%1/home\"\n").arg(m_fakeDir->path()));
+    return fake;
+}
+
 void TestChezmoiService::testExecutablePath()
 {
     service = new ChezmoiService(this);
@@ -55,5 +119,424 @@ void TestChezmoiService::testInitialization()
     delete service;
 }
 
+void TestChezmoiService::testExecutableOverride()
+{
+    script(QStringLiteral("source-path.out"), "/src/dot_bashrc\n");
+    
+    // From the environment
+    qputenv("DOTWEAVER_CHEZMOI", FAKE_CHEZMOI_PATH);
+    service = new ChezmoiService(this);
+    qunsetenv("DOTWEAVER_CHEZMOI");
+    QCOMPARE(service->getSourcePath(QStringLiteral("/home/user/.bashrc")), QStringLiteral("/src/dot_bashrc"));
+    delete service;
+    
+    // From the constructor
+    service = new ChezmoiService(QStringLiteral(FAKE_CHEZMOI_PATH), this);
+    QCOMPARE(service->getSourcePath(QStringLiteral("/home/user/.bashrc")), QStringLiteral("/src/dot_bashrc"));
+    delete service;
+    
+    QCOMPARE(spawns(), QByteArrayList({"source-path /home/user/.bashrc", "source-path /home/user/.bashrc"}));
+}
+
+void TestChezmoiService::testManagedFiles()
+{
+    // chezmoi strips .tmpl from targets, so only the source listing tells templates apart
+    script(QStringLiteral("managed.out"), ".bashrc\n.config/kitty/kitty.conf\n.vimrc\n");
+    script(QStringLiteral("managed.source-relative.out"), "dot_bashrc\ndot_config/kitty/kitty.conf.tmpl\ndot_vimrc\n");
+    script(QStringLiteral("status.out"), " M .bashrc\nA  .vimrc\n");
+    // Small, slow chunks, so rows arrive while the fake is still writing
+    script(QStringLiteral("fakechezmoi.ini"), "[managed]\nchunkBytes=8\nchunkDelayMs=20\n");
+    
+    service = createFakeService();
+    int partialBatches = 0;
+    qsizetype partialFiles = 0;
+    const FileStatusBatch files = service->getManagedFiles(true, [&](const FileStatusBatch &partial) {
+        ++partialBatches;
+        partialFiles += partial.size();
+    });
+    
+    QCOMPARE(files.size(), qsizetype(3));
+    QCOMPARE(files.path(1).toString(), QStringLiteral(".config/kitty/kitty.conf"));
+    QVERIFY(files.isTemplate(1));
+    QVERIFY(!files.isTemplate(0) && !files.isTemplate(2));
+    QCOMPARE(files.sourcePath(1), service->getChezmoiDirectory() + QStringLiteral("/dot_config/kitty/kitty.conf.tmpl"));
+    QCOMPARE(files.status(0), ChezmoiStatus(ChezmoiStatus::NoChange, ChezmoiStatus::Modified));
+    QCOMPARE(files.status(2), ChezmoiStatus(ChezmoiStatus::Added, ChezmoiStatus::NoChange));
+    QVERIFY(files.status(1).isClean());
+    QVERIFY(partialBatches > 1);
+    QCOMPARE(partialFiles, qsizetype(3));
+    
+    delete service;
+}
+
+void TestChezmoiService::testManagedSourcePaths()
+{
+    // Source names carry chezmoi's attributes, so a source is never its target path under the source directory
+    const QDir source(m_fakeDir->filePath(QStringLiteral("source")));
+    QVERIFY(source.mkpath(QStringLiteral("private_dot_ssh")));
+    for (const char *name : {"dot_bashrc", "private_dot_ssh/config"}) {
+        QFile file(source.filePath(QString::fromUtf8(name)));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("Host *\n");
+    }
+    script(QStringLiteral("managed.out"), ".bashrc\n.ssh/config\n.external\n");
+    script(QStringLiteral("managed.source-relative.out"), "dot_bashrc\nprivate_dot_ssh/config\n");
+    
+    service = createFakeService();
+    const FileStatusBatch files = service->getManagedFiles(false);
+    QCOMPARE(files.size(), qsizetype(3));
+    QCOMPARE(files.sourcePath(0), source.filePath(QStringLiteral("dot_bashrc")));
+    QCOMPARE(files.sourcePath(1), source.filePath(QStringLiteral("private_dot_ssh/config")));
+    QVERIFY(files.sourceMetadata(0).exists());
+    QVERIFY(files.sourceMetadata(1).exists());
+    
+    // A target whose source chezmoi did not list has none, rather than a made-up one
+    QVERIFY(files.sourcePath(2).isEmpty());
+    
+    QCOMPARE(spawns().size(), qsizetype(2));
+    QVERIFY(spawns().contains("managed --exclude=dirs --path-style=source-relative"));
+    
+    delete service;
+}
+
+void TestChezmoiService::testWatchedSourceEdit()
+{
+    if (!FileWatcher().isAvailable()) {
+        QSKIP("No file system notifications on this platform");
+    }
+    
+    const QDir source(m_fakeDir->filePath(QStringLiteral("source")));
+    const QDir home(m_fakeDir->filePath(QStringLiteral("home")));
+    QVERIFY(source.mkpath(QStringLiteral(".")) && home.mkpath(QStringLiteral(".")));
+    for (const QString &path : {source.filePath(QStringLiteral("dot_bashrc")), source.filePath(QStringLiteral("dot_zshrc")),
+                                home.filePath(QStringLiteral(".bashrc")), home.filePath(QStringLiteral(".zshrc"))}) {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("# original\n");
+    }
+    script(QStringLiteral("status.out"), " M .bashrc\n");
+    
+    service = createFakeService();
+    service->watchManagedFiles({{QStringLiteral(".bashrc"), source.filePath(QStringLiteral("dot_bashrc"))},
+                                {QStringLiteral(".zshrc"), source.filePath(QStringLiteral("dot_zshrc"))}});
+    QSignalSpy statusSpy(service, &ChezmoiService::fileStatusChanged);
+    QSignalSpy changedSpy(service, &ChezmoiService::managedFilesChanged);
+    
+    // Editing an existing source updates its one row, without rescanning everything
+    {
+        QFile file(source.filePath(QStringLiteral("dot_bashrc")));
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write("# edited\n");
+    }
+    QTRY_COMPARE(statusSpy.size(), 1);
+    QCOMPARE(statusSpy.first().at(0).toString(), QStringLiteral(".bashrc"));
+    QCOMPARE(statusSpy.first().at(1).value<ChezmoiStatus>(), ChezmoiStatus(ChezmoiStatus::NoChange, ChezmoiStatus::Modified));
+    QCOMPARE(spawns(), QByteArrayList{"status " + home.filePath(QStringLiteral(".bashrc")).toUtf8()});
+    QTest::qWait(100);
+    QCOMPARE(statusSpy.size(), 1);
+    QVERIFY(changedSpy.isEmpty());
+    
+    delete service;
+}
+
+void TestChezmoiService::testQueryFailures()
+{
+    script(QStringLiteral("status.out"), " M .bashrc\n");
+    script(QStringLiteral("status.err"), "chezmoi: template: error\n");
+    script(QStringLiteral("source-path.out"), "/src/dot_bashrc\n");
+    script(QStringLiteral("fakechezmoi.ini"), "[status]\nexitCode=1\n[source-path]\nfailEvery=2\n");
+    
+    service = createFakeService();
+    
+    // Partial output of a failed run is not trusted
+    QVERIFY(service->getFileStatuses().isEmpty());
+    
+    QCOMPARE(service->getSourcePath(QStringLiteral("/home/user/.bashrc")), QStringLiteral("/src/dot_bashrc"));
+    QVERIFY(service->getSourcePath(QStringLiteral("/home/user/.bashrc")).isEmpty());
+    QCOMPARE(service->getSourcePath(QStringLiteral("/home/user/.bashrc")), QStringLiteral("/src/dot_bashrc"));
+    
+    delete service;
+}
+
+void TestChezmoiService::testQueryCoalescing()
+{
+    script(QStringLiteral("source-path.out"), "/src/dot_bashrc\n");
+    script(QStringLiteral("fakechezmoi.ini"), "[source-path]\nlatencyMs=500\n");
+    
+    service = createFakeService();
+    
+    // Identical queries issued while the first is still running share its process
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    QList<QFuture<QString>> results;
+    for (int i = 0; i < 4; ++i) {
+        results << QtConcurrent::run(&pool, [this]() {
+            return service->getSourcePath(QStringLiteral("/home/user/.bashrc"));
+        });
+    }
+    for (QFuture<QString> &result : results) {
+        QCOMPARE(result.result(), QStringLiteral("/src/dot_bashrc"));
+    }
+    
+    QVERIFY(service->savedQuerySpawns() > 0);
+    QCOMPARE(spawns().size() + service->savedQuerySpawns(), qint64(4));
+    
+    // Once it has finished, the next query runs chezmoi again
+    service->getSourcePath(QStringLiteral("/home/user/.bashrc"));
+    QCOMPARE(spawns().size() + service->savedQuerySpawns(), qint64(5));
+    
+    delete service;
+}
+
+void TestChezmoiService::testIgnoreMatcher()
+{
+    service = createFakeService();
+    QVERIFY(QDir().mkpath(m_fakeDir->filePath(QStringLiteral("source"))));
+    auto writeIgnore = [this](const QByteArray &contents) {
+        QFile file(m_fakeDir->filePath(QStringLiteral("source/.chezmoiignore")));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(contents);
+    };
+    
+    // A plain file is compiled as it is, without running chezmoi
+    writeIgnore("README.md\n*.txt\n");
+    std::shared_ptr<const IgnoreMatcher> matcher = service->ignoreMatcher();
+    QVERIFY(matcher);
+    QVERIFY(matcher->isIgnored(u"README.md"));
+    QVERIFY(!matcher->isIgnored(u".bashrc"));
+    QVERIFY(spawns().isEmpty());
+    
+    // A template is rendered once, then served from the cache until its contents change
+    writeIgnore("{{ if ne .chezmoi.os \"darwin\" }}\nLibrary\n{{ end }}\n");
+    script(QStringLiteral("execute-template.out"), "\nLibrary\n\n");
+    matcher = service->ignoreMatcher();
+    QVERIFY(matcher);
+    QVERIFY(matcher->isIgnored(u"Library/Preferences"));
+    QVERIFY(service->ignoreMatcher() == matcher);
+    QCOMPARE(spawns().size(), qsizetype(1));
+    QVERIFY(spawns().first().startsWith("execute-template --file "));
+    
+    writeIgnore("{{ if ne .chezmoi.os \"linux\" }}\n.config/systemd\n{{ end }}\n");
+    script(QStringLiteral("execute-template.out"), ".config/systemd\n");
+    matcher = service->ignoreMatcher();
+    QVERIFY(matcher->isIgnored(u".config/systemd/user"));
+    QVERIFY(!matcher->isIgnored(u"Library"));
+    QCOMPARE(spawns().size(), qsizetype(2));
+    
+    // A failed render is not cached as an empty file
+    writeIgnore("{{ broken\n");
+    script(QStringLiteral("fakechezmoi.ini"), "[execute-template]\nexitCode=1\n");
+    QVERIFY(!service->ignoreMatcher());
+    
+    delete service;
+}
+
+void TestChezmoiService::testTargetRelativePath_data()
+{
+    QTest::addColumn<QString>("source");
+    QTest::addColumn<QString>("target");
+    QTest::addColumn<bool>("isTemplate");
+    
+    QTest::newRow("plain") << QStringLiteral("README.md") << QStringLiteral("README.md") << false;
+    QTest::newRow("dot") << QStringLiteral("dot_bashrc") << QStringLiteral(".bashrc") << false;
+    QTest::newRow("template") << QStringLiteral("dot_gitconfig.tmpl") << QStringLiteral(".gitconfig") << true;
+    QTest::newRow("private dot directory") << QStringLiteral("private_dot_ssh/config") << QStringLiteral(".ssh/config") << false;
+    QTest::newRow("directory attributes") << QStringLiteral("exact_private_readonly_dot_gnupg/private_dot_keep")
+                                          << QStringLiteral(".gnupg/.keep") << false;
+    QTest::newRow("readonly") << QStringLiteral("private_readonly_dot_pgpass") << QStringLiteral(".pgpass") << false;
+    QTest::newRow("every file attribute") << QStringLiteral("dot_local/bin/encrypted_private_readonly_empty_executable_dot_tool.tmpl")
+                                          << QStringLiteral(".local/bin/.tool") << true;
+    QTest::newRow("encrypted") << QStringLiteral("encrypted_private_dot_netrc.age") << QStringLiteral(".netrc") << false;
+    QTest::newRow("encrypted template") << QStringLiteral("encrypted_dot_env.tmpl.asc") << QStringLiteral(".env") << true;
+    QTest::newRow("create") << QStringLiteral("create_private_dot_viminfo") << QStringLiteral(".viminfo") << false;
+    QTest::newRow("modify") << QStringLiteral("modify_executable_dot_profile.tmpl") << QStringLiteral(".profile") << true;
+    QTest::newRow("symlink") << QStringLiteral("symlink_dot_vim") << QStringLiteral(".vim") << false;
+    QTest::newRow("script") << QStringLiteral("run_once_before_install.sh") << QStringLiteral("install.sh") << false;
+    QTest::newRow("out of order") << QStringLiteral("dot_private_foo") << QStringLiteral(".private_foo") << false;
+    QTest::newRow("literal prefix") << QStringLiteral("literal_dot_foo") << QStringLiteral("dot_foo") << false;
+    QTest::newRow("literal after attribute") << QStringLiteral("private_literal_executable_x") << QStringLiteral("executable_x") << false;
+    QTest::newRow("literal suffix") << QStringLiteral("dot_notes.tmpl.literal") << QStringLiteral(".notes.tmpl") << false;
+}
+
+void TestChezmoiService::testTargetRelativePath()
+{
+    QFETCH(QString, source);
+    QFETCH(QString, target);
+    QFETCH(bool, isTemplate);
+    
+    bool templated = !isTemplate;
+    QCOMPARE(ChezmoiService::targetRelativePath(source, &templated), target);
+    QCOMPARE(templated, isTemplate);
+}
+
+void TestChezmoiService::testChunkArguments()
+{
+    QStringList paths;
+    for (int i = 0; i < 100; ++i) {
+        paths << QStringLiteral("/home/user/.config/app%1/settings.conf").arg(i, 2, 10, QChar(u'0'));
+    }
+    
+    // Every path takes the same room, so each run holds as many as the budget fits
+    const qsizetype perPath = paths.first().toLocal8Bit().size() + 1 + qsizetype(sizeof(char *));
+    const QList<QStringList> chunks = ChezmoiService::chunkArguments(paths, perPath * 30);
+    QCOMPARE(chunks.size(), qsizetype(4));
+    QCOMPARE(chunks.first().size(), qsizetype(30));
+    QCOMPARE(chunks.last().size(), qsizetype(10));
+    QStringList joined;
+    for (const QStringList &chunk : chunks) {
+        joined += chunk;
+    }
+    QCOMPARE(joined, paths);
+    
+    // A path longer than the budget still runs, on its own
+    QCOMPARE(ChezmoiService::chunkArguments(paths.mid(0, 3), 1).size(), qsizetype(3));
+    QVERIFY(ChezmoiService::chunkArguments(QStringList(), 1000).isEmpty());
+}
+
+void TestChezmoiService::testBulkAdd()
+{
+    const QDir home(m_fakeDir->filePath(QStringLiteral("home")));
+    QVERIFY(home.mkpath(QStringLiteral(".config/app")));
+    for (const char *name : {".bashrc", ".zshrc", ".config/app/a.conf", ".config/app/b.conf"}) {
+        QFile file(home.filePath(QString::fromUtf8(name)));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+    }
+    
+    // What --verbose prints: a diff per source file written, including each file of an added directory,
+    // named with the attributes chezmoi gave them
+    script(QStringLiteral("add.out"),
+           "diff --git a/dot_bashrc b/dot_bashrc\n"
+           "new file mode 100644\n"
+           "diff --git a/dot_zshrc.tmpl b/dot_zshrc.tmpl\n"
+           "diff --git a/dot_config/private_app/a.conf b/dot_config/private_app/a.conf\n"
+           "diff --git a/dot_config/private_app/executable_b.conf b/dot_config/private_app/executable_b.conf\n"
+           "diff --git a/dot_unrelated b/dot_unrelated\n");
+    script(QStringLiteral("status.out"), "MM .zshrc\n");
+    script(QStringLiteral("fakechezmoi.ini"), "[add]\nchunkBytes=40\nchunkDelayMs=20\n");
+    
+    service = createFakeService();
+    QSignalSpy progressSpy(service, &ChezmoiService::progressUpdated);
+    QSignalSpy addedSpy(service, &ChezmoiService::filesAdded);
+    QSignalSpy statusSpy(service, &ChezmoiService::fileStatusChanged);
+    QSignalSpy completedSpy(service, &ChezmoiService::bulkCompleted);
+    
+    QVERIFY(service->addFiles({home.filePath(QStringLiteral(".bashrc")), home.filePath(QStringLiteral(".zshrc")),
+                               home.filePath(QStringLiteral(".config/app"))}));
+    QVERIFY(service->isBulkRunning());
+    QVERIFY(completedSpy.wait(5000));
+    QVERIFY(completedSpy.first().at(0).toBool());
+    QVERIFY(!service->isBulkRunning());
+    
+    // One run for everything, reporting what it wrote; diffs outside what was asked for are not trusted
+    QVERIFY(spawns().first().startsWith("add --verbose "));
+    QCOMPARE(addedSpy.size(), 1);
+    const FileStatusBatch added = addedSpy.first().at(0).value<FileStatusBatch>();
+    QStringList addedPaths;
+    for (qsizetype i = 0; i < added.size(); ++i) {
+        addedPaths << added.path(i).toString();
+    }
+    QCOMPARE(addedPaths, (QStringList{QStringLiteral(".bashrc"), QStringLiteral(".config/app/a.conf"),
+                                      QStringLiteral(".config/app/b.conf"), QStringLiteral(".zshrc")}));
+    
+    // Rows come with the sources chezmoi wrote, and ask for their status once the run is over
+    QCOMPARE(added.sourcePath(2), service->getChezmoiDirectory() + QStringLiteral("/dot_config/private_app/executable_b.conf"));
+    QVERIFY(added.isTemplate(3) && !added.isTemplate(0));
+    QVERIFY(added.hasMetadata());
+    QTRY_COMPARE(statusSpy.size(), 4);
+    QCOMPARE(spawns().size(), qsizetype(2));
+    QVERIFY(spawns().last().startsWith("status "));
+    for (const QList<QVariant> &arguments : std::as_const(statusSpy)) {
+        const ChezmoiStatus expected = arguments.at(0).toString() == QStringLiteral(".zshrc")
+            ? ChezmoiStatus(ChezmoiStatus::Modified, ChezmoiStatus::Modified) : ChezmoiStatus();
+        QCOMPARE(arguments.at(1).value<ChezmoiStatus>(), expected);
+    }
+    
+    // Progress moves per file while chezmoi runs and only reaches 100 once it exits
+    QCOMPARE(progressSpy.size(), 4);
+    QCOMPARE(progressSpy.at(0).at(0).toInt(), 0);
+    QCOMPARE(progressSpy.at(1).at(0).toInt(), 33);
+    QCOMPARE(progressSpy.at(2).at(0).toInt(), 66);
+    QCOMPARE(progressSpy.at(3).at(0).toInt(), 100);
+    
+    delete service;
+}
+
+void TestChezmoiService::testBulkForget()
+{
+    const QDir home(m_fakeDir->filePath(QStringLiteral("home")));
+    script(QStringLiteral("forget.err"), "chezmoi: .zshrc: not managed\n");
+    script(QStringLiteral("fakechezmoi.ini"), "[forget]\nfailEvery=2\n");
+    
+    service = createFakeService();
+    QSignalSpy forgottenSpy(service, &ChezmoiService::filesForgotten);
+    QSignalSpy changedSpy(service, &ChezmoiService::managedFilesChanged);
+    QSignalSpy completedSpy(service, &ChezmoiService::bulkCompleted);
+    
+    // Without diffs in the output, the requested files are what was forgotten
+    QVERIFY(service->forgetFiles({home.filePath(QStringLiteral(".bashrc")), home.filePath(QStringLiteral(".vimrc"))}));
+    QVERIFY(completedSpy.wait(5000));
+    QVERIFY(completedSpy.first().at(0).toBool());
+    QCOMPARE(forgottenSpy.size(), 1);
+    QCOMPARE(forgottenSpy.first().at(0).toStringList(), (QStringList{QStringLiteral(".bashrc"), QStringLiteral(".vimrc")}));
+    QVERIFY(spawns().first().startsWith("forget --verbose --force "));
+    
+    // A failed run could have stopped anywhere, so the tree is reloaded instead
+    QVERIFY(service->forgetFiles({home.filePath(QStringLiteral(".zshrc"))}));
+    QVERIFY(completedSpy.wait(5000));
+    QVERIFY(!completedSpy.last().at(0).toBool());
+    QVERIFY(completedSpy.last().at(1).toString().contains(QStringLiteral("not managed")));
+    QCOMPARE(forgottenSpy.size(), 1);
+    QCOMPARE(changedSpy.size(), 1);
+    
+    delete service;
+}
+
+void TestChezmoiService::testSelectiveApply()
+{
+    const QDir home(m_fakeDir->filePath(QStringLiteral("home")));
+    
+    // .bashrc is written, .vimrc was up to date, and .zshrc was edited outside chezmoi
+    script(QStringLiteral("apply.out"), "diff --git a/.bashrc b/.bashrc\nindex 1..2 100644\n");
+    script(QStringLiteral("apply.err"),
+           "chezmoi: " + home.filePath(QStringLiteral(".zshrc")).toUtf8() + ": has changed since chezmoi last wrote it\n");
+    script(QStringLiteral("status.out"), "MM .zshrc\n");
+    script(QStringLiteral("fakechezmoi.ini"), "[apply]\nexitCode=1\n");
+    
+    service = createFakeService();
+    QSignalSpy startedSpy(service, &ChezmoiService::applyStarted);
+    QSignalSpy appliedSpy(service, &ChezmoiService::fileApplied);
+    QSignalSpy statusSpy(service, &ChezmoiService::fileStatusChanged);
+    QSignalSpy changedSpy(service, &ChezmoiService::managedFilesChanged);
+    QSignalSpy completedSpy(service, &ChezmoiService::bulkCompleted);
+    
+    QVERIFY(service->applyFiles({home.filePath(QStringLiteral(".zshrc")), home.filePath(QStringLiteral(".bashrc")),
+                                 home.filePath(QStringLiteral(".vimrc"))}));
+    QVERIFY(completedSpy.wait(5000));
+    QVERIFY(!completedSpy.first().at(0).toBool());
+    
+    QCOMPARE(startedSpy.size(), 1);
+    QCOMPARE(startedSpy.first().at(0).toStringList(),
+             (QStringList{QStringLiteral(".bashrc"), QStringLiteral(".vimrc"), QStringLiteral(".zshrc")}));
+    QVERIFY(spawns().first().startsWith("apply --verbose --keep-going "));
+    
+    // Files are done as their diff streams by; the failure only takes down the file chezmoi named
+    QCOMPARE(appliedSpy.size(), 3);
+    QCOMPARE(appliedSpy.at(0), (QVariantList{QStringLiteral(".bashrc"), true}));
+    QCOMPARE(appliedSpy.at(1), (QVariantList{QStringLiteral(".vimrc"), true}));
+    QCOMPARE(appliedSpy.at(2), (QVariantList{QStringLiteral(".zshrc"), false}));
+    
+    // Only the applied rows get their status again, and nothing asks for a reload
+    QTRY_COMPARE(statusSpy.size(), 3);
+    QCOMPARE(spawns().size(), qsizetype(2));
+    QVERIFY(spawns().last().startsWith("status "));
+    for (const QList<QVariant> &arguments : std::as_const(statusSpy)) {
+        const bool edited = arguments.at(0).toString() == QStringLiteral(".zshrc");
+        QCOMPARE(arguments.at(1).value<ChezmoiStatus>().isConflict(), edited);
+    }
+    QVERIFY(changedSpy.isEmpty());
+    
+    delete service;
+}
+
 QTEST_GUILESS_MAIN(TestChezmoiService)
 #include "test_chezmoiservice.moc"
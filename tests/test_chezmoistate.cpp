@@ -0,0 +1,166 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QProcess>
+#include <QFile>
+#include <QCryptographicHash>
+#include <cstring>
+#include "chezmoistate.h"
+
+class TestChezmoiState : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testReadsEntryStates();
+    void testCompareTargets();
+    void testRejectsInvalidDatabases();
+
+private:
+    bool chezmoiApply();
+    void writeFile(const QString &path, const QByteArray &content);
+
+    QString m_chezmoi;
+    std::unique_ptr<QTemporaryDir> m_dir;
+    QString m_home;
+    QString m_source;
+    QString m_state;
+};
+
+bool TestChezmoiState::chezmoiApply()
+{
+    // A throwaway HOME keeps the user's own chezmoi configuration and state out of the test
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(QStringLiteral("HOME"), m_home);
+    environment.remove(QStringLiteral("XDG_CONFIG_HOME"));
+    environment.remove(QStringLiteral("XDG_DATA_HOME"));
+
+    QProcess process;
+    process.setProcessEnvironment(environment);
+    process.start(m_chezmoi, {QStringLiteral("apply"), QStringLiteral("--force"),
+                              QStringLiteral("--source"), m_source,
+                              QStringLiteral("--destination"), m_home,
+                              QStringLiteral("--persistent-state"), m_state});
+    if (!process.waitForFinished() || process.exitCode() != 0) {
+        qWarning() << "chezmoi apply failed:" << process.readAllStandardError();
+        return false;
+    }
+    return true;
+}
+
+void TestChezmoiState::writeFile(const QString &path, const QByteArray &content)
+{
+    QVERIFY(QDir().mkpath(QFileInfo(path).path()));
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(content);
+}
+
+void TestChezmoiState::initTestCase()
+{
+    m_chezmoi = QStandardPaths::findExecutable(QStringLiteral("chezmoi"));
+    if (m_chezmoi.isEmpty()) {
+        QSKIP("chezmoi is not installed");
+    }
+}
+
+void TestChezmoiState::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+    m_home = m_dir->filePath(QStringLiteral("home"));
+    m_source = m_home + QStringLiteral("/.local/share/chezmoi");
+    m_state = m_home + QStringLiteral("/.config/chezmoi/chezmoistate.boltdb");
+
+    writeFile(m_source + QStringLiteral("/dot_bashrc"), "export EDITOR=vi\n");
+    writeFile(m_source + QStringLiteral("/private_dot_netrc"), "machine example.com\n");
+    writeFile(m_source + QStringLiteral("/dot_config/kitty/kitty.conf"), "font_size 11\n");
+    writeFile(m_source + QStringLiteral("/symlink_dot_vimrc"), ".config/vim/init.vim\n");
+    QVERIFY(chezmoiApply());
+}
+
+void TestChezmoiState::cleanup()
+{
+    m_dir.reset();
+}
+
+void TestChezmoiState::testReadsEntryStates()
+{
+    ChezmoiState state;
+    QVERIFY(state.load(m_state));
+    QVERIFY(state.isValid());
+
+    const QString bashrc = m_home + QStringLiteral("/.bashrc");
+    QVERIFY(state.contains(bashrc));
+    const ChezmoiState::EntryState bashrcState = state.entryState(bashrc);
+    QCOMPARE(bashrcState.type, QStringLiteral("file"));
+    QCOMPARE(bashrcState.contentsSha256, QCryptographicHash::hash("export EDITOR=vi\n", QCryptographicHash::Sha256));
+
+    QCOMPARE(state.entryState(m_home + QStringLiteral("/.netrc")).mode & 0077, 0u);
+    QCOMPARE(state.entryState(m_home + QStringLiteral("/.config")).type, QStringLiteral("dir"));
+    QCOMPARE(state.entryState(m_home + QStringLiteral("/.vimrc")).type, QStringLiteral("symlink"));
+    QVERIFY(!state.contains(m_home + QStringLiteral("/.profile")));
+}
+
+void TestChezmoiState::testCompareTargets()
+{
+    writeFile(m_home + QStringLiteral("/.bashrc"), "export EDITOR=nvim\n");
+    QVERIFY(QFile::remove(m_home + QStringLiteral("/.config/kitty/kitty.conf")));
+    QVERIFY(QFile::setPermissions(m_home + QStringLiteral("/.netrc"),
+                                  QFile::ReadOwner | QFile::WriteOwner | QFile::ReadGroup | QFile::ReadOther));
+
+    ChezmoiState state;
+    QVERIFY(state.load(m_state));
+
+    const QStringList targets = {
+        m_home + QStringLiteral("/.bashrc"),
+        m_home + QStringLiteral("/.netrc"),
+        m_home + QStringLiteral("/.config/kitty/kitty.conf"),
+        m_home + QStringLiteral("/.vimrc"),
+        m_home + QStringLiteral("/.config"),
+        m_home + QStringLiteral("/.profile"),
+    };
+    const QList<ChezmoiState::TargetChange> expected = {
+        ChezmoiState::TargetChange::Modified,
+        ChezmoiState::TargetChange::Modified,
+        ChezmoiState::TargetChange::Missing,
+        ChezmoiState::TargetChange::Unchanged,
+        ChezmoiState::TargetChange::Unchanged,
+        ChezmoiState::TargetChange::Unknown,
+    };
+    QCOMPARE(state.compareTargets(targets), expected);
+
+    // Re-applying records the new state
+    QVERIFY(chezmoiApply());
+    QVERIFY(state.load(m_state));
+    QCOMPARE(state.compareTarget(m_home + QStringLiteral("/.bashrc")), ChezmoiState::TargetChange::Unchanged);
+    QCOMPARE(state.compareTarget(m_home + QStringLiteral("/.config/kitty/kitty.conf")), ChezmoiState::TargetChange::Unchanged);
+}
+
+void TestChezmoiState::testRejectsInvalidDatabases()
+{
+    ChezmoiState state;
+    QVERIFY(!state.load(m_dir->filePath(QStringLiteral("missing.boltdb"))));
+    QVERIFY(!state.isValid());
+
+    QFile database(m_state);
+    QVERIFY(database.open(QIODevice::ReadOnly));
+    QByteArray data = database.readAll();
+    database.close();
+
+    // Both meta pages carry a checksum; breaking them leaves nothing to trust
+    const QString corruptPath = m_dir->filePath(QStringLiteral("corrupt.boltdb"));
+    quint32 pageSize = 0;
+    std::memcpy(&pageSize, data.constData() + 16 + 8, sizeof(pageSize));
+    QVERIFY(data.size() > qsizetype(pageSize) * 2);
+    data[16 + 20] = char(data.at(16 + 20) ^ 0xff);
+    data[pageSize + 16 + 20] = char(data.at(pageSize + 16 + 20) ^ 0xff);
+    writeFile(corruptPath, data);
+    QVERIFY(!state.load(corruptPath));
+    QCOMPARE(state.size(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestChezmoiState)
+#include "test_chezmoistate.moc"
@@ -0,0 +1,51 @@
+#include <QtTest/QtTest>
+#include "chezmoistatus.h"
+
+class TestChezmoiStatus : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testCodes();
+    void testPredicates();
+};
+
+void TestChezmoiStatus::testCodes()
+{
+    const ChezmoiStatus status = ChezmoiStatus::fromCodes('M', 'A');
+    QCOMPARE(status.actualChange(), ChezmoiStatus::Modified);
+    QCOMPARE(status.targetChange(), ChezmoiStatus::Added);
+    QCOMPARE(status.codes(), QStringLiteral("MA"));
+    QCOMPARE(ChezmoiStatus::fromBits(status.bits()), status);
+
+    QCOMPARE(ChezmoiStatus::fromCodes(' ', 'R').codes(), QStringLiteral(" R"));
+    QCOMPARE(ChezmoiStatus::fromCodes(' ', 'D').targetChange(), ChezmoiStatus::Deleted);
+    QCOMPARE(ChezmoiStatus().codes(), QStringLiteral("  "));
+    QCOMPARE(sizeof(ChezmoiStatus), sizeof(quint8));
+}
+
+void TestChezmoiStatus::testPredicates()
+{
+    QVERIFY(ChezmoiStatus().isClean());
+    QVERIFY(!ChezmoiStatus().isDirty());
+    QCOMPARE(ChezmoiStatus().name(), QStringLiteral("managed"));
+
+    // Scripts that would run are not differences worth highlighting
+    const ChezmoiStatus script = ChezmoiStatus::fromCodes(' ', 'R');
+    QVERIFY(!script.isClean());
+    QVERIFY(!script.isDirty());
+    QCOMPARE(script.name(), QStringLiteral("script"));
+
+    // A modification on either side outranks the other codes
+    QCOMPARE(ChezmoiStatus::fromCodes('D', 'M').summary(), ChezmoiStatus::Modified);
+    QCOMPARE(ChezmoiStatus::fromCodes(' ', 'A').name(), QStringLiteral("added"));
+    QVERIFY(ChezmoiStatus::fromCodes(' ', 'D').isDirty());
+
+    // Only a local edit that apply would overwrite is a conflict
+    QVERIFY(ChezmoiStatus::fromCodes('M', 'M').isConflict());
+    QVERIFY(!ChezmoiStatus::fromCodes(' ', 'M').isConflict());
+    QVERIFY(!ChezmoiStatus::fromCodes('M', ' ').isConflict());
+}
+
+QTEST_GUILESS_MAIN(TestChezmoiStatus)
+#include "test_chezmoistatus.moc"
@@ -0,0 +1,245 @@
+#include <QtTest/QtTest>
+#include <QLoggingCategory>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include "contentsearch.h"
+
+#include <algorithm>
+#include <tuple>
+
+class TestContentSearch : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testFindLiteral();
+    void testRequiredLiteral_data();
+    void testRequiredLiteral();
+    void testLiteralSearch();
+    void testRegexSearch();
+    void testInvalidPattern();
+    void testCancel();
+
+private:
+    QString writeFile(const QString &name, const QByteArray &contents);
+    QList<ContentSearch::Match> search(const QStringList &files, const QString &pattern, const ContentSearch::Options &options);
+    QStringList sampleFiles();
+
+    QTemporaryDir m_dir;
+};
+
+void TestContentSearch::initTestCase()
+{
+    QLoggingCategory::setFilterRules(QStringLiteral("default.debug=false"));
+    QVERIFY(m_dir.isValid());
+}
+
+QString TestContentSearch::writeFile(const QString &name, const QByteArray &contents)
+{
+    const QString path = m_dir.filePath(name);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(contents);
+    }
+    return path;
+}
+
+QStringList TestContentSearch::sampleFiles()
+{
+    return {
+        writeFile(QStringLiteral("dot_bashrc"), "alias ll='ls -l'\nexport EDITOR=vim\n# vim: ft=sh\n"),
+        writeFile(QStringLiteral("notes.txt"), "nothing here\r\nVIM rocks\r\n"),
+        writeFile(QStringLiteral("café.conf"), "café = vim"),
+        writeFile(QStringLiteral("image.bin"), QByteArray("vim\0vim", 7)),
+        writeFile(QStringLiteral(".git/config"), "[core]\n\teditor = vim\n"),
+        writeFile(QStringLiteral("empty"), QByteArray()),
+        m_dir.filePath(QStringLiteral("missing")),
+    };
+}
+
+QList<ContentSearch::Match> TestContentSearch::search(const QStringList &files, const QString &pattern,
+                                                      const ContentSearch::Options &options)
+{
+    ContentSearch contentSearch;
+    QList<ContentSearch::Match> matches;
+    connect(&contentSearch, &ContentSearch::matchesFound, this, [&matches](const QList<ContentSearch::Match> &found) {
+        matches += found;
+    });
+    QSignalSpy finishedSpy(&contentSearch, &ContentSearch::finished);
+
+    if (!contentSearch.start(files, pattern, options) || !finishedSpy.wait(5000)) {
+        return {};
+    }
+    if (finishedSpy.first().first().toBool() || contentSearch.isRunning()) {
+        return {};
+    }
+
+    // Workers finish in any order
+    std::sort(matches.begin(), matches.end(), [](const ContentSearch::Match &a, const ContentSearch::Match &b) {
+        return std::tie(a.filePath, a.line) < std::tie(b.filePath, b.line);
+    });
+    return matches;
+}
+
+void TestContentSearch::testFindLiteral()
+{
+    // Compared against a plain scan across the SIMD block edges, with bytes that only fold together with 0x20
+    const char alphabet[] = "abAB@`[{ 1";
+    QRandomGenerator random(7);
+    for (int round = 0; round < 20000; ++round) {
+        QByteArray haystack;
+        const int size = random.bounded(70);
+        for (int i = 0; i < size; ++i) {
+            haystack += alphabet[random.bounded(10)];
+        }
+        QByteArray needle;
+        const int length = 1 + random.bounded(5);
+        for (int i = 0; i < length; ++i) {
+            needle += alphabet[random.bounded(10)];
+        }
+        const qsizetype from = random.bounded(size + 1);
+        const bool caseSensitive = random.bounded(2);
+
+        qsizetype expected = -1;
+        for (qsizetype i = from; i + needle.size() <= haystack.size(); ++i) {
+            const QByteArray candidate = haystack.mid(i, needle.size());
+            if (caseSensitive ? candidate == needle : candidate.toLower() == needle.toLower()) {
+                expected = i;
+                break;
+            }
+        }
+        QCOMPARE(ContentSearch::findLiteral(haystack, needle, from, caseSensitive), expected);
+    }
+
+    QCOMPARE(ContentSearch::findLiteral("abc", "", 1, true), qsizetype(1));
+    QCOMPARE(ContentSearch::findLiteral("abc", "abcd", 0, true), qsizetype(-1));
+}
+
+void TestContentSearch::testRequiredLiteral_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<QString>("literal");
+
+    QTest::newRow("plain") << QStringLiteral("export") << QStringLiteral("export");
+    QTest::newRow("wildcard") << QStringLiteral("foo.*barbaz") << QStringLiteral("barbaz");
+    QTest::newRow("escaped dot") << QStringLiteral("\\.bashrc") << QStringLiteral(".bashrc");
+    QTest::newRow("class escape") << QStringLiteral("\\d+alias") << QStringLiteral("alias");
+    QTest::newRow("optional char") << QStringLiteral("colou?r") << QStringLiteral("colo");
+    QTest::newRow("repeat") << QStringLiteral("x{2,3}yy") << QStringLiteral("yy");
+    QTest::newRow("bracket") << QStringLiteral("[abc]+xyz") << QStringLiteral("xyz");
+    QTest::newRow("group") << QStringLiteral("(foo)?bar") << QStringLiteral("bar");
+    QTest::newRow("anchors") << QStringLiteral("^set -o$") << QStringLiteral("set -o");
+    QTest::newRow("alternation") << QStringLiteral("vim|nano") << QString();
+    QTest::newRow("inline option") << QStringLiteral("(?i)vim") << QString();
+}
+
+void TestContentSearch::testRequiredLiteral()
+{
+    QFETCH(QString, pattern);
+    QFETCH(QString, literal);
+
+    QCOMPARE(ContentSearch::requiredLiteral(pattern), literal);
+}
+
+void TestContentSearch::testLiteralSearch()
+{
+    const QStringList files = sampleFiles();
+
+    // Binary files and .git are skipped, columns count characters, and CRLF endings are dropped
+    ContentSearch::Options options;
+    const QList<ContentSearch::Match> matches = search(files, QStringLiteral("vim"), options);
+    QCOMPARE(matches.size(), qsizetype(4));
+    QCOMPARE(matches[0].filePath, files[2]);
+    QCOMPARE(matches[0].line, 0);
+    QCOMPARE(matches[0].column, 7);
+    QCOMPARE(matches[0].length, 3);
+    QCOMPARE(matches[1].filePath, files[0]);
+    QCOMPARE(matches[1].line, 1);
+    QCOMPARE(matches[1].column, 14);
+    QCOMPARE(matches[1].lineText, QStringLiteral("export EDITOR=vim"));
+    QCOMPARE(matches[2].line, 2);
+    QCOMPARE(matches[2].column, 2);
+    QCOMPARE(matches[3].filePath, files[1]);
+    QCOMPARE(matches[3].line, 1);
+    QCOMPARE(matches[3].lineText, QStringLiteral("VIM rocks"));
+
+    options.caseSensitive = true;
+    QCOMPARE(search(files, QStringLiteral("vim"), options).size(), qsizetype(3));
+
+    // Without regard to case, non-ASCII text is matched by the expression engine
+    options.caseSensitive = false;
+    QCOMPARE(search(files, QStringLiteral("CAFÉ"), options).size(), qsizetype(1));
+}
+
+void TestContentSearch::testRegexSearch()
+{
+    const QStringList files = sampleFiles();
+
+    ContentSearch::Options options;
+    options.regularExpression = true;
+    options.caseSensitive = true;
+    QList<ContentSearch::Match> matches = search(files, QStringLiteral("EDITOR=\\w+"), options);
+    QCOMPARE(matches.size(), qsizetype(1));
+    QCOMPARE(matches[0].line, 1);
+    QCOMPARE(matches[0].column, 7);
+    QCOMPARE(matches[0].length, 10);
+
+    // The required literal only narrows the lines; the expression still decides
+    matches = search(files, QStringLiteral("^vim"), options);
+    QCOMPARE(matches.size(), qsizetype(0));
+
+    matches = search(files, QStringLiteral("^(alias|nothing)"), options);
+    QCOMPARE(matches.size(), qsizetype(2));
+}
+
+void TestContentSearch::testInvalidPattern()
+{
+    ContentSearch contentSearch;
+    ContentSearch::Options options;
+    QVERIFY(!contentSearch.start(sampleFiles(), QString(), options));
+
+    options.regularExpression = true;
+    QVERIFY(!contentSearch.start(sampleFiles(), QStringLiteral("(unclosed"), options));
+    QVERIFY(!contentSearch.errorString().isEmpty());
+    QVERIFY(!contentSearch.isRunning());
+}
+
+void TestContentSearch::testCancel()
+{
+    QStringList files;
+    const QByteArray contents = QByteArray("match me\n").repeated(2000);
+    for (int i = 0; i < 200; ++i) {
+        files << writeFile(QStringLiteral("many/file%1").arg(i), contents);
+    }
+
+    ContentSearch contentSearch;
+    int delivered = 0;
+    connect(&contentSearch, &ContentSearch::matchesFound, this, [&delivered](const QList<ContentSearch::Match> &found) {
+        delivered += int(found.size());
+    });
+    QSignalSpy finishedSpy(&contentSearch, &ContentSearch::finished);
+
+    ContentSearch::Options options;
+    QVERIFY(contentSearch.start(files, QStringLiteral("match"), options));
+    QVERIFY(contentSearch.isRunning());
+    contentSearch.cancel();
+    QVERIFY(!contentSearch.isRunning());
+    QCOMPARE(finishedSpy.count(), 1);
+    QCOMPARE(finishedSpy.first().first().toBool(), true);
+
+    // Batches the workers posted before stopping never arrive
+    QTest::qWait(200);
+    QCOMPARE(delivered, 0);
+    QCOMPARE(finishedSpy.count(), 1);
+
+    // A new search after a cancelled one runs to the end
+    QVERIFY(contentSearch.start(files.first(5), QStringLiteral("match"), options));
+    QVERIFY(finishedSpy.wait(5000));
+    QCOMPARE(finishedSpy.last().first().toBool(), false);
+    QCOMPARE(delivered, 5 * 2000);
+}
+
+QTEST_GUILESS_MAIN(TestContentSearch)
+#include "test_contentsearch.moc"
@@ -0,0 +1,152 @@
+#include <QtTest/QtTest>
+#include <QLoggingCategory>
+#include "dotfilefiltermodel.h"
+#include "dotfilemanager.h"
+
+class TestDotfileFilterModel : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testTextFilter();
+    void testStatusFilter();
+    void testInventoryReset();
+    void testIncrementalText();
+
+private:
+    static FileStatusBatch sampleInventory();
+    static QStringList visibleFiles(const QAbstractItemModel &model, const QModelIndex &parent = QModelIndex(),
+                                    const QString &prefix = QString());
+};
+
+void TestDotfileFilterModel::initTestCase()
+{
+    QLoggingCategory::setFilterRules(QStringLiteral("default.debug=false"));
+}
+
+FileStatusBatch TestDotfileFilterModel::sampleInventory()
+{
+    FileStatusBatch files(QStringLiteral("/src"), QStringLiteral("/home/user"));
+    files.append(u".bashrc", ChezmoiStatus(), 0);
+    files.append(u".config/kitty/kitty.conf", ChezmoiStatus(ChezmoiStatus::NoChange, ChezmoiStatus::Added), 0);
+    files.append(u".config/nvim/init.lua", ChezmoiStatus(ChezmoiStatus::NoChange, ChezmoiStatus::Modified), 0);
+    files.append(u".config/nvim/lua/plugins.lua", ChezmoiStatus(), FileStatusBatch::Template);
+    return files;
+}
+
+QStringList TestDotfileFilterModel::visibleFiles(const QAbstractItemModel &model, const QModelIndex &parent, const QString &prefix)
+{
+    QStringList files;
+    for (int row = 0; row < model.rowCount(parent); ++row) {
+        const QModelIndex index = model.index(row, 0, parent);
+        const QString path = prefix + index.data().toString();
+        if (model.rowCount(index) > 0) {
+            files += visibleFiles(model, index, path + u'/');
+        } else {
+            files << path;
+        }
+    }
+    files.sort();
+    return files;
+}
+
+void TestDotfileFilterModel::testTextFilter()
+{
+    DotfileManager manager;
+    manager.setInventory(sampleInventory());
+    DotfileFilterModel filter;
+    filter.setSourceModel(&manager);
+    QVERIFY(!filter.isFiltering());
+    QCOMPARE(filter.visibleFileCount(), 4);
+    QCOMPARE(visibleFiles(filter), visibleFiles(manager));
+
+    // Directories stay only while something below them matches
+    filter.setFilterText(QStringLiteral("NVIM"));
+    QCOMPARE(visibleFiles(filter), (QStringList{QStringLiteral(".config/nvim/init.lua"), QStringLiteral(".config/nvim/lua/plugins.lua")}));
+
+    filter.setFilterText(QStringLiteral("nvim/lua"));
+    QCOMPARE(visibleFiles(filter), QStringList{QStringLiteral(".config/nvim/lua/plugins.lua")});
+    QCOMPARE(filter.visibleFileCount(), 1);
+
+    filter.setFilterText(QStringLiteral("nv"));
+    QCOMPARE(filter.visibleFileCount(), 2);
+
+    filter.setFilterText(QStringLiteral("zsh"));
+    QCOMPARE(filter.rowCount(), 0);
+
+    filter.setFilterText(QString());
+    QVERIFY(!filter.isFiltering());
+    QCOMPARE(visibleFiles(filter), visibleFiles(manager));
+}
+
+void TestDotfileFilterModel::testStatusFilter()
+{
+    DotfileManager manager;
+    manager.setInventory(sampleInventory());
+    DotfileFilterModel filter;
+    filter.setSourceModel(&manager);
+
+    filter.setChangeFilter(DotfileFilterModel::changeBit(ChezmoiStatus::Modified));
+    QCOMPARE(visibleFiles(filter), QStringList{QStringLiteral(".config/nvim/init.lua")});
+
+    filter.setChangeFilter(DotfileFilterModel::DirtyChanges);
+    QCOMPARE(visibleFiles(filter), (QStringList{QStringLiteral(".config/kitty/kitty.conf"), QStringLiteral(".config/nvim/init.lua")}));
+
+    // Status and text filters combine
+    filter.setFilterText(QStringLiteral("kitty"));
+    QCOMPARE(visibleFiles(filter), QStringList{QStringLiteral(".config/kitty/kitty.conf")});
+
+    filter.setFilterText(QString());
+    filter.setChangeFilter(DotfileFilterModel::AllChanges);
+    filter.setTemplatesOnly(true);
+    QCOMPARE(visibleFiles(filter), QStringList{QStringLiteral(".config/nvim/lua/plugins.lua")});
+
+    filter.setTemplatesOnly(false);
+    QCOMPARE(filter.visibleFileCount(), 4);
+}
+
+void TestDotfileFilterModel::testInventoryReset()
+{
+    DotfileManager manager;
+    manager.setInventory(sampleInventory());
+    DotfileFilterModel filter;
+    filter.setSourceModel(&manager);
+    filter.setFilterText(QStringLiteral("conf"));
+    QCOMPARE(filter.visibleFileCount(), 3);
+
+    // A new inventory is filtered with the filters already in place
+    FileStatusBatch files(QStringLiteral("/src"), QStringLiteral("/home/user"));
+    files.append(u".config/git/config", ChezmoiStatus(), 0);
+    files.append(u".zshrc", ChezmoiStatus(), 0);
+    manager.setInventory(files);
+    QCOMPARE(filter.visibleFileCount(), 1);
+    QCOMPARE(visibleFiles(filter), QStringList{QStringLiteral(".config/git/config")});
+}
+
+void TestDotfileFilterModel::testIncrementalText()
+{
+    FileStatusBatch files(QStringLiteral("/src"), QStringLiteral("/home/user"));
+    for (int i = 0; i < 600; ++i) {
+        files.append(QStringLiteral(".config/app%1/sub%2/settings-%3.conf").arg(i % 40).arg(i % 7).arg(i), ChezmoiStatus(), 0);
+    }
+    DotfileManager manager;
+    manager.setInventory(files);
+    DotfileFilterModel filter;
+    filter.setSourceModel(&manager);
+
+    // Typing, deleting and replacing the text ends up where a fresh filter does
+    const QStringList typed = {QStringLiteral("a"), QStringLiteral("app1"), QStringLiteral("app12"), QStringLiteral("app12/sub3"),
+                               QStringLiteral("app1"), QStringLiteral("sub3"), QStringLiteral("settings-59"), QString()};
+    for (const QString &text : typed) {
+        filter.setFilterText(text);
+        DotfileFilterModel fresh;
+        fresh.setSourceModel(&manager);
+        fresh.setFilterText(text);
+        QCOMPARE(filter.visibleFileCount(), fresh.visibleFileCount());
+        QCOMPARE(visibleFiles(filter), visibleFiles(fresh));
+    }
+}
+
+QTEST_MAIN(TestDotfileFilterModel)
+#include "test_dotfilefiltermodel.moc"
@@ -10,6 +10,9 @@ class TestDotfileManager : public QObject
 private Q_SLOTS:
     void testModelStructure();
     void testFileHandling();
+    void testSiblingOrder();
+    void testManagedSourcePaths();
+    void testApplyStateReset();
 
 private:
     DotfileManager *manager;
@@ -28,12 +31,15 @@ void TestDotfileManager::testModelStructure()
     
     // Test basic model structure
     QVERIFY(manager->rowCount() >= 0);
-    QCOMPARE(manager->columnCount(), 3);
+    QCOMPARE(manager->columnCount(), 6);
     
     // Test header data
     QCOMPARE(manager->headerData(0, Qt::Horizontal).toString(), QStringLiteral("Name"));
     QCOMPARE(manager->headerData(1, Qt::Horizontal).toString(), QStringLiteral("Status"));
     QCOMPARE(manager->headerData(2, Qt::Horizontal).toString(), QStringLiteral("Type"));
+    QCOMPARE(manager->headerData(3, Qt::Horizontal).toString(), QStringLiteral("Size"));
+    QCOMPARE(manager->headerData(4, Qt::Horizontal).toString(), QStringLiteral("Modified"));
+    QCOMPARE(manager->headerData(5, Qt::Horizontal).toString(), QStringLiteral("Permissions"));
     
     delete manager;
     delete service;
@@ -61,5 +67,87 @@ void TestDotfileManager::testFileHandling()
     delete service;
 }
 
+void TestDotfileManager::testSiblingOrder()
+{
+    int argc = 0;
+    char *argv[] = {nullptr};
+    QApplication app(argc, argv);
+    
+    // chezmoi's path order puts "a-c" before the directory "a", so siblings arrive unsorted
+    FileStatusBatch files(QStringLiteral("/src"), QStringLiteral("/home/user"));
+    files.append(u"a-c", ChezmoiStatus(), 0);
+    files.append(u"a/x", ChezmoiStatus(), 0);
+    files.append(u"b", ChezmoiStatus(), 0);
+    
+    DotfileManager manager;
+    manager.setInventory(files);
+    
+    FileStatusBatch added(QStringLiteral("/src"), QStringLiteral("/home/user"));
+    added.append(u"a-b", ChezmoiStatus(), 0);
+    added.append(u"a0", ChezmoiStatus(), 0);
+    QVERIFY(QMetaObject::invokeMethod(&manager, "onInventoryPartial", Qt::DirectConnection, Q_ARG(FileStatusBatch, added)));
+    
+    QStringList names;
+    for (int row = 0; row < manager.rowCount(); ++row) {
+        names << manager.index(row, 0).data().toString();
+    }
+    QCOMPARE(names, (QStringList{QStringLiteral("a"), QStringLiteral("a-b"), QStringLiteral("a-c"), QStringLiteral("a0"), QStringLiteral("b")}));
+}
+
+void TestDotfileManager::testManagedSourcePaths()
+{
+    int argc = 0;
+    char *argv[] = {nullptr};
+    QApplication app(argc, argv);
+    
+    FileStatusBatch files(QStringLiteral("/src"), QStringLiteral("/home/user"));
+    files.append(u".bashrc", ChezmoiStatus(), 0);
+    files.append(u".external", ChezmoiStatus(), 0);
+    files.append(u".ssh/config", ChezmoiStatus(), 0);
+    files.appendSourcePath(u"dot_bashrc");
+    files.appendSourcePath(QStringView());
+    files.appendSourcePath(u"private_dot_ssh/config");
+    
+    DotfileManager manager;
+    manager.setInventory(files);
+    
+    // What Find in Files searches in source mode: the real source files, never target names under the source directory
+    QCOMPARE(manager.managedSourcePaths(), (QStringList{QStringLiteral("/src/dot_bashrc"), QStringLiteral("/src/private_dot_ssh/config")}));
+    QCOMPARE(manager.getFilePath(manager.index(0, 0)), QStringLiteral("/src/dot_bashrc"));
+}
+
+void TestDotfileManager::testApplyStateReset()
+{
+    int argc = 0;
+    char *argv[] = {nullptr};
+    QApplication app(argc, argv);
+    
+    const ChezmoiStatus modified(ChezmoiStatus::NoChange, ChezmoiStatus::Modified);
+    FileStatusBatch files(QStringLiteral("/src"), QStringLiteral("/home/user"));
+    files.append(u".bashrc", modified, 0);
+    
+    ChezmoiService service;
+    DotfileManager manager;
+    manager.setChezmoiService(&service);
+    manager.setInventory(files);
+    const QModelIndex status = manager.index(0, DotfileManager::StatusColumn);
+    QCOMPARE(status.data().toString(), modified.codes());
+    
+    QVERIFY(QMetaObject::invokeMethod(&manager, "onFileApplied", Qt::DirectConnection,
+                                      Q_ARG(QString, QStringLiteral(".bashrc")), Q_ARG(bool, false)));
+    QCOMPARE(status.data().toString(), QStringLiteral("Failed"));
+    
+    // The next status replaces the result, even when it matches the one before the apply
+    Q_EMIT service.fileStatusChanged(QStringLiteral(".bashrc"), modified);
+    QCOMPARE(status.data().toString(), modified.codes());
+    
+    QVERIFY(QMetaObject::invokeMethod(&manager, "onFileApplied", Qt::DirectConnection,
+                                      Q_ARG(QString, QStringLiteral(".bashrc")), Q_ARG(bool, true)));
+    QCOMPARE(status.data().toString(), QStringLiteral("Done"));
+    Q_EMIT service.fileStatusChanged(QStringLiteral(".bashrc"), ChezmoiStatus());
+    QCOMPARE(status.data().toString(), ChezmoiStatus().codes());
+    QVERIFY(!status.data(Qt::ToolTipRole).toString().contains(QStringLiteral("Applied")));
+}
+
 QTEST_GUILESS_MAIN(TestDotfileManager)
 #include "test_dotfilemanager.moc"
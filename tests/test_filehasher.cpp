@@ -0,0 +1,138 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
+#include <QFile>
+#include "filehasher.h"
+
+class TestFileHasher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void testSha256();
+    void testFastHash();
+    void testCacheByIdentity();
+    void testHashFiles();
+
+private:
+    QString writeFile(const QString &name, const QByteArray &content);
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+QString TestFileHasher::writeFile(const QString &name, const QByteArray &content)
+{
+    const QString path = m_dir->filePath(name);
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(content) != content.size()) {
+        return QString();
+    }
+    return path;
+}
+
+void TestFileHasher::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+}
+
+void TestFileHasher::testSha256()
+{
+    FileHasher hasher;
+    const QByteArray content = "export EDITOR=vi\n";
+    const QString path = writeFile(QStringLiteral("bashrc"), content);
+    QCOMPARE(hasher.hash(path), QCryptographicHash::hash(content, QCryptographicHash::Sha256));
+
+    // Larger than one read chunk, and not a multiple of it
+    QByteArray large;
+    for (int i = 0; large.size() < 3 * 1024 * 1024 + 17; ++i) {
+        large += QByteArray::number(i) + '\n';
+    }
+    const QString largePath = writeFile(QStringLiteral("large"), large);
+    QCOMPARE(hasher.hash(largePath), QCryptographicHash::hash(large, QCryptographicHash::Sha256));
+
+    QCOMPARE(hasher.hash(writeFile(QStringLiteral("empty"), QByteArray())),
+             QCryptographicHash::hash(QByteArray(), QCryptographicHash::Sha256));
+
+    // Only regular files have contents to hash
+    QVERIFY(hasher.hash(m_dir->filePath(QStringLiteral("missing"))).isEmpty());
+    QVERIFY(hasher.hash(m_dir->path()).isEmpty());
+}
+
+void TestFileHasher::testFastHash()
+{
+    FileHasher hasher;
+
+    // Reference XXH64 values with seed 0
+    QCOMPARE(hasher.hash(writeFile(QStringLiteral("empty"), QByteArray()), FileHasher::Algorithm::Fast),
+             QByteArray::fromHex("ef46db3751d8e999"));
+    QCOMPARE(hasher.hash(writeFile(QStringLiteral("abc"), "abc"), FileHasher::Algorithm::Fast),
+             QByteArray::fromHex("44bc2cf5ad770999"));
+
+    // Inputs that cross the 32 byte stripe and the chunk boundaries must not depend on how they were read
+    QByteArray large(1024 * 1024 + 100, 'x');
+    large[1024 * 1024 - 1] = 'y';
+    const QByteArray first = hasher.hash(writeFile(QStringLiteral("large"), large), FileHasher::Algorithm::Fast);
+    QCOMPARE(first.size(), 8);
+    large[1024 * 1024] = 'y';
+    QVERIFY(hasher.hash(writeFile(QStringLiteral("large2"), large), FileHasher::Algorithm::Fast) != first);
+}
+
+void TestFileHasher::testCacheByIdentity()
+{
+    FileHasher hasher;
+    const QString path = writeFile(QStringLiteral("gitconfig"), "[user]\n\tname = A\n");
+
+    const QByteArray first = hasher.hash(path);
+    const qint64 bytesAfterFirst = hasher.bytesRead();
+    QCOMPARE(hasher.cacheHits(), qint64(0));
+
+    // Unchanged files are not read again
+    QCOMPARE(hasher.hash(path), first);
+    QCOMPARE(hasher.cacheHits(), qint64(1));
+    QCOMPARE(hasher.bytesRead(), bytesAfterFirst);
+
+    // A rewrite changes the identity even when the size stays the same
+    FileHasher::Identity before;
+    QVERIFY(FileHasher::identify(path, &before));
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    file.write("[user]\n\tname = B\n");
+    file.flush();
+    // Coarse filesystem timestamps could otherwise leave the mtime where it was
+    QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(5), QFileDevice::FileModificationTime));
+    file.close();
+
+    FileHasher::Identity after;
+    QVERIFY(FileHasher::identify(path, &after));
+    QCOMPARE(after.size, before.size);
+    QVERIFY(!(after == before));
+
+    const QByteArray second = hasher.hash(path);
+    QVERIFY(second != first);
+    QCOMPARE(second, QCryptographicHash::hash("[user]\n\tname = B\n", QCryptographicHash::Sha256));
+    QCOMPARE(hasher.cacheHits(), qint64(1));
+}
+
+void TestFileHasher::testHashFiles()
+{
+    FileHasher hasher;
+    QStringList paths;
+    QList<QByteArray> expected;
+    for (int i = 0; i < 200; ++i) {
+        const QByteArray content = QByteArray::number(i).repeated(i + 1);
+        paths << writeFile(QStringLiteral("file%1").arg(i), content);
+        expected << QCryptographicHash::hash(content, QCryptographicHash::Sha256);
+    }
+    paths << m_dir->filePath(QStringLiteral("missing"));
+    expected << QByteArray();
+
+    // Results keep the order of the input whatever thread hashed them
+    QCOMPARE(hasher.hashFiles(paths), expected);
+    QCOMPARE(hasher.hashFiles(paths), expected);
+    QCOMPARE(hasher.cacheHits(), qint64(200));
+}
+
+QTEST_GUILESS_MAIN(TestFileHasher)
+#include "test_filehasher.moc"
@@ -0,0 +1,102 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include "filemetadata.h"
+
+class TestFileMetadata : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void testStat();
+    void testCollect();
+    void testFormatMode();
+
+private:
+    QString writeFile(const QString &name, const QByteArray &content);
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+QString TestFileMetadata::writeFile(const QString &name, const QByteArray &content)
+{
+    const QString path = m_dir->filePath(name);
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(content) != content.size()) {
+        return QString();
+    }
+    return path;
+}
+
+void TestFileMetadata::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+}
+
+void TestFileMetadata::testStat()
+{
+    const QString script = writeFile(QStringLiteral("setup.sh"), "#!/bin/sh\necho hi\n");
+    QVERIFY(QFile::setPermissions(script, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner));
+
+    QString linkTarget;
+    const FileMetadata::Record record = FileMetadata::stat(script, &linkTarget);
+    QVERIFY(record.exists());
+    QCOMPARE(record.size, qint64(18));
+    QCOMPARE(record.permissions(), 0700u);
+    QVERIFY(record.isExecutable());
+    QVERIFY(!record.isDirectory());
+    QVERIFY(!record.isSymLink());
+    QCOMPARE(record.lastModified(), QFileInfo(script).lastModified());
+    QVERIFY(linkTarget.isEmpty());
+
+    // Links are described themselves rather than followed
+    const QString link = m_dir->filePath(QStringLiteral("vimrc"));
+    QVERIFY(QFile::link(QStringLiteral("setup.sh"), link));
+    const FileMetadata::Record linkRecord = FileMetadata::stat(link, &linkTarget);
+    QVERIFY(linkRecord.isSymLink());
+    QVERIFY(!linkRecord.isExecutable());
+    QCOMPARE(linkTarget, QStringLiteral("setup.sh"));
+
+    QVERIFY(FileMetadata::stat(m_dir->path()).isDirectory());
+
+    const FileMetadata::Record missing = FileMetadata::stat(m_dir->filePath(QStringLiteral("missing")));
+    QVERIFY(!missing.exists());
+    QVERIFY(!missing.lastModified().isValid());
+}
+
+void TestFileMetadata::testCollect()
+{
+    QStringList paths;
+    for (int i = 0; i < 500; ++i) {
+        paths << writeFile(QStringLiteral("file%1").arg(i), QByteArray(i, 'x'));
+    }
+    paths << m_dir->filePath(QStringLiteral("missing"));
+    QVERIFY(QFile::link(QStringLiteral("file7"), m_dir->filePath(QStringLiteral("link"))));
+    paths << m_dir->filePath(QStringLiteral("link"));
+
+    // Spread over several tasks, the records still line up with their paths
+    const FileMetadata metadata = FileMetadata::collect(paths);
+    QCOMPARE(metadata.size(), paths.size());
+    for (int i = 0; i < 500; ++i) {
+        QCOMPARE(metadata.at(i).size, qint64(i));
+        QVERIFY(metadata.linkTarget(i).isEmpty());
+    }
+    QVERIFY(!metadata.at(500).exists());
+    QVERIFY(metadata.at(501).isSymLink());
+    QCOMPARE(metadata.linkTarget(501), QStringLiteral("file7"));
+
+    QCOMPARE(FileMetadata::collect({}).size(), qsizetype(0));
+}
+
+void TestFileMetadata::testFormatMode()
+{
+    QCOMPARE(FileMetadata::formatMode(0100644), QStringLiteral("-rw-r--r--"));
+    QCOMPARE(FileMetadata::formatMode(0100600), QStringLiteral("-rw-------"));
+    QCOMPARE(FileMetadata::formatMode(040755), QStringLiteral("drwxr-xr-x"));
+    QCOMPARE(FileMetadata::formatMode(0120777), QStringLiteral("lrwxrwxrwx"));
+}
+
+QTEST_GUILESS_MAIN(TestFileMetadata)
+#include "test_filemetadata.moc"
@@ -0,0 +1,85 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include "filestatusbatch.h"
+
+class TestFileStatusBatch : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testColumns();
+    void testMetadata();
+};
+
+void TestFileStatusBatch::testColumns()
+{
+    FileStatusBatch batch(QStringLiteral("/src"), QStringLiteral("/home/user"));
+    QVERIFY(batch.isEmpty());
+
+    batch.reserve(3);
+    batch.append(u".bashrc", ChezmoiStatus(), 0);
+    batch.append(u".config/kitty/kitty.conf", ChezmoiStatus(ChezmoiStatus::NoChange, ChezmoiStatus::Modified), FileStatusBatch::Template);
+    batch.append(u".vimrc", ChezmoiStatus(ChezmoiStatus::NoChange, ChezmoiStatus::Added), 0);
+
+    QCOMPARE(batch.size(), qsizetype(3));
+    QCOMPARE(batch.path(0).toString(), QStringLiteral(".bashrc"));
+    QCOMPARE(batch.path(1).toString(), QStringLiteral(".config/kitty/kitty.conf"));
+    QCOMPARE(batch.path(2).toString(), QStringLiteral(".vimrc"));
+    QCOMPARE(batch.status(1), ChezmoiStatus(ChezmoiStatus::NoChange, ChezmoiStatus::Modified));
+    QVERIFY(!batch.isTemplate(0));
+    QVERIFY(batch.isTemplate(1));
+    QCOMPARE(batch.targetPath(2), QStringLiteral("/home/user/.vimrc"));
+
+    // Source names differ from targets, so they are only known once appended
+    QVERIFY(batch.sourcePath(0).isEmpty());
+    batch.appendSourcePath(u"dot_bashrc");
+    batch.appendSourcePath(u"dot_config/kitty/kitty.conf.tmpl");
+    QCOMPARE(batch.sourcePath(0), QStringLiteral("/src/dot_bashrc"));
+    QCOMPARE(batch.sourcePath(1), QStringLiteral("/src/dot_config/kitty/kitty.conf.tmpl"));
+    QVERIFY(batch.sourcePath(2).isEmpty());
+    batch.appendSourcePath(QStringView());
+    QVERIFY(batch.sourcePath(2).isEmpty());
+
+    // Copies share the columns until one of them is changed
+    FileStatusBatch copy = batch;
+    copy.append(u".zshrc", ChezmoiStatus(), 0);
+    QCOMPARE(batch.size(), qsizetype(3));
+    QCOMPARE(copy.path(3).toString(), QStringLiteral(".zshrc"));
+}
+
+void TestFileStatusBatch::testMetadata()
+{
+    QTemporaryDir source;
+    QTemporaryDir target;
+    QVERIFY(source.isValid() && target.isValid());
+
+    QFile file(target.filePath(QStringLiteral(".bashrc")));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("export EDITOR=vi\n");
+    file.close();
+
+    QFile sourceFile(source.filePath(QStringLiteral("dot_bashrc")));
+    QVERIFY(sourceFile.open(QIODevice::WriteOnly));
+    sourceFile.close();
+
+    FileStatusBatch batch(source.path(), target.path());
+    batch.append(u".bashrc", ChezmoiStatus(), 0);
+    batch.append(u".missing", ChezmoiStatus(), 0);
+    batch.appendSourcePath(u"dot_bashrc");
+    batch.appendSourcePath(u"dot_missing");
+
+    // Nothing is stat'ed until asked for
+    QVERIFY(!batch.hasMetadata());
+    QVERIFY(!batch.targetMetadata(0).exists());
+
+    batch.collectMetadata();
+    QVERIFY(batch.hasMetadata());
+    QCOMPARE(batch.targetMetadata(0).size, qint64(17));
+    QVERIFY(batch.sourceMetadata(0).exists());
+    QVERIFY(!batch.sourceMetadata(1).exists());
+    QVERIFY(!batch.targetMetadata(1).exists());
+}
+
+QTEST_GUILESS_MAIN(TestFileStatusBatch)
+#include "test_filestatusbatch.moc"
@@ -0,0 +1,105 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include "filewatcher.h"
+
+class TestFileWatcher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testReportsChangedEntries();
+    void testFollowsNewDirectories();
+    void testClear();
+
+private:
+    static bool writeFile(const QString &path, const QByteArray &contents);
+    static QStringList collectPaths(QSignalSpy &spy);
+};
+
+bool TestFileWatcher::writeFile(const QString &path, const QByteArray &contents)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return file.write(contents) == contents.size();
+}
+
+QStringList TestFileWatcher::collectPaths(QSignalSpy &spy)
+{
+    QStringList paths;
+    for (const QList<QVariant> &arguments : std::as_const(spy)) {
+        paths += arguments.first().toStringList();
+    }
+    return paths;
+}
+
+void TestFileWatcher::testReportsChangedEntries()
+{
+    FileWatcher watcher;
+    if (!watcher.isAvailable()) {
+        QSKIP("inotify is not available");
+    }
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString bashrc = dir.filePath(QStringLiteral(".bashrc"));
+    QVERIFY(writeFile(bashrc, "export EDITOR=vi\n"));
+
+    QVERIFY(watcher.addDirectory(dir.path()));
+    QSignalSpy spy(&watcher, &FileWatcher::pathsChanged);
+
+    QVERIFY(writeFile(bashrc, "export EDITOR=nvim\n"));
+    QTRY_VERIFY(collectPaths(spy).contains(bashrc));
+
+    spy.clear();
+    QVERIFY(QFile::remove(bashrc));
+    QTRY_VERIFY(collectPaths(spy).contains(bashrc));
+}
+
+void TestFileWatcher::testFollowsNewDirectories()
+{
+    FileWatcher watcher;
+    if (!watcher.isAvailable()) {
+        QSKIP("inotify is not available");
+    }
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("dot_config/.git")));
+
+    QVERIFY(watcher.addDirectory(dir.path(), true));
+    QVERIFY(watcher.directories().contains(dir.filePath(QStringLiteral("dot_config"))));
+    QVERIFY(!watcher.directories().contains(dir.filePath(QStringLiteral("dot_config/.git"))));
+
+    QSignalSpy spy(&watcher, &FileWatcher::pathsChanged);
+    QVERIFY(QDir(dir.path()).mkpath(QStringLiteral("dot_config/kitty")));
+    QTRY_VERIFY(watcher.directories().contains(dir.filePath(QStringLiteral("dot_config/kitty"))));
+
+    const QString kittyConf = dir.filePath(QStringLiteral("dot_config/kitty/kitty.conf"));
+    QVERIFY(writeFile(kittyConf, "font_size 11\n"));
+    QTRY_VERIFY(collectPaths(spy).contains(kittyConf));
+}
+
+void TestFileWatcher::testClear()
+{
+    FileWatcher watcher;
+    if (!watcher.isAvailable()) {
+        QSKIP("inotify is not available");
+    }
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(watcher.addDirectory(dir.path()));
+    watcher.clear();
+    QVERIFY(watcher.directories().isEmpty());
+
+    QSignalSpy spy(&watcher, &FileWatcher::pathsChanged);
+    QVERIFY(writeFile(dir.filePath(QStringLiteral("unwatched")), "x"));
+    QTest::qWait(100);
+    QVERIFY(collectPaths(spy).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestFileWatcher)
+#include "test_filewatcher.moc"
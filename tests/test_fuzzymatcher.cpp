@@ -0,0 +1,99 @@
+#include <QtTest/QtTest>
+#include "fuzzymatcher.h"
+
+class TestFuzzyMatcher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testSubsequence();
+    void testRanking();
+    void testNarrowing();
+    void testLongPaths();
+
+private:
+    static QStringList matchedPaths(FuzzyMatcher &matcher, const QString &query, qsizetype limit = 100);
+};
+
+QStringList TestFuzzyMatcher::matchedPaths(FuzzyMatcher &matcher, const QString &query, qsizetype limit)
+{
+    QStringList paths;
+    for (const FuzzyMatcher::Match &match : matcher.match(query, limit)) {
+        paths << matcher.path(match.index);
+    }
+    return paths;
+}
+
+void TestFuzzyMatcher::testSubsequence()
+{
+    FuzzyMatcher matcher;
+    matcher.setPaths({QStringLiteral(".bashrc"), QStringLiteral(".config/bat/config"), QStringLiteral(".config/Kitty/kitty.conf")});
+    QCOMPARE(matcher.size(), qsizetype(3));
+
+    // Characters in order, not necessarily adjacent, ignoring case and spaces
+    QCOMPARE(matchedPaths(matcher, QStringLiteral("brc")), QStringList{QStringLiteral(".bashrc")});
+    QCOMPARE(matchedPaths(matcher, QStringLiteral("KITTY conf")), QStringList{QStringLiteral(".config/Kitty/kitty.conf")});
+    QVERIFY(matchedPaths(matcher, QStringLiteral("crb")).isEmpty());
+    QVERIFY(matchedPaths(matcher, QStringLiteral("zsh")).isEmpty());
+
+    // No query lists everything in order, up to the limit
+    QCOMPARE(matchedPaths(matcher, QString(), 2), (QStringList{QStringLiteral(".bashrc"), QStringLiteral(".config/bat/config")}));
+}
+
+void TestFuzzyMatcher::testRanking()
+{
+    FuzzyMatcher matcher;
+    matcher.setPaths({
+        QStringLiteral(".config/k/i/t/t/y.conf"),
+        QStringLiteral(".config/kitty/themes/dark.conf"),
+        QStringLiteral(".config/kitty/kitty.conf"),
+        QStringLiteral(".local/share/kitty-backup/kitty.conf.bak"),
+    });
+
+    // A run in the file name beats the same run in a directory, which beats scattered initials
+    const QStringList ranked = matchedPaths(matcher, QStringLiteral("kitty"));
+    QCOMPARE(ranked.size(), qsizetype(4));
+    QCOMPARE(ranked.at(0), QStringLiteral(".config/kitty/kitty.conf"));
+    QCOMPARE(ranked.at(1), QStringLiteral(".local/share/kitty-backup/kitty.conf.bak"));
+    QCOMPARE(ranked.last(), QStringLiteral(".config/k/i/t/t/y.conf"));
+
+    QCOMPARE(matchedPaths(matcher, QStringLiteral("kitty"), 1), QStringList{QStringLiteral(".config/kitty/kitty.conf")});
+}
+
+void TestFuzzyMatcher::testNarrowing()
+{
+    QStringList paths;
+    for (int i = 0; i < 500; ++i) {
+        paths << QStringLiteral(".config/app%1/settings-%2.conf").arg(i % 37).arg(i);
+    }
+    FuzzyMatcher matcher;
+    matcher.setPaths(paths);
+
+    // Typing, deleting and retyping gives the same results as searching from scratch
+    const QStringList typed = {QStringLiteral("a"), QStringLiteral("ap"), QStringLiteral("app1"), QStringLiteral("app12"), QStringLiteral("app1"), QStringLiteral("app13set"), QStringLiteral("x"), QStringLiteral("app13set9")};
+    for (const QString &query : typed) {
+        FuzzyMatcher fresh;
+        fresh.setPaths(paths);
+        QCOMPARE(matchedPaths(matcher, query, paths.size()), matchedPaths(fresh, query, paths.size()));
+    }
+}
+
+void TestFuzzyMatcher::testLongPaths()
+{
+    // Matches before, across and after every 8-character block the vectorised scan reads
+    FuzzyMatcher matcher;
+    QStringList paths;
+    for (int length = 1; length <= 40; ++length) {
+        paths << QString(length - 1, u'x') + u'y';
+    }
+    matcher.setPaths(paths);
+    QCOMPARE(matchedPaths(matcher, QStringLiteral("y"), paths.size()).size(), paths.size());
+    QCOMPARE(matchedPaths(matcher, QStringLiteral("xxxxxxxxxy"), paths.size()).size(), paths.size() - 9);
+    QVERIFY(matchedPaths(matcher, QStringLiteral("yx")).isEmpty());
+
+    QCOMPARE(FuzzyMatcher::score(u"abc", u"abd", 0), FuzzyMatcher::NoMatch);
+    QVERIFY(FuzzyMatcher::score(u"config/abc", u"abc", 7) > FuzzyMatcher::score(u"config/axbxc", u"abc", 7));
+}
+
+QTEST_GUILESS_MAIN(TestFuzzyMatcher)
+#include "test_fuzzymatcher.moc"
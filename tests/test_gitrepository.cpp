@@ -0,0 +1,258 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QProcess>
+#include <QFile>
+#include "gitrepository.h"
+
+class TestGitRepository : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testInvalidRepository();
+    void testHeadResolution();
+    void testCommitParsing();
+    void testPackedRefsAndObjects();
+    void testDeepDeltaChain();
+    void testWorkTreeStatus();
+    void testWorkTreeStatFastPath();
+    void testAheadBehind();
+
+private:
+    QString git(const QStringList &arguments);
+    void writeFile(const QString &relativePath, const QByteArray &content);
+    void commitFile(const QString &relativePath, const QByteArray &content, const QString &message);
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+QString TestGitRepository::git(const QStringList &arguments)
+{
+    QProcess process;
+    process.setWorkingDirectory(m_dir->path());
+    process.start(QStringLiteral("git"), arguments);
+    if (!process.waitForFinished() || process.exitCode() != 0) {
+        qWarning() << "git" << arguments << "failed:" << process.readAllStandardError();
+        return QString();
+    }
+    return QString::fromUtf8(process.readAllStandardOutput()).trimmed();
+}
+
+void TestGitRepository::writeFile(const QString &relativePath, const QByteArray &content)
+{
+    QFile file(m_dir->filePath(relativePath));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(content);
+}
+
+void TestGitRepository::commitFile(const QString &relativePath, const QByteArray &content, const QString &message)
+{
+    writeFile(relativePath, content);
+    git({QStringLiteral("add"), relativePath});
+    git({QStringLiteral("commit"), QStringLiteral("-q"), QStringLiteral("-m"), message});
+}
+
+void TestGitRepository::initTestCase()
+{
+    if (QStandardPaths::findExecutable(QStringLiteral("git")).isEmpty()) {
+        QSKIP("git is not installed");
+    }
+}
+
+void TestGitRepository::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+
+    git({QStringLiteral("init"), QStringLiteral("-q")});
+    git({QStringLiteral("symbolic-ref"), QStringLiteral("HEAD"), QStringLiteral("refs/heads/main")});
+    git({QStringLiteral("config"), QStringLiteral("user.name"), QStringLiteral("Test User")});
+    git({QStringLiteral("config"), QStringLiteral("user.email"), QStringLiteral("test@example.com")});
+    git({QStringLiteral("config"), QStringLiteral("commit.gpgsign"), QStringLiteral("false")});
+}
+
+void TestGitRepository::cleanup()
+{
+    m_dir.reset();
+}
+
+void TestGitRepository::testInvalidRepository()
+{
+    QTemporaryDir emptyDir;
+    GitRepository repository(emptyDir.path());
+    QVERIFY(!repository.isValid());
+    QVERIFY(!GitRepository::isRepository(emptyDir.path()));
+    QVERIFY(repository.headId().isEmpty());
+    QVERIFY(!repository.workTreeStatus().valid);
+}
+
+void TestGitRepository::testHeadResolution()
+{
+    GitRepository unborn(m_dir->path());
+    QVERIFY(unborn.isValid());
+    QCOMPARE(unborn.currentBranch(), QStringLiteral("main"));
+    QVERIFY(unborn.headId().isEmpty());
+
+    commitFile(QStringLiteral("dot_bashrc"), "export EDITOR=vim\n", QStringLiteral("Add bashrc"));
+
+    GitRepository repository(m_dir->path());
+    QCOMPARE(QString::fromLatin1(repository.headId()), git({QStringLiteral("rev-parse"), QStringLiteral("HEAD")}));
+
+    git({QStringLiteral("checkout"), QStringLiteral("-q"), QStringLiteral("--detach")});
+    QVERIFY(repository.currentBranch().isEmpty());
+    QCOMPARE(QString::fromLatin1(repository.headId()), git({QStringLiteral("rev-parse"), QStringLiteral("HEAD")}));
+}
+
+void TestGitRepository::testCommitParsing()
+{
+    commitFile(QStringLiteral("dot_bashrc"), "first\n", QStringLiteral("First commit"));
+    commitFile(QStringLiteral("dot_bashrc"), "second\n", QStringLiteral("Second commit\n\nWith a body"));
+
+    GitRepository repository(m_dir->path());
+    const GitRepository::Commit commit = repository.readCommit(repository.headId());
+    QVERIFY(commit.isValid());
+    QCOMPARE(commit.subject, QStringLiteral("Second commit"));
+    QCOMPARE(commit.authorName, QStringLiteral("Test User"));
+    QCOMPARE(QString::number(commit.authorTime), git({QStringLiteral("log"), QStringLiteral("-1"), QStringLiteral("--format=%at")}));
+    QCOMPARE(QString::fromLatin1(commit.treeId), git({QStringLiteral("rev-parse"), QStringLiteral("HEAD^{tree}")}));
+    QCOMPARE(commit.parents.size(), 1);
+    QCOMPARE(QString::fromLatin1(commit.parents.first()), git({QStringLiteral("rev-parse"), QStringLiteral("HEAD~1")}));
+
+    QByteArray content;
+    QVERIFY(repository.readFileAtCommit(commit.parents.first(), QStringLiteral("dot_bashrc"), &content));
+    QCOMPARE(content, QByteArray("first\n"));
+    QVERIFY(!repository.readFileAtCommit(commit.id, QStringLiteral("dot_missing"), &content));
+}
+
+void TestGitRepository::testPackedRefsAndObjects()
+{
+    // Enough revisions of one file for the packer to produce delta chains
+    QByteArray content;
+    for (int i = 0; i < 20; ++i) {
+        content += QByteArray("line ") + QByteArray::number(i) + QByteArray(200, 'x') + '\n';
+        commitFile(QStringLiteral("dot_vimrc"), content, QStringLiteral("Revision %1").arg(i));
+    }
+    const QString blobId = git({QStringLiteral("rev-parse"), QStringLiteral("HEAD~10:dot_vimrc")});
+    const QString expectedBlob = git({QStringLiteral("cat-file"), QStringLiteral("blob"), blobId});
+
+    git({QStringLiteral("gc"), QStringLiteral("-q"), QStringLiteral("--aggressive")});
+    QVERIFY(!QFile::exists(m_dir->filePath(QStringLiteral(".git/refs/heads/main"))));
+
+    GitRepository repository(m_dir->path());
+    QCOMPARE(QString::fromLatin1(repository.headId()), git({QStringLiteral("rev-parse"), QStringLiteral("HEAD")}));
+    QCOMPARE(repository.readCommit(repository.headId()).subject, QStringLiteral("Revision 19"));
+
+    QByteArray type;
+    QByteArray data;
+    QVERIFY(repository.readObject(blobId.toLatin1(), &type, &data));
+    QCOMPARE(type, QByteArray("blob"));
+    QCOMPARE(QString::fromUtf8(data).trimmed(), expectedBlob);
+}
+
+void TestGitRepository::testDeepDeltaChain()
+{
+    // Longer than any recursion limit a reader could reasonably pick; "--depth=250" is git's aggressive default
+    QByteArray content;
+    for (int i = 0; i < 120; ++i) {
+        content += QByteArray("line ") + QByteArray::number(i) + QByteArray(100, 'y') + '\n';
+        commitFile(QStringLiteral("dot_zshrc"), content, QStringLiteral("Revision %1").arg(i));
+    }
+    const QString blobId = git({QStringLiteral("rev-parse"), QStringLiteral("HEAD~119:dot_zshrc")});
+    const QString expectedBlob = git({QStringLiteral("cat-file"), QStringLiteral("blob"), blobId});
+
+    git({QStringLiteral("repack"), QStringLiteral("-q"), QStringLiteral("-a"), QStringLiteral("-d"), QStringLiteral("-f"),
+         QStringLiteral("--depth=250"), QStringLiteral("--window=250")});
+
+    GitRepository repository(m_dir->path());
+    QByteArray type;
+    QByteArray data;
+    QVERIFY(repository.readObject(blobId.toLatin1(), &type, &data));
+    QCOMPARE(type, QByteArray("blob"));
+    QCOMPARE(QString::fromUtf8(data).trimmed(), expectedBlob);
+}
+
+void TestGitRepository::testWorkTreeStatus()
+{
+    commitFile(QStringLiteral("dot_bashrc"), "bash\n", QStringLiteral("Add bashrc"));
+    commitFile(QStringLiteral("dot_zshrc"), "zsh\n", QStringLiteral("Add zshrc"));
+
+    GitRepository repository(m_dir->path());
+    GitRepository::WorkTreeStatus status = repository.workTreeStatus();
+    QVERIFY(status.valid);
+    QCOMPARE(status.dirtyCount(), 0);
+
+    // Same content with a new mtime must not count as a change
+    QFile::remove(m_dir->filePath(QStringLiteral("dot_bashrc")));
+    writeFile(QStringLiteral("dot_bashrc"), "bash\n");
+    QCOMPARE(repository.workTreeStatus().dirtyCount(), 0);
+
+    writeFile(QStringLiteral("dot_bashrc"), "bash edited\n");
+    QFile::remove(m_dir->filePath(QStringLiteral("dot_zshrc")));
+    status = repository.workTreeStatus();
+    QCOMPARE(status.modified, QStringList{QStringLiteral("dot_bashrc")});
+    QCOMPARE(status.deleted, QStringList{QStringLiteral("dot_zshrc")});
+    QVERIFY(status.staged.isEmpty());
+
+    git({QStringLiteral("add"), QStringLiteral("dot_bashrc")});
+    status = repository.workTreeStatus();
+    QVERIFY(status.modified.isEmpty());
+    QCOMPARE(status.staged, QStringList{QStringLiteral("dot_bashrc")});
+    QCOMPARE(status.dirtyCount(), 2);
+}
+
+void TestGitRepository::testWorkTreeStatFastPath()
+{
+    // A file whose stat data still matches the index must be trusted without being hashed. Rewriting it in
+    // place with same-size content and its old mtime makes hashing observable: only a re-hash would notice.
+    const QString path = m_dir->filePath(QStringLiteral("dot_bashrc"));
+    const QDateTime oldTime = QDateTime::currentDateTime().addSecs(-3600);
+    writeFile(QStringLiteral("dot_bashrc"), "aaaa\n");
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.setFileTime(oldTime, QFileDevice::FileModificationTime));
+    }
+    git({QStringLiteral("add"), QStringLiteral("dot_bashrc")});
+    git({QStringLiteral("commit"), QStringLiteral("-q"), QStringLiteral("-m"), QStringLiteral("Add bashrc")});
+
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        file.write("bbbb\n");
+        file.flush();
+        QVERIFY(file.setFileTime(oldTime, QFileDevice::FileModificationTime));
+    }
+
+    GitRepository repository(m_dir->path());
+    QCOMPARE(repository.workTreeStatus().dirtyCount(), 0);
+}
+
+void TestGitRepository::testAheadBehind()
+{
+    commitFile(QStringLiteral("dot_bashrc"), "base\n", QStringLiteral("Base"));
+    git({QStringLiteral("branch"), QStringLiteral("upstream")});
+    git({QStringLiteral("config"), QStringLiteral("branch.main.remote"), QStringLiteral(".")});
+    git({QStringLiteral("config"), QStringLiteral("branch.main.merge"), QStringLiteral("refs/heads/upstream")});
+
+    commitFile(QStringLiteral("dot_bashrc"), "local 1\n", QStringLiteral("Local 1"));
+    commitFile(QStringLiteral("dot_bashrc"), "local 2\n", QStringLiteral("Local 2"));
+
+    git({QStringLiteral("checkout"), QStringLiteral("-q"), QStringLiteral("upstream")});
+    commitFile(QStringLiteral("dot_zshrc"), "remote\n", QStringLiteral("Remote 1"));
+    git({QStringLiteral("checkout"), QStringLiteral("-q"), QStringLiteral("main")});
+
+    GitRepository repository(m_dir->path());
+    QCOMPARE(repository.upstreamRef(), QStringLiteral("refs/heads/upstream"));
+
+    int ahead = -1;
+    int behind = -1;
+    QVERIFY(repository.aheadBehind(repository.headId(), repository.resolveRef(repository.upstreamRef()), &ahead, &behind));
+    QCOMPARE(ahead, 2);
+    QCOMPARE(behind, 1);
+}
+
+QTEST_GUILESS_MAIN(TestGitRepository)
+#include "test_gitrepository.moc"
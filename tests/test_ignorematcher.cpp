@@ -0,0 +1,136 @@
+#include <QtTest/QtTest>
+#include "ignorematcher.h"
+
+class TestIgnoreMatcher : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testEmpty();
+    void testPatterns_data();
+    void testPatterns();
+    void testExcludes();
+    void testBraceExpansion();
+    void testClassify();
+
+private:
+    static QString sampleIgnore();
+};
+
+QString TestIgnoreMatcher::sampleIgnore()
+{
+    return QStringLiteral(
+        "# rendered .chezmoiignore\n"
+        ".bashrc\n"
+        "*.txt  # only at the top level\n"
+        ".config/**/cache\n"
+        "!.config/keep/cache\n"
+        ".oh-my-zsh/**\n"
+        "docs/\n"
+        ".local/share/[a-c]*\n"
+        ".ssh/id_{rsa,ed25519}\n"
+        "**/*.bak\n"
+        "?.log\n"
+        ".x/[!0-9]\n"
+        "literal\\*star\n");
+}
+
+void TestIgnoreMatcher::testEmpty()
+{
+    IgnoreMatcher matcher;
+    QVERIFY(matcher.isEmpty());
+    QVERIFY(!matcher.isIgnored(u".bashrc"));
+
+    matcher.compile(QStringLiteral("\n   \n# only a comment\n"));
+    QVERIFY(matcher.isEmpty());
+    QVERIFY(!matcher.isIgnored(u".bashrc"));
+}
+
+void TestIgnoreMatcher::testPatterns_data()
+{
+    QTest::addColumn<QString>("path");
+    QTest::addColumn<bool>("ignored");
+
+    QTest::newRow("exact") << QStringLiteral(".bashrc") << true;
+    QTest::newRow("exact is not a prefix") << QStringLiteral(".bashrc2") << false;
+    QTest::newRow("shorter than exact") << QStringLiteral(".bash") << false;
+    QTest::newRow("star at top level") << QStringLiteral("notes.txt") << true;
+    QTest::newRow("star stays in its component") << QStringLiteral("dir/notes.txt") << false;
+    QTest::newRow("globstar zero dirs") << QStringLiteral(".config/cache") << true;
+    QTest::newRow("globstar two dirs") << QStringLiteral(".config/a/b/cache") << true;
+    QTest::newRow("below ignored dir") << QStringLiteral(".config/a/b/cache/file") << true;
+    QTest::newRow("globstar needs whole name") << QStringLiteral(".config/cachex") << false;
+    QTest::newRow("trailing globstar itself") << QStringLiteral(".oh-my-zsh") << true;
+    QTest::newRow("trailing globstar below") << QStringLiteral(".oh-my-zsh/lib/git.zsh") << true;
+    QTest::newRow("trailing globstar sibling") << QStringLiteral(".oh-my-zshrc") << false;
+    QTest::newRow("trailing slash") << QStringLiteral("docs/index.md") << true;
+    QTest::newRow("trailing slash sibling") << QStringLiteral("docsy") << false;
+    QTest::newRow("class") << QStringLiteral(".local/share/applications") << true;
+    QTest::newRow("class miss") << QStringLiteral(".local/share/fonts") << false;
+    QTest::newRow("negated class") << QStringLiteral(".x/a") << true;
+    QTest::newRow("negated class miss") << QStringLiteral(".x/1") << false;
+    QTest::newRow("brace first") << QStringLiteral(".ssh/id_rsa") << true;
+    QTest::newRow("brace second") << QStringLiteral(".ssh/id_ed25519") << true;
+    QTest::newRow("brace miss") << QStringLiteral(".ssh/id_rsa.pub") << false;
+    QTest::newRow("leading globstar") << QStringLiteral("a/b/c.bak") << true;
+    QTest::newRow("leading globstar top") << QStringLiteral("c.bak") << true;
+    QTest::newRow("question mark") << QStringLiteral("a.log") << true;
+    QTest::newRow("question mark is one character") << QStringLiteral("ab.log") << false;
+    QTest::newRow("escaped star") << QStringLiteral("literal*star") << true;
+    QTest::newRow("escaped star is literal") << QStringLiteral("literalxstar") << false;
+}
+
+void TestIgnoreMatcher::testPatterns()
+{
+    QFETCH(QString, path);
+    QFETCH(bool, ignored);
+
+    IgnoreMatcher matcher;
+    matcher.compile(sampleIgnore());
+    QCOMPARE(matcher.patternCount(), qsizetype(12));
+    QCOMPARE(matcher.isIgnored(path), ignored);
+}
+
+void TestIgnoreMatcher::testExcludes()
+{
+    IgnoreMatcher matcher;
+
+    // Excludes win over includes of the same path
+    matcher.compile(QStringLiteral(".config/cache\n!.config/cache\n"));
+    QVERIFY(!matcher.isIgnored(u".config/cache"));
+    QVERIFY(!matcher.isIgnored(u".config/cache/file"));
+
+    matcher.compile(QStringLiteral("**\n!.bashrc\n"));
+    QVERIFY(!matcher.isIgnored(u".bashrc"));
+    QVERIFY(matcher.isIgnored(u".zshrc"));
+
+    // An ignored directory is never walked, so excluding something inside it has no effect
+    matcher.compile(QStringLiteral(".config\n!.config/nvim\n"));
+    QVERIFY(matcher.isIgnored(u".config/nvim"));
+}
+
+void TestIgnoreMatcher::testBraceExpansion()
+{
+    QCOMPARE(IgnoreMatcher::expandBraces(QStringLiteral("plain")), QStringList{QStringLiteral("plain")});
+    QCOMPARE(IgnoreMatcher::expandBraces(QStringLiteral("{a,b{c,d}}x{1,2}")),
+             (QStringList{QStringLiteral("ax1"), QStringLiteral("ax2"), QStringLiteral("bcx1"),
+                          QStringLiteral("bcx2"), QStringLiteral("bdx1"), QStringLiteral("bdx2")}));
+    QCOMPARE(IgnoreMatcher::expandBraces(QStringLiteral("unclosed{a,b")), QStringList{QStringLiteral("unclosed{a,b")});
+}
+
+void TestIgnoreMatcher::testClassify()
+{
+    IgnoreMatcher matcher;
+    matcher.compile(sampleIgnore());
+
+    QStringList paths;
+    QList<bool> expected;
+    for (int i = 0; i < 1000; ++i) {
+        paths << QStringLiteral(".config/app%1/cache").arg(i) << QStringLiteral(".config/app%1/init.lua").arg(i);
+        expected << true << false;
+    }
+    QCOMPARE(matcher.classify(paths), expected);
+}
+
+QTEST_GUILESS_MAIN(TestIgnoreMatcher)
+#include "test_ignorematcher.moc"
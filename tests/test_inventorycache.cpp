@@ -0,0 +1,142 @@
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <cstring>
+#include "inventorycache.h"
+
+class TestInventoryCache : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testRoundTrip();
+    void testSourceDirectoryMismatch();
+    void testRejectsDamagedFiles();
+
+private:
+    static QList<InventoryCache::Entry> sampleEntries();
+};
+
+QList<InventoryCache::Entry> TestInventoryCache::sampleEntries()
+{
+    InventoryCache::Entry bashrc;
+    bashrc.path = QStringLiteral(".bashrc");
+    bashrc.sourcePath = QStringLiteral("dot_bashrc.tmpl");
+    bashrc.status = ChezmoiStatus(ChezmoiStatus::Modified, ChezmoiStatus::Modified);
+    bashrc.iconName = QStringLiteral("application-x-shellscript");
+    bashrc.attributes = InventoryCache::Template | InventoryCache::TargetExists;
+    bashrc.sourceMtime = 1700000000000;
+    bashrc.targetMtime = 1700000001000;
+
+    InventoryCache::Entry config;
+    config.path = QStringLiteral(".config/kitty/kitty.conf");
+    config.sourcePath = QStringLiteral("dot_config/kitty/kitty.conf");
+    config.iconName = QStringLiteral("text-x-generic");
+
+    InventoryCache::Entry key;
+    key.path = QStringLiteral(".ssh/id_ed25519");
+    key.sourcePath = QStringLiteral("private_dot_ssh/private_id_ed25519");
+    key.iconName = QStringLiteral("text-x-generic");
+    key.attributes = InventoryCache::TargetExists | InventoryCache::TargetPrivate;
+
+    return {bashrc, config, key};
+}
+
+void TestInventoryCache::testRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const InventoryCache cache(dir.filePath(QStringLiteral("cache/inventory.cache")));
+    const QString sourceDir = QStringLiteral("/home/user/.local/share/chezmoi");
+
+    const QList<InventoryCache::Entry> entries = sampleEntries();
+    QVERIFY(cache.save(sourceDir, entries));
+
+    QList<InventoryCache::Entry> loaded;
+    QVERIFY(cache.load(sourceDir, &loaded));
+    QCOMPARE(loaded.size(), entries.size());
+    for (int i = 0; i < entries.size(); ++i) {
+        QCOMPARE(loaded[i].path, entries[i].path);
+        QCOMPARE(loaded[i].sourcePath, entries[i].sourcePath);
+        QCOMPARE(loaded[i].status, entries[i].status);
+        QCOMPARE(loaded[i].iconName, entries[i].iconName);
+        QCOMPARE(loaded[i].attributes, entries[i].attributes);
+        QCOMPARE(loaded[i].sourceMtime, entries[i].sourceMtime);
+        QCOMPARE(loaded[i].targetMtime, entries[i].targetMtime);
+    }
+    QVERIFY(loaded.first().isTemplate());
+    QVERIFY(!loaded.last().isTemplate());
+
+    // An empty inventory is still a valid snapshot
+    QVERIFY(cache.save(sourceDir, {}));
+    QVERIFY(cache.load(sourceDir, &loaded));
+    QVERIFY(loaded.isEmpty());
+}
+
+void TestInventoryCache::testSourceDirectoryMismatch()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const InventoryCache cache(dir.filePath(QStringLiteral("inventory.cache")));
+
+    QVERIFY(cache.save(QStringLiteral("/srv/dotfiles"), sampleEntries()));
+
+    QList<InventoryCache::Entry> loaded;
+    QVERIFY(!cache.load(QStringLiteral("/srv/other-dotfiles"), &loaded));
+    QVERIFY(loaded.isEmpty());
+
+    // A missing file is simply a cold start
+    const InventoryCache missing(dir.filePath(QStringLiteral("missing.cache")));
+    QVERIFY(!missing.load(QStringLiteral("/srv/dotfiles"), &loaded));
+}
+
+void TestInventoryCache::testRejectsDamagedFiles()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("inventory.cache"));
+    const InventoryCache cache(path);
+    const QString sourceDir = QStringLiteral("/srv/dotfiles");
+    QList<InventoryCache::Entry> loaded;
+
+    QVERIFY(cache.save(sourceDir, sampleEntries()));
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray original = file.readAll();
+    file.close();
+
+    auto rewrite = [&path](const QByteArray &data) {
+        QFile out(path);
+        QVERIFY(out.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        out.write(data);
+    };
+
+    // Truncated
+    rewrite(original.left(original.size() - 5));
+    QVERIFY(!cache.load(sourceDir, &loaded));
+
+    // Corrupted string pool
+    QByteArray corrupted = original;
+    corrupted[corrupted.size() - 1] = char(corrupted.at(corrupted.size() - 1) ^ 0x20);
+    rewrite(corrupted);
+    QVERIFY(!cache.load(sourceDir, &loaded));
+
+    // Written by another format version
+    QByteArray otherVersion = original;
+    const quint32 version = InventoryCache::FormatVersion + 1;
+    std::memcpy(otherVersion.data() + 4, &version, sizeof(version));
+    rewrite(otherVersion);
+    QVERIFY(!cache.load(sourceDir, &loaded));
+
+    // Not a cache at all
+    rewrite(QByteArray("sourceDir = \"/srv/dotfiles\"\n").repeated(4));
+    QVERIFY(!cache.load(sourceDir, &loaded));
+    QVERIFY(loaded.isEmpty());
+
+    rewrite(original);
+    QVERIFY(cache.load(sourceDir, &loaded));
+    QCOMPARE(loaded.size(), 3);
+}
+
+QTEST_GUILESS_MAIN(TestInventoryCache)
+#include "test_inventorycache.moc"
@@ -0,0 +1,59 @@
+#include <QtTest/QtTest>
+#include "memoryregistry.h"
+
+class TestMemoryRegistry : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testSnapshot();
+    void testStringBytes();
+};
+
+void TestMemoryRegistry::testSnapshot()
+{
+    MemoryRegistry *registry = MemoryRegistry::instance();
+    qint64 documents = 2;
+    const quint64 tree = registry->add(QStringLiteral("Test tree"), []() {
+        return MemoryRegistry::Usage{4096, 10};
+    });
+    const quint64 first = registry->add(QStringLiteral("Test documents"), [&documents]() {
+        return MemoryRegistry::Usage{documents * 100, documents};
+    });
+    const quint64 second = registry->add(QStringLiteral("Test documents"), []() {
+        return MemoryRegistry::Usage{50, 1};
+    });
+
+    // Same-named reporters are summed, and asked again on every snapshot
+    QCOMPARE(registry->usage(QStringLiteral("Test documents")).bytes, qint64(250));
+    documents = 3;
+    QCOMPARE(registry->usage(QStringLiteral("Test documents")).objects, qint64(4));
+
+    const QList<MemoryRegistry::Entry> entries = registry->snapshot();
+    QVERIFY(entries.size() >= 2);
+    for (qsizetype i = 1; i < entries.size(); ++i) {
+        QVERIFY(entries.at(i - 1).usage.bytes >= entries.at(i).usage.bytes);
+    }
+
+    const QString report = registry->report();
+    QVERIFY(report.contains(QStringLiteral("Test tree:")));
+    QVERIFY(report.contains(QStringLiteral("Total:")));
+
+    registry->remove(tree);
+    registry->remove(first);
+    QCOMPARE(registry->usage(QStringLiteral("Test tree")).bytes, qint64(0));
+    QCOMPARE(registry->usage(QStringLiteral("Test documents")).bytes, qint64(50));
+    registry->remove(second);
+}
+
+void TestMemoryRegistry::testStringBytes()
+{
+    QCOMPARE(MemoryRegistry::stringBytes(QString()), qint64(0));
+
+    QString path = QStringLiteral(".config/nvim/init.lua");
+    path.detach();
+    QVERIFY(MemoryRegistry::stringBytes(path) >= qint64(path.size() * 2));
+}
+
+QTEST_GUILESS_MAIN(TestMemoryRegistry)
+#include "test_memoryregistry.moc"